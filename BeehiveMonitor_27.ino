@@ -15,12 +15,27 @@
 #include "serial_commands.h"
 #include "sms_handler.h"
 #include "provisioning_server.h"
+#include "http_server.h"
+#include "lcd_endpoint.h"
+#include "api_endpoint.h"
+#include "metrics_endpoint.h"
+#include "ota_update.h"
+#include "perf_stats.h"
+#include "mem_telemetry.h"
+#include "tsdb.h"
+#include "ts_queue.h"
+#include "sd_storage.h"
+#include "gateway.h"
+#include "telemetry_sink.h"
+#include "upload_scheduler.h"
+#include "wifi_manager.h"
+#include "settings.h"
 
 #include <WiFi.h>
 #include <LiquidCrystal_I2C.h>
-#include <Preferences.h>
 #include <SD.h>
 #include <SPI.h>
+#include <atomic>
 
 // -----------------------------------------------------------------------------
 // Single global language selection (definition)
@@ -45,87 +60,31 @@ float test_batt_voltage = 4.12;
 int test_batt_percent = 87;
 int test_rssi = -72;
 
-// -----------------------------------------------------------------------------
-// Preferences keys used by the provisioning form / app
-static const char* PREF_WIFI_NS = "beehive";
-static const char* PREF_WIFI_SSID1 = "wifi_ssid1";
-static const char* PREF_WIFI_PSK1  = "wifi_psk1";
-static const char* PREF_WIFI_SSID2 = "wifi_ssid2";
-static const char* PREF_WIFI_PSK2  = "wifi_psk2";
-
-static const char* PREF_APP_NS = "beehive_app";
-static const char* PREF_TS_AUTO = "ts_auto";
-static const char* PREF_TS_INTERVAL = "ts_interval_min";
-static const char* PREF_NET_PREF = "net_pref"; // 0=auto,1=force wifi,2=force lte
-
 // -----------------------------------------------------------------------------
 // Network mode enum + runtime state
 enum NetMode { NET_NONE = 0, NET_LTE = 1, NET_WIFI = 2 };
 static NetMode currentNet = NET_NONE;
-static int net_pref = 0; // read from prefs (0 auto,1 wifi,2 lte)
+static int net_pref = 0; // settings().netPref (0 auto,1 wifi,2 lte)
 
 // Auto-upload state
 static bool ts_auto_enabled = false;
 static int ts_interval_min = 60;
 static unsigned long ts_next_upload = 0;
 
-// Forward declaration to the modem posting helper (in thingspeak_client_modem.cpp)
-extern bool thingspeak_post_via_modem(const String &postBody);
-
-// -----------------------------------------------------------------------------
-// wifi_connectFromPrefs implementation
-// Tries SSID1 then SSID2. Returns true if connected.
-bool wifi_connectFromPrefs(unsigned long timeoutMs = 8000) {
-  Preferences p;
-  p.begin(PREF_WIFI_NS, true);
-  String ssid1 = p.getString(PREF_WIFI_SSID1, "");
-  String psk1  = p.getString(PREF_WIFI_PSK1, "");
-  String ssid2 = p.getString(PREF_WIFI_SSID2, "");
-  String psk2  = p.getString(PREF_WIFI_PSK2, "");
-  p.end();
-
-  if (ssid1.length() == 0 && ssid2.length() == 0) {
-    Serial.println(F("[WiFi] No SSID stored in prefs"));
-    return false;
-  }
-
-  auto tryConnect = [&](const String &ssid, const String &psk) -> bool {
-    if (ssid.length() == 0) return false;
-    Serial.print(F("[WiFi] Trying SSID: "));
-    Serial.println(ssid);
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid.c_str(), psk.c_str());
-    unsigned long start = millis();
-    while (WiFi.status() != WL_CONNECTED && millis() - start < timeoutMs) {
-      delay(200);
-    }
-    if (WiFi.status() == WL_CONNECTED) {
-      Serial.print(F("[WiFi] Connected, IP: "));
-      Serial.println(WiFi.localIP());
-      return true;
-    }
-    Serial.println(F("[WiFi] Connect timed out"));
-    return false;
-  };
-
-  if (tryConnect(ssid1, psk1)) { currentNet = NET_WIFI; return true; }
-  if (tryConnect(ssid2, psk2)) { currentNet = NET_WIFI; return true; }
-  return false;
-}
-
 // -----------------------------------------------------------------------------
 // tryStartLTE implementation
 void tryStartLTE() {
+  if (!modem_isReady()) {
+    // modem still coming up in the background (or absent) - nothing to attach yet
+    currentNet = NET_NONE;
+    return;
+  }
   TinyGsm& modem = modem_get();
   Serial.println(F("[LTE] Attempting GPRS attach"));
   bool ok = modem.gprsConnect(MODEM_APN, MODEM_GPRS_USER, MODEM_GPRS_PASS);
   if (ok) {
     Serial.println(F("[LTE] GPRS attach OK"));
-    if (WiFi.status() == WL_CONNECTED) {
-      WiFi.disconnect(true);
-      WiFi.mode(WIFI_OFF);
-    }
-    keyServer_stop();
+    wifi_setEnabled(false);   // wifi_manager keeps STA mode for ESP-NOW roles; http_loop() stops the server
     currentNet = NET_LTE;
   } else {
     Serial.println(F("[LTE] GPRS attach failed"));
@@ -133,82 +92,67 @@ void tryStartLTE() {
   }
 }
 
-// -----------------------------------------------------------------------------
-// enqueue to SD helper (for offline posts)
-static bool enqueuePostToSD(const String &post) {
-  if (!SD.begin(SD_CS)) {
-    Serial.println(F("[TS-QUEUE] SD.begin failed - cannot enqueue"));
-    return false;
-  }
-  File f = SD.open("/ts_queue.txt", FILE_APPEND);
-  if (!f) {
-    Serial.println(F("[TS-QUEUE] Cannot open /ts_queue.txt for append"));
-    return false;
-  }
-  f.println(post);
-  f.close();
-  Serial.println(F("[TS-QUEUE] Post enqueued to /ts_queue.txt"));
-  return true;
+// Adopt a GPRS session that the background modem bring-up already attached.
+// Mirrors the tail of tryStartLTE() without issuing a second gprsConnect().
+static void adoptBootLTE() {
+  Serial.println(F("[LTE] GPRS attached during boot"));
+  wifi_setEnabled(false);   // wifi_manager keeps STA mode for ESP-NOW roles; http_loop() stops the server
+  currentNet = NET_LTE;
 }
 
-// Build ThingSpeak body
-static String buildThingSpeakPostBody() {
-  char buf[64];
-  String b;
-  b.reserve(256);
-
-  snprintf(buf, sizeof(buf), "%.1f", test_weight);
-  b += String("field1=") + String(buf);
-  snprintf(buf, sizeof(buf), "%.1f", test_temp_int);
-  b += String("&field2=") + String(buf);
-  snprintf(buf, sizeof(buf), "%.0f", test_hum_int);
-  b += String("&field3=") + String(buf);
-  snprintf(buf, sizeof(buf), "%.1f", test_temp_ext);
-  b += String("&field4=") + String(buf);
-  snprintf(buf, sizeof(buf), "%.0f", test_hum_ext);
-  b += String("&field5=") + String(buf);
-  snprintf(buf, sizeof(buf), "%.0f", test_pressure);
-  b += String("&field6=") + String(buf);
-  snprintf(buf, sizeof(buf), "%.2f", test_batt_voltage);
-  b += String("&field7=") + String(buf);
-
-  Preferences p;
-  p.begin(PREF_WIFI_NS, true);
-  String latS = p.getString("owm_lat", "");
-  String lonS = p.getString("owm_lon", "");
-  p.end();
-  double lat = DEFAULT_LAT, lon = DEFAULT_LON;
-  if (latS.length() && lonS.length()) { lat = latS.toDouble(); lon = lonS.toDouble(); }
-  char latBuf[32], lonBuf[32];
-  snprintf(latBuf, sizeof(latBuf), "%.4f", lat);
-  snprintf(lonBuf, sizeof(lonBuf), "%.4f", lon);
-  String coords = String(latBuf) + String(" ") + String(lonBuf);
-  coords.replace(" ", "+");
-  b += String("&field8=") + coords;
-
-  String post = String("api_key=") + String(THINGSPEAK_WRITE_APIKEY) + String("&") + b;
-  return post;
+// -----------------------------------------------------------------------------
+// network management honoring net_pref (called every loop)
+static void manageNetwork() {
+  static unsigned long lastTry = 0;   // gprsConnect() blocks: one attach attempt per 30 s
+  if (!modem_isBootDone() && net_pref != 1) {
+    // bring-up still running: only WiFi (enabled in setup) is usable
+    if (currentNet != NET_LTE) currentNet = wifi_isConnected() ? NET_WIFI : NET_NONE;
+  } else if (net_pref == 0) {
+    if (currentNet == NET_LTE) {
+      if (!modem_isNetworkRegistered()) { currentNet = NET_NONE; wifi_setEnabled(true); }
+    } else if (currentNet == NET_WIFI) {
+      if (!wifi_isConnected()) currentNet = NET_NONE;
+      else if (modem_isNetworkRegistered() && millis() - lastTry > 30000) {
+        lastTry = millis();
+        tryStartLTE();
+        // a failed attach leaves WiFi up: keep using it until the next try
+        if (currentNet != NET_LTE && wifi_isConnected()) currentNet = NET_WIFI;
+      }
+    } else if (wifi_isConnected()) {
+      currentNet = NET_WIFI;
+    } else {
+      if (millis() - lastTry > 30000) { lastTry = millis(); tryStartLTE(); if (currentNet != NET_LTE) wifi_setEnabled(true); }
+    }
+  } else if (net_pref == 1) {
+    wifi_setEnabled(true);
+    currentNet = wifi_isConnected() ? NET_WIFI : NET_NONE;
+  } else if (currentNet != NET_LTE && millis() - lastTry > 30000) {
+    lastTry = millis();
+    tryStartLTE();
+  }
 }
 
-// Try auto upload (WiFi -> LTE -> queue)
-static bool uploadThingSpeakAuto() {
-  String post = buildThingSpeakPostBody();
+// Menu / web / SMS changes apply without a reboot. The listener runs on the
+// task that made the change (httpd, SMS, serial); it only records what
+// changed, and loop() applies it to the state it owns.
+static std::atomic<uint16_t> s_settingsChanged{0};
 
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println(F("[TS-AUTO] WiFi connected - posting via WiFi"));
-    bool ok = thingspeak_upload_current(); // existing WiFi path
-    if (ok) return true;
-    Serial.println(F("[TS-AUTO] thingspeak_upload_current() failed"));
-  }
+static void onSettingsChanged(uint16_t changed) {
+  s_settingsChanged.fetch_or(changed);
+}
 
-  if (modem_isNetworkRegistered()) {
-    Serial.println(F("[TS-AUTO] Modem registered - posting via MODEM"));
-    bool ok = thingspeak_post_via_modem(post);
-    if (ok) return true;
-    Serial.println(F("[TS-AUTO] modem post failed"));
+static void applySettingsChanges() {
+  uint16_t changed = s_settingsChanged.exchange(0);
+  if (!(changed & (SET_NET | SET_UPLOAD))) return;
+  const Settings &cfg = settings();
+  if (changed & SET_NET) net_pref = cfg.netPref;
+  if (changed & SET_UPLOAD) {
+    if (cfg.tsAuto && (!ts_auto_enabled || cfg.tsIntervalMin != ts_interval_min)) {
+      ts_next_upload = millis() + (unsigned long)cfg.tsIntervalMin * 60UL * 1000UL;
+    }
+    ts_interval_min = cfg.tsIntervalMin;
+    ts_auto_enabled = cfg.tsAuto;
   }
-
-  return enqueuePostToSD(post);
 }
 
 // -----------------------------------------------------------------------------
@@ -217,87 +161,116 @@ void setup() {
   Serial.begin(115200);
   delay(50);
 
+  // Settings first (a few ms): net_pref decides whether the modem
+  // bring-up task should also attach GPRS.
+  settings_init();
+  {
+    const Settings &cfg = settings();
+    ts_auto_enabled = cfg.tsAuto;
+    ts_interval_min = cfg.tsIntervalMin;
+    net_pref = cfg.netPref;
+    if (ts_auto_enabled) ts_next_upload = millis() + 30 * 1000UL;
+  }
+  settings_onChange(onSettingsChanged);
+
+  // Modem power-up / restart / GPRS attach run in the background from here on;
+  // everything below overlaps with it. Dependent steps (time sync via +CCLK,
+  // SMS, LTE uploads) wait for modem_isReady(). Satellites have no modem.
+#if NODE_ROLE != NODE_ROLE_SATELLITE
+  modemManager_startAsync(net_pref != 1);
+#endif
+
   uiInit();
   pinMode(BTN_UP, INPUT_PULLUP);
   pinMode(BTN_DOWN, INPUT_PULLUP);
   pinMode(BTN_SELECT, INPUT_PULLUP);
   pinMode(BTN_BACK, INPUT_PULLUP);
 
-  SPI.begin(SD_SCLK, SD_MISO, SD_MOSI, SD_CS);
-  bool sd_ok = SD.begin(SD_CS);
+  bool sd_ok = sd_init();   // the only SD.begin(); sd_loop() remounts after errors
 
   weather_init();
 
-  {
-    Preferences p;
-    p.begin(PREF_APP_NS, false);
-    ts_auto_enabled = p.getBool(PREF_TS_AUTO, false);
-    ts_interval_min = p.getInt(PREF_TS_INTERVAL, 60);
-    net_pref = p.getInt(PREF_NET_PREF, 0);
-    p.end();
-    if (ts_interval_min <= 0) ts_interval_min = 60;
-    if (ts_auto_enabled) ts_next_upload = millis() + 30 * 1000UL;
+  Serial.println(sd_ok ? F("SD init OK") : F("SD init FAIL"));
+  if (sd_ok) {
+    tsdb_init();
+    tsq_init();
   }
+  sinks_init();
 
-  Serial.println(sd_ok ? F("SD init OK") : F("SD init FAIL"));
+  timeManager_init();
 
   showSplashScreen();
   menuInit();
   menuDraw();
 
-  modem_hw_init();
-  modemManager_init();
   serial_commands_init();
-  sms_init();
-
-  provisioning_init(); // starts server8080 internally
-
-  // apply network pref
-  if (net_pref == 2) tryStartLTE();
-  else if (net_pref == 1) { if (!wifi_connectFromPrefs(8000)) Serial.println(F("[NET] Forced WiFi failed")); }
-  else { tryStartLTE(); if (currentNet != NET_LTE) wifi_connectFromPrefs(8000); }
-
-  timeManager_init();
+  mem_init();
+
+  // routes of the port-80 server; http_loop() starts it once WiFi is up
+  keyServer_init();
+  provisioning_init();
+  lcd_endpoint_init();
+  api_endpoint_init();
+  metrics_endpoint_init();
+  ota_init();           // also decides whether this boot is an unconfirmed update
+
+  // WiFi association runs in the background (wifi_loop()) alongside the
+  // modem bring-up. In auto mode the loop switches over to LTE once the
+  // background attach reports success.
+  wifi_init();
+  gateway_init();   // ESP-NOW follows the AP channel once the station associates
+  if (net_pref != 2) wifi_setEnabled(true);
 
   if (ts_auto_enabled && ts_next_upload == 0) ts_next_upload = millis() + (unsigned long)ts_interval_min * 60UL * 1000UL;
 }
 
 void loop() {
-  menuUpdate();
-  timeManager_update();
-
-  // network management honoring net_pref
-  if (net_pref == 0) {
-    if (currentNet == NET_LTE) {
-      if (!modem_isNetworkRegistered()) { currentNet = NET_NONE; wifi_connectFromPrefs(5000); }
-    } else if (currentNet == NET_WIFI) {
-      if (modem_isNetworkRegistered()) {
-        if (WiFi.status() == WL_CONNECTED) { WiFi.disconnect(true); WiFi.mode(WIFI_OFF); }
-        tryStartLTE();
-      }
-    } else {
-      static unsigned long lastTry = 0;
-      if (millis() - lastTry > 30000) { lastTry = millis(); tryStartLTE(); if (currentNet != NET_LTE) wifi_connectFromPrefs(5000); }
-    }
-  } else if (net_pref == 1) {
-    if (currentNet != NET_WIFI) { if (wifi_connectFromPrefs(5000)) currentNet = NET_WIFI; }
-  } else {
-    if (currentNet != NET_LTE) tryStartLTE();
+#if ENABLE_PERF_STATS
+  int64_t loopT0 = esp_timer_get_time();
+#endif
+  PERF_STAGE(PERF_MENU, menuUpdate());
+  applySettingsChanges();
+  PERF_STAGE(PERF_TIME, timeManager_update());
+
+  // pick up the GPRS session attached by the background bring-up (once)
+  static bool bootLteChecked = false;
+  if (!bootLteChecked && modem_isBootDone()) {
+    bootLteChecked = true;
+    if (net_pref != 1 && modem_bootGprsAttached()) adoptBootLTE();
   }
 
-  keyServer_loop();
-  provisioning_loop();
-  serial_commands_poll();
-  sms_loop();
-
-  if (ts_auto_enabled && millis() >= ts_next_upload) {
-    Serial.println(F("[TS-AUTO] Scheduled ThingSpeak upload triggered"));
-    bool ok = uploadThingSpeakAuto();
+  // network management honoring net_pref
+  PERF_STAGE(PERF_NETWORK, { wifi_loop(); manageNetwork(); ota_loop(); });
+
+  PERF_STAGE(PERF_HTTP, { http_loop(); lcd_endpoint_loop(); });
+  PERF_STAGE(PERF_SERIAL, serial_commands_poll());
+  PERF_STAGE(PERF_SMS, sms_loop());
+  mem_loop();
+  sd_loop();
+  tsdb_loop();
+  gateway_loop();
+
+  // The first upload waits for the modem bring-up unless WiFi is already up.
+  // Satellites hand their samples to the gateway instead (gateway_loop()).
+  bool uploadLinkKnown = modem_isBootDone() || wifi_isConnected();
+  if (NODE_ROLE != NODE_ROLE_SATELLITE && ts_auto_enabled && uploadLinkKnown && millis() >= ts_next_upload) {
+    Serial.println(F("[TS-AUTO] Scheduled upload triggered"));
+    TelemetrySample sample;
+    sample_capture(sample);
+    bool ok;
+    PERF_STAGE(PERF_UPLOAD, ok = sinks_publish(sample));
     Serial.print(F("[TS-AUTO] Upload result: "));
     Serial.println(ok ? F("OK") : F("FAIL"));
     ts_next_upload = millis() + (unsigned long)ts_interval_min * 60UL * 1000UL;
   }
 
+  // queued samples go out per sink as links, rate limits and the
+  // scheduler (signal / battery) allow
+  if (NODE_ROLE != NODE_ROLE_SATELLITE) {
+    sched_loop();
+    PERF_STAGE(PERF_RETRY, sinks_loop());
+  }
+
   static unsigned long lastRetry = 0;
   if (millis() - lastRetry > 60000) { retryQueuedThingSpeak(); lastRetry = millis(); }
 
@@ -330,6 +303,9 @@ void loop() {
   }
 #endif
 
+#if ENABLE_PERF_STATS
+  perf_record(PERF_LOOP, (uint32_t)(esp_timer_get_time() - loopT0));  // excludes the idle delay below
+#endif
   delay(10);
 }
 
@@ -0,0 +1,186 @@
+#include "api_endpoint.h"
+#include "http_server.h"
+#include "telemetry_sample.h"
+#include "tsdb.h"
+#include "time_manager.h"
+#include "upload_scheduler.h"
+#include "modem_manager.h"
+#include "config.h"
+#include <WiFi.h>
+#include <time.h>
+
+// Decimals per channel in display units (kg, degC, %, hPa, V)
+static const uint8_t s_decimals[CH_COUNT] = { 3, 2, 1, 2, 1, 1, 3 };
+
+static const char *api_timeSourceName(TimeSource src) {
+  switch (src) {
+    case TSRC_WIFI:    return "wifi";
+    case TSRC_LTE:     return "lte";
+    case TSRC_GATEWAY: return "gateway";
+    default:           return "none";
+  }
+}
+
+static uint32_t api_fnv1a(const char *p, size_t n) {
+  uint32_t h = 2166136261UL;
+  while (n--) h = (h ^ (uint8_t)*p++) * 16777619UL;
+  return h;
+}
+
+static esp_err_t api_handleCurrent(httpd_req_t *req) {
+  TelemetrySample s;
+  sample_capture(s);
+
+  char json[512];
+  size_t n = 0;
+  if (s.ts) n = snprintf(json, sizeof(json), "{\"ts\":%lu", (unsigned long)s.ts);
+  else      n = strlcpy(json, "{\"ts\":null", sizeof(json));
+  size_t tsLen = n;
+  n += snprintf(json + n, sizeof(json) - n, ",\"time_source\":\"%s\"",
+                api_timeSourceName(timeManager_getSource()));
+  for (uint8_t c = 0; c < CH_COUNT; ++c) {
+    n += snprintf(json + n, sizeof(json) - n, ",\"%s\":%.*f", sample_channelName((SampleChannel)c),
+                  s_decimals[c], sample_value(s, (SampleChannel)c));
+  }
+  n += snprintf(json + n, sizeof(json) - n, ",\"batt_pct\":%d,\"accel\":{\"x\":%.3f,\"y\":%.3f,\"z\":%.3f}",
+                test_batt_percent, test_acc_x, test_acc_y, test_acc_z);
+
+  // Link quality from cached state only: WiFi.RSSI() reads the driver,
+  // the CSQ is the one upload_scheduler samples on the loop task
+  if (WiFi.status() == WL_CONNECTED) {
+    n += snprintf(json + n, sizeof(json) - n, ",\"link\":\"wifi\",\"rssi_dbm\":%d,\"csq\":null}", (int)WiFi.RSSI());
+  } else {
+    int16_t csq = sched_csq();
+    if (csq == 99) {
+      n += snprintf(json + n, sizeof(json) - n, ",\"link\":\"%s\",\"rssi_dbm\":null,\"csq\":null}",
+                    modem_isReady() ? "lte" : "none");
+    } else {
+      n += snprintf(json + n, sizeof(json) - n, ",\"link\":\"lte\",\"rssi_dbm\":%d,\"csq\":%d}", -113 + 2 * csq, csq);
+    }
+  }
+
+  // Sensors carry no version, so the ETag hashes the document minus "ts":
+  // a poller gets 304 until a reading (at its printed precision) changes
+  char etag[12];
+  snprintf(etag, sizeof(etag), "\"%08lx\"", (unsigned long)api_fnv1a(json + tsLen, n - tsLen));
+  if (http_notModified(req, etag)) return ESP_OK;
+  return http_sendJson(req, json, n);
+}
+
+// ---------------------------------------------------------
+// History: tsdb_queryPage() pages -> chunked JSON
+// ---------------------------------------------------------
+struct ApiHistoryOut {
+  httpd_req_t *req;
+  size_t len;
+  uint32_t count;
+  uint32_t next;               // ts of the first point not sent, 0 = complete
+  bool failed;                 // client gone, stop reading the card
+};
+
+// One buffer for every request: handlers run one at a time on the httpd task
+static char s_chunk[API_CHUNK_BYTES];
+static TsdbRollup s_page[API_PAGE_POINTS];
+
+static bool api_flush(ApiHistoryOut &o) {
+  if (o.len && httpd_resp_send_chunk(o.req, s_chunk, o.len) != ESP_OK) o.failed = true;
+  o.len = 0;
+  return !o.failed;
+}
+
+// v: a CH_COUNT array of a packed TsdbRollup, copied out byte-wise
+static void api_appendValues(ApiHistoryOut &o, const void *v) {
+  TelemetrySample tmp;
+  memcpy(tmp.v, v, sizeof(tmp.v));
+  s_chunk[o.len++] = '[';
+  for (uint8_t c = 0; c < CH_COUNT; ++c) {
+    o.len += snprintf(s_chunk + o.len, sizeof(s_chunk) - o.len, "%s%.*f", c ? "," : "",
+                      s_decimals[c], sample_value(tmp, (SampleChannel)c));
+  }
+  s_chunk[o.len++] = ']';
+}
+
+// Longest point: ts, n and three arrays of CH_COUNT values
+#define API_POINT_MAX (24 + 3 * (2 + CH_COUNT * 14))
+
+static bool api_historyPoint(const TsdbRollup &p, void *ctx) {
+  ApiHistoryOut &o = *(ApiHistoryOut *)ctx;
+  if (o.count >= API_HISTORY_MAX_POINTS) {
+    o.next = p.ts;
+    return false;
+  }
+  if (sizeof(s_chunk) - o.len < API_POINT_MAX && !api_flush(o)) return false;
+  o.len += snprintf(s_chunk + o.len, sizeof(s_chunk) - o.len, "%s[%lu,%u,", o.count ? "," : "",
+                    (unsigned long)p.ts, p.count);
+  api_appendValues(o, p.vmean);
+  s_chunk[o.len++] = ',';
+  api_appendValues(o, p.vmin);
+  s_chunk[o.len++] = ',';
+  api_appendValues(o, p.vmax);
+  s_chunk[o.len++] = ']';
+  o.count++;
+  return true;
+}
+
+static bool api_queryU32(const char *query, const char *key, uint32_t &out) {
+  char val[16];
+  if (!query || !http_formValue(query, key, val, sizeof(val)) || !val[0]) return false;
+  char *end;
+  unsigned long v = strtoul(val, &end, 10);
+  if (*end) return false;
+  out = (uint32_t)v;
+  return true;
+}
+
+static esp_err_t api_handleHistory(httpd_req_t *req) {
+  char query[96];
+  const char *q = httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK ? query : nullptr;
+
+  uint32_t to = 0, from = 0, step = 0;
+  bool hasTo = api_queryU32(q, "to", to);
+  bool hasFrom = api_queryU32(q, "from", from);
+  api_queryU32(q, "step", step);
+  if (!hasTo) {
+    if (!timeManager_isTimeValid()) return http_sendStatus(req, "503 Service Unavailable", "{\"error\":\"clock not set, pass from and to\"}");
+    to = (uint32_t)time(nullptr);
+  }
+  if (!hasFrom) from = to > 86400 ? to - 86400 : 0;
+  if (to < from) return http_sendStatus(req, "400 Bad Request", "{\"error\":\"to < from\"}");
+  if (to - from > API_HISTORY_MAX_SPAN_S) {
+    return http_sendStatus(req, "400 Bad Request", "{\"error\":\"range longer than the stored history\"}");
+  }
+
+  httpd_resp_set_type(req, "application/json; charset=utf-8");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+
+  ApiHistoryOut o = { req, 0, 0, 0, false };
+  o.len = snprintf(s_chunk, sizeof(s_chunk), "{\"from\":%lu,\"to\":%lu,\"step\":%lu,\"channels\":[",
+                   (unsigned long)from, (unsigned long)to, (unsigned long)step);
+  for (uint8_t c = 0; c < CH_COUNT; ++c) {
+    o.len += snprintf(s_chunk + o.len, sizeof(s_chunk) - o.len, "%s\"%s\"", c ? "," : "",
+                      sample_channelName((SampleChannel)c));
+  }
+  o.len += strlcpy(s_chunk + o.len, "],\"points\":[", sizeof(s_chunk) - o.len);
+
+  // The card is locked only while a page is read, never while it is sent
+  uint32_t cursor = 0;
+  bool more = true;
+  do {
+    uint16_t n = tsdb_queryPage(from, to, step, cursor, s_page, API_PAGE_POINTS);
+    for (uint16_t k = 0; k < n && more; ++k) more = api_historyPoint(s_page[k], &o);
+  } while (more && cursor);
+  if (o.failed) return ESP_FAIL;           // drops the connection
+  if (sizeof(s_chunk) - o.len < 64 && !api_flush(o)) return ESP_FAIL;
+
+  if (o.next) o.len += snprintf(s_chunk + o.len, sizeof(s_chunk) - o.len, "],\"count\":%lu,\"next\":%lu}",
+                                (unsigned long)o.count, (unsigned long)o.next);
+  else        o.len += snprintf(s_chunk + o.len, sizeof(s_chunk) - o.len, "],\"count\":%lu,\"next\":null}",
+                                (unsigned long)o.count);
+  if (!api_flush(o)) return ESP_FAIL;
+  return httpd_resp_send_chunk(req, nullptr, 0);
+}
+
+void api_endpoint_init() {
+  http_on("/api/v1/current", HTTP_GET, api_handleCurrent);
+  http_on("/api/v1/history", HTTP_GET, api_handleHistory);
+}
@@ -0,0 +1,42 @@
+#ifndef API_ENDPOINT_H
+#define API_ENDPOINT_H
+
+#include <Arduino.h>
+
+// Machine-readable telemetry on the shared web server (http_server.h).
+//
+// GET /api/v1/current
+//   {"ts":<epoch|null>,"time_source":"wifi",
+//    "weight":kg,"temp_int":C,"hum_int":%,"temp_ext":C,"hum_ext":%,
+//    "pressure":hPa,"batt":V,"batt_pct":N,"accel":{"x":..,"y":..,"z":..},
+//    "link":"wifi"|"lte"|"none","rssi_dbm":N|null,"csq":N|null}
+//   Values come from the sensor globals and cached link state; the modem
+//   is never queried from the web server task. The ETag hashes everything
+//   but "ts", so If-None-Match gets 304 while the readings are unchanged.
+//
+// GET /api/v1/history?from=<epoch>&to=<epoch>&step=<s>
+//   Points from the SD time-series store (tsdb.h), sent with chunked
+//   transfer encoding from one fixed buffer:
+//   {"from":F,"to":T,"step":S,"channels":["weight",...],
+//    "points":[[ts,n,[mean...],[min...],[max...]],...],"count":N,"next":ts|null}
+//   Defaults: to = now, from = to - 24 h, step = 0 (stored resolution).
+//   At most API_HISTORY_MAX_POINTS points per response; "next" is the
+//   from= of the following page. Points are read API_PAGE_POINTS at a time
+//   and sent with the SD card unlocked, so a slow client never holds up
+//   other SD users. Ranges longer than the stored history are refused.
+
+#ifndef API_HISTORY_MAX_POINTS
+#define API_HISTORY_MAX_POINTS 500
+#endif
+
+#ifndef API_PAGE_POINTS
+#define API_PAGE_POINTS 16
+#endif
+
+#define API_HISTORY_MAX_SPAN_S ((TSDB_ROLLUP_DAYS + 1) * 86400UL)
+
+#define API_CHUNK_BYTES 1024
+
+void api_endpoint_init();      // registers /api/v1/*
+
+#endif // API_ENDPOINT_H
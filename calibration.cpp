@@ -1,5 +1,5 @@
 #include "calibration.h"
-#include <Preferences.h>
+#include "settings.h"
 
 #if HAVE_HX711
   #include <HX711.h>
@@ -29,13 +29,10 @@ void calib_init() {
   #endif
 #endif
 
-  Preferences p;
-  if (p.begin(CALIB_PREF_NS, true)) {
-    g_saved_factor = p.getFloat("factor", 0.0f);
-    g_saved_offset = p.getLong("offset", 0);
-    g_saved_known  = p.getInt("known", 0);
-    p.end();
-  }
+  const Settings &cfg = settings();
+  g_saved_factor = cfg.calFactor;
+  g_saved_offset = cfg.calOffset;
+  g_saved_known  = cfg.calKnownGrams;
 
   #if ENABLE_DEBUG
     Serial.print(F("[CALIB] loaded factor="));
@@ -100,17 +97,12 @@ float calib_computeFactorFromKnownWeight(long raw_at_weight, long offset, float
 }
 
 bool calib_saveFactor(float factor, long offset, int known_grams) {
-  Preferences p;
-  if (!p.begin(CALIB_PREF_NS, false)) {
+  if (!settings_setCalibration(factor, offset, known_grams)) {
     #if ENABLE_DEBUG
-      Serial.println(F("[CALIB] Preferences begin failed"));
+      Serial.println(F("[CALIB] settings write failed"));
     #endif
     return false;
   }
-  p.putFloat("factor", factor);
-  p.putLong("offset", offset);
-  p.putInt("known", known_grams);
-  p.end();
 
   g_saved_factor = factor;
   g_saved_offset = offset;
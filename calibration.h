@@ -16,8 +16,6 @@
   #define HAVE_HX711 0
 #endif
 
-#define CALIB_PREF_NS "calib_ns"
-
 #ifndef CALIB_SAMPLES
   #define CALIB_SAMPLES 20
 #endif
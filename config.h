@@ -15,6 +15,12 @@
 #define ENABLE_DEBUG 1
 #endif
 
+// Loop-stage latency histograms (serial 'perf', GET /perf.json).
+// Set to 0 to compile the instrumentation out entirely.
+#ifndef ENABLE_PERF_STATS
+#define ENABLE_PERF_STATS 1
+#endif
+
 // Timing (microseconds)
 #define MEASUREMENT_INTERVAL  (3600ULL * 1000000ULL)
 
@@ -59,6 +65,15 @@
 #define CONNECTIVITY_WIFI    1
 #define CONNECTIVITY_OFFLINE 2
 
+// Apiary role (gateway.h). A gateway aggregates satellite hives over ESP-NOW
+// and uploads them through its modem; satellites have no modem.
+#define NODE_ROLE_STANDALONE 0
+#define NODE_ROLE_GATEWAY    1
+#define NODE_ROLE_SATELLITE  2
+#ifndef NODE_ROLE
+#define NODE_ROLE NODE_ROLE_STANDALONE
+#endif
+
 // LTE Configuration
 #define MODEM_APN        "internet"
 #define MODEM_GPRS_USER  ""
@@ -87,14 +102,6 @@ extern int connectivityMode;
 // Single global LCD instance is defined in ui.cpp; make it visible to all units.
 extern LiquidCrystal_I2C lcd;
 
-// Safe INIT_SD_CARD macro: initializes SPI pins and SD; ensure backslashes remain at EOL
-#ifndef INIT_SD_CARD
-#define INIT_SD_CARD() do { \
-    SPI.begin(SD_SCLK, SD_MISO, SD_MOSI, SD_CS); \
-    SD.begin(SD_CS); \
-} while(0)
-#endif
-
 #ifndef DEGREE_SYMBOL_UTF
 // UTF-8 degree sign for Serial / web clients
 #define DEGREE_SYMBOL_UTF "\xC2\xB0"
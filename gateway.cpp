@@ -0,0 +1,602 @@
+// gateway.cpp - ESP-NOW satellite/gateway aggregation for multi-hive apiaries.
+
+#include "gateway.h"
+
+#if NODE_ROLE != NODE_ROLE_STANDALONE
+
+#include "sample_codec.h"
+#include "thingspeak_client.h"
+#include "modem_manager.h"
+#include "time_manager.h"
+#include "sd_storage.h"
+#include <WiFi.h>
+#include <Preferences.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <time.h>
+
+#define GW_MAGIC_DATA    0xB7
+#define GW_MAGIC_ACK     0xB8
+#define GW_VERSION       2
+#define GW_PKT_MAX       250          // ESP_NOW_MAX_DATA_LEN
+#define GW_RX_QUEUE_LEN  8
+#define GW_SAT_RETRY_MS  (30UL * 1000UL)
+#define GW_PREFS_NS      "gateway"
+#define GW_MIN_VALID_TS  1600000000UL
+#define GW_JOURNAL_DIR   "/gw"
+#define GW_JOURNAL       GW_JOURNAL_DIR "/ring.q"
+#define GW_JOURNAL_NEW   GW_JOURNAL_DIR "/ring.new"
+#define GW_JOURNAL_SYNC  0xA5
+
+// Satellite -> gateway: header, then count x [len][sample_codec frame].
+// The first frame is a keyframe, the rest are deltas within the packet,
+// so a lost packet never breaks the decoding of the next one.
+// Every sample has a number (first + i) that survives retransmission;
+// the gateway drops numbers it has already taken from the same boot.
+struct GwDataHdr {
+  uint8_t  magic;
+  uint8_t  version;
+  uint8_t  node;
+  uint8_t  seq;                       // packet, echoed in the ack
+  uint8_t  count;
+  uint8_t  behind;                    // newer samples still in the backlog
+  uint16_t boot;                      // random per satellite boot
+  uint32_t first;                     // number of the first sample
+} __attribute__((packed));
+
+// Gateway -> satellite, unicast to the sender
+struct GwAck {
+  uint8_t  magic;
+  uint8_t  version;
+  uint8_t  node;
+  uint8_t  seq;
+  uint32_t gwTime;                    // gateway UTC epoch, 0 if its clock is not set
+} __attribute__((packed));
+
+// The receive callback runs in the WiFi task: packets are copied into a
+// queue and handled by gateway_loop().
+struct GwRx {
+  uint8_t mac[6];
+  uint8_t len;
+  uint8_t data[GW_PKT_MAX];
+};
+
+static const uint8_t kBroadcast[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+static QueueHandle_t s_rxQueue = nullptr;
+static volatile uint32_t s_rxDropped = 0;
+static bool s_ready = false;
+
+static void gw_onRecvRaw(const uint8_t *mac, const uint8_t *data, int len) {
+  if (!s_rxQueue || len <= 0 || len > GW_PKT_MAX) return;
+  GwRx rx;
+  memcpy(rx.mac, mac, 6);
+  rx.len = (uint8_t)len;
+  memcpy(rx.data, data, len);
+  if (xQueueSend(s_rxQueue, &rx, 0) != pdTRUE) s_rxDropped++;
+}
+
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+static void gw_onRecv(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
+  gw_onRecvRaw(info->src_addr, data, len);
+}
+#else
+static void gw_onRecv(const uint8_t *mac, const uint8_t *data, int len) {
+  gw_onRecvRaw(mac, data, len);
+}
+#endif
+
+static bool gw_addPeer(const uint8_t *mac) {
+  if (esp_now_is_peer_exist(mac)) return true;
+  esp_now_peer_info_t peer;
+  memset(&peer, 0, sizeof(peer));
+  memcpy(peer.peer_addr, mac, 6);
+  peer.channel = 0;                   // whatever channel the radio is on
+  peer.ifidx = WIFI_IF_STA;
+  peer.encrypt = false;
+  return esp_now_add_peer(&peer) == ESP_OK;
+}
+
+#if NODE_ROLE == NODE_ROLE_SATELLITE
+// =====================================================================
+// Satellite
+// =====================================================================
+static uint8_t  s_nodeId = 0;
+static TelemetrySample s_backlog[GW_SAT_BACKLOG];
+static uint8_t  s_blHead = 0;
+static uint8_t  s_blCount = 0;
+static uint32_t s_blFirst = 0;        // number of the sample at s_blHead
+static uint16_t s_boot = 0;
+static uint8_t  s_seq = 0;
+static uint8_t  s_inFlight = 0;       // backlog samples carried by packet s_seq
+static uint8_t  s_gwMac[6];
+static bool     s_gwKnown = false;    // learnt from the first ack, then unicast
+static uint32_t s_sent = 0;
+static uint32_t s_acked = 0;
+static uint32_t s_overflow = 0;
+static unsigned long s_lastSampleMs = 0;
+static unsigned long s_lastSendMs = 0;
+static bool     s_sampledOnce = false;
+
+static void sat_push(const TelemetrySample &s) {
+  if (s_blCount == GW_SAT_BACKLOG) {
+    // gateway unreachable for a long time: drop the oldest
+    s_blHead = (s_blHead + 1) % GW_SAT_BACKLOG;
+    s_blCount--;
+    s_blFirst++;
+    if (s_inFlight) s_inFlight--;
+    s_overflow++;
+  }
+  s_backlog[(s_blHead + s_blCount) % GW_SAT_BACKLOG] = s;
+  s_blCount++;
+}
+
+static void sat_send() {
+  if (!s_blCount) return;
+  uint8_t pkt[GW_PKT_MAX];
+  GwDataHdr h = { GW_MAGIC_DATA, GW_VERSION, s_nodeId, ++s_seq, 0, 0, s_boot, s_blFirst };
+  size_t pos = sizeof(h);
+  SampleEncoder enc;
+  sample_encoderReset(enc);
+  uint8_t n = 0;
+  while (n < s_blCount) {
+    uint8_t frame[SAMPLE_FRAME_MAX];
+    size_t len = sample_encodeNext(enc, s_backlog[(s_blHead + n) % GW_SAT_BACKLOG], frame, sizeof(frame));
+    if (!len || pos + 1 + len > sizeof(pkt)) break;
+    pkt[pos++] = (uint8_t)len;
+    memcpy(pkt + pos, frame, len);
+    pos += len;
+    n++;
+  }
+  h.count = n;
+  h.behind = s_blCount - n;
+  memcpy(pkt, &h, sizeof(h));
+  s_inFlight = n;
+  s_lastSendMs = millis();
+  if (esp_now_send(s_gwKnown ? s_gwMac : kBroadcast, pkt, pos) == ESP_OK) s_sent += n;
+}
+
+static void sat_onAck(const GwRx &rx) {
+  GwAck a;
+  if (rx.len < sizeof(a)) return;
+  memcpy(&a, rx.data, sizeof(a));
+  if (a.version != GW_VERSION || a.node != s_nodeId) return;
+
+  if (!s_gwKnown) {
+    memcpy(s_gwMac, rx.mac, 6);
+    s_gwKnown = gw_addPeer(s_gwMac);
+  }
+  // Adopt the gateway clock unless we have a better source (WiFi NTP / LTE)
+  if (a.gwTime >= GW_MIN_VALID_TS &&
+      (!timeManager_isTimeValid() || timeManager_getSource() == TSRC_GATEWAY)) {
+    long skew = (long)a.gwTime - (long)time(nullptr);
+    if (!timeManager_isTimeValid() || skew > 2 || skew < -2) timeManager_setExternal(a.gwTime);
+  }
+  if (a.seq != s_seq || !s_inFlight) return;      // stale ack
+
+  s_blHead = (s_blHead + s_inFlight) % GW_SAT_BACKLOG;
+  s_blCount -= s_inFlight;
+  s_blFirst += s_inFlight;
+  s_acked += s_inFlight;
+  s_inFlight = 0;
+  if (s_blCount) sat_send();                      // rest of the backlog
+}
+
+static void sat_loop() {
+  unsigned long now = millis();
+  if (!s_sampledOnce || now - s_lastSampleMs >= GW_SAT_INTERVAL_S * 1000UL) {
+    s_sampledOnce = true;
+    s_lastSampleMs = now;
+    TelemetrySample s;
+    sample_capture(s);
+    sat_push(s);
+    sat_send();
+  } else if (s_blCount && now - s_lastSendMs >= GW_SAT_RETRY_MS) {
+    sat_send();
+  }
+}
+
+#else
+// =====================================================================
+// Gateway
+// =====================================================================
+struct GwNode {
+  uint8_t  id;                        // 0 = free slot
+  uint8_t  mac[6];
+  uint32_t channelId;                 // 0 = no ThingSpeak channel configured
+  char     key[20];
+  uint16_t boot;                      // satellite boot the numbers belong to
+  uint32_t nextSample;                // first sample number not taken yet
+  uint32_t rx;
+  uint32_t dup;
+  uint32_t uploaded;
+  unsigned long lastSeenMs;
+};
+
+struct GwEntry {
+  uint8_t node;                       // 0 = uploaded, removed by gw_ringCompact()
+  TelemetrySample s;
+} __attribute__((packed));
+
+// Journal record: every acked sample is on SD before its ack goes out
+struct GwRecord {
+  uint8_t  sync;
+  GwEntry  e;
+  uint16_t crc;                       // CRC-16 of e
+} __attribute__((packed));
+
+static GwNode   s_nodes[GW_MAX_NODES];
+static GwEntry  s_ring[GW_RING_LEN];
+static uint16_t s_ringHead = 0;
+static uint16_t s_ringCount = 0;
+static uint32_t s_ringFull = 0;       // packets not acked: no room in the ring
+static uint32_t s_noClock = 0;        // packets not acked: untimed samples, no clock here
+static uint32_t s_journalErrors = 0;  // samples acked from RAM only (no SD)
+static uint32_t s_unconfigured = 0;
+static uint32_t s_sessions = 0;       // upload rounds (one LTE session each)
+static uint32_t s_requests = 0;       // bulk_update requests
+static unsigned long s_lastUploadMs = 0;
+
+static GwNode *gw_node(uint8_t id, bool create) {
+  GwNode *freeSlot = nullptr;
+  for (int i = 0; i < GW_MAX_NODES; ++i) {
+    if (s_nodes[i].id == id) return &s_nodes[i];
+    if (!s_nodes[i].id && !freeSlot) freeSlot = &s_nodes[i];
+  }
+  if (!create || !freeSlot) return nullptr;
+
+  memset(freeSlot, 0, sizeof(*freeSlot));
+  freeSlot->id = id;
+  char k[8];
+  Preferences p;
+  p.begin(GW_PREFS_NS, true);
+  snprintf(k, sizeof(k), "c%u", id);
+  freeSlot->channelId = p.getUInt(k, 0);
+  snprintf(k, sizeof(k), "k%u", id);
+  String key = p.getString(k, "");
+  p.end();
+  strncpy(freeSlot->key, key.c_str(), sizeof(freeSlot->key) - 1);
+  return freeSlot;
+}
+
+// The caller checks for room: an acked sample is never overwritten
+static void gw_ringPush(uint8_t node, const TelemetrySample &s) {
+  GwEntry &e = s_ring[(s_ringHead + s_ringCount) % GW_RING_LEN];
+  e.node = node;
+  e.s = s;
+  s_ringCount++;
+}
+
+static void gw_ringCompact() {
+  uint16_t w = 0;
+  for (uint16_t i = 0; i < s_ringCount; ++i) {
+    GwEntry &e = s_ring[(s_ringHead + i) % GW_RING_LEN];
+    if (!e.node) continue;
+    if (w != i) s_ring[(s_ringHead + w) % GW_RING_LEN] = e;
+    w++;
+  }
+  s_ringCount = w;
+}
+
+// ---------------------------------------------------------
+// SD journal of the ring
+// ---------------------------------------------------------
+// GW_JOURNAL holds the pending samples; new ones are appended before they
+// are acked, and after an upload round the rest is written to
+// GW_JOURNAL_NEW, which then replaces it. A reboot loads whichever is
+// complete, so an acked sample is uploaded at least once (twice if the
+// power goes between an upload and the rewrite).
+
+// CRC-16/CCITT-FALSE
+static uint16_t gw_crc16(const uint8_t *p, size_t n) {
+  uint16_t crc = 0xFFFF;
+  while (n--) {
+    crc ^= (uint16_t)(*p++) << 8;
+    for (int i = 0; i < 8; ++i) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+  }
+  return crc;
+}
+
+static bool gw_journalWrite(File &f, uint16_t from, uint16_t count) {
+  for (uint16_t i = 0; i < count; ++i) {
+    GwRecord r;
+    r.sync = GW_JOURNAL_SYNC;
+    r.e = s_ring[(s_ringHead + from + i) % GW_RING_LEN];
+    r.crc = gw_crc16((const uint8_t*)&r.e, sizeof(r.e));
+    if (sd_write(f, (const uint8_t*)&r, sizeof(r)) != sizeof(r)) return false;
+  }
+  return true;
+}
+
+// Append ring entries [from, from + count)
+static bool gw_journalAppend(uint16_t from, uint16_t count) {
+  SdLock lk;
+  if (!lk) return false;
+  File f = SD.open(GW_JOURNAL, FILE_APPEND);
+  if (!f) {
+    sd_noteError(GW_JOURNAL);
+    return false;
+  }
+  bool ok = gw_journalWrite(f, from, count);
+  f.close();
+  return ok;
+}
+
+static void gw_journalRewrite() {
+  SdLock lk;
+  if (!lk) return;
+  File f = SD.open(GW_JOURNAL_NEW, FILE_WRITE);
+  if (!f) {
+    sd_noteError(GW_JOURNAL_NEW);
+    return;
+  }
+  bool ok = gw_journalWrite(f, 0, s_ringCount);
+  f.close();
+  if (!ok) {
+    SD.remove(GW_JOURNAL_NEW);        // the old journal stays authoritative
+    return;
+  }
+  SD.remove(GW_JOURNAL);
+  if (!SD.rename(GW_JOURNAL_NEW, GW_JOURNAL)) sd_noteError(GW_JOURNAL);
+}
+
+// Reload the ring after a reboot; a torn tail record is cut off
+static void gw_journalLoad() {
+  SdLock lk;
+  if (!lk) return;
+  if (!SD.exists(GW_JOURNAL_DIR) && !SD.mkdir(GW_JOURNAL_DIR)) {
+    sd_noteError(GW_JOURNAL_DIR);
+    return;
+  }
+  if (SD.exists(GW_JOURNAL)) SD.remove(GW_JOURNAL_NEW);       // rewrite interrupted
+  else if (SD.exists(GW_JOURNAL_NEW)) SD.rename(GW_JOURNAL_NEW, GW_JOURNAL);
+
+  File f = SD.open(GW_JOURNAL, FILE_READ);
+  if (!f) return;
+  uint32_t size = f.size(), good = 0;
+  GwRecord r;
+  while (s_ringCount < GW_RING_LEN && f.read((uint8_t*)&r, sizeof(r)) == sizeof(r)) {
+    if (r.sync != GW_JOURNAL_SYNC || r.crc != gw_crc16((const uint8_t*)&r.e, sizeof(r.e)) || !r.e.node) break;
+    gw_ringPush(r.e.node, r.e.s);
+    good += sizeof(r);
+  }
+  f.close();
+  if (size > good) {
+    Serial.printf("[GW] dropping %lu byte torn journal tail\n", (unsigned long)(size - good));
+    sd_truncate(GW_JOURNAL, good);
+  }
+  if (s_ringCount) Serial.printf("[GW] %u pending samples reloaded from SD\n", (unsigned)s_ringCount);
+}
+
+static void gw_onData(const GwRx &rx) {
+  GwDataHdr h;
+  if (rx.len < sizeof(h)) return;
+  memcpy(&h, rx.data, sizeof(h));
+  if (h.version != GW_VERSION || h.node == 0 || h.node == 0xFF) return;
+  GwNode *n = gw_node(h.node, true);
+  if (!n) return;                     // node table full
+  memcpy(n->mac, rx.mac, 6);
+  n->lastSeenMs = millis();
+  // Nowhere to upload: no ack, so the satellite keeps its samples until
+  // 'gw node' configures a channel
+  if (!n->channelId) {
+    s_unconfigured += h.count;
+    return;
+  }
+  if (h.boot != n->boot) {            // satellite restarted its numbering
+    n->boot = h.boot;
+    n->nextSample = 0;
+  }
+
+  // Check the whole packet first: a malformed one is not acked and comes again
+  bool clockOk = timeManager_isTimeValid();
+  SampleDecoder dec;
+  TelemetrySample s;
+  sample_decoderReset(dec);
+  size_t pos = sizeof(h);
+  uint8_t i = 0;
+  uint16_t fresh = 0;
+  bool untimed = false;
+  for (; i < h.count && pos < rx.len; ++i) {
+    size_t len = rx.data[pos++];
+    if (pos + len > rx.len || sample_decodeNext(dec, rx.data + pos, len, s) != len) break;
+    pos += len;
+    if (h.first + i < n->nextSample) continue;
+    fresh++;
+    if (!s.ts) untimed = true;
+  }
+  if (i != h.count) return;
+  // Not acked, so the satellite keeps them: samples neither node can date
+  // (ThingSpeak rejects an entry without created_at), or no room left
+  if (untimed && !clockOk) {
+    s_noClock++;
+    return;
+  }
+  if (fresh > GW_RING_LEN - s_ringCount) {
+    s_ringFull++;
+    return;
+  }
+
+  uint32_t now = (uint32_t)time(nullptr);
+  uint16_t from = s_ringCount;
+  sample_decoderReset(dec);
+  pos = sizeof(h);
+  for (i = 0; i < h.count; ++i) {
+    size_t len = rx.data[pos++];
+    sample_decodeNext(dec, rx.data + pos, len, s);
+    pos += len;
+    if (h.first + i < n->nextSample) { n->dup++; continue; }
+    // satellite has no clock yet: one interval per sample back from its newest
+    if (!s.ts) s.ts = now - (uint32_t)(h.count - 1 - i + h.behind) * GW_SAT_INTERVAL_S;
+    n->rx++;
+    gw_ringPush(h.node, s);
+  }
+  if (h.first + h.count > n->nextSample) n->nextSample = h.first + h.count;
+  // Without a card the samples are still acked; they then live in RAM only
+  if (s_ringCount > from && !gw_journalAppend(from, s_ringCount - from)) s_journalErrors += s_ringCount - from;
+
+  GwAck a = { GW_MAGIC_ACK, GW_VERSION, h.node, h.seq, clockOk ? now : 0 };
+  if (gw_addPeer(rx.mac)) esp_now_send(rx.mac, (const uint8_t*)&a, sizeof(a));
+}
+
+// Upload one bulk_update for node n. Returns false if the request failed.
+static bool gw_uploadNode(GwNode &n, uint16_t &cursor) {
+  uint16_t idx[GW_BULK_MAX];
+  uint8_t cnt = 0;
+  String json;
+  json.reserve(64 + GW_BULK_MAX * 180);
+  json = "{\"write_api_key\":\"";
+  json += n.key;
+  json += "\",\"updates\":[";
+  for (; cursor < s_ringCount && cnt < GW_BULK_MAX; ++cursor) {
+    uint16_t k = (s_ringHead + cursor) % GW_RING_LEN;
+    if (s_ring[k].node != n.id) continue;
+    if (cnt) json += ",";
+    json += thingspeak_bulkEntry(s_ring[k].s);
+    idx[cnt++] = k;
+  }
+  json += "]}";
+  if (!cnt) return true;
+
+  s_requests++;
+  if (!thingspeak_bulk_via_modem(n.channelId, json)) return false;
+  for (uint8_t i = 0; i < cnt; ++i) s_ring[idx[i]].node = 0;
+  n.uploaded += cnt;
+  return true;
+}
+
+static void gw_upload() {
+  s_lastUploadMs = millis();
+  if (!s_ringCount) return;
+  if (!modem_isNetworkRegistered()) {
+    Serial.printf("[GW] %u samples pending, modem not registered\n", (unsigned)s_ringCount);
+    return;
+  }
+  s_sessions++;
+  bool ok = true;
+  for (int i = 0; i < GW_MAX_NODES && ok; ++i) {
+    GwNode &n = s_nodes[i];
+    if (!n.id || !n.channelId) continue;
+    uint16_t cursor = 0;
+    while (ok && cursor < s_ringCount) ok = gw_uploadNode(n, cursor);
+  }
+  uint16_t before = s_ringCount;
+  gw_ringCompact();
+  if (s_ringCount != before) gw_journalRewrite();
+  Serial.printf("[GW] upload %s, %u samples pending\n", ok ? "OK" : "FAILED", (unsigned)s_ringCount);
+}
+
+bool gateway_setNode(uint8_t node, uint32_t channelId, const char *writeKey) {
+  if (node == 0 || node == 0xFF || !writeKey) return false;
+  char k[8];
+  Preferences p;
+  p.begin(GW_PREFS_NS, false);
+  snprintf(k, sizeof(k), "c%u", node);
+  if (writeKey[0]) p.putUInt(k, channelId);
+  else p.remove(k);
+  snprintf(k, sizeof(k), "k%u", node);
+  if (writeKey[0]) p.putString(k, writeKey);
+  else p.remove(k);
+  p.end();
+
+  GwNode *n = gw_node(node, true);
+  if (n) {
+    n->channelId = writeKey[0] ? channelId : 0;
+    strncpy(n->key, writeKey, sizeof(n->key) - 1);
+    n->key[sizeof(n->key) - 1] = 0;
+  }
+  return true;
+}
+#endif // NODE_ROLE
+
+// =====================================================================
+// Common
+// =====================================================================
+void gateway_restoreChannel() {
+  if (s_ready && WiFi.status() != WL_CONNECTED) esp_wifi_set_channel(GW_ESPNOW_CHANNEL, WIFI_SECOND_CHAN_NONE);
+}
+
+void gateway_init() {
+  s_rxQueue = xQueueCreate(GW_RX_QUEUE_LEN, sizeof(GwRx));
+  if (WiFi.getMode() == WIFI_OFF) WiFi.mode(WIFI_STA);
+  if (WiFi.status() != WL_CONNECTED) esp_wifi_set_channel(GW_ESPNOW_CHANNEL, WIFI_SECOND_CHAN_NONE);
+  if (!s_rxQueue || esp_now_init() != ESP_OK) {
+    Serial.println(F("[GW] ESP-NOW init failed"));
+    return;
+  }
+  esp_now_register_recv_cb(gw_onRecv);
+  s_ready = true;
+
+#if NODE_ROLE == NODE_ROLE_SATELLITE
+  uint8_t mac[6];
+  WiFi.macAddress(mac);
+  s_nodeId = GW_NODE_ID ? GW_NODE_ID : mac[5];
+  s_boot = (uint16_t)esp_random();
+  if (s_nodeId == 0 || s_nodeId == 0xFF) s_nodeId = 1;
+  gw_addPeer(kBroadcast);
+  Serial.printf("[GW] satellite node %u on channel %d\n", s_nodeId, GW_ESPNOW_CHANNEL);
+#else
+  s_lastUploadMs = millis();
+  gw_journalLoad();
+  Serial.printf("[GW] gateway on channel %d\n", GW_ESPNOW_CHANNEL);
+#endif
+}
+
+void gateway_loop() {
+  if (!s_ready) return;
+  GwRx rx;
+  while (xQueueReceive(s_rxQueue, &rx, 0) == pdTRUE) {
+#if NODE_ROLE == NODE_ROLE_SATELLITE
+    if (rx.data[0] == GW_MAGIC_ACK) sat_onAck(rx);
+#else
+    if (rx.data[0] == GW_MAGIC_DATA) gw_onData(rx);
+#endif
+  }
+#if NODE_ROLE == NODE_ROLE_SATELLITE
+  sat_loop();
+#else
+  if (s_ringCount >= GW_BATCH_TRIGGER || millis() - s_lastUploadMs >= GW_UPLOAD_INTERVAL_S * 1000UL) gw_upload();
+#endif
+}
+
+void gateway_print(Print &out) {
+#if NODE_ROLE == NODE_ROLE_SATELLITE
+  out.printf("[GW] satellite %u, ESP-NOW %s, gateway %s\n", s_nodeId, s_ready ? "up" : "DOWN",
+             s_gwKnown ? "known" : "not seen yet");
+  out.printf("[GW] backlog %u/%u, sent %lu, acked %lu, overflow %lu, rx dropped %lu\n",
+             (unsigned)s_blCount, (unsigned)GW_SAT_BACKLOG, (unsigned long)s_sent,
+             (unsigned long)s_acked, (unsigned long)s_overflow, (unsigned long)s_rxDropped);
+#else
+  out.printf("[GW] gateway, ESP-NOW %s, pending %u/%u, unconfigured %lu, rx dropped %lu\n",
+             s_ready ? "up" : "DOWN", (unsigned)s_ringCount, (unsigned)GW_RING_LEN,
+             (unsigned long)s_unconfigured, (unsigned long)s_rxDropped);
+  out.printf("[GW] not acked: ring full %lu, no clock %lu; acked without SD %lu\n", (unsigned long)s_ringFull,
+             (unsigned long)s_noClock, (unsigned long)s_journalErrors);
+  out.printf("[GW] upload sessions %lu, bulk requests %lu\n", (unsigned long)s_sessions, (unsigned long)s_requests);
+  for (int i = 0; i < GW_MAX_NODES; ++i) {
+    const GwNode &n = s_nodes[i];
+    if (!n.id) continue;
+    out.printf("  node %3u ch %-8lu rx %-6lu dup %-4lu up %-6lu seen %lus ago\n", n.id,
+               (unsigned long)n.channelId, (unsigned long)n.rx, (unsigned long)n.dup,
+               (unsigned long)n.uploaded, (millis() - n.lastSeenMs) / 1000UL);
+  }
+#endif
+}
+
+#if NODE_ROLE == NODE_ROLE_SATELLITE
+bool gateway_setNode(uint8_t, uint32_t, const char *) {
+  return false;
+}
+#endif
+
+#else  // NODE_ROLE_STANDALONE
+
+void gateway_init() {}
+void gateway_loop() {}
+void gateway_restoreChannel() {}
+bool gateway_setNode(uint8_t, uint32_t, const char *) { return false; }
+void gateway_print(Print &out) { out.println(F("[GW] standalone node (NODE_ROLE 0)")); }
+
+#endif // NODE_ROLE != NODE_ROLE_STANDALONE
@@ -0,0 +1,78 @@
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "telemetry_sample.h"
+
+// Apiary aggregation over ESP-NOW (NODE_ROLE in config.h).
+//
+// Satellite: no modem. Every GW_SAT_INTERVAL_S it captures a sample and
+// sends it, together with any unacknowledged backlog, to the gateway as
+// sample_codec frames. The gateway's ack also carries its clock, so a
+// satellite without WiFi/LTE still timestamps its samples.
+//
+// Gateway: collects satellite samples in a RAM ring, journaled on SD
+// (/gw) so a reboot keeps them, and every GW_UPLOAD_INTERVAL_S (or once
+// GW_BATCH_TRIGGER samples are pending) uploads them with one ThingSpeak
+// bulk_update per hive over the modem, so the apiary opens one LTE session
+// per interval instead of one per hive and sample. Its own hive keeps using
+// the normal upload path. A packet is acked only once its samples are in
+// the ring and the journal; while the ring is full, or while neither node
+// has a clock to date them, the satellite keeps its backlog.
+// Each satellite's ThingSpeak channel id and write key live in NVS
+// (namespace "gateway"), set with the serial command 'gw node'. Packets from
+// a satellite without a channel are not acked, so it keeps its backlog.
+//
+// ESP-NOW shares the WiFi radio: all nodes must be on GW_ESPNOW_CHANNEL,
+// which is the AP's channel if the gateway is also associated to WiFi.
+
+#ifndef GW_ESPNOW_CHANNEL
+#define GW_ESPNOW_CHANNEL 1
+#endif
+
+#ifndef GW_NODE_ID
+#define GW_NODE_ID 0                 // satellite id 1..254, 0 = low byte of the MAC
+#endif
+
+#ifndef GW_SAT_INTERVAL_S
+#define GW_SAT_INTERVAL_S 300
+#endif
+
+#ifndef GW_SAT_BACKLOG
+#define GW_SAT_BACKLOG 16            // samples a satellite keeps while the gateway is away
+#endif
+
+#ifndef GW_MAX_NODES
+#define GW_MAX_NODES 32
+#endif
+
+#ifndef GW_RING_LEN
+#define GW_RING_LEN 256              // pending satellite samples on the gateway (and on SD)
+#endif
+
+#ifndef GW_UPLOAD_INTERVAL_S
+#define GW_UPLOAD_INTERVAL_S 900
+#endif
+
+#ifndef GW_BATCH_TRIGGER
+#define GW_BATCH_TRIGGER 192         // upload early when the ring is this full
+#endif
+
+#ifndef GW_BULK_MAX
+#define GW_BULK_MAX 24               // entries per bulk_update request
+#endif
+
+void gateway_init();                 // no-op for NODE_ROLE_STANDALONE
+void gateway_loop();
+
+// After the STA association was dropped (LTE takeover) put the radio back
+// on the ESP-NOW channel.
+void gateway_restoreChannel();
+
+// Gateway: map a satellite to its ThingSpeak channel (empty key removes it)
+bool gateway_setNode(uint8_t node, uint32_t channelId, const char *writeKey);
+
+void gateway_print(Print &out);      // serial 'gw'
+
+#endif // GATEWAY_H
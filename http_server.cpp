@@ -0,0 +1,243 @@
+// http_server.cpp - shared esp_http_server instance, route table, form helpers.
+
+#include "http_server.h"
+#include "wifi_manager.h"
+#include "config.h"
+#include <lwip/sockets.h>
+
+struct HttpRoute {
+  const char     *uri;
+  httpd_method_t  method;
+  HttpHandler     handler;
+  uint32_t        hits;
+};
+
+static HttpRoute      s_routes[HTTP_MAX_ROUTES];
+static uint8_t        s_routeCount = 0;
+static httpd_handle_t s_server = nullptr;
+static uint32_t       s_starts = 0;
+static uint32_t       s_requests = 0;
+static volatile int   s_sessions = 0;
+static int            s_maxSessions = 0;
+static uint32_t       s_accepted = 0;
+static uint32_t       s_notModified = 0;
+static HttpCloseListener s_closeListeners[HTTP_MAX_CLOSE_LISTENERS];
+static uint8_t        s_closeListenerCount = 0;
+
+// Every route goes through here for the request counters
+static esp_err_t http_dispatch(httpd_req_t *req) {
+  HttpRoute *r = (HttpRoute *)req->user_ctx;
+  r->hits++;
+  s_requests++;
+  return r->handler(req);
+}
+
+static bool http_register(HttpRoute &r) {
+  httpd_uri_t u = {};
+  u.uri = r.uri;
+  u.method = r.method;
+  u.handler = http_dispatch;
+  u.user_ctx = &r;
+  return httpd_register_uri_handler(s_server, &u) == ESP_OK;
+}
+
+bool http_on(const char *uri, httpd_method_t method, HttpHandler handler) {
+  if (s_routeCount >= HTTP_MAX_ROUTES) {
+    Serial.printf("[HTTP] route table full, %s dropped\n", uri);
+    return false;
+  }
+  HttpRoute &r = s_routes[s_routeCount++];
+  r.uri = uri;
+  r.method = method;
+  r.handler = handler;
+  r.hits = 0;
+  return s_server ? http_register(r) : true;
+}
+
+bool http_onSessionClose(HttpCloseListener cb) {
+  if (s_closeListenerCount >= HTTP_MAX_CLOSE_LISTENERS) return false;
+  s_closeListeners[s_closeListenerCount++] = cb;
+  return true;
+}
+
+static esp_err_t http_sessionOpened(httpd_handle_t, int) {
+  s_accepted++;
+  if (++s_sessions > s_maxSessions) s_maxSessions = s_sessions;
+  return ESP_OK;
+}
+
+// With a close callback installed the server leaves closing the socket to us
+static void http_sessionClosed(httpd_handle_t, int sockfd) {
+  s_sessions--;
+  for (uint8_t i = 0; i < s_closeListenerCount; ++i) s_closeListeners[i](sockfd);
+  close(sockfd);
+}
+
+static bool http_start() {
+  httpd_config_t cfg = HTTPD_DEFAULT_CONFIG();
+  cfg.server_port = HTTP_SERVER_PORT;
+  cfg.max_open_sockets = HTTP_MAX_SOCKETS;
+  cfg.max_uri_handlers = HTTP_MAX_ROUTES;
+  cfg.stack_size = HTTP_TASK_STACK;
+  cfg.lru_purge_enable = true;           // a new client evicts the idlest keep-alive one
+  cfg.uri_match_fn = httpd_uri_match_wildcard;
+  cfg.open_fn = http_sessionOpened;
+  cfg.close_fn = http_sessionClosed;
+
+  s_sessions = 0;
+  if (httpd_start(&s_server, &cfg) != ESP_OK) {
+    s_server = nullptr;
+    Serial.println(F("[HTTP] server start failed"));
+    return false;
+  }
+  for (uint8_t i = 0; i < s_routeCount; ++i) http_register(s_routes[i]);
+  s_starts++;
+#if ENABLE_DEBUG
+  Serial.printf("[HTTP] listening on port %u, %u routes\n", HTTP_SERVER_PORT, s_routeCount);
+#endif
+  return true;
+}
+
+static void http_stop() {
+  if (!s_server) return;
+  httpd_stop(s_server);
+  s_server = nullptr;
+#if ENABLE_DEBUG
+  Serial.println(F("[HTTP] stopped"));
+#endif
+}
+
+void http_loop() {
+  bool up = wifi_isConnected();
+  if (up && !s_server) {
+    static unsigned long lastTry = 0;
+    if (s_starts == 0 || millis() - lastTry > 5000) {
+      lastTry = millis();
+      http_start();
+    }
+  } else if (!up && s_server) {
+    http_stop();
+  }
+}
+
+bool http_isRunning() {
+  return s_server != nullptr;
+}
+
+httpd_handle_t http_handle() {
+  return s_server;
+}
+
+esp_err_t http_sendJson(httpd_req_t *req, const char *json, ssize_t len) {
+  httpd_resp_set_type(req, "application/json; charset=utf-8");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  return httpd_resp_send(req, json, len);
+}
+
+esp_err_t http_sendStatus(httpd_req_t *req, const char *status, const char *json) {
+  httpd_resp_set_status(req, status);
+  if (!json) return httpd_resp_send(req, nullptr, 0);
+  return http_sendJson(req, json);
+}
+
+esp_err_t http_redirect(httpd_req_t *req, const char *location) {
+  httpd_resp_set_status(req, "303 See Other");
+  httpd_resp_set_hdr(req, "Location", location);
+  return httpd_resp_send(req, nullptr, 0);
+}
+
+bool http_notModified(httpd_req_t *req, const char *etag, const char *cacheControl) {
+  httpd_resp_set_hdr(req, "ETag", etag);
+  httpd_resp_set_hdr(req, "Cache-Control", cacheControl);
+  char inm[128];
+  size_t len = httpd_req_get_hdr_value_len(req, "If-None-Match");
+  if (len == 0 || len >= sizeof(inm)) return false;
+  if (httpd_req_get_hdr_value_str(req, "If-None-Match", inm, sizeof(inm)) != ESP_OK) return false;
+  if (strcmp(inm, "*") != 0 && !strstr(inm, etag)) return false;
+  s_notModified++;
+  httpd_resp_set_status(req, "304 Not Modified");
+  httpd_resp_send(req, nullptr, 0);
+  return true;
+}
+
+esp_err_t http_sendAsset(httpd_req_t *req, const WebAsset &asset) {
+  // Pages are revalidated on every load (a 304 costs a few bytes); their
+  // scripts and styles have the hash in the name and never change
+  const char *cache = asset.immutable ? "public, max-age=31536000, immutable" : "no-cache";
+  if (http_notModified(req, asset.etag, cache)) return ESP_OK;
+  // Every browser sends Accept-Encoding: gzip, so only the gzip copy is kept
+  httpd_resp_set_type(req, asset.type);
+  httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+  return httpd_resp_send(req, (const char *)asset.gz, asset.gzLen);
+}
+
+bool http_readForm(httpd_req_t *req, char *buf, size_t size) {
+  if (req->content_len == 0) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing fields");
+    return false;
+  }
+  if (req->content_len >= size) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Form too large");
+    return false;
+  }
+  size_t got = 0;
+  while (got < req->content_len) {
+    int n = httpd_req_recv(req, buf + got, req->content_len - got);
+    if (n == HTTPD_SOCK_ERR_TIMEOUT) continue;
+    if (n <= 0) {
+      httpd_resp_send_err(req, HTTPD_408_REQ_TIMEOUT, nullptr);
+      return false;
+    }
+    got += n;
+  }
+  buf[got] = '\0';
+  return true;
+}
+
+static int http_hex(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+bool http_formValue(const char *form, const char *key, char *out, size_t size) {
+  size_t keyLen = strlen(key);
+  const char *p = form;
+  while (p && *p) {
+    if (strncmp(p, key, keyLen) == 0 && p[keyLen] == '=') {
+      p += keyLen + 1;
+      size_t n = 0;
+      while (*p && *p != '&' && n + 1 < size) {
+        int hi, lo;
+        if (*p == '+') {
+          out[n++] = ' ';
+          p++;
+        } else if (*p == '%' && (hi = http_hex(p[1])) >= 0 && (lo = http_hex(p[2])) >= 0) {
+          out[n++] = (char)(hi << 4 | lo);
+          p += 3;
+        } else {
+          out[n++] = *p++;
+        }
+      }
+      out[n] = '\0';
+      return true;
+    }
+    p = strchr(p, '&');
+    if (p) p++;
+  }
+  if (size) out[0] = '\0';
+  return false;
+}
+
+void http_print(Print &out) {
+  out.printf("[HTTP] %s on port %u, %d/%u sessions (max %d), %lu connections, %lu requests (%lu not modified), %lu starts\n",
+             s_server ? "running" : "stopped", HTTP_SERVER_PORT, (int)s_sessions, HTTP_MAX_SOCKETS, s_maxSessions,
+             (unsigned long)s_accepted, (unsigned long)s_requests, (unsigned long)s_notModified,
+             (unsigned long)s_starts);
+  for (uint8_t i = 0; i < s_routeCount; ++i) {
+    const HttpRoute &r = s_routes[i];
+    out.printf("  %-7s %-20s %lu\n", r.method == HTTP_GET ? "GET" : r.method == HTTP_POST ? "POST" : "OPTIONS",
+               r.uri, (unsigned long)r.hits);
+  }
+}
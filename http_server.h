@@ -0,0 +1,84 @@
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <Arduino.h>
+#include <esp_http_server.h>
+
+// The device's only web server: one ESP-IDF esp_http_server on port 80.
+// It runs in its own task ("httpd") with a select() loop over up to
+// HTTP_MAX_SOCKETS connections, so several browsers / pollers are served
+// at once and HTTP/1.1 keep-alive connections are reused. When every
+// socket is taken the least recently used one is closed.
+//
+// Modules register their routes once with http_on() (key_server.cpp,
+// provisioning_server.cpp, lcd_endpoint.cpp). Handlers run on the httpd
+// task: state written by the loop task must be locked or copied.
+// http_loop() starts the server when WiFi connects and stops it when the
+// station drops (LTE takeover), freeing its task and sockets.
+
+#ifndef HTTP_SERVER_PORT
+#define HTTP_SERVER_PORT 80
+#endif
+
+#ifndef HTTP_MAX_SOCKETS
+#define HTTP_MAX_SOCKETS 7           // lwIP has 10, the server keeps 3 for itself
+#endif
+
+#ifndef HTTP_MAX_ROUTES
+#define HTTP_MAX_ROUTES 24
+#endif
+
+#ifndef HTTP_TASK_STACK
+#define HTTP_TASK_STACK 6144
+#endif
+
+#define HTTP_FORM_MAX 512            // largest accepted form body
+#define HTTP_MAX_CLOSE_LISTENERS 2
+
+
+typedef esp_err_t (*HttpHandler)(httpd_req_t *req);
+typedef void (*HttpCloseListener)(int sockfd);
+
+// A gzip-compressed page from web/, generated into web_assets.cpp by
+// tools/embed_assets.py (the ETag is a hash of the uncompressed content).
+struct WebAsset {
+  const char    *path;
+  const char    *type;
+  const char    *etag;         // quoted, e.g. "\"3f2a...\""
+  const uint8_t *gz;
+  uint32_t       gzLen;
+  bool           immutable;    // content-hashed name under /assets/, cached for a year
+};
+
+// Register a route; "*" at the end of uri matches any suffix.
+bool http_on(const char *uri, httpd_method_t method, HttpHandler handler);
+
+void http_loop();                    // start / stop with the WiFi station
+bool http_isRunning();
+httpd_handle_t http_handle();        // nullptr while stopped
+
+// Called on the httpd task whenever a connection closes (client gone, LRU
+// purge, server stop). For modules that keep sockets open (SSE streams).
+bool http_onSessionClose(HttpCloseListener cb);
+
+// Handler helpers
+esp_err_t http_sendJson(httpd_req_t *req, const char *json, ssize_t len = HTTPD_RESP_USE_STRLEN);
+esp_err_t http_sendStatus(httpd_req_t *req, const char *status, const char *json = nullptr);
+esp_err_t http_redirect(httpd_req_t *req, const char *location);   // 303 See Other
+
+// Conditional GET: sets the ETag and Cache-Control headers (etag must stay
+// valid until the response is sent) and, when If-None-Match matches,
+// answers 304 itself. Returns true if the request is done.
+bool http_notModified(httpd_req_t *req, const char *etag, const char *cacheControl = "no-cache");
+// Embedded file with Content-Encoding: gzip, or 304 when unchanged
+esp_err_t http_sendAsset(httpd_req_t *req, const WebAsset &asset);
+
+// Read an urlencoded form body (NUL-terminated). Returns false and answers
+// the request itself when the body is missing, too large or times out.
+bool http_readForm(httpd_req_t *req, char *buf, size_t size);
+// URL-decoded value of key in a form body / query string
+bool http_formValue(const char *form, const char *key, char *out, size_t size);
+
+void http_print(Print &out);         // serial 'http'
+
+#endif // HTTP_SERVER_H
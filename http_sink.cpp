@@ -0,0 +1,52 @@
+// http_sink.cpp - JSON batch POST telemetry sink (WiFi only).
+
+#include "http_sink.h"
+#include "config.h"
+#include <WiFi.h>
+#include <HTTPClient.h>
+
+static bool http_enabled() {
+  return HTTP_SINK_URL[0] != '\0';
+}
+
+static bool http_ready() {
+  return WiFi.status() == WL_CONNECTED;
+}
+
+static uint8_t http_send(const TelemetrySample *batch, uint8_t n) {
+  char buf[32];
+  String body;
+  body.reserve(48 + n * 160);
+  body += "{\"device\":\"";
+  body += sinks_deviceId();
+  body += "\",\"samples\":[";
+  for (uint8_t i = 0; i < n; ++i) {
+    body += i ? ",{\"ts\":" : "{\"ts\":";
+    body += String((unsigned long)batch[i].ts);
+    for (int c = 0; c < CH_COUNT; ++c) {
+      snprintf(buf, sizeof(buf), ",\"%s\":%.2f", sample_channelName((SampleChannel)c),
+               sample_value(batch[i], (SampleChannel)c));
+      body += buf;
+    }
+    body += "}";
+  }
+  body += "]}";
+
+  HTTPClient http;
+  http.begin(HTTP_SINK_URL);
+  http.addHeader("Content-Type", "application/json");
+  int code = http.POST(body);
+  http.end();
+#if ENABLE_DEBUG
+  Serial.printf("[HTTP-SINK] %u samples, HTTP %d\n", n, code);
+#endif
+  return (code >= 200 && code < 300) ? n : 0;
+}
+
+const TelemetrySink &http_sink() {
+  static const TelemetrySink sink = {
+    "http", http_enabled, http_ready, http_send, nullptr,
+    HTTP_SINK_BATCH, 60000UL, 30000UL, 900000UL
+  };
+  return sink;
+}
@@ -0,0 +1,22 @@
+#ifndef HTTP_SINK_H
+#define HTTP_SINK_H
+
+#include <Arduino.h>
+#include "telemetry_sink.h"
+
+// Generic HTTP(S) sink: POSTs batches of samples as JSON to HTTP_SINK_URL
+// over WiFi (LTE bandwidth is left to ThingSpeak/MQTT):
+//
+//   {"device":"bh-a1b2c3","samples":[{"ts":1700000000,"weight":12.4,...},...]}
+//
+// Any 2xx response acknowledges the whole batch. Disabled while the URL is empty.
+
+#ifndef HTTP_SINK_URL
+#define HTTP_SINK_URL ""
+#endif
+
+#ifndef HTTP_SINK_BATCH
+#define HTTP_SINK_BATCH 16
+#endif
+
+#endif // HTTP_SINK_H
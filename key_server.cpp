@@ -1,157 +1,75 @@
 #include "key_server.h"
-#include "lcd_endpoint.h"
-#include <WebServer.h>
-#include <Preferences.h>
+#include "perf_stats.h"
+#include "mem_telemetry.h"
+#include "settings.h"
+#include "http_server.h"
+#include "web_assets.h"
 #include "config.h"
-#include <WiFi.h>
 
-// single global server instance used by keyServer_init/loop
-static WebServer *s_srv = nullptr;
+static esp_err_t handleMemJson(httpd_req_t *req) {
+  String json = mem_buildJson();
+  return http_sendJson(req, json.c_str(), json.length());
+}
 
-// HTML templates in PROGMEM
-const char HTML_WIFI_FORM[] PROGMEM = 
-  "<!doctype html><html><head><meta charset='utf-8'><title>WiFi Setup</title></head><body>"
-  "<h3>Store WiFi credentials</h3>"
-  "<form method='POST' action='/set_wifi'>"
-  "SSID:<br><input name='ssid' type='text'><br>"
-  "Password:<br><input name='pass' type='password'><br><br>"
-  "<input type='submit' value='Save'>"
-  "</form>"
-  "</body></html>";
+#if ENABLE_PERF_STATS
+static esp_err_t handlePerfJson(httpd_req_t *req) {
+  String json = perf_buildJson();
+  return http_sendJson(req, json.c_str(), json.length());
+}
+#endif
 
-const char HTML_INDEX[] PROGMEM = 
-  "<!doctype html><html><head><meta charset='utf-8'><title>Key Server</title></head><body>"
-  "<h3>Beehive Monitor</h3>"
-  "<ul>"
-  "<li><a href='/wifi'>Store WiFi credentials</a></li>"
-  "<li><a href='/lcd.json'>LCD (JSON)</a></li>"
-  "</ul>"
-  "</body></html>";
+// Pages live in web/ and are embedded gzipped (tools/embed_assets.py)
+static esp_err_t handleWifiForm(httpd_req_t *req) {
+  return http_sendAsset(req, WEB_WIFI_HTML);
+}
 
-// Minimal JSON escaper for lcd lines
-static String escapeJSON(const String &s) {
-  String out;
-  out.reserve(s.length() * 2);
-  for (size_t i = 0; i < s.length(); ++i) {
-    char c = s[i];
-    switch (c) {
-      case '\"': out += "\\\""; break;
-      case '\\': out += "\\\\"; break;
-      case '\b': out += "\\b"; break;
-      case '\f': out += "\\f"; break;
-      case '\n': out += "\\n"; break;
-      case '\r': out += "\\r"; break;
-      case '\t': out += "\\t"; break;
-      default:
-        if ((uint8_t)c < 0x20) {
-          char buf[7];
-          snprintf(buf, sizeof(buf), "\\u%04x", (unsigned int)(uint8_t)c);
-          out += buf;
-        } else {
-          out += c;
-        }
-    }
+static esp_err_t handleSetWifi(httpd_req_t *req) {
+  char form[HTTP_FORM_MAX];
+  if (!http_readForm(req, form, sizeof(form))) return ESP_OK;
+  char ssid[33], pass[65];
+  if (!http_formValue(form, "ssid", ssid, sizeof(ssid)) || !http_formValue(form, "pass", pass, sizeof(pass))) {
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing fields");
+    return ESP_OK;
   }
-  return out;
+  settings_setWifi(2, ssid, pass);
+  return http_redirect(req, "/wifi");
 }
 
-// Internal: register handlers on an already-constructed server instance
-static void register_handlers(WebServer &srv) {
-  // lcd.json on port 80
-  srv.on("/lcd.json", HTTP_GET, [&srv]() {
-    String json = String("{\"lines\":[\"")
-      + escapeJSON(lcd_get_line(0)) + String("\",\"")
-      + escapeJSON(lcd_get_line(1)) + String("\",\"")
-      + escapeJSON(lcd_get_line(2)) + String("\",\"")
-      + escapeJSON(lcd_get_line(3)) + String("\"],\"ts\":") + String(millis()) + String("}");
-    srv.sendHeader("Access-Control-Allow-Origin", "*");
-    srv.send(200, "application/json; charset=utf-8", json);
-  });
-
-  // /wifi form
-  srv.on("/wifi", HTTP_GET, [&srv]() {
-    srv.send_P(200, "text/html; charset=utf-8", HTML_WIFI_FORM);
-  });
-
-  // Save WiFi POST handler
-  srv.on("/set_wifi", HTTP_POST, [&srv]() {
-    if (!srv.hasArg("ssid") || !srv.hasArg("pass")) {
-      srv.send(400, F("text/plain"), F("Missing fields"));
-      return;
-    }
-    String ssid = srv.arg("ssid");
-    String pass = srv.arg("pass");
-    Preferences p;
-    p.begin("wifi_cfg", false);
-    p.putString("ssid", ssid);
-    p.putString("pass", pass);
-    p.end();
-    srv.sendHeader(F("Location"), F("/wifi"));
-    srv.send(303);
-  });
-
-  // index
-  srv.on("/", HTTP_GET, [&srv]() {
-    srv.send_P(200, "text/html; charset=utf-8", HTML_INDEX);
-  });
+// OPTIONS preflight for /set_wifi
+static esp_err_t handleSetWifiOptions(httpd_req_t *req) {
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Methods", "POST, OPTIONS");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Headers", "Content-Type");
+  return http_sendStatus(req, "204 No Content");
+}
 
-  // OPTIONS preflight for /set_wifi
-  srv.on("/set_wifi", HTTP_OPTIONS, [&srv]() {
-    srv.sendHeader(F("Access-Control-Allow-Origin"), F("*"));
-    srv.sendHeader(F("Access-Control-Allow-Methods"), F("POST, OPTIONS"));
-    srv.sendHeader(F("Access-Control-Allow-Headers"), F("Content-Type"));
-    srv.send(204);
-  });
+static esp_err_t handleIndex(httpd_req_t *req) {
+  return http_sendAsset(req, WEB_INDEX_HTML);
 }
 
-void keyServer_init() {
-  // create server only if WiFi is up; otherwise do nothing (lazy start in loop)
-  if (s_srv) return; // already created
-  if (WiFi.status() != WL_CONNECTED) {
-    // don't create server now; it will be auto-started inside keyServer_loop()
-#if ENABLE_DEBUG
-    Serial.println(F("[KeyServer] WiFi not connected - deferring server start"));
-#endif
-    return;
-  }
+// Single-page dashboard; it renders client-side from /api/v1/*
+static esp_err_t handleDashboard(httpd_req_t *req) {
+  return http_sendAsset(req, WEB_DASHBOARD_HTML);
+}
 
-  s_srv = new WebServer(80);
-  register_handlers(*s_srv);
-  s_srv->begin();
-#if ENABLE_DEBUG
-  Serial.println(F("[KeyServer] started on port 80"));
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.print(F("[KeyServer] IP: "));
-    Serial.println(WiFi.localIP());
-  }
-#endif
+// /assets/<name>.<hash>.<ext> from the generated manifest
+static esp_err_t handleAsset(httpd_req_t *req) {
+  const WebAsset *asset = web_findAsset(req->uri);
+  if (!asset) return httpd_resp_send_404(req);
+  return http_sendAsset(req, *asset);
 }
 
-void keyServer_stop() {
-  if (!s_srv) return;
-#if ENABLE_DEBUG
-  Serial.println(F("[KeyServer] stopping server"));
+void keyServer_init() {
+  http_on("/", HTTP_GET, handleIndex);
+  http_on("/dashboard", HTTP_GET, handleDashboard);
+  http_on("/assets/*", HTTP_GET, handleAsset);
+  http_on("/wifi", HTTP_GET, handleWifiForm);
+  http_on("/set_wifi", HTTP_POST, handleSetWifi);
+  http_on("/set_wifi", HTTP_OPTIONS, handleSetWifiOptions);
+  // heap / fragmentation / task stack watermarks
+  http_on("/mem.json", HTTP_GET, handleMemJson);
+#if ENABLE_PERF_STATS
+  // loop() stage latency histograms
+  http_on("/perf.json", HTTP_GET, handlePerfJson);
 #endif
-  // attempt graceful stop; WebServer has no explicit stop API in all builds,
-  // but deleting the instance will free resources. First try close() if available.
-  #if defined(ESP8266)
-    s_srv->close();
-  #endif
-  delete s_srv;
-  s_srv = nullptr;
 }
-
-void keyServer_loop() {
-  // Auto-start server when WiFi comes up
-  if (!s_srv && WiFi.status() == WL_CONNECTED) {
-    keyServer_init();
-  }
-
-  // Auto-stop server when WiFi goes down
-  if (s_srv && WiFi.status() != WL_CONNECTED) {
-    keyServer_stop();
-    return;
-  }
-
-  if (s_srv) s_srv->handleClient();
-}
\ No newline at end of file
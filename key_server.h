@@ -3,10 +3,8 @@
 
 #include <Arduino.h>
 
-// Initialize server (no-op until WiFi connected). Call once in setup or leave out and call keyServer_loop() from loop().
-// You must call keyServer_loop() regularly (from your main loop).
-void keyServer_init();   // starts the server if WiFi connected (safe to call repeatedly)
-void keyServer_loop();   // handle incoming HTTP requests; also auto-starts server when WiFi connects
-void keyServer_stop();   // stop server
+// Index page, WiFi form (/wifi, /set_wifi) and the /mem.json, /perf.json
+// diagnostics on the shared web server (http_server.h).
+void keyServer_init();   // register the routes, once from setup()
 
-#endif // KEY_SERVER_H
\ No newline at end of file
+#endif // KEY_SERVER_H
@@ -1,14 +1,40 @@
 // url=https://github.com/manolena/Beehive-Monitor/blob/main/lcd_endpoint.cpp
 #include "lcd_endpoint.h"
-#include <WebServer.h>
+#include "http_server.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <lwip/sockets.h>
 
-// Internal storage for the last 4 LCD lines (initial placeholders)
-static String lcd_lines[4] = {
+// Last 4 LCD lines (initial placeholders); written by the loop task, read by httpd
+static char lcd_lines[LCD_ROWS][LCD_LINE_BYTES] = {
   "....................",
   "....................",
   "....................",
   "...................."
 };
+static SemaphoreHandle_t s_lcdMutex = nullptr;
+static volatile uint8_t s_dirty = 0;      // rows changed since the last push
+static uint32_t s_version = 0;
+static uint32_t s_bootNonce = 0;          // in the ETag, so a reboot never matches an old one
+static uint32_t s_changedMs = 0;          // millis() of the last change
+
+// Stream viewers; the slots are only touched on the httpd task
+static int s_streamFds[LCD_STREAM_MAX_CLIENTS];
+static volatile uint8_t s_streamCount = 0;
+static volatile bool s_pushQueued = false;
+static char s_event[LCD_ROWS * (2 * LCD_LINE_BYTES + 8) + 64];
+static uint32_t s_eventsSent = 0;
+static uint32_t s_viewersDropped = 0;
+
+static void lcd_lock() {
+  // created on first use from setup() (uiInit), before the server task exists
+  if (!s_lcdMutex) s_lcdMutex = xSemaphoreCreateMutex();
+  xSemaphoreTake(s_lcdMutex, portMAX_DELAY);
+}
+
+static void lcd_unlock() {
+  xSemaphoreGive(s_lcdMutex);
+}
 
 // UTF‑8 aware truncation/pad (same logic as ui.cpp pad20)
 static String pad20_local(const String &s_in) {
@@ -44,62 +70,184 @@ static String pad20_local(const String &s_in) {
 
 // Store up to 20 visual chars UTF-8 per line (pad/truncate safely)
 void lcd_set_line(uint8_t idx, const String &text) {
-  if (idx >= 4) return;
+  if (idx >= LCD_ROWS) return;
   String s = pad20_local(text);
-  lcd_lines[idx] = s;
+  lcd_lock();
+  if (strcmp(lcd_lines[idx], s.c_str()) != 0) {
+    strlcpy(lcd_lines[idx], s.c_str(), LCD_LINE_BYTES);
+    s_dirty |= 1 << idx;
+    s_version++;
+    s_changedMs = millis();
+  }
+  lcd_unlock();
 }
 
 String lcd_get_line(uint8_t idx) {
-  if (idx >= 4) return String();
-  return lcd_lines[idx];
+  if (idx >= LCD_ROWS) return String();
+  lcd_lock();
+  String s(lcd_lines[idx]);
+  lcd_unlock();
+  return s;
 }
 
-// Improved escape: ensures returned JSON is valid UTF-8.
-// - Escapes " and \, \n, \r
-// - Replaces control chars (< 0x20) with space
-// - Converts LCD raw byte 223 (0xDF) to degree sign U+00B0 (0xC2 0xB0)
-// - Converts other bytes >= 0x80 using Latin-1 -> UTF-8 mapping (two-byte)
-static String escapeJSON(const String& s) {
-  String r;
-  r.reserve(s.length() * 2);
-  for (size_t i = 0; i < s.length(); ++i) {
-    uint8_t b = (uint8_t)s[i];
-    if (b == '\"') {
-      r += "\\\"";
-    } else if (b == '\\') {
-      r += "\\\\";
-    } else if (b == '\n') {
-      r += "\\n";
-    } else if (b == '\r') {
-      r += "\\r";
-    } else if (b < 0x20) {
-      r += ' ';
-    } else if (b == 223) {
-      r += (char)0xC2;
-      r += (char)0xB0; // U+00B0
-    } else if (b < 0x80) {
-      r += (char)b;
+// JSON string body for one UTF-8 line: escapes " and \, control characters
+// become spaces. Returns the bytes written (out must hold 2 * strlen + 1).
+static size_t lcd_escapeJSON(const char *in, char *out) {
+  char *o = out;
+  for (; *in; ++in) {
+    uint8_t b = (uint8_t)*in;
+    if (b == '"' || b == '\\') {
+      *o++ = '\\';
+      *o++ = (char)b;
     } else {
-      char hi = (char)(0xC0 | (b >> 6));
-      char lo = (char)(0x80 | (b & 0x3F));
-      r += hi;
-      r += lo;
+      *o++ = b < 0x20 ? ' ' : (char)b;
     }
   }
-  return r;
+  *o = '\0';
+  return o - out;
 }
 
-// Register the HTTP GET handler on the provided WebServer instance.
-void register_lcd_endpoint(WebServer &srv) {
-  srv.on("/lcd.json", HTTP_GET, [&srv]() {
-    String json = String("{\"lines\":[\"")
-      + escapeJSON(lcd_lines[0]) + String("\",\"")
-      + escapeJSON(lcd_lines[1]) + String("\",\"")
-      + escapeJSON(lcd_lines[2]) + String("\",\"")
-      + escapeJSON(lcd_lines[3]) + String("\"],\"ts\":\"")
-      + String(millis()) + String("\"}");
-
-    srv.sendHeader("Access-Control-Allow-Origin", "*");
-    srv.send(200, "application/json; charset=utf-8", json);
-  });
-}
\ No newline at end of file
+// The ETag is the boot nonce and the screen version, so an unchanged screen
+// costs a 304 and a cached copy from before a reboot does not
+static esp_err_t lcd_handleJson(httpd_req_t *req) {
+  char lines[LCD_ROWS][LCD_LINE_BYTES];
+  lcd_lock();
+  uint32_t version = s_version;
+  uint32_t changedMs = s_changedMs;
+  memcpy(lines, lcd_lines, sizeof(lines));
+  lcd_unlock();
+
+  char etag[32];
+  snprintf(etag, sizeof(etag), "\"lcd-%08lx-%lu\"", (unsigned long)s_bootNonce, (unsigned long)version);
+  if (http_notModified(req, etag)) return ESP_OK;
+
+  char json[LCD_ROWS * 2 * LCD_LINE_BYTES + 48];
+  size_t n = strlcpy(json, "{\"lines\":[", sizeof(json));
+  for (uint8_t i = 0; i < LCD_ROWS; ++i) {
+    if (i) json[n++] = ',';
+    json[n++] = '"';
+    n += lcd_escapeJSON(lines[i], json + n);
+    json[n++] = '"';
+  }
+  n += snprintf(json + n, sizeof(json) - n, "],\"ts\":%lu}", (unsigned long)changedMs);
+  return http_sendJson(req, json, n);
+}
+
+// SSE event with the rows in mask, see lcd_endpoint.h
+static size_t lcd_buildEvent(uint8_t mask, uint32_t version, char lines[][LCD_LINE_BYTES]) {
+  size_t n = snprintf(s_event, sizeof(s_event), "id: %lu\ndata: {\"rows\":{", (unsigned long)version);
+  bool first = true;
+  for (uint8_t i = 0; i < LCD_ROWS; ++i) {
+    if (!(mask & (1 << i))) continue;
+    n += snprintf(s_event + n, sizeof(s_event) - n, "%s\"%u\":\"", first ? "" : ",", i);
+    n += lcd_escapeJSON(lines[i], s_event + n);
+    s_event[n++] = '"';
+    first = false;
+  }
+  n += snprintf(s_event + n, sizeof(s_event) - n, "},\"ts\":%lu}\n\n", millis());
+  return n;
+}
+
+static void lcd_streamRemove(int sockfd) {
+  for (uint8_t i = 0; i < LCD_STREAM_MAX_CLIENTS; ++i) {
+    if (s_streamFds[i] == sockfd) {
+      s_streamFds[i] = -1;
+      s_streamCount--;
+    }
+  }
+}
+
+// httpd task (queued by lcd_endpoint_loop): one event, written to all viewers
+static void lcd_streamPush(void *) {
+  char lines[LCD_ROWS][LCD_LINE_BYTES];
+  lcd_lock();
+  uint8_t mask = s_dirty;
+  uint32_t version = s_version;
+  s_dirty = 0;
+  memcpy(lines, lcd_lines, sizeof(lines));
+  lcd_unlock();
+  s_pushQueued = false;
+
+  size_t n = mask ? lcd_buildEvent(mask, version, lines) : strlcpy(s_event, ": ping\n\n", sizeof(s_event));
+  httpd_handle_t h = http_handle();
+  for (uint8_t i = 0; i < LCD_STREAM_MAX_CLIENTS; ++i) {
+    int fd = s_streamFds[i];
+    if (fd < 0) continue;
+    // Never wait on a viewer: a short write means its buffer is full
+    if (httpd_socket_send(h, fd, s_event, n, MSG_DONTWAIT) != (int)n) {
+      lcd_streamRemove(fd);
+      s_viewersDropped++;
+      httpd_sess_trigger_close(h, fd);
+      continue;
+    }
+    s_eventsSent++;
+  }
+}
+
+static esp_err_t lcd_handleStream(httpd_req_t *req) {
+  int fd = httpd_req_to_sockfd(req);
+  int slot = -1;
+  for (uint8_t i = 0; i < LCD_STREAM_MAX_CLIENTS; ++i) {
+    if (s_streamFds[i] < 0) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot < 0) return http_sendStatus(req, "503 Service Unavailable", "{\"error\":\"too many viewers\"}");
+
+  // The stream never ends, so the response head is written by hand and the
+  // socket stays with us until the viewer goes away (http_onSessionClose).
+  static const char head[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "Connection: keep-alive\r\n\r\n"
+    "retry: 3000\n\n";
+  if (httpd_socket_send(req->handle, fd, head, sizeof(head) - 1, 0) != (int)sizeof(head) - 1) return ESP_FAIL;
+
+  char lines[LCD_ROWS][LCD_LINE_BYTES];
+  lcd_lock();
+  uint32_t version = s_version;
+  memcpy(lines, lcd_lines, sizeof(lines));
+  lcd_unlock();
+  size_t n = lcd_buildEvent((1 << LCD_ROWS) - 1, version, lines);
+  if (httpd_socket_send(req->handle, fd, s_event, n, 0) != (int)n) return ESP_FAIL;
+
+  s_streamFds[slot] = fd;
+  s_streamCount++;
+  return ESP_OK;
+}
+
+void lcd_endpoint_loop() {
+  static unsigned long lastPush = 0;
+  httpd_handle_t h = http_handle();
+  if (!h) {
+    // server stopped: its task, sockets and any queued push are gone
+    for (uint8_t i = 0; i < LCD_STREAM_MAX_CLIENTS; ++i) s_streamFds[i] = -1;
+    s_streamCount = 0;
+    s_pushQueued = false;
+    return;
+  }
+  if (!s_streamCount || s_pushQueued) return;
+
+  unsigned long wait = s_dirty ? LCD_STREAM_MIN_MS : LCD_STREAM_PING_MS;
+  if (millis() - lastPush < wait) return;
+  lastPush = millis();
+  s_pushQueued = true;
+  if (httpd_queue_work(h, lcd_streamPush, nullptr) != ESP_OK) s_pushQueued = false;
+}
+
+void lcd_endpoint_print(Print &out) {
+  out.printf("[LCD] stream: %u/%u viewers, %lu events sent, %lu viewers dropped, version %lu\n",
+             s_streamCount, LCD_STREAM_MAX_CLIENTS, (unsigned long)s_eventsSent,
+             (unsigned long)s_viewersDropped, (unsigned long)s_version);
+}
+
+void lcd_endpoint_init() {
+  s_bootNonce = esp_random();
+  for (uint8_t i = 0; i < LCD_STREAM_MAX_CLIENTS; ++i) s_streamFds[i] = -1;
+  http_onSessionClose(lcd_streamRemove);
+  http_on("/lcd.json", HTTP_GET, lcd_handleJson);
+  http_on("/lcd/stream", HTTP_GET, lcd_handleStream);
+}
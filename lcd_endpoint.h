@@ -2,17 +2,43 @@
 #define LCD_ENDPOINT_H
 
 #include <Arduino.h>
-#include <WebServer.h>
 
-// Register the /lcd.json endpoint on the provided WebServer instance.
-// Call this from your key_server setup() after the server instance exists:
-//    register_lcd_endpoint(server);
-void register_lcd_endpoint(WebServer &srv);
+// Web mirror of the 4x20 LCD.
+// ui.cpp writes every line it prints with lcd_set_line(); GET /lcd.json on
+// the shared web server (http_server.h) returns them with "ts" = millis()
+// of the last change; the ETag is a per-boot nonce plus the screen version
+// (If-None-Match -> 304).
+// The handler runs on the httpd task, so the line buffers sit behind a lock.
+//
+// GET /lcd/stream is a Server-Sent Events feed for live viewers: the full
+// screen on connect, then one event per burst of changes carrying only
+// the rows that changed:
+//   id: <version>
+//   data: {"rows":{"1":"...","3":"..."},"ts":<millis>}
+// The event is built once and written to every viewer without blocking;
+// a viewer whose socket buffer is full is disconnected (EventSource
+// reconnects on its own and gets a fresh full screen).
+
+#define LCD_ROWS       4
+#define LCD_LINE_BYTES 81      // 20 visual characters, up to 4 UTF-8 bytes each
+
+#ifndef LCD_STREAM_MAX_CLIENTS
+#define LCD_STREAM_MAX_CLIENTS 3     // each holds one of HTTP_MAX_SOCKETS
+#endif
+
+#ifndef LCD_STREAM_MIN_MS
+#define LCD_STREAM_MIN_MS 100        // coalesce row writes of one screen redraw
+#endif
+
+#ifndef LCD_STREAM_PING_MS
+#define LCD_STREAM_PING_MS 15000     // keep-alive comment, also detects dead viewers
+#endif
+
+void lcd_endpoint_init();      // registers /lcd.json and /lcd/stream
+void lcd_endpoint_loop();      // loop task: queues pushes to the stream viewers
+void lcd_endpoint_print(Print &out);
 
-// Small API to update/read the 4 cached LCD lines.
-// Call lcd_set_line() wherever your code writes to the physical LCD so the
-// web endpoint always reflects what the display shows.
 void lcd_set_line(uint8_t idx, const String &text);
 String lcd_get_line(uint8_t idx);
 
-#endif // LCD_ENDPOINT_H
\ No newline at end of file
+#endif // LCD_ENDPOINT_H
@@ -0,0 +1,138 @@
+// mem_telemetry.cpp - heap fragmentation and task stack watermarks.
+
+#include "mem_telemetry.h"
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Tasks we report on. Tasks that are not running (e.g. ModemBoot after it
+// finished) are simply skipped.
+static const char* const s_taskNames[] = {
+  "loopTask",
+  "httpd",
+  "ModemBoot",
+  nullptr
+};
+
+#define MEM_MAX_TASKS 8
+
+static MemSample s_history[MEM_HISTORY_LEN];
+static uint8_t   s_histHead = 0;     // next write slot
+static uint8_t   s_histCount = 0;
+static MemSample s_last = {};
+static uint32_t  s_minLargestBlock = 0xFFFFFFFFUL;
+static int32_t   s_taskMinFree[MEM_MAX_TASKS];
+static unsigned long s_lastSample = 0;
+
+void mem_init() {
+  for (int i = 0; i < MEM_MAX_TASKS; ++i) s_taskMinFree[i] = -1;
+  mem_sampleNow();
+}
+
+int32_t mem_taskStackFree(const char *taskName) {
+  TaskHandle_t h = xTaskGetHandle(taskName);
+  if (!h) return -1;
+  // ESP-IDF reports the high-water mark in bytes
+  return (int32_t)uxTaskGetStackHighWaterMark(h);
+}
+
+void mem_sampleNow() {
+  MemSample m;
+  m.uptime_s      = millis() / 1000UL;
+  m.free_heap     = ESP.getFreeHeap();
+  m.largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  m.min_free_heap = ESP.getMinFreeHeap();
+  m.frag_pct      = (m.free_heap > 0) ? (uint8_t)(100 - (uint64_t)m.largest_block * 100 / m.free_heap) : 0;
+
+  if (m.largest_block < s_minLargestBlock) s_minLargestBlock = m.largest_block;
+
+  for (int i = 0; s_taskNames[i] && i < MEM_MAX_TASKS; ++i) {
+    int32_t f = mem_taskStackFree(s_taskNames[i]);
+    if (f >= 0 && (s_taskMinFree[i] < 0 || f < s_taskMinFree[i])) s_taskMinFree[i] = f;
+  }
+
+  s_last = m;
+  s_history[s_histHead] = m;
+  s_histHead = (s_histHead + 1) % MEM_HISTORY_LEN;
+  if (s_histCount < MEM_HISTORY_LEN) s_histCount++;
+  s_lastSample = millis();
+
+#if ENABLE_DEBUG
+  Serial.printf("[MEM] free=%lu largest=%lu min=%lu frag=%u%%\n",
+                (unsigned long)m.free_heap, (unsigned long)m.largest_block,
+                (unsigned long)m.min_free_heap, (unsigned)m.frag_pct);
+#endif
+}
+
+void mem_loop() {
+  if (millis() - s_lastSample < MEM_SAMPLE_INTERVAL_MS) return;
+  mem_sampleNow();
+}
+
+const MemSample& mem_last() {
+  return s_last;
+}
+
+void mem_print(Print &out) {
+  mem_sampleNow();
+  out.printf("[MEM] uptime:        %lu s\n", (unsigned long)s_last.uptime_s);
+  out.printf("[MEM] free heap:     %lu\n", (unsigned long)s_last.free_heap);
+  out.printf("[MEM] largest block: %lu (lowest seen %lu)\n",
+             (unsigned long)s_last.largest_block, (unsigned long)s_minLargestBlock);
+  out.printf("[MEM] min free heap: %lu\n", (unsigned long)s_last.min_free_heap);
+  out.printf("[MEM] fragmentation: %u%%\n", (unsigned)s_last.frag_pct);
+  for (int i = 0; s_taskNames[i] && i < MEM_MAX_TASKS; ++i) {
+    int32_t f = mem_taskStackFree(s_taskNames[i]);
+    if (f < 0 && s_taskMinFree[i] < 0) continue;
+    out.printf("[MEM] stack %-10s free now %ld, lowest %ld\n",
+               s_taskNames[i], (long)f, (long)s_taskMinFree[i]);
+  }
+}
+
+String mem_buildJson() {
+  String json;
+  json.reserve(256 + s_histCount * 48);
+  char buf[160];
+  snprintf(buf, sizeof(buf),
+           "{\"uptime_s\":%lu,\"free_heap\":%lu,\"largest_block\":%lu,\"largest_block_min\":%lu,"
+           "\"min_free_heap\":%lu,\"frag_pct\":%u,\"tasks\":{",
+           (unsigned long)s_last.uptime_s, (unsigned long)s_last.free_heap,
+           (unsigned long)s_last.largest_block, (unsigned long)s_minLargestBlock,
+           (unsigned long)s_last.min_free_heap, (unsigned)s_last.frag_pct);
+  json += buf;
+  bool first = true;
+  for (int i = 0; s_taskNames[i] && i < MEM_MAX_TASKS; ++i) {
+    int32_t f = mem_taskStackFree(s_taskNames[i]);
+    if (f < 0 && s_taskMinFree[i] < 0) continue;
+    snprintf(buf, sizeof(buf), "%s\"%s\":{\"stack_free\":%ld,\"stack_free_min\":%ld}",
+             first ? "" : ",", s_taskNames[i], (long)f, (long)s_taskMinFree[i]);
+    json += buf;
+    first = false;
+  }
+  json += F("},\"history\":[");
+  // oldest first: [uptime_s, free_heap, largest_block, frag_pct]
+  for (uint8_t n = 0; n < s_histCount; ++n) {
+    uint8_t idx = (s_histHead + MEM_HISTORY_LEN - s_histCount + n) % MEM_HISTORY_LEN;
+    const MemSample &m = s_history[idx];
+    snprintf(buf, sizeof(buf), "%s[%lu,%lu,%lu,%u]", n ? "," : "",
+             (unsigned long)m.uptime_s, (unsigned long)m.free_heap,
+             (unsigned long)m.largest_block, (unsigned)m.frag_pct);
+    json += buf;
+  }
+  json += F("]}");
+  return json;
+}
+
+void mem_appendThingSpeakStatus(String &body) {
+#if MEM_TELEMETRY_TS_STATUS
+  char buf[96];
+  // '+' is the form-encoded space
+  snprintf(buf, sizeof(buf), "&status=heap+%lu+blk+%lu+min+%lu+frag+%u+up+%lu",
+           (unsigned long)s_last.free_heap, (unsigned long)s_last.largest_block,
+           (unsigned long)s_last.min_free_heap, (unsigned)s_last.frag_pct,
+           (unsigned long)s_last.uptime_s);
+  body += buf;
+#else
+  (void) body;
+#endif
+}
@@ -0,0 +1,50 @@
+#ifndef MEM_TELEMETRY_H
+#define MEM_TELEMETRY_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Heap / stack watermark telemetry.
+// mem_loop() samples free heap, the largest free block (fragmentation),
+// the all-time minimum free heap and the stack high-water mark of the
+// project's FreeRTOS tasks every MEM_SAMPLE_INTERVAL_MS. A short history
+// ring is kept so that /mem.json shows the trend, not just the last value.
+
+#ifndef MEM_SAMPLE_INTERVAL_MS
+#define MEM_SAMPLE_INTERVAL_MS (60UL * 1000UL)
+#endif
+
+#ifndef MEM_HISTORY_LEN
+#define MEM_HISTORY_LEN 24
+#endif
+
+// Append memory stats to ThingSpeak uploads as the channel "status" text
+// (all eight fields are taken by sensor data).
+#ifndef MEM_TELEMETRY_TS_STATUS
+#define MEM_TELEMETRY_TS_STATUS 0
+#endif
+
+struct MemSample {
+  uint32_t uptime_s;
+  uint32_t free_heap;
+  uint32_t largest_block;
+  uint32_t min_free_heap;   // ESP.getMinFreeHeap() (since boot)
+  uint8_t  frag_pct;        // 100 - largest_block * 100 / free_heap
+};
+
+void mem_init();
+void mem_loop();
+void mem_sampleNow();
+
+const MemSample& mem_last();
+
+// Stack high-water mark (bytes never used) for a task by name, -1 if unknown
+int32_t mem_taskStackFree(const char *taskName);
+
+void   mem_print(Print &out);       // serial 'mem' command
+String mem_buildJson();             // GET /mem.json
+
+// Adds "&status=heap..." to a ThingSpeak body when MEM_TELEMETRY_TS_STATUS is on
+void mem_appendThingSpeakStatus(String &body);
+
+#endif // MEM_TELEMETRY_H
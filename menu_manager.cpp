@@ -11,17 +11,18 @@
 #include "weather_manager.h"
 #include "provisioning_ui.h"
 #include "sms_handler.h"
+#include "sd_storage.h"
+#include "wifi_manager.h"
+#include "settings.h"
 #include <SD.h>
 #include <LiquidCrystal_I2C.h>
 #include <WiFi.h>
-#include <Preferences.h>
 
 #include "calibration.h"
 
 extern LiquidCrystal_I2C lcd;
 
-// Forward declaration: wifi helper defined in BeehiveMonitor_27.ino
-extern bool wifi_connectFromPrefs(unsigned long timeoutMs);
+// Forward declaration: LTE helper defined in BeehiveMonitor_27.ino
 extern void tryStartLTE();
 
 // =====================================================================
@@ -257,7 +258,8 @@ static void menuShowTime() {
       String d = timeManager_getDate();
       String t = timeManager_getTime();
       TimeSource src = timeManager_getSource();
-      const char* srcName = (src == TSRC_WIFI) ? "WIFI" : (src == TSRC_LTE) ? "LTE" : "NONE";
+      const char* srcName = (src == TSRC_WIFI) ? "WIFI" : (src == TSRC_LTE) ? "LTE" :
+                            (src == TSRC_GATEWAY) ? "GW" : "NONE";
       if (d != oldDate) {
         if (currentLanguage == LANG_EN) uiPrint(0, 0, (String("DATE: ") + d).c_str());
         else { char line[21]; snprintf(line, 21, "\u0397\u039c/\u039d\u0399\u0391: %s", d.c_str()); lcdPrintGreek(line, 0, 0); }
@@ -332,19 +334,31 @@ static void menuShowMeasurements() {
 
 // =====================================================================
 // SD CARD INFO
+// Uses the stats kept by sd_storage (no re-mount); refreshed once a second.
 static void menuShowSDInfo() {
-  uiClear();
-  bool ok = SD.begin(SD_CS);
-  if (currentLanguage == LANG_EN) {
-    uiPrint(0, 0, getTextEN(TXT_SD_CARD_INFO));
-    uiPrint(0, 1, ok ? getTextEN(TXT_SD_OK) : getTextEN(TXT_NO_CARD));
-    uiPrint(0, 3, getTextEN(TXT_BACK_SMALL));
-  } else {
-    lcdPrintGreek(getTextGR(TXT_SD_CARD_INFO), 0, 0);
-    lcdPrintGreek(ok ? getTextGR(TXT_SD_OK) : getTextGR(TXT_NO_CARD), 0, 1);
-    lcdPrintGreek(getTextGR(TXT_BACK_SMALL), 0, 3);
-  }
+  char line[21];
+  unsigned long lastDraw = 0;
+  bool first = true;
   while (true) {
+    if (first || millis() - lastDraw >= 1000) {
+      SdStats st;
+      sd_getStats(st);
+      if (first) {
+        uiClear();
+        if (currentLanguage == LANG_EN) uiPrint(0, 0, getTextEN(TXT_SD_CARD_INFO));
+        else lcdPrintGreek(getTextGR(TXT_SD_CARD_INFO), 0, 0);
+        first = false;
+      }
+      if (currentLanguage == LANG_EN) uiPrint(0, 1, st.mounted ? getTextEN(TXT_SD_OK) : getTextEN(TXT_NO_CARD));
+      else lcdPrintGreek(st.mounted ? getTextGR(TXT_SD_OK) : getTextGR(TXT_NO_CARD), 0, 1);
+      snprintf(line, 21, "%-4s free %6luMB  ", sd_cardTypeName(st.cardType),
+               (unsigned long)((st.totalBytes - st.usedBytes) >> 20));
+      uiPrint(0, 2, line);
+      snprintf(line, 21, "W%3lu/%4lums E%-5lu", (unsigned long)(st.writeAvgUs / 1000),
+               (unsigned long)(st.writeMaxUs / 1000), (unsigned long)st.errors);
+      uiPrint(0, 3, line);
+      lastDraw = millis();
+    }
     Button b = getButton();
     if (b == BTN_BACK_PRESSED || b == BTN_SELECT_PRESSED) { menuDraw(); return; }
     delay(50);
@@ -403,8 +417,7 @@ static void menuShowConnectivity() {
     Button b = getButton();
 
     if (b == BTN_SELECT_PRESSED) {
-      Preferences p; p.begin("beehive_app", false); int cur = p.getInt("net_pref", 0); p.end();
-      int sel = cur; // 0 auto,1 wifi,2 lte
+      int sel = settings().netPref; // 0 auto,1 wifi,2 lte
       auto drawPref = [&]() {
         uiClear();
         uiPrint(0, 0, "Network Mode        ");
@@ -419,13 +432,13 @@ static void menuShowConnectivity() {
         else if (bb == BTN_DOWN_PRESSED) { sel = (sel + 1) % 3; drawPref(); }
         else if (bb == BTN_BACK_PRESSED) { menuDraw(); return; }
         else if (bb == BTN_SELECT_PRESSED) {
-          Preferences prefs; prefs.begin("beehive_app", false); prefs.putInt("net_pref", sel); prefs.end();
+          settings_setNetPref(sel);
           uiClear();
           if (sel == 0) uiPrint(0, 0, "Mode: Auto saved    ");
           else if (sel == 1) uiPrint(0, 0, "Mode: WiFi saved    ");
           else uiPrint(0, 0, "Mode: LTE saved     ");
           uiPrint(0, 3, getTextEN(TXT_BACK_SMALL));
-          if (sel == 1) { uiPrint(0, 1, "Connecting WiFi...  "); wifi_connectFromPrefs(8000); }
+          if (sel == 1) { uiPrint(0, 1, "Connecting WiFi...  "); wifi_connectNow(); }
           else if (sel == 2) { uiPrint(0, 1, "Attaching LTE...    "); tryStartLTE(); }
           while (true) {
             Button bbb = getButton();
@@ -0,0 +1,187 @@
+#include "metrics_endpoint.h"
+#include "http_server.h"
+#include "telemetry_sink.h"
+#include "ts_queue.h"
+#include "upload_scheduler.h"
+#include "modem_manager.h"
+#include "time_manager.h"
+#include "perf_stats.h"
+#include "config.h"
+#include <WiFi.h>
+#include <esp_heap_caps.h>
+#include <stdarg.h>
+
+struct MetricsOut {
+  httpd_req_t *req;
+  size_t len;
+  bool failed;                 // client gone, stop rendering
+};
+
+// One buffer for every scrape: handlers run one at a time on the httpd task
+static char s_buf[METRICS_CHUNK_BYTES];
+static uint32_t s_scrapes = 0;
+
+static void metrics_flush(MetricsOut &o) {
+  if (o.len && !o.failed && httpd_resp_send_chunk(o.req, s_buf, o.len) != ESP_OK) o.failed = true;
+  o.len = 0;
+}
+
+// Append one formatted line; sends the buffer when it is full
+static void metrics_printf(MetricsOut &o, const char *fmt, ...) {
+  for (uint8_t attempt = 0; attempt < 2 && !o.failed; ++attempt) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(s_buf + o.len, sizeof(s_buf) - o.len, fmt, ap);
+    va_end(ap);
+    if (n >= 0 && o.len + n < sizeof(s_buf)) {
+      o.len += n;
+      return;
+    }
+    if (o.len == 0) return;    // longer than the whole buffer, never happens for our lines
+    metrics_flush(o);
+  }
+}
+
+static void metrics_family(MetricsOut &o, const char *name, const char *type, const char *help) {
+  metrics_printf(o, "# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+}
+
+// labels: "" or 'key="value"'
+static void metrics_gauge(MetricsOut &o, const char *name, const char *labels, double v) {
+  const char *open = labels[0] ? "{" : "";
+  const char *close = labels[0] ? "}" : "";
+  if (isnan(v))      metrics_printf(o, "%s%s%s%s NaN\n", name, open, labels, close);
+  else if (isinf(v)) metrics_printf(o, "%s%s%s%s %cInf\n", name, open, labels, close, v > 0 ? '+' : '-');
+  else               metrics_printf(o, "%s%s%s%s %.7g\n", name, open, labels, close, v);
+}
+
+static void metrics_uint(MetricsOut &o, const char *name, const char *labels, uint64_t v) {
+  const char *open = labels[0] ? "{" : "";
+  const char *close = labels[0] ? "}" : "";
+  metrics_printf(o, "%s%s%s%s %llu\n", name, open, labels, close, (unsigned long long)v);
+}
+
+static void metrics_hive(MetricsOut &o) {
+  metrics_family(o, "beehive_weight_kilograms", "gauge", "Hive weight.");
+  metrics_gauge(o, "beehive_weight_kilograms", "", test_weight);
+  metrics_family(o, "beehive_temperature_celsius", "gauge", "Temperature inside and outside the hive.");
+  metrics_gauge(o, "beehive_temperature_celsius", "sensor=\"internal\"", test_temp_int);
+  metrics_gauge(o, "beehive_temperature_celsius", "sensor=\"external\"", test_temp_ext);
+  metrics_family(o, "beehive_humidity_percent", "gauge", "Relative humidity inside and outside the hive.");
+  metrics_gauge(o, "beehive_humidity_percent", "sensor=\"internal\"", test_hum_int);
+  metrics_gauge(o, "beehive_humidity_percent", "sensor=\"external\"", test_hum_ext);
+  metrics_family(o, "beehive_pressure_pascals", "gauge", "Barometric pressure.");
+  metrics_gauge(o, "beehive_pressure_pascals", "", test_pressure * 100.0);
+  metrics_family(o, "beehive_battery_volts", "gauge", "Battery voltage.");
+  metrics_gauge(o, "beehive_battery_volts", "", test_batt_voltage);
+  metrics_family(o, "beehive_battery_percent", "gauge", "Battery charge estimate.");
+  metrics_gauge(o, "beehive_battery_percent", "", test_batt_percent);
+  metrics_family(o, "beehive_acceleration_g", "gauge", "Accelerometer reading per axis.");
+  metrics_gauge(o, "beehive_acceleration_g", "axis=\"x\"", test_acc_x);
+  metrics_gauge(o, "beehive_acceleration_g", "axis=\"y\"", test_acc_y);
+  metrics_gauge(o, "beehive_acceleration_g", "axis=\"z\"", test_acc_z);
+}
+
+static void metrics_uploads(MetricsOut &o) {
+  SinkStats st[SINK_COUNT];
+  bool have[SINK_COUNT];
+  for (uint8_t k = 0; k < SINK_COUNT; ++k) have[k] = sinks_stats(k, st[k]);
+  char label[32];
+
+  metrics_family(o, "beehive_upload_sent", "counter", "Samples delivered per sink since boot.");
+  for (uint8_t k = 0; k < SINK_COUNT; ++k) {
+    if (!have[k]) continue;
+    snprintf(label, sizeof(label), "sink=\"%s\"", st[k].name);
+    metrics_uint(o, "beehive_upload_sent_total", label, st[k].sent);
+  }
+  metrics_family(o, "beehive_upload_failed", "counter", "Failed send attempts per sink since boot.");
+  for (uint8_t k = 0; k < SINK_COUNT; ++k) {
+    if (!have[k]) continue;
+    snprintf(label, sizeof(label), "sink=\"%s\"", st[k].name);
+    metrics_uint(o, "beehive_upload_failed_total", label, st[k].failed);
+  }
+  metrics_family(o, "beehive_queue_pending_samples", "gauge", "Samples in the SD queue not yet delivered, per active sink.");
+  for (uint8_t k = 0; k < SINK_COUNT; ++k) {
+    if (!have[k] || !st[k].active) continue;
+    snprintf(label, sizeof(label), "sink=\"%s\"", st[k].name);
+    metrics_uint(o, "beehive_queue_pending_samples", label, tsq_pending(k));
+  }
+
+  metrics_family(o, "beehive_upload_mode", "stateset", "Upload scheduler mode.");
+  SchedMode mode = sched_mode();
+  for (uint8_t m = SCHED_FLUSH; m <= SCHED_SAVE; ++m) {
+    snprintf(label, sizeof(label), "beehive_upload_mode=\"%s\"", sched_modeName((SchedMode)m));
+    metrics_uint(o, "beehive_upload_mode", label, m == mode ? 1 : 0);
+  }
+}
+
+static void metrics_links(MetricsOut &o) {
+  if (WiFi.status() == WL_CONNECTED) {
+    metrics_family(o, "beehive_wifi_rssi_dbm", "gauge", "WiFi signal of the joined access point.");
+    metrics_gauge(o, "beehive_wifi_rssi_dbm", "", WiFi.RSSI());
+  }
+  metrics_family(o, "beehive_modem_ready", "gauge", "1 once the LTE modem answered AT after power-up.");
+  metrics_uint(o, "beehive_modem_ready", "", modem_isReady() ? 1 : 0);
+  int16_t csq = sched_csq();
+  if (csq != 99) {
+    metrics_family(o, "beehive_modem_csq", "gauge", "Last sampled LTE signal quality (AT+CSQ, 0-31).");
+    metrics_uint(o, "beehive_modem_csq", "", csq);
+  }
+  metrics_family(o, "beehive_time_valid", "gauge", "1 when the clock is synchronised.");
+  metrics_uint(o, "beehive_time_valid", "", timeManager_isTimeValid() ? 1 : 0);
+}
+
+static void metrics_device(MetricsOut &o) {
+  metrics_family(o, "beehive_uptime_seconds", "gauge", "Time since boot.");
+  metrics_uint(o, "beehive_uptime_seconds", "", millis() / 1000);
+  metrics_family(o, "beehive_heap_free_bytes", "gauge", "Free heap.");
+  metrics_uint(o, "beehive_heap_free_bytes", "", ESP.getFreeHeap());
+  metrics_family(o, "beehive_heap_min_free_bytes", "gauge", "Lowest free heap since boot.");
+  metrics_uint(o, "beehive_heap_min_free_bytes", "", ESP.getMinFreeHeap());
+  metrics_family(o, "beehive_heap_largest_block_bytes", "gauge", "Largest allocatable heap block.");
+  metrics_uint(o, "beehive_heap_largest_block_bytes", "", heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+  metrics_family(o, "beehive_http_scrapes", "counter", "Requests to /metrics since boot.");
+  metrics_uint(o, "beehive_http_scrapes_total", "", s_scrapes);
+
+#if ENABLE_PERF_STATS
+  // perf_stats buckets are log2 microseconds (bucket b holds [2^b, 2^(b+1)) us);
+  // every second boundary is exported (x4 steps) to keep a scrape short
+  metrics_family(o, "beehive_loop_stage_seconds", "histogram", "Duration of each loop() stage.");
+  char label[48];
+  for (uint8_t i = 0; i < PERF_STAGE_COUNT; ++i) {
+    PerfHistogram h;
+    perf_histogram((PerfStage)i, h);
+    const char *stage = perf_stageName((PerfStage)i);
+    uint32_t acc = 0;
+    for (uint8_t b = 0; b + 1 < PERF_BUCKETS; ++b) {
+      acc += h.buckets[b];
+      if (!(b & 1)) continue;
+      snprintf(label, sizeof(label), "stage=\"%s\",le=\"%.9g\"", stage, (double)(2UL << b) / 1e6);
+      metrics_uint(o, "beehive_loop_stage_seconds_bucket", label, acc);
+    }
+    snprintf(label, sizeof(label), "stage=\"%s\",le=\"+Inf\"", stage);
+    metrics_uint(o, "beehive_loop_stage_seconds_bucket", label, h.count);
+    snprintf(label, sizeof(label), "stage=\"%s\"", stage);
+    metrics_uint(o, "beehive_loop_stage_seconds_count", label, h.count);
+    metrics_gauge(o, "beehive_loop_stage_seconds_sum", label, (double)h.sumUs / 1e6);
+  }
+#endif
+}
+
+static esp_err_t metrics_handle(httpd_req_t *req) {
+  s_scrapes++;
+  httpd_resp_set_type(req, "application/openmetrics-text; version=1.0.0; charset=utf-8");
+  MetricsOut o = { req, 0, false };
+  metrics_hive(o);
+  metrics_uploads(o);
+  metrics_links(o);
+  metrics_device(o);
+  metrics_printf(o, "# EOF\n");
+  metrics_flush(o);
+  if (o.failed) return ESP_FAIL;
+  return httpd_resp_send_chunk(req, nullptr, 0);
+}
+
+void metrics_endpoint_init() {
+  http_on("/metrics", HTTP_GET, metrics_handle);
+}
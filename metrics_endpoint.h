@@ -0,0 +1,25 @@
+#ifndef METRICS_ENDPOINT_H
+#define METRICS_ENDPOINT_H
+
+#include <Arduino.h>
+
+// GET /metrics: Prometheus scrape target in OpenMetrics text format.
+//
+//   hive       beehive_weight_kilograms, beehive_temperature_celsius{sensor},
+//              beehive_humidity_percent{sensor}, beehive_pressure_pascals,
+//              beehive_battery_volts / _percent, beehive_acceleration_g{axis}
+//   uploads    beehive_upload_sent_total / _failed_total{sink},
+//              beehive_queue_pending_samples{sink}, beehive_upload_mode
+//   links      beehive_wifi_rssi_dbm, beehive_modem_ready, beehive_modem_csq
+//   device     beehive_uptime_seconds, beehive_heap_*_bytes,
+//              beehive_loop_stage_seconds{stage} (histogram of perf_stats)
+//
+// The text is written with httpd_resp_send_chunk() from one fixed buffer,
+// no String is built. Modem values are the cached ones (upload_scheduler),
+// a scrape never sends AT commands.
+
+#define METRICS_CHUNK_BYTES 1024
+
+void metrics_endpoint_init();    // registers /metrics
+
+#endif // METRICS_ENDPOINT_H
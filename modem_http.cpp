@@ -0,0 +1,98 @@
+// modem_http.cpp - HTTP(S) POST through the A7670's built-in HTTP client.
+
+#include "modem_http.h"
+#include "modem_manager.h"
+#include "config.h"
+#include <TinyGsmClient.h>
+
+// Replies are read with TinyGSM's waitResponse(), never straight off the
+// UART: it hands the socket URCs it meets (+CIPRXGET, +IPCLOSE, ...) to
+// the open TinyGsmClients, so an MQTT session over LTE keeps its data and
+// close notifications while the modem works on a request.
+
+static bool mhttp_at(const char *cmd) {
+  TinyGsm &modem = modem_get();
+  modem.sendAT(cmd);
+  return modem.waitResponse(MODEM_HTTP_AT_MS) == 1;
+}
+
+static int mhttp_fail(const char *step, int ret) {
+  Serial.printf("[MHTTP] %s failed\n", step);
+  mhttp_at("+HTTPTERM");
+  return ret;
+}
+
+// AT+HTTPREAD=0,<n>: OK, "+HTTPREAD: <len>", <len> raw bytes, "+HTTPREAD: 0"
+static void mhttp_read(size_t avail, char *resp, size_t cap) {
+  if (!cap) return;
+  size_t want = avail < cap - 1 ? avail : cap - 1;
+  if (!want) return;
+  TinyGsm &modem = modem_get();
+  char cmd[32];
+  snprintf(cmd, sizeof(cmd), "+HTTPREAD=0,%u", (unsigned)want);
+  modem.sendAT(cmd);
+  if (modem.waitResponse(MODEM_HTTP_AT_MS, GF("+HTTPREAD:")) != 1) return;
+  size_t n = (size_t)modem.stream.readStringUntil('\n').toInt();
+  unsigned long deadline = millis() + MODEM_HTTP_AT_MS;
+  size_t got = 0;
+  while (got < n && (long)(deadline - millis()) > 0) {
+    if (!modem.stream.available()) {
+      delay(2);
+      continue;
+    }
+    char c = (char)modem.stream.read();
+    if (got < want) resp[got] = c;
+    got++;
+  }
+  resp[got < want ? got : want] = '\0';
+  modem.waitResponse(MODEM_HTTP_AT_MS, GF("+HTTPREAD: 0"));
+}
+
+int mhttp_post(const char *url, const char *contentType, const char *body, size_t len,
+               char *resp, size_t cap) {
+  TinyGsm &modem = modem_get();
+  char cmd[160];
+  if (cap) resp[0] = '\0';
+
+  mhttp_at("+HTTPTERM");                // session left open by an earlier failure
+  if (!mhttp_at("+HTTPINIT")) return mhttp_fail("HTTPINIT", MHTTP_NOT_SENT);
+
+  if (strncmp(url, "https://", 8) == 0) {
+    // TLS 1.2 with SNI in SSL context 0; older firmwares take https without these
+    mhttp_at("+CSSLCFG=\"sslversion\",0,4");
+    mhttp_at("+CSSLCFG=\"authmode\",0,0");
+    mhttp_at("+CSSLCFG=\"enableSNI\",0,1");
+    mhttp_at("+HTTPPARA=\"SSLCFG\",0");
+  }
+  if (snprintf(cmd, sizeof(cmd), "+HTTPPARA=\"URL\",\"%s\"", url) >= (int)sizeof(cmd) || !mhttp_at(cmd)) {
+    return mhttp_fail("URL", MHTTP_NOT_SENT);
+  }
+  snprintf(cmd, sizeof(cmd), "+HTTPPARA=\"CONTENT\",\"%s\"", contentType);
+  if (!mhttp_at(cmd)) return mhttp_fail("CONTENT", MHTTP_NOT_SENT);
+
+  snprintf(cmd, sizeof(cmd), "+HTTPDATA=%u,%u", (unsigned)len, (unsigned)(MODEM_HTTP_AT_MS / 1000));
+  modem.sendAT(cmd);
+  if (modem.waitResponse(MODEM_HTTP_AT_MS, GF("DOWNLOAD")) != 1) return mhttp_fail("HTTPDATA", MHTTP_NOT_SENT);
+  modem.stream.write((const uint8_t *)body, len);
+  if (modem.waitResponse(MODEM_HTTP_AT_MS) != 1) return mhttp_fail("HTTPDATA", MHTTP_NOT_SENT);
+
+  // From here the request may have reached the server
+  modem.sendAT("+HTTPACTION=1");
+  if (modem.waitResponse(MODEM_HTTP_ACTION_MS, GF("+HTTPACTION:")) != 1) return mhttp_fail("HTTPACTION", 0);
+  int method = 0, status = 0;
+  unsigned long avail = 0;
+  String line = modem.stream.readStringUntil('\n');      // " 1,200,4"
+  if (sscanf(line.c_str(), "%d,%d,%lu", &method, &status, &avail) < 2) return mhttp_fail("HTTPACTION", 0);
+  if (status >= 600) {
+    // 7xx: the modem's own error (DNS, TLS handshake, network timeout)
+    Serial.printf("[MHTTP] modem error %d\n", status);
+    return mhttp_fail("request", 0);
+  }
+  mhttp_read(avail, resp, cap);
+  mhttp_at("+HTTPTERM");
+
+#if ENABLE_DEBUG
+  Serial.printf("[MHTTP] POST %s -> %d (%lu bytes) '%s'\n", url, status, avail, cap ? resp : "");
+#endif
+  return status;
+}
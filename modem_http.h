@@ -0,0 +1,38 @@
+#ifndef MODEM_HTTP_H
+#define MODEM_HTTP_H
+
+#include <Arduino.h>
+
+// HTTP(S) POST handed to the A7670's own HTTP client (AT+HTTPINIT /
+// HTTPPARA / HTTPDATA / HTTPACTION / HTTPREAD / HTTPTERM). Only the body
+// goes over the UART, and only the status and the first bytes of the reply
+// come back; TLS runs in the modem, so https works with any TinyGSM fork.
+//
+// The modem does not verify the server certificate (it has no CA store
+// loaded): the link is encrypted, not authenticated.
+//
+// Loop task only, like every other user of the modem.
+
+#ifndef MODEM_HTTP_ENABLE
+#define MODEM_HTTP_ENABLE 1              // 0 = ThingSpeak over TinyGSM TCP sockets as before
+#endif
+
+#ifndef MODEM_HTTP_AT_MS
+#define MODEM_HTTP_AT_MS 5000            // plain AT round trip
+#endif
+
+#ifndef MODEM_HTTP_ACTION_MS
+#define MODEM_HTTP_ACTION_MS 60000UL     // DNS + TLS handshake + request on a slow cell
+#endif
+
+#define MHTTP_NOT_SENT (-1)              // failed before HTTPACTION: nothing reached the server
+
+// POST body[len] to url (http:// or https://). The reply body, cut to
+// cap - 1 bytes, is left NUL-terminated in resp. Returns the HTTP status,
+// 0 when the request went out but no usable answer came back, or
+// MHTTP_NOT_SENT when the modem refused the setup (no HTTP stack, no PDP
+// context); only then is it safe to retry over another transport.
+int mhttp_post(const char *url, const char *contentType, const char *body, size_t len,
+               char *resp, size_t cap);
+
+#endif // MODEM_HTTP_H
@@ -1,5 +1,6 @@
 // modem_manager.cpp (patched - full)
 // Contains: modem_hw_init(), modem_get(), modemManager_init(),
+// modemManager_startAsync() + readiness events,
 // modem_isNetworkRegistered(), modem_getRSSI(), modem_getOperator().
 
 #include "modem_manager.h"
@@ -7,6 +8,8 @@
 #include <HardwareSerial.h>
 #include <TinyGsmClient.h>
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
 
 // ---------------------------------------------------------
 // Physical serial port for modem (ESP32 UART2)
@@ -14,6 +17,25 @@ HardwareSerial SerialAT(2);  // UART2 on ESP32
 
 static TinyGsm* _modem = nullptr;
 
+// ---------------------------------------------------------
+// Bring-up completion events
+// ---------------------------------------------------------
+#define MODEM_EVT_READY  (1 << 0)   // modem answered AT after restart
+#define MODEM_EVT_GPRS   (1 << 1)   // GPRS attached by the bring-up task
+#define MODEM_EVT_DONE   (1 << 2)   // bring-up task finished (any result)
+
+#ifndef MODEM_BOOT_TASK_STACK
+#define MODEM_BOOT_TASK_STACK 6144
+#endif
+
+static EventGroupHandle_t s_modemEvents = nullptr;
+static bool s_bootAttachGprs = false;
+
+static EventGroupHandle_t modem_events() {
+    if (!s_modemEvents) s_modemEvents = xEventGroupCreate();
+    return s_modemEvents;
+}
+
 // ---------------------------------------------------------
 // Helper: power-up sequences and AT check
 // ---------------------------------------------------------
@@ -161,7 +183,8 @@ TinyGsm& modem_get() {
 // ---------------------------------------------------------
 // Initialization
 // ---------------------------------------------------------
-void modemManager_init()
+// Power-up, restart and CFUN=1. Returns true when the modem answers AT.
+static bool modem_bringUp()
 {
     // safe to call modem_hw_init here as well
     modem_hw_init();
@@ -181,9 +204,89 @@ void modemManager_init()
     modem.sendAT("+CFUN=1");
     modem.waitResponse(1000);
 
+    bool ok = modem.testAT(1000);
+
 #if ENABLE_DEBUG
     Serial.println(F("[modemManager_init] modemManager_init completed"));
 #endif
+    return ok;
+}
+
+void modemManager_init()
+{
+    if (modem_bringUp()) xEventGroupSetBits(modem_events(), MODEM_EVT_READY);
+    xEventGroupSetBits(modem_events(), MODEM_EVT_DONE);
+}
+
+// ---------------------------------------------------------
+// Background bring-up task
+// ---------------------------------------------------------
+static void modem_boot_task(void *pvParameters) {
+    (void) pvParameters;
+    unsigned long t0 = millis();
+
+    // The modem is owned by this task until the bits below are published,
+    // so READY is only set once the GPRS attempt is finished as well.
+    EventBits_t bits = MODEM_EVT_DONE;
+    if (modem_bringUp()) {
+        bits |= MODEM_EVT_READY;
+        if (s_bootAttachGprs) {
+#if ENABLE_DEBUG
+            Serial.println(F("[ModemBoot] attempting GPRS attach"));
+#endif
+            TinyGsm &modem = modem_get();
+            if (modem.gprsConnect(MODEM_APN, MODEM_GPRS_USER, MODEM_GPRS_PASS)) bits |= MODEM_EVT_GPRS;
+        }
+    }
+    xEventGroupSetBits(modem_events(), bits);
+
+#if ENABLE_DEBUG
+    Serial.printf("[ModemBoot] done in %lu ms (ready=%d gprs=%d)\n",
+                  millis() - t0, (bits & MODEM_EVT_READY) ? 1 : 0, (bits & MODEM_EVT_GPRS) ? 1 : 0);
+#else
+    (void) t0;
+#endif
+    vTaskDelete(NULL);
+}
+
+void modemManager_startAsync(bool attachGprs) {
+    EventGroupHandle_t ev = modem_events();
+    xEventGroupClearBits(ev, MODEM_EVT_READY | MODEM_EVT_GPRS | MODEM_EVT_DONE);
+    s_bootAttachGprs = attachGprs;
+
+    BaseType_t r = xTaskCreatePinnedToCore(
+        modem_boot_task,
+        "ModemBoot",
+        MODEM_BOOT_TASK_STACK,
+        NULL,
+        1,
+        NULL,
+        0
+    );
+    if (r != pdPASS) {
+        // Fall back to the old blocking bring-up rather than leaving the modem down.
+        Serial.println(F("[ModemBoot] task create failed - initializing inline"));
+        modemManager_init();
+    }
+}
+
+bool modem_isReady() {
+    return (xEventGroupGetBits(modem_events()) & MODEM_EVT_READY) != 0;
+}
+
+bool modem_isBootDone() {
+    return (xEventGroupGetBits(modem_events()) & MODEM_EVT_DONE) != 0;
+}
+
+bool modem_waitReady(uint32_t timeoutMs) {
+    // Returns as soon as the modem is usable, or when bring-up gave up.
+    EventBits_t bits = xEventGroupWaitBits(modem_events(), MODEM_EVT_READY | MODEM_EVT_DONE,
+                                           pdFALSE, pdFALSE, pdMS_TO_TICKS(timeoutMs));
+    return (bits & MODEM_EVT_READY) != 0;
+}
+
+bool modem_bootGprsAttached() {
+    return (xEventGroupGetBits(modem_events()) & MODEM_EVT_GPRS) != 0;
 }
 
 // ---------------------------------------------------------
@@ -191,6 +294,7 @@ void modemManager_init()
 // ---------------------------------------------------------
 bool modem_isNetworkRegistered()
 {
+    if (!modem_isReady()) return false;
     TinyGsm &modem = modem_get();
     int stat = modem.getRegistrationStatus();
     return (stat == 1 || stat == 5);
@@ -201,6 +305,7 @@ bool modem_isNetworkRegistered()
 // ---------------------------------------------------------
 int16_t modem_getRSSI()
 {
+    if (!modem_isReady()) return 99;   // CSQ "not known"
     TinyGsm &modem = modem_get();
     // TinyGsm returns signal quality (0-31 or 99); return as int16_t
     return modem.getSignalQuality();
@@ -211,6 +316,7 @@ int16_t modem_getRSSI()
 // ---------------------------------------------------------
 String modem_getOperator()
 {
+    if (!modem_isReady()) return String();
     TinyGsm &modem = modem_get();
     return modem.getOperator();
 }
\ No newline at end of file
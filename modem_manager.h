@@ -14,6 +14,12 @@
 // Expose the global modem instance
 TinyGsm& modem_get();
 
+// TinyGSM socket numbers. Users that can be open at the same time need
+// their own: opening a socket already in use drops the other session.
+#define MODEM_MUX_REQUEST 0     // short request/response sockets (TinyGsmClient default)
+#define MODEM_MUX_MQTT    1     // mqtt_sink's long-lived session
+#define MODEM_MUX_OTA     2     // ota_update's LTE pull
+
 // ---------------------------------------------------------------------
 // Public API
 // ---------------------------------------------------------------------
@@ -23,5 +29,19 @@ String modem_getOperator();
 
 void modemManager_init();
 
+// ---------------------------------------------------------------------
+// Background bring-up
+// ---------------------------------------------------------------------
+// Starts a FreeRTOS task that runs the power sequence, modem.restart(),
+// CFUN=1 and (optionally) the GPRS attach while setup() keeps going with
+// the LCD, SD and WiFi. Other modules must not touch the modem until
+// modem_isReady() returns true.
+void modemManager_startAsync(bool attachGprs);
+
+bool modem_isReady();                    // bring-up finished and modem answered AT
+bool modem_isBootDone();                 // bring-up task finished (success or not)
+bool modem_waitReady(uint32_t timeoutMs); // block until ready (or timeout)
+bool modem_bootGprsAttached();           // GPRS attach done by the bring-up task
+
 // Hardware init helper (power/reset/pwrkey sequence)
 void modem_hw_init();
\ No newline at end of file
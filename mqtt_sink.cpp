@@ -0,0 +1,297 @@
+// mqtt_sink.cpp - MQTT 3.1.1 telemetry sink over WiFiClient / TinyGsmClient.
+
+#include "mqtt_sink.h"
+#include "modem_manager.h"
+#include "config.h"
+#include <WiFi.h>
+
+#define MQTT_BATCH_MAX 16            // acks are tracked in a 32-bit mask
+
+#define MQTT_CONNECT    0x10
+#define MQTT_CONNACK    0x20
+#define MQTT_PUBLISH_Q1 0x32
+#define MQTT_PUBACK     0x40
+#define MQTT_PINGREQ    0xC0
+#define MQTT_PINGRESP   0xD0
+#define MQTT_DISCONNECT 0xE0
+
+enum MqttLink { LINK_NONE = 0, LINK_WIFI, LINK_LTE };
+
+static WiFiClient     s_wifiClient;
+static TinyGsmClient *s_lteClient = nullptr;   // MODEM_MUX_MQTT
+static Client        *s_client = nullptr;
+static MqttLink       s_link = LINK_NONE;
+static uint16_t       s_packetId = 0;
+static unsigned long  s_lastTxMs = 0;
+static unsigned long  s_pingSentMs = 0;        // 0 = no PINGREQ outstanding
+static uint32_t       s_connects = 0;
+static uint32_t       s_published = 0;
+static char           s_topic[48] = "";
+
+// ---------------------------------------------------------
+// Packet helpers
+// ---------------------------------------------------------
+static size_t mqtt_putLen(uint8_t *p, uint32_t len) {
+  size_t n = 0;
+  do {
+    uint8_t b = len & 0x7F;
+    len >>= 7;
+    p[n++] = len ? (b | 0x80) : b;
+  } while (len);
+  return n;
+}
+
+static size_t mqtt_putStr(uint8_t *p, const char *s) {
+  size_t n = strlen(s);
+  p[0] = n >> 8;
+  p[1] = n & 0xFF;
+  memcpy(p + 2, s, n);
+  return n + 2;
+}
+
+static bool mqtt_write(const uint8_t *buf, size_t len) {
+  if (s_client->write(buf, len) != len) return false;
+  s_lastTxMs = millis();
+  return true;
+}
+
+// Read one packet; keeps up to cap body bytes and skips the rest.
+// Returns the first header byte, 0 on timeout or a dropped connection.
+static uint8_t mqtt_readPacket(uint8_t *body, size_t cap, size_t &len, unsigned long timeoutMs) {
+  unsigned long start = millis();
+  auto readByte = [&](uint8_t &b) -> bool {
+    while (!s_client->available()) {
+      if (millis() - start >= timeoutMs || !s_client->connected()) return false;
+      delay(5);
+    }
+    b = (uint8_t)s_client->read();
+    return true;
+  };
+
+  uint8_t type, b;
+  if (!readByte(type)) return 0;
+  uint32_t rem = 0;
+  uint8_t shift = 0;
+  do {
+    if (shift > 21 || !readByte(b)) return 0;
+    rem |= (uint32_t)(b & 0x7F) << shift;
+    shift += 7;
+  } while (b & 0x80);
+
+  len = 0;
+  for (uint32_t i = 0; i < rem; ++i) {
+    if (!readByte(b)) return 0;
+    if (len < cap) body[len++] = b;
+  }
+  return type;
+}
+
+static uint16_t mqtt_nextId() {
+  if (++s_packetId == 0) s_packetId = 1;
+  return s_packetId;
+}
+
+// ---------------------------------------------------------
+// Session
+// ---------------------------------------------------------
+bool mqtt_isConnected() {
+  return s_client && s_client->connected();
+}
+
+void mqtt_disconnect() {
+  if (s_client) {
+    if (s_client->connected()) {
+      const uint8_t d[2] = { MQTT_DISCONNECT, 0 };
+      s_client->write(d, sizeof(d));
+    }
+    s_client->stop();
+  }
+  s_client = nullptr;
+  s_link = LINK_NONE;
+  s_pingSentMs = 0;
+}
+
+static MqttLink mqtt_currentLink() {
+  if (WiFi.status() == WL_CONNECTED) return LINK_WIFI;
+  if (modem_isNetworkRegistered()) return LINK_LTE;
+  return LINK_NONE;
+}
+
+static bool mqtt_connect(MqttLink link) {
+  mqtt_disconnect();
+  if (link == LINK_WIFI) {
+    s_client = &s_wifiClient;
+  } else {
+    if (!s_lteClient) s_lteClient = new TinyGsmClient(modem_get(), MODEM_MUX_MQTT);
+    s_client = s_lteClient;
+  }
+  if (!s_client->connect(MQTT_HOST, MQTT_PORT)) {
+    Serial.printf("[MQTT] TCP connect to %s:%d failed\n", MQTT_HOST, MQTT_PORT);
+    s_client = nullptr;
+    return false;
+  }
+
+  const char *id = sinks_deviceId();
+  uint8_t flags = 0x02;                       // clean session
+  if (MQTT_USER[0]) flags |= 0x80;
+  if (MQTT_PASS[0]) flags |= 0x40;
+  size_t bodyLen = 10 + 2 + strlen(id);
+  if (MQTT_USER[0]) bodyLen += 2 + strlen(MQTT_USER);
+  if (MQTT_PASS[0]) bodyLen += 2 + strlen(MQTT_PASS);
+
+  uint8_t pkt[192];
+  if (bodyLen + 5 > sizeof(pkt)) {
+    Serial.println(F("[MQTT] credentials too long"));
+    mqtt_disconnect();
+    return false;
+  }
+  size_t n = 0;
+  pkt[n++] = MQTT_CONNECT;
+  n += mqtt_putLen(pkt + n, bodyLen);
+  n += mqtt_putStr(pkt + n, "MQTT");
+  pkt[n++] = 4;                                // protocol level 3.1.1
+  pkt[n++] = flags;
+  pkt[n++] = MQTT_KEEPALIVE_S >> 8;
+  pkt[n++] = MQTT_KEEPALIVE_S & 0xFF;
+  n += mqtt_putStr(pkt + n, id);
+  if (MQTT_USER[0]) n += mqtt_putStr(pkt + n, MQTT_USER);
+  if (MQTT_PASS[0]) n += mqtt_putStr(pkt + n, MQTT_PASS);
+
+  uint8_t ack[4];
+  size_t ackLen = 0;
+  if (!mqtt_write(pkt, n) ||
+      mqtt_readPacket(ack, sizeof(ack), ackLen, MQTT_ACK_TIMEOUT_MS) != MQTT_CONNACK || ackLen < 2 || ack[1] != 0) {
+    Serial.printf("[MQTT] broker refused connection (rc %d)\n", ackLen >= 2 ? ack[1] : -1);
+    mqtt_disconnect();
+    return false;
+  }
+
+  s_link = link;
+  s_connects++;
+  Serial.printf("[MQTT] connected to %s:%d via %s\n", MQTT_HOST, MQTT_PORT, link == LINK_WIFI ? "WiFi" : "LTE");
+  return true;
+}
+
+// ---------------------------------------------------------
+// Sink
+// ---------------------------------------------------------
+static size_t mqtt_payload(const TelemetrySample &s, char *buf, size_t bufsz) {
+  int n = snprintf(buf, bufsz, "%lu", (unsigned long)s.ts);
+  for (int c = 0; c < CH_COUNT && n > 0 && (size_t)n < bufsz; ++c) {
+    n += snprintf(buf + n, bufsz - n, ",%ld", (long)s.v[c]);
+  }
+  return (n > 0 && (size_t)n < bufsz) ? (size_t)n : 0;
+}
+
+// Publish the whole batch, then collect the PUBACKs. Returns the number of
+// leading samples the broker acknowledged.
+static uint8_t mqtt_send(const TelemetrySample *batch, uint8_t n) {
+  MqttLink want = mqtt_currentLink();
+  if (want == LINK_NONE) return 0;
+  if ((!mqtt_isConnected() || s_link != want) && !mqtt_connect(want)) return 0;
+  if (n > MQTT_BATCH_MAX) n = MQTT_BATCH_MAX;
+  if (!s_topic[0]) snprintf(s_topic, sizeof(s_topic), MQTT_TOPIC_PREFIX "/%s/t", sinks_deviceId());
+
+  uint16_t ids[MQTT_BATCH_MAX];
+  size_t topicLen = strlen(s_topic);
+  for (uint8_t i = 0; i < n; ++i) {
+    char payload[96];
+    size_t plen = mqtt_payload(batch[i], payload, sizeof(payload));
+    uint8_t pkt[5 + 2 + sizeof(s_topic) + 2 + sizeof(payload)];
+    size_t len = 0;
+    ids[i] = mqtt_nextId();
+    pkt[len++] = MQTT_PUBLISH_Q1;
+    len += mqtt_putLen(pkt + len, 2 + topicLen + 2 + plen);
+    len += mqtt_putStr(pkt + len, s_topic);
+    pkt[len++] = ids[i] >> 8;
+    pkt[len++] = ids[i] & 0xFF;
+    memcpy(pkt + len, payload, plen);
+    len += plen;
+    if (!mqtt_write(pkt, len)) {
+      mqtt_disconnect();
+      return 0;
+    }
+  }
+
+  uint32_t acked = 0;
+  const uint32_t all = (1u << n) - 1;
+  unsigned long start = millis();
+  while (acked != all) {
+    unsigned long spent = millis() - start;
+    if (spent >= MQTT_ACK_TIMEOUT_MS) break;
+    uint8_t body[4];
+    size_t len = 0;
+    uint8_t type = mqtt_readPacket(body, sizeof(body), len, MQTT_ACK_TIMEOUT_MS - spent);
+    if (!type) break;
+    if ((type & 0xF0) == MQTT_PUBACK && len >= 2) {
+      uint16_t id = (body[0] << 8) | body[1];
+      for (uint8_t i = 0; i < n; ++i) {
+        if (ids[i] == id) acked |= 1u << i;
+      }
+    } else if (type == MQTT_PINGRESP) {
+      s_pingSentMs = 0;
+    }
+  }
+
+  uint8_t ok = 0;
+  while (ok < n && (acked & (1u << ok))) ok++;
+  // the broker may still deliver the rest; they are sent again (QoS 1 is
+  // at-least-once anyway) on a clean session
+  if (ok < n) mqtt_disconnect();
+  s_published += ok;
+  return ok;
+}
+
+static void mqtt_loop() {
+  if (!s_client) return;
+  if (!s_client->connected()) {
+    Serial.println(F("[MQTT] connection lost"));
+    mqtt_disconnect();
+    return;
+  }
+  // WiFi is preferred: leave LTE once it is back, and a WiFi session once it is gone
+  if ((s_link == LINK_WIFI) != (WiFi.status() == WL_CONNECTED)) {
+    mqtt_disconnect();
+    return;
+  }
+
+  while (s_client->available()) {
+    uint8_t body[4];
+    size_t len;
+    uint8_t type = mqtt_readPacket(body, sizeof(body), len, 200);
+    if (!type) break;
+    if (type == MQTT_PINGRESP) s_pingSentMs = 0;
+  }
+
+  unsigned long now = millis();
+  if (s_pingSentMs && now - s_pingSentMs > MQTT_ACK_TIMEOUT_MS) {
+    Serial.println(F("[MQTT] no PINGRESP, dropping session"));
+    mqtt_disconnect();
+  } else if (!s_pingSentMs && now - s_lastTxMs >= MQTT_KEEPALIVE_S * 1000UL / 2) {
+    const uint8_t ping[2] = { MQTT_PINGREQ, 0 };
+    if (mqtt_write(ping, sizeof(ping))) s_pingSentMs = now;
+    else mqtt_disconnect();
+  }
+}
+
+static bool mqtt_enabled() {
+  return MQTT_HOST[0] != '\0';
+}
+
+static bool mqtt_ready() {
+  return mqtt_isConnected() || mqtt_currentLink() != LINK_NONE;
+}
+
+const TelemetrySink &mqtt_sink() {
+  static const TelemetrySink sink = {
+    "mqtt", mqtt_enabled, mqtt_ready, mqtt_send, mqtt_loop,
+    MQTT_BATCH_MAX, 0, 10000UL, 300000UL
+  };
+  return sink;
+}
+
+void mqtt_print(Print &out) {
+  out.printf("[MQTT] broker %s:%d, %s", mqtt_enabled() ? MQTT_HOST : "(none)", MQTT_PORT,
+             mqtt_isConnected() ? (s_link == LINK_WIFI ? "connected via WiFi" : "connected via LTE") : "not connected");
+  out.printf(", sessions %lu, published %lu\n", (unsigned long)s_connects, (unsigned long)s_published);
+}
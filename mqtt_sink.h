@@ -0,0 +1,49 @@
+#ifndef MQTT_SINK_H
+#define MQTT_SINK_H
+
+#include <Arduino.h>
+#include "telemetry_sink.h"
+
+// Minimal MQTT 3.1.1 client for the telemetry sink: one persistent TCP
+// session (WiFi, or the modem's second socket when only LTE is up),
+// QoS 1 publishes pipelined per batch, PINGREQ keepalive.
+//
+// Topic:   MQTT_TOPIC_PREFIX/<device id>/t
+// Payload: "ts,weight,temp_int,hum_int,temp_ext,hum_ext,pressure,batt" in the
+//          fixed-point units of TelemetrySample (~40 bytes per sample)
+//
+// The sink is disabled while MQTT_HOST is empty.
+
+#ifndef MQTT_HOST
+#define MQTT_HOST ""
+#endif
+
+#ifndef MQTT_PORT
+#define MQTT_PORT 1883
+#endif
+
+#ifndef MQTT_USER
+#define MQTT_USER ""
+#endif
+
+#ifndef MQTT_PASS
+#define MQTT_PASS ""
+#endif
+
+#ifndef MQTT_TOPIC_PREFIX
+#define MQTT_TOPIC_PREFIX "beehive"
+#endif
+
+#ifndef MQTT_KEEPALIVE_S
+#define MQTT_KEEPALIVE_S 60
+#endif
+
+#ifndef MQTT_ACK_TIMEOUT_MS
+#define MQTT_ACK_TIMEOUT_MS 10000
+#endif
+
+bool mqtt_isConnected();
+void mqtt_disconnect();
+void mqtt_print(Print &out);
+
+#endif // MQTT_SINK_H
@@ -0,0 +1,280 @@
+// ota_payload.cpp - raw / zlib / delta OTA payload decoder.
+
+#include "ota_payload.h"
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <esp32/rom/miniz.h>          // tinfl in ROM
+
+#define OTA_WINDOW_BYTES (1UL << OTA_INFLATE_WINDOW_BITS)
+
+enum OtaDeltaOp { DOP_END = 0, DOP_ADD, DOP_COPY, DOP_PATCH };
+enum OtaDeltaStep { DSTEP_OP = 0, DSTEP_OFFSET, DSTEP_LEN, DSTEP_DATA, DSTEP_DONE };
+
+static OtaImageSink     s_sink = nullptr;
+static OtaPayloadFormat s_format = OTAP_UNKNOWN;
+static const char      *s_error = "";
+static bool             s_failed = false;
+static uint8_t          s_head[OTA_DELTA_HEADER_BYTES];
+static uint8_t          s_headLen = 0;
+static uint32_t         s_image = 0;
+
+// Inflate, allocated only while a compressed payload is open
+static tinfl_decompressor *s_inflator = nullptr;
+static uint8_t *s_window = nullptr;
+static size_t   s_windowAt = 0;
+static bool     s_zlibChecked = false;
+static bool     s_inflated = false;   // stream end and Adler-32 seen
+
+// Delta
+static const esp_partition_t *s_base = nullptr;
+static uint32_t s_baseSize = 0;
+static uint32_t s_target = 0;
+static uint8_t  s_op = DOP_END;
+static uint8_t  s_step = DSTEP_OP;
+static uint32_t s_var = 0;
+static uint8_t  s_varShift = 0;
+static uint32_t s_baseAt = 0;         // running-image offset of the next COPY/PATCH byte
+static uint32_t s_left = 0;           // bytes left in the current operation
+static uint8_t  s_baseBuf[OTA_PAYLOAD_BASE_BYTES];
+
+static bool otap_fail(const char *why) {
+  if (!s_failed) s_error = why;
+  s_failed = true;
+  return false;
+}
+
+static bool otap_emit(const uint8_t *data, size_t len) {
+  if (s_target && s_image + len > s_target) return otap_fail("delta longer than its target");
+  s_image += len;
+  if (!s_sink(data, len)) return otap_fail("flash write failed");
+  return true;
+}
+
+static uint32_t otap_le32(const uint8_t *p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// ---------------------------------------------------------
+// Delta operations (the inflated stream of a delta payload)
+// ---------------------------------------------------------
+
+// COPY / PATCH: len bytes of the running image from s_baseAt, patch may be null
+static bool otap_fromBase(const uint8_t *patch, uint32_t len) {
+  while (len) {
+    size_t n = len < sizeof(s_baseBuf) ? len : sizeof(s_baseBuf);
+    if (esp_partition_read(s_base, s_baseAt, s_baseBuf, n) != ESP_OK) return otap_fail("cannot read running image");
+    if (patch) {
+      for (size_t i = 0; i < n; ++i) s_baseBuf[i] += patch[i];
+      patch += n;
+    }
+    if (!otap_emit(s_baseBuf, n)) return false;
+    s_baseAt += n;
+    len -= n;
+  }
+  return true;
+}
+
+static bool otap_ops(const uint8_t *p, size_t n) {
+  while (n) {
+    if (s_step == DSTEP_DONE) return otap_fail("data after END");
+
+    if (s_step == DSTEP_OP) {
+      s_op = *p++;
+      n--;
+      if (s_op > DOP_PATCH) return otap_fail("bad delta operation");
+      s_var = 0;
+      s_varShift = 0;
+      s_step = s_op == DOP_END ? DSTEP_DONE : s_op == DOP_ADD ? DSTEP_LEN : DSTEP_OFFSET;
+      continue;
+    }
+
+    if (s_step == DSTEP_OFFSET || s_step == DSTEP_LEN) {
+      uint8_t b = *p++;
+      n--;
+      if (s_varShift > 28) return otap_fail("bad varint");
+      s_var |= (uint32_t)(b & 0x7F) << s_varShift;
+      s_varShift += 7;
+      if (b & 0x80) continue;
+      uint32_t v = s_var;
+      s_var = 0;
+      s_varShift = 0;
+      if (s_step == DSTEP_OFFSET) {
+        s_baseAt += (uint32_t)((int32_t)(v >> 1) ^ -(int32_t)(v & 1));
+        s_step = DSTEP_LEN;
+        continue;
+      }
+      if (s_op != DOP_ADD && (s_baseAt > s_baseSize || v > s_baseSize - s_baseAt)) {
+        return otap_fail("delta reads past the running image");
+      }
+      s_left = v;
+      if (s_op == DOP_COPY) {
+        if (!otap_fromBase(nullptr, v)) return false;
+        s_left = 0;
+      }
+      s_step = s_left ? DSTEP_DATA : DSTEP_OP;
+      continue;
+    }
+
+    // DSTEP_DATA: ADD literals or PATCH bytes
+    size_t k = n < s_left ? n : s_left;
+    if (!(s_op == DOP_ADD ? otap_emit(p, k) : otap_fromBase(p, k))) return false;
+    p += k;
+    n -= k;
+    s_left -= k;
+    if (!s_left) s_step = DSTEP_OP;
+  }
+  return true;
+}
+
+// ---------------------------------------------------------
+// Inflate into the ring window; every output run is passed on
+// ---------------------------------------------------------
+static bool otap_decoded(const uint8_t *data, size_t len) {
+  return s_format == OTAP_DELTA ? otap_ops(data, len) : otap_emit(data, len);
+}
+
+static bool otap_inflate(const uint8_t *p, size_t n) {
+  if (s_inflated) return n == 0 || otap_fail("data after the compressed stream");
+  if (!s_zlibChecked && n) {
+    // CMF: deflate, window 2^(CINFO + 8)
+    if ((p[0] & 0x0F) != 8 || (p[0] >> 4) + 8 > OTA_INFLATE_WINDOW_BITS) {
+      return otap_fail("zlib window larger than OTA_INFLATE_WINDOW_BITS");
+    }
+    s_zlibChecked = true;
+  }
+  for (;;) {
+    size_t in = n;
+    size_t out = OTA_WINDOW_BYTES - s_windowAt;
+    tinfl_status st = tinfl_decompress(s_inflator, p, &in, s_window, s_window + s_windowAt, &out,
+                                       TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT);
+    p += in;
+    n -= in;
+    if (out && !otap_decoded(s_window + s_windowAt, out)) return false;
+    s_windowAt = (s_windowAt + out) & (OTA_WINDOW_BYTES - 1);
+    if (st < TINFL_STATUS_DONE) return otap_fail(st == TINFL_STATUS_ADLER32_MISMATCH ? "Adler-32 mismatch" : "corrupt zlib stream");
+    if (st == TINFL_STATUS_DONE) {
+      s_inflated = true;
+      return n == 0 || otap_fail("data after the compressed stream");
+    }
+    if (st == TINFL_STATUS_NEEDS_MORE_INPUT && n == 0) return true;
+  }
+}
+
+static bool otap_openInflate() {
+  s_inflator = (tinfl_decompressor *)malloc(sizeof(tinfl_decompressor));
+  s_window = (uint8_t *)malloc(OTA_WINDOW_BYTES);
+  if (!s_inflator || !s_window) return otap_fail("no memory for the inflate window");
+  tinfl_init(s_inflator);
+  s_windowAt = 0;
+  return true;
+}
+
+// ---------------------------------------------------------
+// Format detection
+// ---------------------------------------------------------
+
+// Delta header: the base must be the image we are running
+static bool otap_openDelta() {
+  s_target = otap_le32(s_head + 4);
+  s_baseSize = otap_le32(s_head + 8);
+  s_base = esp_ota_get_running_partition();
+  if (!s_base || s_baseSize > s_base->size) return otap_fail("delta base larger than the running slot");
+  uint8_t sha[32];
+  if (esp_partition_get_sha256(s_base, sha) != ESP_OK || memcmp(sha, s_head + 12, sizeof(sha)) != 0) {
+    return otap_fail("delta was made for another firmware");
+  }
+  s_baseAt = 0;
+  s_step = DSTEP_OP;
+  return otap_openInflate();
+}
+
+// Decide once 4 bytes (delta: the whole header) are in s_head
+static bool otap_detect() {
+  if (s_head[0] == 0xE9) {
+    s_format = OTAP_RAW;
+    return otap_emit(s_head, s_headLen);
+  }
+  if (memcmp(s_head, OTA_DELTA_MAGIC, 4) == 0) {
+    s_format = OTAP_DELTA;
+    return true;                      // waits for the rest of the header
+  }
+  if ((s_head[0] & 0x0F) == 8 && ((s_head[0] << 8) | s_head[1]) % 31 == 0) {
+    s_format = OTAP_ZLIB;
+    return otap_openInflate() && otap_inflate(s_head, s_headLen);
+  }
+  return otap_fail("unknown payload format");
+}
+
+void otap_begin(OtaImageSink sink) {
+  otap_end();
+  s_sink = sink;
+  s_format = OTAP_UNKNOWN;
+  s_error = "";
+  s_failed = false;
+  s_headLen = 0;
+  s_image = 0;
+  s_target = 0;
+  s_zlibChecked = false;
+  s_inflated = false;
+}
+
+bool otap_feed(const uint8_t *data, size_t len) {
+  if (s_failed) return false;
+  if (s_format == OTAP_UNKNOWN || (s_format == OTAP_DELTA && !s_inflator)) {
+    size_t need = (s_format == OTAP_DELTA ? OTA_DELTA_HEADER_BYTES : 4) - s_headLen;
+    size_t k = len < need ? len : need;
+    memcpy(s_head + s_headLen, data, k);
+    s_headLen += k;
+    data += k;
+    len -= k;
+    if (k < need) return true;
+    if (s_format == OTAP_UNKNOWN ? !otap_detect() : !otap_openDelta()) return false;
+    if (s_format == OTAP_DELTA && !s_inflator) return otap_feed(data, len);
+  }
+  if (!len) return true;
+  return s_format == OTAP_RAW ? otap_emit(data, len) : otap_inflate(data, len);
+}
+
+bool otap_finish() {
+  if (s_failed) return false;
+  switch (s_format) {
+    case OTAP_RAW:   return true;
+    case OTAP_ZLIB:  return s_inflated || otap_fail("compressed stream truncated");
+    case OTAP_DELTA:
+      if (!s_inflated || s_step != DSTEP_DONE) return otap_fail("delta truncated");
+      return s_image == s_target || otap_fail("delta shorter than its target");
+    default:         return otap_fail("payload too short");
+  }
+}
+
+void otap_end() {
+  free(s_inflator);
+  free(s_window);
+  s_inflator = nullptr;
+  s_window = nullptr;
+}
+
+OtaPayloadFormat otap_format() {
+  return s_format;
+}
+
+const char *otap_formatName() {
+  switch (s_format) {
+    case OTAP_RAW:   return "raw";
+    case OTAP_ZLIB:  return "zlib";
+    case OTAP_DELTA: return "delta";
+    default:         return "?";
+  }
+}
+
+const char *otap_error() {
+  return s_error;
+}
+
+uint32_t otap_imageBytes() {
+  return s_image;
+}
+
+uint32_t otap_targetBytes() {
+  return s_target;
+}
@@ -0,0 +1,60 @@
+#ifndef OTA_PAYLOAD_H
+#define OTA_PAYLOAD_H
+
+#include <Arduino.h>
+
+// Turns the bytes an OTA transport delivers into the firmware image that
+// ota_update.cpp writes to flash. The format is recognised from the first
+// bytes, so every transport accepts all three:
+//
+//   raw    an ESP32 app image (0xE9 ...), passed through
+//   zlib   the image deflated by tools/ota_pack.py
+//   delta  "BHD1" header, then a zlib stream of operations that rebuild
+//          the image from the running one (tools/ota_pack.py --base):
+//            0x01 ADD   <len> <len bytes>
+//            0x02 COPY  <offset> <len>               from the running image
+//            0x03 PATCH <offset> <len> <len bytes>   running image + bytes (mod 256)
+//            0x00 END
+//          <len> is a varint, <offset> a zigzag varint relative to where
+//          the previous COPY/PATCH ended. The header names the base by
+//          the SHA-256 digest esptool appends to an image, which is what
+//          esp_partition_get_sha256() returns for the running slot.
+//
+// Decoding streams in a fixed RAM window: the inflate dictionary
+// (1 << OTA_INFLATE_WINDOW_BITS bytes) and the tinfl state (~11 KB) are
+// allocated when a compressed payload starts and freed by otap_end(); a
+// delta reads the running image OTA_PAYLOAD_BASE_BYTES at a time. The
+// decoder state survives between otap_feed() calls, so a transfer can be
+// resumed at any byte.
+
+#ifndef OTA_INFLATE_WINDOW_BITS
+#define OTA_INFLATE_WINDOW_BITS 15      // 32 KB, the largest tinfl supports
+#endif
+
+#define OTA_PAYLOAD_BASE_BYTES 256
+
+#define OTA_DELTA_MAGIC "BHD1"
+#define OTA_DELTA_HEADER_BYTES 44       // magic, target size, base size, base image digest
+
+// Receives the decoded image; false stops decoding
+typedef bool (*OtaImageSink)(const uint8_t *data, size_t len);
+
+enum OtaPayloadFormat {
+  OTAP_UNKNOWN = 0,    // fewer than 4 bytes seen
+  OTAP_RAW,
+  OTAP_ZLIB,
+  OTAP_DELTA
+};
+
+void otap_begin(OtaImageSink sink);
+bool otap_feed(const uint8_t *data, size_t len);   // false: bad payload or sink failed
+bool otap_finish();                                // payload ended cleanly and completely
+void otap_end();                                   // frees the inflate window
+
+OtaPayloadFormat otap_format();
+const char *otap_formatName();
+const char *otap_error();
+uint32_t otap_imageBytes();                        // decoded so far
+uint32_t otap_targetBytes();                       // delta: final image size, else 0
+
+#endif // OTA_PAYLOAD_H
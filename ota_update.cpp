@@ -0,0 +1,591 @@
+// ota_update.cpp - streaming OTA writer, POST /ota, LTE pull, rollback check.
+
+#include "ota_update.h"
+#include "ota_payload.h"
+#include "http_server.h"
+#include "wifi_manager.h"
+#include "modem_manager.h"
+#include "telemetry_sink.h"
+#include "config.h"
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+#include <TinyGsmClient.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+
+// ---------------------------------------------------------
+// Streaming writer
+// ---------------------------------------------------------
+static volatile OtaState s_state = OTA_IDLE;
+static SemaphoreHandle_t s_owner = nullptr;   // held by the transport feeding the writer
+static const esp_partition_t *s_part = nullptr;
+static esp_ota_handle_t s_handle = 0;
+static mbedtls_sha256_context s_sha;
+static bool     s_shaOpen = false;
+static uint8_t  s_chunk[OTA_CHUNK_BYTES];
+static size_t   s_chunkLen = 0;
+static uint32_t s_offset = 0;           // payload bytes accepted
+static uint32_t s_size = 0;             // payload size, 0 = unknown
+static uint32_t s_written = 0;          // image bytes decoded (flash + staged)
+static const char *s_writeError = nullptr;
+static uint8_t  s_expect[32];
+static bool     s_hasExpect = false;
+static char     s_digest[65] = "";
+static char     s_error[48] = "";
+static unsigned long s_rebootAtMs = 0;
+static bool     s_trial = false;        // this boot is an unconfirmed update
+static unsigned long s_healthAtMs = 0;  // next health check of a trial boot
+
+static int ota_nibble(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static bool ota_parseSha(const char *hex, uint8_t out[32]) {
+  if (!hex || strlen(hex) != 64) return false;
+  for (uint8_t i = 0; i < 32; ++i) {
+    int hi = ota_nibble(hex[2 * i]), lo = ota_nibble(hex[2 * i + 1]);
+    if (hi < 0 || lo < 0) return false;
+    out[i] = (uint8_t)(hi << 4 | lo);
+  }
+  return true;
+}
+
+static bool ota_claim() {
+  return xSemaphoreTake(s_owner, 0) == pdTRUE;
+}
+
+static void ota_release() {
+  xSemaphoreGive(s_owner);
+}
+
+static void ota_fail(const char *why) {
+  if (s_handle) esp_ota_abort(s_handle);
+  s_handle = 0;
+  if (s_shaOpen) mbedtls_sha256_free(&s_sha);
+  s_shaOpen = false;
+  s_chunkLen = 0;
+  otap_end();
+  s_state = OTA_FAILED;
+  strlcpy(s_error, why, sizeof(s_error));
+  Serial.printf("[OTA] failed at %lu bytes: %s\n", (unsigned long)s_offset, why);
+}
+
+// Errors are only recorded here: ota_fail() would free the decoder that is
+// calling us through otap_feed()
+static bool ota_flushChunk() {
+  if (s_chunkLen == 0) return true;
+  esp_err_t err = esp_ota_write(s_handle, s_chunk, s_chunkLen);
+  if (err != ESP_OK) {
+    s_writeError = esp_err_to_name(err);
+    return false;
+  }
+  s_chunkLen = 0;
+  return true;
+}
+
+// Decoded image bytes from ota_payload
+static bool ota_stage(const uint8_t *data, size_t len) {
+  if (s_written + len > s_part->size) {
+    s_writeError = "image larger than the slot";
+    return false;
+  }
+  while (len) {
+    size_t n = sizeof(s_chunk) - s_chunkLen;
+    if (n > len) n = len;
+    memcpy(s_chunk + s_chunkLen, data, n);
+    s_chunkLen += n;
+    s_written += n;
+    data += n;
+    len -= n;
+    if (s_chunkLen == sizeof(s_chunk) && !ota_flushChunk()) return false;
+  }
+  return true;
+}
+
+bool ota_begin(uint32_t size, const char *sha256Hex) {
+  if (s_state == OTA_DONE) return false;          // rebooting into the previous update
+  if (s_state == OTA_RECEIVING) ota_fail("restarted");
+  s_offset = 0;
+  s_written = 0;
+  s_chunkLen = 0;
+  s_writeError = nullptr;
+  s_digest[0] = '\0';
+  s_hasExpect = sha256Hex != nullptr;
+  if (s_hasExpect && !ota_parseSha(sha256Hex, s_expect)) {
+    ota_fail("bad SHA-256");
+    return false;
+  }
+  s_part = esp_ota_get_next_update_partition(nullptr);
+  if (!s_part) {
+    ota_fail("no OTA partition");
+    return false;
+  }
+  if (size > s_part->size) {
+    ota_fail("payload larger than the slot");
+    return false;
+  }
+  // Sequential writes erase sector by sector instead of the whole slot up front
+  esp_err_t err = esp_ota_begin(s_part, OTA_WITH_SEQUENTIAL_WRITES, &s_handle);
+  if (err != ESP_OK) {
+    s_handle = 0;
+    ota_fail(esp_err_to_name(err));
+    return false;
+  }
+  mbedtls_sha256_init(&s_sha);
+  mbedtls_sha256_starts(&s_sha, 0);
+  s_shaOpen = true;
+  otap_begin(ota_stage);
+  s_size = size;
+  s_error[0] = '\0';
+  s_state = OTA_RECEIVING;
+  Serial.printf("[OTA] receiving %lu bytes for %s\n", (unsigned long)size, s_part->label);
+  return true;
+}
+
+bool ota_write(const uint8_t *data, size_t len) {
+  if (s_state != OTA_RECEIVING) return false;
+  if (s_size && s_offset + len > s_size) {
+    ota_fail("payload longer than announced");
+    return false;
+  }
+  // The SHA-256 covers the payload as sent (what sha256sum prints for the file)
+  mbedtls_sha256_update(&s_sha, data, len);
+  s_offset += len;
+  if (!otap_feed(data, len)) {
+    ota_fail(s_writeError ? s_writeError : otap_error());
+    return false;
+  }
+  return true;
+}
+
+bool ota_finish() {
+  if (s_state != OTA_RECEIVING) return false;
+  if (s_size && s_offset != s_size) {
+    ota_fail("payload truncated");
+    return false;
+  }
+  if (!otap_finish()) {
+    ota_fail(otap_error());
+    return false;
+  }
+  otap_end();
+  if (!ota_flushChunk()) {
+    ota_fail(s_writeError);
+    return false;
+  }
+  uint8_t digest[32];
+  mbedtls_sha256_finish(&s_sha, digest);
+  mbedtls_sha256_free(&s_sha);
+  s_shaOpen = false;
+  for (uint8_t i = 0; i < 32; ++i) snprintf(s_digest + 2 * i, 3, "%02x", digest[i]);
+  if (s_hasExpect && memcmp(digest, s_expect, sizeof(digest)) != 0) {
+    ota_fail("SHA-256 mismatch");
+    return false;
+  }
+  // esp_ota_end() checks the image header and its own checksum
+  esp_err_t err = esp_ota_end(s_handle);
+  s_handle = 0;
+  if (err == ESP_OK) err = esp_ota_set_boot_partition(s_part);
+  if (err != ESP_OK) {
+    ota_fail(esp_err_to_name(err));
+    return false;
+  }
+  s_state = OTA_DONE;
+  s_rebootAtMs = millis() + 2000;
+  Serial.printf("[OTA] %s payload %lu bytes -> image %lu bytes, sha256 %s, booting %s\n", otap_formatName(),
+                (unsigned long)s_offset, (unsigned long)s_written, s_digest, s_part->label);
+  return true;
+}
+
+void ota_abort(const char *why) {
+  if (s_state == OTA_RECEIVING) ota_fail(why);
+}
+
+uint32_t ota_offset() {
+  return s_offset;
+}
+
+OtaState ota_state() {
+  return s_state;
+}
+
+static const char *ota_stateName(OtaState s) {
+  switch (s) {
+    case OTA_RECEIVING: return "receiving";
+    case OTA_DONE:      return "done";
+    case OTA_FAILED:    return "failed";
+    default:            return "idle";
+  }
+}
+
+// ---------------------------------------------------------
+// WiFi: POST /ota on the shared web server (httpd task)
+// ---------------------------------------------------------
+static esp_err_t ota_reply(httpd_req_t *req, const char *status, const char *result) {
+  char json[224];
+  snprintf(json, sizeof(json),
+           "{\"status\":\"%s\",\"state\":\"%s\",\"offset\":%lu,\"size\":%lu,\"format\":\"%s\",\"image\":%lu,\"error\":\"%s\"}",
+           result, ota_stateName(s_state), (unsigned long)s_offset, (unsigned long)s_size, otap_formatName(),
+           (unsigned long)s_written, s_error);
+  return http_sendStatus(req, status, json);
+}
+
+static esp_err_t ota_handleStatus(httpd_req_t *req) {
+  return ota_reply(req, "200 OK", "ok");
+}
+
+// Constant time, so the response time does not reveal a matching prefix
+static bool ota_keyOk(const char *key) {
+  size_t n = strlen(key), m = strlen(OTA_PASSWORD);
+  if (!m) return false;
+  uint8_t diff = n != m;
+  for (size_t i = 0; i < n; ++i) diff |= (uint8_t)key[i] ^ (uint8_t)OTA_PASSWORD[i % m];
+  return diff == 0;
+}
+
+static esp_err_t ota_handleUpload(httpd_req_t *req) {
+  // Always required: a custom header also forces a CORS preflight, so a
+  // web page the owner opens cannot POST an image to the hive
+  char hdr[72];
+  if (httpd_req_get_hdr_value_str(req, "X-OTA-Key", hdr, sizeof(hdr)) != ESP_OK || !ota_keyOk(hdr)) {
+    return http_sendStatus(req, "403 Forbidden", "{\"status\":\"error\",\"error\":\"bad X-OTA-Key\"}");
+  }
+  if (req->content_len == 0) return http_sendStatus(req, "400 Bad Request", "{\"status\":\"error\",\"error\":\"empty body\"}");
+  if (!ota_claim()) return ota_reply(req, "409 Conflict", "busy");
+
+  // X-OTA-Offset continues the open image exactly where it stopped
+  uint32_t resumeAt = 0;
+  if (httpd_req_get_hdr_value_str(req, "X-OTA-Offset", hdr, sizeof(hdr)) == ESP_OK) resumeAt = strtoul(hdr, nullptr, 10);
+  bool ok;
+  if (resumeAt) {
+    ok = s_state == OTA_RECEIVING && resumeAt == s_offset;
+  } else {
+    bool hasSha = httpd_req_get_hdr_value_str(req, "X-SHA256", hdr, sizeof(hdr)) == ESP_OK;
+    ok = ota_begin(req->content_len, hasSha ? hdr : nullptr);
+  }
+  if (!ok) {
+    ota_release();
+    return ota_reply(req, "409 Conflict", "error");
+  }
+
+  uint8_t buf[1024];
+  size_t left = req->content_len;
+  uint8_t timeouts = 0;
+  while (left && s_state == OTA_RECEIVING) {
+    int n = httpd_req_recv(req, (char *)buf, left < sizeof(buf) ? left : sizeof(buf));
+    if (n == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < 5) continue;
+    if (n <= 0) break;
+    timeouts = 0;
+    if (!ota_write(buf, n)) break;
+    left -= n;
+  }
+
+  esp_err_t res;
+  if (s_state != OTA_RECEIVING) {
+    res = ota_reply(req, "500 Internal Server Error", "error");
+  } else if (left) {
+    // Keep the image open: the client may resend the rest with X-OTA-Offset
+    Serial.printf("[OTA] upload interrupted at %lu bytes\n", (unsigned long)s_offset);
+    res = ota_reply(req, "408 Request Timeout", "partial");
+  } else if (s_size && s_offset < s_size) {
+    res = ota_reply(req, "202 Accepted", "partial");
+  } else if (ota_finish()) {
+    res = ota_reply(req, "200 OK", "rebooting");
+  } else {
+    res = ota_reply(req, "500 Internal Server Error", "error");
+  }
+  ota_release();
+  return res;
+}
+
+// ---------------------------------------------------------
+// LTE: pull over TinyGSM, resumed with a Range request (loop task)
+// ---------------------------------------------------------
+enum OtaPullStep { PULL_OFF = 0, PULL_CONNECT, PULL_HEADERS, PULL_BODY };
+
+static OtaPullStep    s_pull = PULL_OFF;
+static TinyGsmClient *s_client = nullptr;
+static char           s_pullHost[64];
+static char           s_pullPath[128];
+static uint16_t       s_pullPort = 80;
+static char           s_pullSha[65];
+static uint8_t        s_pullRetries = 0;
+static unsigned long  s_pullAtMs = 0;   // next connect attempt, then last data
+static uint32_t       s_pullSkip = 0;   // leading bytes of a 200 reply we already have
+static uint32_t       s_pullLength = 0; // Content-Length of the current reply
+static int            s_httpCode = 0;
+static char           s_line[128];
+static uint8_t        s_lineLen = 0;
+
+bool ota_pullStart(const char *url, const char *sha256Hex) {
+  uint8_t sha[32];
+  if (strncmp(url, "http://", 7) != 0 || !ota_parseSha(sha256Hex, sha)) return false;
+  const char *host = url + 7;
+  const char *path = strchr(host, '/');
+  size_t hostLen = path ? (size_t)(path - host) : strlen(host);
+  const char *colon = (const char *)memchr(host, ':', hostLen);
+  size_t nameLen = colon ? (size_t)(colon - host) : hostLen;
+  if (nameLen == 0 || nameLen >= sizeof(s_pullHost) || (path && strlen(path) >= sizeof(s_pullPath))) return false;
+  if (!ota_claim()) return false;
+
+  memcpy(s_pullHost, host, nameLen);
+  s_pullHost[nameLen] = '\0';
+  s_pullPort = colon ? (uint16_t)atoi(colon + 1) : 80;
+  strlcpy(s_pullPath, path ? path : "/", sizeof(s_pullPath));
+  strlcpy(s_pullSha, sha256Hex, sizeof(s_pullSha));
+  ota_abort("replaced by LTE pull");
+  s_pullRetries = 0;
+  s_pullAtMs = millis();
+  s_pull = PULL_CONNECT;
+  Serial.printf("[OTA] pulling http://%s:%u%s over LTE\n", s_pullHost, s_pullPort, s_pullPath);
+  return true;
+}
+
+static void ota_pullStop() {
+  if (s_client) s_client->stop();
+  s_pull = PULL_OFF;
+  ota_release();
+}
+
+// Link dropped or refused: resume from ota_offset() after a growing pause
+static void ota_pullRetry(const char *why) {
+  if (s_client) s_client->stop();
+  if (++s_pullRetries > OTA_PULL_RETRIES) {
+    if (s_state == OTA_RECEIVING) ota_fail(why);
+    else {
+      s_state = OTA_FAILED;
+      strlcpy(s_error, why, sizeof(s_error));
+      Serial.printf("[OTA] pull failed: %s\n", why);
+    }
+    ota_pullStop();
+    return;
+  }
+  Serial.printf("[OTA] %s at %lu bytes, retry %u in %u s\n", why, (unsigned long)s_offset, s_pullRetries,
+                5U * s_pullRetries);
+  s_pull = PULL_CONNECT;
+  s_pullAtMs = millis() + 5000UL * s_pullRetries;
+}
+
+static void ota_pullConnect() {
+  if ((long)(millis() - s_pullAtMs) < 0) return;
+  if (!modem_isReady()) {
+    ota_pullRetry("modem not ready");
+    return;
+  }
+  TinyGsm &modem = modem_get();
+  if (!modem.isGprsConnected() && !modem.gprsConnect(MODEM_APN, MODEM_GPRS_USER, MODEM_GPRS_PASS)) {
+    ota_pullRetry("no data connection");
+    return;
+  }
+  if (!s_client) s_client = new TinyGsmClient(modem, MODEM_MUX_OTA);
+  if (!s_client->connect(s_pullHost, s_pullPort, 30)) {
+    ota_pullRetry("connect failed");
+    return;
+  }
+  uint32_t from = s_state == OTA_RECEIVING ? s_offset : 0;
+  char req[320];
+  int n = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: beehive-ota\r\nConnection: close\r\n",
+                   s_pullPath, s_pullHost);
+  if (from) n += snprintf(req + n, sizeof(req) - n, "Range: bytes=%lu-\r\n", (unsigned long)from);
+  n += snprintf(req + n, sizeof(req) - n, "\r\n");
+  s_client->write((const uint8_t *)req, n);
+  s_httpCode = 0;
+  s_pullLength = 0;
+  s_pullSkip = 0;
+  s_lineLen = 0;
+  s_pullAtMs = millis();
+  s_pull = PULL_HEADERS;
+}
+
+// Headers done: decide how the body continues the image
+static bool ota_pullBodyStart() {
+  bool resuming = s_state == OTA_RECEIVING;
+  if (s_httpCode == 206 && resuming) return true;       // Content-Range was checked per line
+  if (s_httpCode == 200) {
+    if (resuming) {
+      s_pullSkip = s_offset;                             // server ignored Range
+      return true;
+    }
+    return ota_begin(s_pullLength, s_pullSha);
+  }
+  char why[24];
+  snprintf(why, sizeof(why), "HTTP %d", s_httpCode);
+  if (resuming) ota_fail(why);
+  else {
+    s_state = OTA_FAILED;
+    strlcpy(s_error, why, sizeof(s_error));
+  }
+  return false;
+}
+
+static void ota_pullHeaders() {
+  while (s_client->available()) {
+    char c = (char)s_client->read();
+    s_pullAtMs = millis();
+    if (c == '\r') continue;
+    if (c != '\n') {
+      if (s_lineLen < sizeof(s_line) - 1) s_line[s_lineLen++] = c;
+      continue;
+    }
+    s_line[s_lineLen] = '\0';
+    s_lineLen = 0;
+    if (s_httpCode == 0) {
+      const char *sp = strchr(s_line, ' ');
+      s_httpCode = sp ? atoi(sp + 1) : -1;
+    } else if (s_line[0] == '\0') {
+      if (!ota_pullBodyStart()) {
+        ota_pullStop();
+        return;
+      }
+      s_pull = PULL_BODY;
+      return;
+    } else if (strncasecmp(s_line, "Content-Length:", 15) == 0) {
+      s_pullLength = strtoul(s_line + 15, nullptr, 10);
+    } else if (strncasecmp(s_line, "Content-Range:", 14) == 0) {
+      const char *p = strstr(s_line, "bytes ");
+      if (!p || strtoul(p + 6, nullptr, 10) != s_offset) {
+        ota_fail("Content-Range does not match");
+        ota_pullStop();
+        return;
+      }
+    }
+  }
+  if (!s_client->connected()) ota_pullRetry("connection closed");
+  else if (millis() - s_pullAtMs > OTA_PULL_STALL_MS) ota_pullRetry("no response");
+}
+
+static void ota_pullBody() {
+  uint8_t buf[512];
+  uint32_t budget = OTA_PULL_SLICE_BYTES;
+  while (budget && s_client->available()) {
+    int n = s_client->read(buf, budget < sizeof(buf) ? budget : sizeof(buf));
+    if (n <= 0) break;
+    budget -= n;
+    s_pullAtMs = millis();
+    const uint8_t *p = buf;
+    if (s_pullSkip) {
+      uint32_t k = s_pullSkip < (uint32_t)n ? s_pullSkip : (uint32_t)n;
+      p += k;
+      n -= k;
+      s_pullSkip -= k;
+    }
+#if ENABLE_DEBUG
+    if (n && (s_offset >> 16) != ((s_offset + n) >> 16)) {
+      Serial.printf("[OTA] %lu / %lu bytes\n", (unsigned long)(s_offset + n), (unsigned long)s_size);
+    }
+#endif
+    if (n && !ota_write(p, n)) {
+      ota_pullStop();
+      return;
+    }
+    if (s_size && s_offset == s_size) {
+      ota_finish();
+      ota_pullStop();
+      return;
+    }
+  }
+  if (!s_client->connected() && !s_client->available()) {
+    // Without a length the end of the connection is the end of the image
+    if (s_size == 0) {
+      ota_finish();
+      ota_pullStop();
+    } else {
+      ota_pullRetry("connection dropped");
+    }
+  } else if (millis() - s_pullAtMs > OTA_PULL_STALL_MS) {
+    ota_pullRetry("download stalled");
+  }
+}
+
+// ---------------------------------------------------------
+// Rollback
+// ---------------------------------------------------------
+
+// Tell the Arduino core not to confirm the image at boot; ota_loop() does
+// it after the health check.
+extern "C" bool verifyRollbackLater() {
+  return true;
+}
+
+// A link that carries data: WiFi associated, the modem's data connection
+// up, or a sample delivered by a sink. A modem that only answers AT does
+// not count, an image that broke the uplink must roll back.
+static bool ota_healthy() {
+#if NODE_ROLE == NODE_ROLE_SATELLITE
+  return true;                          // no uplink of its own
+#else
+  if (wifi_isConnected()) return true;
+  if (modem_isReady() && modem_get().isGprsConnected()) return true;
+  SinkStats st;
+  for (uint8_t k = 0; k < SINK_COUNT; ++k) {
+    if (sinks_stats(k, st) && st.sent) return true;
+  }
+  return false;
+#endif
+}
+
+// Checked every OTA_HEALTH_CHECK_MS: the GPRS check is an AT round trip
+static void ota_checkTrial() {
+  if (!s_trial || millis() < OTA_HEALTH_MIN_MS || (long)(millis() - s_healthAtMs) < 0) return;
+  s_healthAtMs = millis() + OTA_HEALTH_CHECK_MS;
+  if (ota_healthy()) {
+    esp_ota_mark_app_valid_cancel_rollback();
+    s_trial = false;
+    Serial.println(F("[OTA] new firmware confirmed"));
+  } else if (millis() >= OTA_HEALTH_TIMEOUT_MS) {
+    Serial.println(F("[OTA] health check failed, rolling back"));
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+  }
+}
+
+void ota_init() {
+  s_owner = xSemaphoreCreateMutex();
+  esp_ota_img_states_t st;
+  const esp_partition_t *running = esp_ota_get_running_partition();
+  if (esp_ota_get_state_partition(running, &st) == ESP_OK && st == ESP_OTA_IMG_PENDING_VERIFY) {
+    s_trial = true;
+    Serial.printf("[OTA] running %s on trial, confirming after the health check\n", running->label);
+  } else if (running) {
+    // Still confirm the image if the bootloader has no rollback support
+    esp_ota_mark_app_valid_cancel_rollback();
+  }
+  http_on("/ota", HTTP_GET, ota_handleStatus);
+  if (OTA_PASSWORD[0]) http_on("/ota", HTTP_POST, ota_handleUpload);
+  else Serial.println(F("[OTA] OTA_PASSWORD not set, WiFi upload disabled"));
+}
+
+void ota_loop() {
+  ota_checkTrial();
+  switch (s_pull) {
+    case PULL_CONNECT: ota_pullConnect(); break;
+    case PULL_HEADERS: ota_pullHeaders(); break;
+    case PULL_BODY:    ota_pullBody();    break;
+    default: break;
+  }
+  if (s_state == OTA_DONE && (long)(millis() - s_rebootAtMs) >= 0) {
+    Serial.println(F("[OTA] rebooting into the new firmware"));
+    delay(100);
+    ESP.restart();
+  }
+}
+
+void ota_print(Print &out) {
+  out.printf("[OTA] %s, %lu / %lu bytes%s%s\n", ota_stateName(s_state), (unsigned long)s_offset,
+             (unsigned long)s_size, s_error[0] ? ", error: " : "", s_error);
+  if (s_offset) {
+    out.printf("[OTA] %s payload, %lu image bytes written", otap_formatName(), (unsigned long)s_written);
+    if (otap_targetBytes()) out.printf(" of %lu", (unsigned long)otap_targetBytes());
+    out.println();
+  }
+  if (s_pull != PULL_OFF) {
+    out.printf("[OTA] LTE pull from %s:%u%s, retry %u/%u\n", s_pullHost, s_pullPort, s_pullPath, s_pullRetries,
+               OTA_PULL_RETRIES);
+  }
+  if (s_digest[0]) out.printf("[OTA] last payload sha256 %s\n", s_digest);
+  const esp_partition_t *running = esp_ota_get_running_partition();
+  out.printf("[OTA] running %s%s\n", running ? running->label : "?", s_trial ? " (trial, not yet confirmed)" : "");
+}
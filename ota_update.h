@@ -0,0 +1,90 @@
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#include <Arduino.h>
+
+// Firmware update into the inactive OTA slot, over WiFi or LTE.
+//
+// Both transports feed the same streaming writer. The payload may be a raw
+// image, a zlib-compressed one or a delta against the running firmware
+// (ota_payload.h, tools/ota_pack.py); a running SHA-256 is kept over the
+// payload as sent. The decoded image is staged in one OTA_CHUNK_BYTES
+// buffer and written to flash a chunk at a time, so it is never held in
+// RAM. The payload bytes accepted so far (ota_offset()) are the resume
+// point after a link drop. ota_finish() checks the length and hash, lets
+// esp_ota_end() validate the image and selects the new slot; ota_loop()
+// reboots into it.
+//
+//   WiFi  POST /ota with the payload as body (curl --data-binary @fw.bin)
+//         and X-OTA-Key: OTA_PASSWORD; without a password the route is not
+//         registered. Optional headers: X-SHA256 (hex), X-OTA-Offset to
+//         continue an interrupted upload.
+//         GET /ota reports state and offset.
+//   LTE   serial 'ota http://host[:port]/path <sha256>': pulled through
+//         TinyGSM on the loop task, a slice per loop() pass. A dropped
+//         connection is resumed with "Range: bytes=<offset>-". There is no
+//         TLS on this path, so the SHA-256 is mandatory.
+//
+// Rollback: the new image boots in the bootloader's pending-verify state.
+// It is marked valid once it has run OTA_HEALTH_MIN_MS with a link that
+// carries data (WiFi associated, GPRS attached, or a sample delivered by a
+// sink); if that has not happened after OTA_HEALTH_TIMEOUT_MS,
+// or the image crashes / resets before, the bootloader returns to the
+// previous slot.
+
+#ifndef OTA_CHUNK_BYTES
+#define OTA_CHUNK_BYTES 4096            // one flash sector per write
+#endif
+
+#ifndef OTA_PASSWORD
+#define OTA_PASSWORD ""                 // empty: no POST /ota (WiFi upload off)
+#endif
+
+#ifndef OTA_PULL_RETRIES
+#define OTA_PULL_RETRIES 8              // resumes after a drop before giving up
+#endif
+
+#ifndef OTA_PULL_SLICE_BYTES
+#define OTA_PULL_SLICE_BYTES 8192       // read per loop() pass
+#endif
+
+#ifndef OTA_PULL_STALL_MS
+#define OTA_PULL_STALL_MS 30000UL       // no data for this long = dropped link
+#endif
+
+#ifndef OTA_HEALTH_MIN_MS
+#define OTA_HEALTH_MIN_MS 60000UL
+#endif
+
+#ifndef OTA_HEALTH_CHECK_MS
+#define OTA_HEALTH_CHECK_MS 5000UL
+#endif
+
+#ifndef OTA_HEALTH_TIMEOUT_MS
+#define OTA_HEALTH_TIMEOUT_MS 600000UL
+#endif
+
+enum OtaState {
+  OTA_IDLE = 0,
+  OTA_RECEIVING,       // image open, ota_offset() bytes accepted
+  OTA_DONE,            // verified, rebooting
+  OTA_FAILED
+};
+
+void ota_init();       // registers /ota, checks whether this boot is a trial
+void ota_loop();       // LTE pull, health check, reboot after an update
+
+// Streaming writer. size 0 = unknown; sha256Hex may be nullptr.
+bool     ota_begin(uint32_t size, const char *sha256Hex);
+bool     ota_write(const uint8_t *data, size_t len);
+bool     ota_finish();
+void     ota_abort(const char *why);
+uint32_t ota_offset();
+OtaState ota_state();
+
+// Start an LTE pull (http:// only). False if busy or the arguments are bad.
+bool ota_pullStart(const char *url, const char *sha256Hex);
+
+void ota_print(Print &out);   // serial 'ota'
+
+#endif // OTA_UPDATE_H
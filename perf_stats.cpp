@@ -0,0 +1,131 @@
+// perf_stats.cpp - fixed-memory latency histograms for loop() stages.
+// All updates happen from the Arduino loop task. The web handlers read
+// from the httpd task without a lock: a report may mix two loop iterations.
+
+#include "perf_stats.h"
+
+#if ENABLE_PERF_STATS
+
+struct PerfHist {
+  uint32_t buckets[PERF_BUCKETS];
+  uint32_t count;
+  uint32_t maxUs;
+  uint32_t lastUs;
+  uint64_t sumUs;
+};
+
+static PerfHist s_hist[PERF_STAGE_COUNT];
+
+static const char* const s_stageNames[PERF_STAGE_COUNT] = {
+  "menu",
+  "time",
+  "network",
+  "http",
+  "serial",
+  "sms",
+  "upload",
+  "retry",
+  "loop"
+};
+
+const char* perf_stageName(PerfStage stage) {
+  if (stage >= PERF_STAGE_COUNT) return "?";
+  return s_stageNames[stage];
+}
+
+// floor(log2(us)), clamped to the bucket range
+static inline uint8_t perf_bucketOf(uint32_t us) {
+  if (us < 2) return 0;
+  uint8_t b = 31 - __builtin_clz(us);
+  return (b >= PERF_BUCKETS) ? (PERF_BUCKETS - 1) : b;
+}
+
+void perf_record(PerfStage stage, uint32_t us) {
+  if (stage >= PERF_STAGE_COUNT) return;
+  PerfHist &h = s_hist[stage];
+  h.buckets[perf_bucketOf(us)]++;
+  h.count++;
+  h.sumUs += us;
+  h.lastUs = us;
+  if (us > h.maxUs) h.maxUs = us;
+}
+
+void perf_reset() {
+  memset(s_hist, 0, sizeof(s_hist));
+}
+
+uint32_t perf_percentile(PerfStage stage, uint8_t pct) {
+  if (stage >= PERF_STAGE_COUNT) return 0;
+  const PerfHist &h = s_hist[stage];
+  if (h.count == 0) return 0;
+  uint32_t target = (uint32_t)(((uint64_t)h.count * pct + 99) / 100);
+  uint32_t acc = 0;
+  for (uint8_t b = 0; b < PERF_BUCKETS; ++b) {
+    acc += h.buckets[b];
+    if (acc >= target) {
+      if (b == PERF_BUCKETS - 1) return h.maxUs;
+      uint32_t upper = (2UL << b) - 1;
+      return (upper < h.maxUs) ? upper : h.maxUs;
+    }
+  }
+  return h.maxUs;
+}
+
+void perf_histogram(PerfStage stage, PerfHistogram &out) {
+  memset(&out, 0, sizeof(out));
+  if (stage >= PERF_STAGE_COUNT) return;
+  const PerfHist &h = s_hist[stage];
+  memcpy(out.buckets, h.buckets, sizeof(out.buckets));
+  out.count = h.count;
+  out.sumUs = h.sumUs;
+}
+
+void perf_print(Print &out) {
+  out.println(F("[PERF] stage          count      avg_us   p50_us   p99_us   max_us"));
+  char line[96];
+  for (uint8_t i = 0; i < PERF_STAGE_COUNT; ++i) {
+    const PerfHist &h = s_hist[i];
+    uint32_t avg = h.count ? (uint32_t)(h.sumUs / h.count) : 0;
+    snprintf(line, sizeof(line), "[PERF] %-12s %8lu %10lu %8lu %8lu %8lu",
+             s_stageNames[i], (unsigned long)h.count, (unsigned long)avg,
+             (unsigned long)perf_percentile((PerfStage)i, 50),
+             (unsigned long)perf_percentile((PerfStage)i, 99),
+             (unsigned long)h.maxUs);
+    out.println(line);
+  }
+}
+
+String perf_buildJson() {
+  String json;
+  json.reserve(256 + PERF_STAGE_COUNT * (PERF_BUCKETS * 6 + 128));
+  json += F("{\"unit\":\"us\",\"buckets\":\"log2\",\"stages\":{");
+  char buf[96];
+  for (uint8_t i = 0; i < PERF_STAGE_COUNT; ++i) {
+    const PerfHist &h = s_hist[i];
+    uint32_t avg = h.count ? (uint32_t)(h.sumUs / h.count) : 0;
+    if (i) json += ',';
+    snprintf(buf, sizeof(buf), "\"%s\":{\"count\":%lu,\"avg\":%lu,\"last\":%lu,\"max\":%lu,",
+             s_stageNames[i], (unsigned long)h.count, (unsigned long)avg,
+             (unsigned long)h.lastUs, (unsigned long)h.maxUs);
+    json += buf;
+    snprintf(buf, sizeof(buf), "\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"hist\":[",
+             (unsigned long)perf_percentile((PerfStage)i, 50),
+             (unsigned long)perf_percentile((PerfStage)i, 90),
+             (unsigned long)perf_percentile((PerfStage)i, 99));
+    json += buf;
+    // trim trailing empty buckets to keep the payload small
+    int last = PERF_BUCKETS - 1;
+    while (last > 0 && h.buckets[last] == 0) last--;
+    for (int b = 0; b <= last; ++b) {
+      if (b) json += ',';
+      json += String(h.buckets[b]);
+    }
+    json += F("]}");
+  }
+  json += F("},\"uptime_ms\":");
+  json += String(millis());
+  json += '}';
+  return json;
+}
+
+#endif // ENABLE_PERF_STATS
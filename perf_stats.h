@@ -0,0 +1,67 @@
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <Arduino.h>
+#include "config.h"
+#include <esp_timer.h>
+
+// Per-stage loop() latency histograms.
+// Each stage keeps log2-bucketed durations (microseconds) in fixed memory:
+// bucket 0 = <2us, bucket k = [2^k, 2^(k+1)) us, last bucket = everything above.
+// Compile with ENABLE_PERF_STATS 0 to remove all timing code.
+
+enum PerfStage {
+  PERF_MENU = 0,
+  PERF_TIME,
+  PERF_NETWORK,
+  PERF_HTTP,        // web server start/stop (requests run on the httpd task)
+  PERF_SERIAL,
+  PERF_SMS,
+  PERF_UPLOAD,
+  PERF_RETRY,
+  PERF_LOOP,        // whole loop() iteration
+  PERF_STAGE_COUNT
+};
+
+#define PERF_BUCKETS 24   // up to ~8 s; last bucket is the overflow bucket
+
+#if ENABLE_PERF_STATS
+
+void perf_record(PerfStage stage, uint32_t us);
+void perf_reset();
+const char* perf_stageName(PerfStage stage);
+
+// Print a human-readable table (serial 'perf' command)
+void perf_print(Print &out);
+
+// Build the /perf.json document
+String perf_buildJson();
+
+// Approximate percentile (upper bound of the bucket holding it), in us
+uint32_t perf_percentile(PerfStage stage, uint8_t pct);
+
+// Copy of one stage's histogram (GET /metrics)
+struct PerfHistogram {
+  uint32_t buckets[PERF_BUCKETS];
+  uint32_t count;
+  uint64_t sumUs;
+};
+void perf_histogram(PerfStage stage, PerfHistogram &out);
+
+struct PerfScope {
+  PerfStage stage;
+  int64_t t0;
+  explicit PerfScope(PerfStage s) : stage(s), t0(esp_timer_get_time()) {}
+  ~PerfScope() { perf_record(stage, (uint32_t)(esp_timer_get_time() - t0)); }
+};
+
+// Time one statement as a loop stage: PERF_STAGE(PERF_SMS, sms_loop());
+#define PERF_STAGE(stage, stmt) do { PerfScope _perf_scope(stage); stmt; } while (0)
+
+#else
+
+#define PERF_STAGE(stage, stmt) do { stmt; } while (0)
+
+#endif // ENABLE_PERF_STATS
+
+#endif // PERF_STATS_H
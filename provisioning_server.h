@@ -1,8 +1,8 @@
 #ifndef PROVISIONING_SERVER_H
 #define PROVISIONING_SERVER_H
 
-// Initialize provisioning server (serves HTML form on port 8080)
-void provisioning_init();
-void provisioning_loop(); // call from main loop periodically
+// Two-network WiFi provisioning form (/provision, /save-wifi, /reboot)
+// on the shared web server (http_server.h)
+void provisioning_init();   // register the routes, once from setup()
 
-#endif // PROVISIONING_SERVER_H
\ No newline at end of file
+#endif // PROVISIONING_SERVER_H
@@ -0,0 +1,114 @@
+// sample_codec.cpp - delta + zigzag varint encoding of TelemetrySample.
+
+#include "sample_codec.h"
+
+static inline uint32_t zigzag(int32_t v) {
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static size_t put_varint(uint32_t v, uint8_t *out, size_t cap) {
+  size_t n = 0;
+  do {
+    if (n >= cap) return 0;
+    uint8_t b = v & 0x7F;
+    v >>= 7;
+    out[n++] = v ? (b | 0x80) : b;
+  } while (v);
+  return n;
+}
+
+// Returns bytes consumed, 0 if truncated or longer than 5 bytes
+static size_t get_varint(const uint8_t *in, size_t len, uint32_t &v) {
+  v = 0;
+  for (size_t i = 0; i < len && i < 5; ++i) {
+    v |= (uint32_t)(in[i] & 0x7F) << (7 * i);
+    if (!(in[i] & 0x80)) return i + 1;
+  }
+  return 0;
+}
+
+size_t sample_encode(const TelemetrySample *prev, const TelemetrySample &cur, uint8_t *out, size_t cap) {
+  if (cap < 1) return 0;
+  bool key = (prev == nullptr);
+  uint8_t mask = 0;
+  for (int c = 0; c < CH_COUNT; ++c) {
+    if (key ? (cur.v[c] != 0) : (cur.v[c] != prev->v[c])) mask |= (uint8_t)(1 << c);
+  }
+  out[0] = (key ? SAMPLE_FRAME_KEY : 0) | mask;
+  size_t n = 1, w;
+
+  if (key) w = put_varint(cur.ts, out + n, cap - n);
+  else     w = put_varint(zigzag((int32_t)(cur.ts - prev->ts)), out + n, cap - n);
+  if (!w) return 0;
+  n += w;
+
+  for (int c = 0; c < CH_COUNT; ++c) {
+    if (!(mask & (1 << c))) continue;
+    int32_t d = key ? cur.v[c] : (int32_t)((uint32_t)cur.v[c] - (uint32_t)prev->v[c]);
+    w = put_varint(zigzag(d), out + n, cap - n);
+    if (!w) return 0;
+    n += w;
+  }
+  return n;
+}
+
+size_t sample_decode(const TelemetrySample *prev, const uint8_t *in, size_t len, TelemetrySample &out) {
+  if (len < 1) return 0;
+  uint8_t hdr = in[0];
+  bool key = (hdr & SAMPLE_FRAME_KEY) != 0;
+  uint8_t mask = hdr & SAMPLE_FRAME_MASK;
+  if (!key && !prev) return 0;
+  if (mask >> CH_COUNT) return 0;            // unknown channels -> not a frame we wrote
+
+  size_t n = 1, r;
+  uint32_t u;
+  r = get_varint(in + n, len - n, u);
+  if (!r) return 0;
+  n += r;
+  TelemetrySample s;
+  s.ts = key ? u : prev->ts + (uint32_t)unzigzag(u);
+
+  for (int c = 0; c < CH_COUNT; ++c) {
+    int32_t base = key ? 0 : prev->v[c];
+    if (mask & (1 << c)) {
+      r = get_varint(in + n, len - n, u);
+      if (!r) return 0;
+      n += r;
+      s.v[c] = (int32_t)((uint32_t)base + (uint32_t)unzigzag(u));
+    } else {
+      s.v[c] = base;
+    }
+  }
+  out = s;
+  return n;
+}
+
+void sample_encoderReset(SampleEncoder &e) {
+  e.hasPrev = false;
+}
+
+size_t sample_encodeNext(SampleEncoder &e, const TelemetrySample &cur, uint8_t *out, size_t cap, bool forceKey) {
+  size_t n = sample_encode((e.hasPrev && !forceKey) ? &e.prev : nullptr, cur, out, cap);
+  if (n) {
+    e.prev = cur;
+    e.hasPrev = true;
+  }
+  return n;
+}
+
+void sample_decoderReset(SampleDecoder &d) {
+  d.hasPrev = false;
+}
+
+size_t sample_decodeNext(SampleDecoder &d, const uint8_t *in, size_t len, TelemetrySample &out) {
+  size_t n = sample_decode(d.hasPrev ? &d.prev : nullptr, in, len, out);
+  if (n) {
+    d.prev = out;
+    d.hasPrev = true;
+  }
+  return n;
+}
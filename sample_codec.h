@@ -0,0 +1,51 @@
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+#include <Arduino.h>
+#include "telemetry_sample.h"
+
+// Compact encoding for TelemetrySample, shared by the SD upload queue and
+// any batch/radio path.
+//
+// Frame layout:
+//   header   bit7 = keyframe (absolute values), bits0..6 = channel mask
+//   ts       keyframe: varint(ts)          delta frame: zigzag varint(ts - prev.ts)
+//   values   for each channel set in the mask, in channel order:
+//            keyframe: zigzag varint(v)    delta frame: zigzag varint(v - prev.v)
+//
+// Delta frames omit channels that did not change, so a slowly drifting
+// sample costs ~8-12 bytes instead of ~120 bytes of form-encoded ASCII.
+// A frame can only be decoded with the sample that preceded it; keyframes
+// need no history.
+
+#define SAMPLE_FRAME_MAX (1 + 5 + CH_COUNT * 5)
+
+#define SAMPLE_FRAME_KEY   0x80
+#define SAMPLE_FRAME_MASK  0x7F
+
+// Encode cur relative to prev (prev == nullptr -> keyframe).
+// Returns the frame length, 0 if cap is too small.
+size_t sample_encode(const TelemetrySample *prev, const TelemetrySample &cur, uint8_t *out, size_t cap);
+
+// Decode one frame. prev is required for delta frames.
+// Returns bytes consumed, 0 on truncated/invalid input.
+size_t sample_decode(const TelemetrySample *prev, const uint8_t *in, size_t len, TelemetrySample &out);
+
+// Streaming helpers that carry the previous sample between frames
+struct SampleEncoder {
+  TelemetrySample prev;
+  bool hasPrev;
+};
+
+struct SampleDecoder {
+  TelemetrySample prev;
+  bool hasPrev;
+};
+
+void   sample_encoderReset(SampleEncoder &e);
+size_t sample_encodeNext(SampleEncoder &e, const TelemetrySample &cur, uint8_t *out, size_t cap, bool forceKey = false);
+
+void   sample_decoderReset(SampleDecoder &d);
+size_t sample_decodeNext(SampleDecoder &d, const uint8_t *in, size_t len, TelemetrySample &out);
+
+#endif // SAMPLE_CODEC_H
@@ -0,0 +1,189 @@
+// sd_storage.cpp - mount-once SD card service with health tracking.
+
+#include "sd_storage.h"
+#include <SPI.h>
+#include <unistd.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+static SemaphoreHandle_t s_mutex = nullptr;
+
+static bool     s_mounted = false;
+static bool     s_spiReady = false;
+static uint8_t  s_cardType = CARD_NONE;
+static uint64_t s_cardBytes = 0;
+static uint64_t s_totalBytes = 0;
+static uint64_t s_usedBytes = 0;
+static uint32_t s_mounts = 0;
+static uint32_t s_errors = 0;
+static uint32_t s_writes = 0;
+static uint64_t s_writeUsSum = 0;
+static uint32_t s_writeMaxUs = 0;
+
+static unsigned long s_retryAtMs = 0;
+static unsigned long s_backoffMs = SD_REMOUNT_MIN_MS;
+static unsigned long s_lastProbeMs = 0;
+static unsigned long s_lastSpaceMs = 0;
+
+static SemaphoreHandle_t sd_mutex() {
+  // created on first use from setup(), before any other task touches the card
+  if (!s_mutex) s_mutex = xSemaphoreCreateRecursiveMutex();
+  return s_mutex;
+}
+
+SdLock::SdLock() {
+  xSemaphoreTakeRecursive(sd_mutex(), portMAX_DELAY);
+  _ok = s_mounted;
+}
+
+SdLock::~SdLock() {
+  xSemaphoreGiveRecursive(sd_mutex());
+}
+
+// Caller holds the lock
+static void sd_refreshSpace() {
+  s_totalBytes = SD.totalBytes();
+  s_usedBytes = SD.usedBytes();
+  s_lastSpaceMs = millis();
+}
+
+// Caller holds the lock
+static bool sd_mount() {
+  if (!s_spiReady) {
+    SPI.begin(SD_SCLK, SD_MISO, SD_MOSI, SD_CS);
+    s_spiReady = true;
+  }
+  if (s_mounts > 0) SD.end();
+  s_mounted = SD.begin(SD_CS, SPI, 4000000, SD_MOUNT_POINT);
+  s_cardType = s_mounted ? SD.cardType() : CARD_NONE;
+  if (s_mounted && s_cardType == CARD_NONE) {
+    SD.end();
+    s_mounted = false;
+  }
+  if (!s_mounted) return false;
+
+  s_mounts++;
+  s_cardBytes = SD.cardSize();
+  sd_refreshSpace();
+  s_lastProbeMs = millis();
+  s_backoffMs = SD_REMOUNT_MIN_MS;
+  return true;
+}
+
+bool sd_init() {
+  SdLock lk;
+  if (s_mounted) return true;
+  bool ok = sd_mount();
+  if (!ok) s_retryAtMs = millis() + s_backoffMs;
+  return ok;
+}
+
+bool sd_isMounted() {
+  return s_mounted;
+}
+
+uint32_t sd_mountCount() {
+  return s_mounts;
+}
+
+void sd_noteError(const char *what) {
+  SdLock lk;
+  s_errors++;
+  if (!s_mounted) return;
+  s_mounted = false;
+  s_retryAtMs = millis() + s_backoffMs;
+  Serial.printf("[SD] I/O error (%s), remount in %lu s\n", what ? what : "?", s_backoffMs / 1000UL);
+}
+
+size_t sd_write(File &f, const uint8_t *buf, size_t len) {
+  uint32_t t0 = micros();
+  size_t n = f.write(buf, len);
+  uint32_t us = micros() - t0;
+
+  SdLock lk;
+  s_writes++;
+  s_writeUsSum += us;
+  if (us > s_writeMaxUs) s_writeMaxUs = us;
+  if (n != len) sd_noteError("short write");
+  return n;
+}
+
+bool sd_truncate(const char *path, uint32_t len) {
+  char vfsPath[64];
+  snprintf(vfsPath, sizeof(vfsPath), "%s%s", SD_MOUNT_POINT, path);
+  if (truncate(vfsPath, len) == 0) return true;
+  sd_noteError("truncate");
+  return false;
+}
+
+void sd_loop() {
+  unsigned long now = millis();
+  SdLock lk;
+
+  if (!s_mounted) {
+    if ((long)(now - s_retryAtMs) < 0) return;
+    if (sd_mount()) {
+      Serial.printf("[SD] card mounted (%s)\n", sd_cardTypeName(s_cardType));
+    } else {
+      s_backoffMs = min(s_backoffMs * 2, SD_REMOUNT_MAX_MS);
+      s_retryAtMs = now + s_backoffMs;
+    }
+    return;
+  }
+
+  // Cheap presence check: listing the root directory goes to the card, so a
+  // pulled card shows up here even when nothing is being written.
+  if (now - s_lastProbeMs >= SD_PROBE_INTERVAL_MS) {
+    s_lastProbeMs = now;
+    File root = SD.open("/");
+    bool ok = root && root.isDirectory();
+    if (ok) {
+      File e = root.openNextFile();
+      if (e) e.close();
+    }
+    if (root) root.close();
+    if (!ok) {
+      sd_noteError("probe");
+      return;
+    }
+  }
+
+  if (now - s_lastSpaceMs >= SD_SPACE_INTERVAL_MS) sd_refreshSpace();
+}
+
+void sd_getStats(SdStats &out) {
+  SdLock lk;
+  out.mounted = s_mounted;
+  out.cardType = s_cardType;
+  out.cardBytes = s_cardBytes;
+  out.totalBytes = s_totalBytes;
+  out.usedBytes = s_usedBytes;
+  out.mounts = s_mounts;
+  out.errors = s_errors;
+  out.writes = s_writes;
+  out.writeAvgUs = s_writes ? (uint32_t)(s_writeUsSum / s_writes) : 0;
+  out.writeMaxUs = s_writeMaxUs;
+}
+
+const char *sd_cardTypeName(uint8_t type) {
+  switch (type) {
+    case CARD_MMC:  return "MMC";
+    case CARD_SD:   return "SDSC";
+    case CARD_SDHC: return "SDHC";
+    case CARD_NONE: return "NONE";
+    default:        return "UNKNOWN";
+  }
+}
+
+void sd_print(Print &out) {
+  SdStats st;
+  sd_getStats(st);
+  out.printf("[SD] %s, type %s, card %lu MB\n", st.mounted ? "mounted" : "NOT mounted",
+             sd_cardTypeName(st.cardType), (unsigned long)(st.cardBytes >> 20));
+  out.printf("[SD] fs %lu MB, used %lu MB, free %lu MB\n", (unsigned long)(st.totalBytes >> 20),
+             (unsigned long)(st.usedBytes >> 20),
+             (unsigned long)((st.totalBytes - st.usedBytes) >> 20));
+  out.printf("[SD] writes %lu, avg %lu us, max %lu us, errors %lu, mounts %lu\n",
+             (unsigned long)st.writes, (unsigned long)st.writeAvgUs, (unsigned long)st.writeMaxUs,
+             (unsigned long)st.errors, (unsigned long)st.mounts);
+}
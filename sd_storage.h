@@ -0,0 +1,84 @@
+#ifndef SD_STORAGE_H
+#define SD_STORAGE_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include "config.h"
+
+// SD card service.
+// The card is mounted once in setup(); callers no longer run SD.begin().
+// Every SD access happens under SdLock, which serialises the loop, the web
+// server and background tasks and reports whether the card is usable.
+// After an I/O error the card is marked unhealthy and sd_loop() remounts it
+// with an increasing backoff instead of re-initialising on every operation.
+
+// VFS mount point, needed for POSIX calls such as truncate()
+#ifndef SD_MOUNT_POINT
+#define SD_MOUNT_POINT "/sd"
+#endif
+
+#ifndef SD_REMOUNT_MIN_MS
+#define SD_REMOUNT_MIN_MS   (5UL * 1000UL)
+#endif
+
+#ifndef SD_REMOUNT_MAX_MS
+#define SD_REMOUNT_MAX_MS   (5UL * 60UL * 1000UL)
+#endif
+
+#ifndef SD_PROBE_INTERVAL_MS
+#define SD_PROBE_INTERVAL_MS (30UL * 1000UL)     // card presence check
+#endif
+
+#ifndef SD_SPACE_INTERVAL_MS
+#define SD_SPACE_INTERVAL_MS (10UL * 60UL * 1000UL)  // free-space refresh (scans the FAT)
+#endif
+
+struct SdStats {
+  bool     mounted;
+  uint8_t  cardType;        // sdcard_type_t
+  uint64_t cardBytes;
+  uint64_t totalBytes;      // filesystem size
+  uint64_t usedBytes;       // refreshed every SD_SPACE_INTERVAL_MS
+  uint32_t mounts;          // successful mounts incl. the first one
+  uint32_t errors;          // failed opens / short writes / failed probes
+  uint32_t writes;
+  uint32_t writeAvgUs;
+  uint32_t writeMaxUs;
+};
+
+bool sd_init();             // SPI + first mount; returns mounted state
+void sd_loop();             // presence probe, remount after errors, free space refresh
+bool sd_isMounted();
+
+// Changes every time the card is (re)mounted; modules caching directory
+// state compare it to notice a swapped card.
+uint32_t sd_mountCount();
+
+// Report an I/O failure; the card is remounted by sd_loop() after a backoff.
+void sd_noteError(const char *what);
+
+// File::write() with latency / error accounting. A short write counts as an error.
+size_t sd_write(File &f, const uint8_t *buf, size_t len);
+
+// Cut a (closed) file back to len bytes, e.g. to drop a torn tail record.
+bool sd_truncate(const char *path, uint32_t len);
+
+void sd_getStats(SdStats &out);
+const char *sd_cardTypeName(uint8_t type);
+void sd_print(Print &out);
+
+// Scoped lock on the card (recursive, so helpers may nest).
+//   SdLock lk;
+//   if (!lk) return false;      // card not mounted
+class SdLock {
+public:
+  SdLock();
+  ~SdLock();
+  explicit operator bool() const { return _ok; }
+private:
+  bool _ok;
+  SdLock(const SdLock &) = delete;
+  SdLock &operator=(const SdLock &) = delete;
+};
+
+#endif // SD_STORAGE_H
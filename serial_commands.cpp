@@ -2,14 +2,28 @@
 #include "sms_handler.h"
 #include "thingspeak_client.h"
 #include "config.h"
+#include "perf_stats.h"
+#include "mem_telemetry.h"
+#include "tsdb.h"
+#include "ts_queue.h"
+#include "sd_storage.h"
+#include "gateway.h"
+#include "telemetry_sink.h"
+#include "mqtt_sink.h"
+#include "upload_scheduler.h"
+#include "wifi_manager.h"
+#include "settings.h"
+#include "http_server.h"
+#include "lcd_endpoint.h"
+#include "ota_update.h"
+#include "time_manager.h"
+#include <time.h>
 #include <WiFi.h>
 #include <SD.h>
-#include <Preferences.h>
 #include "modem_manager.h"
 #include <TinyGsmClient.h>
 
 // Forward to modem post function implemented in thingspeak_client_modem.cpp
-extern bool thingspeak_post_via_modem(const String &postBody);
 
 static String inputLine;
 
@@ -34,21 +48,34 @@ static String readSerialLineNonBlocking() {
   return String();
 }
 
+static bool printQueuedSample(const TelemetrySample &s, uint32_t idx, void *ctx) {
+  (void) ctx;
+  Serial.printf("#%lu: ts=%lu weight=%.2f t_int=%.2f batt=%.2f\n", (unsigned long)idx + 1,
+                (unsigned long)s.ts, sample_value(s, CH_WEIGHT), sample_value(s, CH_TEMP_INT),
+                sample_value(s, CH_BATT));
+  return true;
+}
+
 static void printTSQueueStatus() {
-  if (!SD.begin(SD_CS)) {
+  SdLock lk;
+  if (!lk) {
     Serial.println(F("[TS STATUS] SD not available"));
     return;
   }
-  if (!SD.exists(TS_QUEUE_FILENAME)) {
-    Serial.println(F("[TS STATUS] No queued posts (no /ts_queue.txt)"));
-    return;
+  Serial.printf("[TS STATUS] %lu samples queued in " TSQ_DIR " (thingspeak %lu, mqtt %lu, http %lu)\n",
+                (unsigned long)tsq_depth(), (unsigned long)tsq_pending(SINK_THINGSPEAK),
+                (unsigned long)tsq_pending(SINK_MQTT), (unsigned long)tsq_pending(SINK_HTTP));
+  if (tsq_forEach(printQueuedSample, nullptr, 50) >= 50) {
+    Serial.println(F("[TS STATUS] ... truncated after 50 samples"));
   }
+
+  if (!SD.exists(TS_QUEUE_FILENAME)) return;
   File f = SD.open(TS_QUEUE_FILENAME, FILE_READ);
   if (!f) {
     Serial.println(F("[TS STATUS] Cannot open /ts_queue.txt"));
     return;
   }
-  Serial.println(F("[TS STATUS] /ts_queue.txt contents:"));
+  Serial.println(F("[TS STATUS] legacy /ts_queue.txt contents:"));
   int i = 0;
   while (f.available()) {
     String ln = f.readStringUntil('\n');
@@ -147,11 +174,32 @@ static void runModemDiag() {
   Serial.println(F("[MODEM DIAG] Done."));
 }
 
-// Simple URL-encode for coordinates (space -> +, others left as-is)
-static String urlEncodeSimple(const String &s) {
-  String r = s;
-  r.replace(" ", "+");
-  return r;
+// 'hist [hours]': hourly weight summary straight from the local store
+static bool printHistRow(const TsdbRollup &r, void *ctx) {
+  (void) ctx;
+  time_t t = (time_t)r.ts;
+  struct tm tmv;
+  gmtime_r(&t, &tmv);
+  char line[96];
+  snprintf(line, sizeof(line), "  %02d-%02d %02d:00Z  n=%-3u weight %.2f kg (min %.2f max %.2f)  t_int %.1f",
+           tmv.tm_mday, tmv.tm_mon + 1, tmv.tm_hour, (unsigned)r.count,
+           r.vmean[CH_WEIGHT] / 1000.0f, r.vmin[CH_WEIGHT] / 1000.0f, r.vmax[CH_WEIGHT] / 1000.0f,
+           r.vmean[CH_TEMP_INT] / 100.0f);
+  Serial.println(line);
+  return true;
+}
+
+static void printHistory(int hours) {
+  if (!timeManager_isTimeValid()) {
+    Serial.println(F("[HIST] time not valid yet"));
+    return;
+  }
+  if (hours <= 0) hours = 24;
+  uint32_t to = (uint32_t)time(nullptr);
+  uint32_t from = to - (uint32_t)hours * 3600UL;
+  unsigned long t0 = millis();
+  uint32_t n = tsdb_query(from, to, 3600, printHistRow, nullptr);
+  Serial.printf("[HIST] %lu points in %lu ms\n", (unsigned long)n, millis() - t0);
 }
 
 void serial_commands_poll() {
@@ -167,13 +215,57 @@ void serial_commands_poll() {
     sms_scan_now();
     return;
   }
+  if (up == "SMS PIN" || up.startsWith("SMS PIN ")) {
+    String pin = ln.length() > 8 ? ln.substring(8) : String();
+    pin.trim();
+    bool valid = pin.length() == 0 || (pin.length() >= 4 && pin.length() <= 8);
+    for (size_t i = 0; valid && i < pin.length(); ++i) valid = isdigit((unsigned char)pin[i]);
+    if (valid && settings_setSmsPin(pin.c_str())) {
+      Serial.println(pin.length() ? F("[CMD] SMS PIN saved") : F("[CMD] SMS PIN access off"));
+    } else {
+      Serial.println(F("[CMD] usage: sms pin <4-8 digits>  (no PIN turns PIN access off)"));
+    }
+    return;
+  }
+  if (up.startsWith("SMS ALLOW ")) {
+    unsigned slot = 0;
+    char number[17] = "";
+    int n = sscanf(ln.c_str() + 10, "%u %16s", &slot, number);
+    if (n >= 1 && slot >= 1 && slot <= SETTINGS_SMS_ALLOW && settings_setSmsAllow(slot - 1, number)) {
+      Serial.printf("[CMD] SMS sender %u: %s\n", slot, number[0] ? number : "(cleared)");
+    } else {
+      Serial.printf("[CMD] usage: sms allow <1-%u> <+number>  (no number clears the slot)\n", SETTINGS_SMS_ALLOW);
+    }
+    return;
+  }
   if (up == "HELP" || up == "?") {
     Serial.println(F("[CMD] Commands:"));
     Serial.println(F("  sms            -> trigger immediate SMS scan"));
+    Serial.println(F("  sms pin <pin>  -> PIN for SMS commands ('#<pin> STATUS'), no PIN = off"));
+    Serial.println(F("  sms allow <n> <+number> -> sender allowed without PIN (slot 1-4)"));
     Serial.println(F("  ts status      -> print ThingSpeak/WiFi/queue status"));
     Serial.println(F("  ts send        -> trigger immediate ThingSpeak upload (WiFi-first path)"));
     Serial.println(F("  ts send-lte    -> trigger ThingSpeak upload via MODEM (LTE, manual)"));
+    Serial.println(F("  ts key <key>   -> store the ThingSpeak write key (no key = config.h default)"));
+    Serial.println(F("  sinks          -> telemetry sinks (ThingSpeak/MQTT/HTTP) backlog and state"));
+    Serial.println(F("  sched          -> upload scheduler mode, signal, battery, radio time per sample"));
+    Serial.println(F("  wifi           -> WiFi manager state, last BSSID/channel, cached scan"));
+    Serial.println(F("  wifi scan      -> refresh the scan cache in the background"));
+    Serial.println(F("  http           -> web server sessions, per-route request counts, LCD stream viewers"));
+    Serial.println(F("  ota            -> firmware update state, running slot, trial status"));
+    Serial.println(F("  ota <url> <sha256> -> pull firmware over LTE (http:// only, resumes after drops)"));
+    Serial.println(F("  ota abort      -> discard an unfinished update"));
+    Serial.println(F("  settings       -> stored settings (WiFi slots, upload, coordinates, calibration)"));
     Serial.println(F("  modem test     -> run modem diagnostics (AT cmds + TCP test)"));
+    Serial.println(F("  hist [hours]   -> hourly weight summary from the SD store (default 24h)"));
+    Serial.println(F("  mem            -> print heap/fragmentation and task stack watermarks"));
+    Serial.println(F("  sd             -> print SD card state, free space, write latency, errors"));
+    Serial.println(F("  gw             -> ESP-NOW gateway/satellite status"));
+    Serial.println(F("  gw node <id> <channel> <key> -> map a satellite to its ThingSpeak channel (gateway)"));
+#if ENABLE_PERF_STATS
+    Serial.println(F("  perf           -> print loop() stage latency histograms"));
+    Serial.println(F("  perf reset     -> clear latency histograms"));
+#endif
     Serial.println(F("  help           -> print this help"));
     return;
   }
@@ -186,10 +278,10 @@ void serial_commands_poll() {
     Serial.print(F("  localIP: "));
     Serial.println(ip);
     printTSQueueStatus();
-    if (strlen(THINGSPEAK_WRITE_APIKEY) == 0) {
-      Serial.println(F("  THINGSPEAK_WRITE_APIKEY: (empty)"));
+    if (strlen(thingspeak_apiKey()) == 0) {
+      Serial.println(F("  ThingSpeak write key: (empty)"));
     } else {
-      Serial.println(F("  THINGSPEAK_WRITE_APIKEY: set"));
+      Serial.println(F("  ThingSpeak write key: set"));
     }
     return;
   }
@@ -198,7 +290,74 @@ void serial_commands_poll() {
     Serial.println(F("[CMD] Triggering manual ThingSpeak upload (WiFi-first path)..."));
     bool ok = thingspeak_upload_current();
     if (ok) Serial.println(F("[CMD] ThingSpeak upload: SUCCESS (immediate)"));
-    else Serial.println(F("[CMD] ThingSpeak upload: FAILED or queued"));
+    else Serial.println(F("[CMD] ThingSpeak upload: FAILED"));
+    return;
+  }
+
+  if (up == "TS KEY" || up.startsWith("TS KEY ")) {
+    // keep the original case of the key
+    String key = ln.length() > 7 ? ln.substring(7) : String();
+    key.trim();
+    if (thingspeak_setApiKey(key.c_str())) {
+      Serial.println(key.length() ? F("[CMD] ThingSpeak write key saved") : F("[CMD] ThingSpeak write key reset to default"));
+      sinks_init();
+    } else {
+      Serial.println(F("[CMD] Cannot store ThingSpeak write key"));
+    }
+    return;
+  }
+
+  if (up == "SCHED") {
+    sched_print(Serial);
+    return;
+  }
+
+  if (up == "HTTP") {
+    http_print(Serial);
+    lcd_endpoint_print(Serial);
+    return;
+  }
+
+  if (up == "OTA") {
+    ota_print(Serial);
+    return;
+  }
+  if (up == "OTA ABORT") {
+    ota_abort("aborted");
+    Serial.println(F("[CMD] OTA image discarded"));
+    return;
+  }
+  if (up.startsWith("OTA ")) {
+    // keep the original case of the URL
+    char url[192] = "";
+    char sha[65] = "";
+    if (sscanf(ln.c_str() + 4, "%191s %64s", url, sha) == 2 && ota_pullStart(url, sha)) {
+      Serial.println(F("[CMD] OTA pull started, 'ota' shows progress"));
+    } else {
+      Serial.println(F("[CMD] usage: ota http://host[:port]/path <sha256 hex>  (not while another update runs)"));
+    }
+    return;
+  }
+
+  if (up == "SETTINGS") {
+    settings_print(Serial);
+    return;
+  }
+
+  if (up == "WIFI") {
+    wifi_print(Serial);
+    return;
+  }
+
+  if (up == "WIFI SCAN") {
+    wifi_requestScan();
+    Serial.println(F("[CMD] WiFi scan requested - 'wifi' shows the results"));
+    return;
+  }
+
+  if (up == "SINKS") {
+    sinks_print(Serial);
+    mqtt_print(Serial);
     return;
   }
 
@@ -206,58 +365,9 @@ void serial_commands_poll() {
     Serial.println(F("[CMD] Triggering ThingSpeak upload via MODEM (LTE)..."));
 
     // Build post body same as thingspeak_upload_current() would
-    char buf[64];
-    String b;
-    b.reserve(200);
-
-    // field1: weight (kg) 1 decimal
-    snprintf(buf, sizeof(buf), "%.1f", test_weight);
-    b += "field1=" + String(buf);
-
-    // field2: internal temp 1 decimal
-    snprintf(buf, sizeof(buf), "%.1f", test_temp_int);
-    b += "&field2=" + String(buf);
-
-    // field3: internal humidity 0 decimals
-    snprintf(buf, sizeof(buf), "%.0f", test_hum_int);
-    b += "&field3=" + String(buf);
-
-    // field4: external temp 1 decimal
-    snprintf(buf, sizeof(buf), "%.1f", test_temp_ext);
-    b += "&field4=" + String(buf);
-
-    // field5: external humidity 0 decimals
-    snprintf(buf, sizeof(buf), "%.0f", test_hum_ext);
-    b += "&field5=" + String(buf);
-
-    // field6: pressure 0 decimals
-    snprintf(buf, sizeof(buf), "%.0f", test_pressure);
-    b += "&field6=" + String(buf);
-
-    // field7: battery voltage 2 decimals
-    snprintf(buf, sizeof(buf), "%.2f", test_batt_voltage);
-    b += "&field7=" + String(buf);
-
-    // coords from preferences
-    Preferences p;
-    p.begin("beehive", true);
-    String latS = p.getString("owm_lat", "");
-    String lonS = p.getString("owm_lon", "");
-    p.end();
-    double lat = DEFAULT_LAT, lon = DEFAULT_LON;
-    if (latS.length() && lonS.length()) {
-      lat = latS.toDouble();
-      lon = lonS.toDouble();
-    }
-    char latBuf[32], lonBuf[32];
-    snprintf(latBuf, sizeof(latBuf), "%.4f", lat);
-    snprintf(lonBuf, sizeof(lonBuf), "%.4f", lon);
-    String coords = String(latBuf) + String(" ") + String(lonBuf);
-    String coordsEnc = urlEncodeSimple(coords);  // or urlEncodeSimple(coords) -> ensure it encodes space as +
-    b += "&field8=" + coordsEnc;
-
-    // Prepend api_key
-    String post = String("api_key=") + THINGSPEAK_WRITE_APIKEY + String("&") + b;
+    TelemetrySample sample;
+    sample_capture(sample);
+    String post = thingspeak_buildPost(sample, true);
 
     // Call modem poster
     bool ok = thingspeak_post_via_modem(post);
@@ -267,6 +377,51 @@ void serial_commands_poll() {
     return;
   }
 
+  if (up == "HIST" || up.startsWith("HIST ")) {
+    printHistory(up.length() > 5 ? up.substring(5).toInt() : 24);
+    return;
+  }
+
+  if (up == "MEM") {
+    mem_print(Serial);
+    return;
+  }
+
+  if (up == "SD") {
+    sd_print(Serial);
+    return;
+  }
+
+  if (up == "GW") {
+    gateway_print(Serial);
+    return;
+  }
+  if (up.startsWith("GW NODE ")) {
+    // keep the original case for the write key
+    unsigned id = 0;
+    unsigned long channel = 0;
+    char key[24] = "";
+    int n = sscanf(ln.c_str() + 8, "%u %lu %23s", &id, &channel, key);
+    if (n >= 2 && id > 0 && id < 255 && gateway_setNode((uint8_t)id, channel, key)) {
+      Serial.printf("[CMD] node %u -> channel %lu %s\n", id, channel, key[0] ? "saved" : "removed");
+    } else {
+      Serial.println(F("[CMD] usage: gw node <id 1..254> <channel> <write key>  (gateway only, no key removes)"));
+    }
+    return;
+  }
+
+#if ENABLE_PERF_STATS
+  if (up == "PERF") {
+    perf_print(Serial);
+    return;
+  }
+  if (up == "PERF RESET") {
+    perf_reset();
+    Serial.println(F("[CMD] Latency histograms cleared"));
+    return;
+  }
+#endif
+
   if (up == "MODEM TEST" || up == "MODEMTEST") {
     Serial.println(F("[CMD] Running modem diagnostics..."));
     runModemDiag();
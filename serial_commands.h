@@ -7,5 +7,8 @@ void serial_commands_init();
 // Poll serial input; should be called frequently from loop()
 // Recognized commands:
 //   sms    -> trigger immediate SMS scan (calls sms_scan_now())
+//   hist   -> hourly weight summary from the local SD store
+//   mem    -> print heap / stack watermark telemetry
+//   perf   -> print loop() stage latency histograms (ENABLE_PERF_STATS)
 //   help   -> print help
 void serial_commands_poll();
\ No newline at end of file
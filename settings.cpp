@@ -0,0 +1,346 @@
+// settings.cpp - RAM settings cache, one CRC-checked NVS blob, schema migration.
+
+#include "settings.h"
+#include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define SETTINGS_SCHEMA 2
+
+static Settings          s_cfg;
+static SemaphoreHandle_t s_mutex = nullptr;
+static SettingsListener  s_listeners[SETTINGS_MAX_LISTENERS];
+static uint8_t           s_listenerCount = 0;
+static uint32_t          s_writes = 0;
+static uint32_t          s_writeErrors = 0;
+
+static void settings_lock()   { xSemaphoreTake(s_mutex, portMAX_DELAY); }
+static void settings_unlock() { xSemaphoreGive(s_mutex); }
+
+// Zero-padded copy, so unchanged strings compare equal byte for byte
+static void settings_copyStr(char *dst, size_t size, const char *src) {
+  strncpy(dst, src ? src : "", size - 1);
+  dst[size - 1] = '\0';
+}
+
+static void settings_defaults(Settings &c) {
+  memset(&c, 0, sizeof(c));
+  c.tsIntervalMin = 60;
+}
+
+// ---------------------------------------------------------------------------
+// NVS layout (SETTINGS_NS): "cfg" = SettingsHeader + Settings, one blob, so a
+// boot is one read and a save replaces all fields at once (NVS writes the
+// new entry before it drops the old one).
+//
+// Schema history, each with its loader below:
+//   0  scattered keys in beehive / beehive_app / wifi_cfg / calib_ns
+//   1  one key per field in SETTINGS_NS, "ver" = 1
+//   2  the "cfg" blob
+// Fields appended to Settings need no new schema: a shorter blob of the
+// same schema leaves them at their defaults. Anything else bumps
+// SETTINGS_SCHEMA and adds a settings_upgradeN() step.
+
+struct SettingsHeader {
+  uint16_t schema;
+  uint16_t size;             // sizeof(Settings) when written
+  uint32_t crc;              // CRC-32 of the header (crc = 0) and the payload
+} __attribute__((packed));
+
+static_assert(sizeof(SettingsHeader) + sizeof(Settings) < 1984, "settings blob outgrew one NVS page");
+
+static uint16_t      s_loadedSchema = 0;
+static unsigned long s_loadUs = 0;
+
+static uint32_t settings_crc32(const uint8_t *p, size_t n, uint32_t crc = 0xFFFFFFFF) {
+  while (n--) {
+    crc ^= *p++;
+    for (int i = 0; i < 8; ++i) crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+  }
+  return crc;
+}
+
+static uint32_t settings_blobCrc(SettingsHeader h, const uint8_t *payload, size_t len) {
+  h.crc = 0;
+  uint32_t crc = settings_crc32((const uint8_t *)&h, sizeof(h));
+  return ~settings_crc32(payload, len, crc);
+}
+
+// Schema 2. Returns false for a missing, corrupt or newer blob.
+static bool settings_fromBlob(Preferences &p) {
+  uint8_t buf[sizeof(SettingsHeader) + sizeof(Settings)];
+  size_t n = p.getBytesLength("cfg");
+  if (n < sizeof(SettingsHeader) || n > sizeof(buf)) return false;
+  if (p.getBytes("cfg", buf, n) != n) return false;
+
+  SettingsHeader h;
+  memcpy(&h, buf, sizeof(h));
+  size_t len = n - sizeof(h);
+  if (h.size != len || h.crc != settings_blobCrc(h, buf + sizeof(h), len)) {
+    Serial.println(F("[CFG] settings blob corrupt - using defaults"));
+    return false;
+  }
+  if (h.schema != SETTINGS_SCHEMA) {
+    // no older blob schema exists yet; a newer one means a downgrade
+    Serial.printf("[CFG] settings schema %u unknown - using defaults\n", h.schema);
+    return false;
+  }
+  memcpy(&s_cfg, buf + sizeof(h), len);
+  return true;
+}
+
+// Schema 1 (first settings release): one key per field
+static void settings_fromKeys(Preferences &p) {
+  char k[8];
+  for (uint8_t i = 0; i < SETTINGS_WIFI_SLOTS; ++i) {
+    snprintf(k, sizeof(k), "w%us", i);
+    settings_copyStr(s_cfg.wifi[i].ssid, sizeof(s_cfg.wifi[i].ssid), p.getString(k, "").c_str());
+    snprintf(k, sizeof(k), "w%up", i);
+    settings_copyStr(s_cfg.wifi[i].pass, sizeof(s_cfg.wifi[i].pass), p.getString(k, "").c_str());
+  }
+  settings_copyStr(s_cfg.wifiLastSsid, sizeof(s_cfg.wifiLastSsid), p.getString("wl_ssid", "").c_str());
+  if (p.getBytes("wl_bssid", s_cfg.wifiLastBssid, 6) == 6) s_cfg.wifiLastChannel = p.getUChar("wl_ch", 0);
+
+  s_cfg.hasCoords = p.isKey("lat") && p.isKey("lon");
+  if (s_cfg.hasCoords) {
+    s_cfg.lat = p.getDouble("lat", DEFAULT_LAT);
+    s_cfg.lon = p.getDouble("lon", DEFAULT_LON);
+  }
+
+  s_cfg.tsAuto = p.getBool("ts_auto", false);
+  s_cfg.tsIntervalMin = p.getUShort("ts_int", 60);
+  s_cfg.netPref = p.getUChar("net", 0);
+  settings_copyStr(s_cfg.tsKey, sizeof(s_cfg.tsKey), p.getString("ts_key", "").c_str());
+
+  s_cfg.calFactor = p.getFloat("cal_f", 0.0f);
+  s_cfg.calOffset = p.getInt("cal_o", 0);
+  s_cfg.calKnownGrams = p.getInt("cal_k", 0);
+}
+
+// Schema 0 (pre-settings firmware): four namespaces
+static void settings_fromLegacy() {
+  Preferences p;
+  if (p.begin("beehive", true)) {
+    settings_copyStr(s_cfg.wifi[0].ssid, sizeof(s_cfg.wifi[0].ssid), p.getString("wifi_ssid1", "").c_str());
+    settings_copyStr(s_cfg.wifi[0].pass, sizeof(s_cfg.wifi[0].pass), p.getString("wifi_psk1", "").c_str());
+    settings_copyStr(s_cfg.wifi[1].ssid, sizeof(s_cfg.wifi[1].ssid), p.getString("wifi_ssid2", "").c_str());
+    settings_copyStr(s_cfg.wifi[1].pass, sizeof(s_cfg.wifi[1].pass), p.getString("wifi_psk2", "").c_str());
+    settings_copyStr(s_cfg.wifiLastSsid, sizeof(s_cfg.wifiLastSsid), p.getString("wifi_last", "").c_str());
+    if (p.getBytes("wifi_bssid", s_cfg.wifiLastBssid, 6) == 6) s_cfg.wifiLastChannel = p.getUChar("wifi_ch", 0);
+    String lat = p.getString("owm_lat", "");
+    String lon = p.getString("owm_lon", "");
+    if (lat.length() && lon.length()) {
+      s_cfg.hasCoords = true;
+      s_cfg.lat = lat.toDouble();
+      s_cfg.lon = lon.toDouble();
+    }
+    settings_copyStr(s_cfg.tsKey, sizeof(s_cfg.tsKey), p.getString("ts_key", "").c_str());
+    p.end();
+  }
+  if (p.begin("beehive_app", true)) {
+    s_cfg.tsAuto = p.getBool("ts_auto", false);
+    int iv = p.getInt("ts_interval_min", 60);
+    s_cfg.tsIntervalMin = (iv > 0 && iv <= 0xFFFF) ? iv : 60;
+    s_cfg.netPref = (uint8_t)constrain(p.getInt("net_pref", 0), 0, 2);
+    p.end();
+  }
+  if (p.begin("wifi_cfg", true)) {
+    settings_copyStr(s_cfg.wifi[2].ssid, sizeof(s_cfg.wifi[2].ssid), p.getString("ssid", "").c_str());
+    settings_copyStr(s_cfg.wifi[2].pass, sizeof(s_cfg.wifi[2].pass), p.getString("pass", "").c_str());
+    p.end();
+  }
+  if (p.begin("calib_ns", true)) {
+    s_cfg.calFactor = p.getFloat("factor", 0.0f);
+    s_cfg.calOffset = p.getLong("offset", 0);
+    s_cfg.calKnownGrams = p.getInt("known", 0);
+    p.end();
+  }
+}
+
+// Old keys go only after the blob holding their values has been written
+static void settings_eraseOld(uint16_t schema) {
+  Preferences p;
+  if (schema == 0) {
+    if (p.begin("beehive", false)) {
+      static const char *const moved[] = { "wifi_ssid1", "wifi_psk1", "wifi_ssid2", "wifi_psk2", "wifi_last",
+                                           "wifi_bssid", "wifi_ch", "owm_lat", "owm_lon", "ts_key" };
+      for (const char *k : moved) p.remove(k);
+      p.end();
+    }
+    static const char *const spaces[] = { "beehive_app", "wifi_cfg", "calib_ns" };
+    for (const char *ns : spaces) {
+      if (!p.begin(ns, false)) continue;
+      p.clear();
+      p.end();
+    }
+  } else if (schema == 1 && p.begin(SETTINGS_NS, false)) {
+    static const char *const keys[] = { "w0s", "w0p", "w1s", "w1p", "w2s", "w2p", "wl_ssid", "wl_bssid", "wl_ch",
+                                        "lat", "lon", "ts_auto", "ts_int", "net", "ts_key", "cal_f", "cal_o",
+                                        "cal_k", "ver" };
+    for (const char *k : keys) p.remove(k);
+    p.end();
+  }
+}
+
+// Caller holds the lock (or is settings_init)
+static bool settings_store() {
+  uint8_t buf[sizeof(SettingsHeader) + sizeof(Settings)];
+  SettingsHeader h = { SETTINGS_SCHEMA, (uint16_t)sizeof(Settings), 0 };
+  memcpy(buf + sizeof(h), &s_cfg, sizeof(Settings));
+  h.crc = settings_blobCrc(h, buf + sizeof(h), sizeof(Settings));
+  memcpy(buf, &h, sizeof(h));
+
+  Preferences p;
+  bool ok = p.begin(SETTINGS_NS, false) && p.putBytes("cfg", buf, sizeof(buf)) == sizeof(buf);
+  p.end();
+
+  s_writes++;
+  if (!ok) {
+    s_writeErrors++;
+    Serial.println(F("[CFG] NVS write failed"));
+  }
+  return ok;
+}
+
+void settings_init() {
+  if (s_mutex) return;
+  s_mutex = xSemaphoreCreateMutex();
+  settings_defaults(s_cfg);
+
+  unsigned long t0 = micros();
+  Preferences p;
+  bool opened = p.begin(SETTINGS_NS, true);
+  if (opened && settings_fromBlob(p)) {
+    s_loadedSchema = SETTINGS_SCHEMA;
+  } else if (opened && p.getUChar("ver", 0) == 1) {
+    s_loadedSchema = 1;
+    settings_fromKeys(p);
+  } else if (!opened || !p.isKey("cfg")) {
+    s_loadedSchema = 0;
+    settings_fromLegacy();
+  } else {
+    s_loadedSchema = SETTINGS_SCHEMA;    // corrupt/unknown blob: defaults, kept until the next save
+  }
+  p.end();
+  s_loadUs = micros() - t0;
+  if (s_cfg.tsIntervalMin == 0) s_cfg.tsIntervalMin = 60;
+
+  if (s_loadedSchema < SETTINGS_SCHEMA) {
+    if (settings_store()) settings_eraseOld(s_loadedSchema);
+    Serial.printf("[CFG] settings migrated from schema %u\n", s_loadedSchema);
+  }
+}
+
+const Settings &settings() {
+  return s_cfg;
+}
+
+void settings_copy(Settings &out) {
+  settings_lock();
+  out = s_cfg;
+  settings_unlock();
+}
+
+bool settings_onChange(SettingsListener cb) {
+  if (!cb || s_listenerCount >= SETTINGS_MAX_LISTENERS) return false;
+  s_listeners[s_listenerCount++] = cb;
+  return true;
+}
+
+// Apply edit() to the RAM copy; persist and notify only if it changed something.
+template <typename F>
+static bool settings_apply(uint16_t group, F edit) {
+  settings_lock();
+  Settings before = s_cfg;
+  edit(s_cfg);
+  bool changed = memcmp(&before, &s_cfg, sizeof(Settings)) != 0;
+  bool ok = !changed || settings_store();
+  settings_unlock();
+  if (changed) {
+    for (uint8_t i = 0; i < s_listenerCount; ++i) s_listeners[i](group);
+  }
+  return ok;
+}
+
+bool settings_setWifi(uint8_t slot, const char *ssid, const char *pass) {
+  if (slot >= SETTINGS_WIFI_SLOTS) return false;
+  return settings_apply(SET_WIFI, [&](Settings &c) {
+    settings_copyStr(c.wifi[slot].ssid, sizeof(c.wifi[slot].ssid), ssid);
+    settings_copyStr(c.wifi[slot].pass, sizeof(c.wifi[slot].pass), pass);
+  });
+}
+
+bool settings_setWifiLast(const char *ssid, const uint8_t bssid[6], uint8_t channel) {
+  return settings_apply(SET_WIFI_LAST, [&](Settings &c) {
+    settings_copyStr(c.wifiLastSsid, sizeof(c.wifiLastSsid), ssid);
+    memcpy(c.wifiLastBssid, bssid, 6);
+    c.wifiLastChannel = channel;
+  });
+}
+
+bool settings_setCoords(double lat, double lon) {
+  return settings_apply(SET_COORDS, [&](Settings &c) {
+    c.hasCoords = true;
+    c.lat = lat;
+    c.lon = lon;
+  });
+}
+
+bool settings_setUpload(bool autoOn, uint16_t intervalMin) {
+  if (intervalMin == 0) return false;
+  return settings_apply(SET_UPLOAD, [&](Settings &c) {
+    c.tsAuto = autoOn;
+    c.tsIntervalMin = intervalMin;
+  });
+}
+
+bool settings_setNetPref(uint8_t pref) {
+  if (pref > 2) return false;
+  return settings_apply(SET_NET, [&](Settings &c) { c.netPref = pref; });
+}
+
+bool settings_setTsKey(const char *key) {
+  return settings_apply(SET_TS_KEY, [&](Settings &c) { settings_copyStr(c.tsKey, sizeof(c.tsKey), key); });
+}
+
+bool settings_setCalibration(float factor, int32_t offset, int32_t knownGrams) {
+  return settings_apply(SET_CALIB, [&](Settings &c) {
+    c.calFactor = factor;
+    c.calOffset = offset;
+    c.calKnownGrams = knownGrams;
+  });
+}
+
+bool settings_setSmsPin(const char *pin) {
+  return settings_apply(SET_SMS, [&](Settings &c) { settings_copyStr(c.smsPin, sizeof(c.smsPin), pin); });
+}
+
+bool settings_setSmsAllow(uint8_t slot, const char *number) {
+  if (slot >= SETTINGS_SMS_ALLOW) return false;
+  return settings_apply(SET_SMS, [&](Settings &c) {
+    settings_copyStr(c.smsAllow[slot], sizeof(c.smsAllow[slot]), number);
+  });
+}
+
+void settings_print(Print &out) {
+  Settings c;
+  settings_copy(c);
+  for (uint8_t i = 0; i < SETTINGS_WIFI_SLOTS; ++i) {
+    out.printf("[CFG] wifi%u: %s%s\n", i, c.wifi[i].ssid[0] ? c.wifi[i].ssid : "(empty)",
+               c.wifi[i].pass[0] ? " (password set)" : "");
+  }
+  if (c.wifiLastChannel) out.printf("[CFG] last AP: %s ch %u\n", c.wifiLastSsid, c.wifiLastChannel);
+  out.printf("[CFG] coords: %.4f %.4f%s\n", c.hasCoords ? c.lat : DEFAULT_LAT, c.hasCoords ? c.lon : DEFAULT_LON,
+             c.hasCoords ? "" : " (default)");
+  out.printf("[CFG] upload: auto %s every %u min, network %s\n", c.tsAuto ? "on" : "off", c.tsIntervalMin,
+             c.netPref == 1 ? "WiFi" : c.netPref == 2 ? "LTE" : "auto");
+  out.printf("[CFG] ThingSpeak key: %s\n", c.tsKey[0] ? "stored" : "config.h default");
+  out.printf("[CFG] calibration: factor %.4f offset %ld known %ld g\n", c.calFactor, (long)c.calOffset,
+             (long)c.calKnownGrams);
+  uint8_t allowed = 0;
+  for (uint8_t i = 0; i < SETTINGS_SMS_ALLOW; ++i) allowed += c.smsAllow[i][0] ? 1 : 0;
+  out.printf("[CFG] SMS commands: PIN %s, %u allowed sender(s)\n", c.smsPin[0] ? "set" : "off", allowed);
+  out.printf("[CFG] blob %u bytes, schema %u (loaded from %u in %lu us), NVS writes %lu, failed %lu\n",
+             (unsigned)(sizeof(SettingsHeader) + sizeof(Settings)), SETTINGS_SCHEMA, s_loadedSchema, s_loadUs,
+             (unsigned long)s_writes, (unsigned long)s_writeErrors);
+}
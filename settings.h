@@ -0,0 +1,96 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// User settings, loaded from NVS once in setup() into one RAM struct.
+// Readers use settings() and never open Preferences themselves; the
+// setters write through to NVS (only when a value actually changes) and
+// then call the registered change listeners with the group bits changed.
+//
+// Settings is stored as one CRC-checked, versioned blob, so boot is a
+// single NVS read and related fields (e.g. the three calibration values)
+// are saved atomically. Older layouts - the scattered "beehive",
+// "beehive_app", "wifi_cfg", "calib_ns" keys and the first key-per-field
+// "settings" store - are converted once and deleted (settings.cpp).
+// Per-satellite keys stay in gateway.cpp's own table.
+
+#define SETTINGS_NS         "settings"
+#define SETTINGS_WIFI_SLOTS 3        // 0, 1: provisioning form, 2: key server /set_wifi
+#define SETTINGS_SMS_ALLOW  4        // senders whose SMS commands need no PIN
+
+#ifndef SETTINGS_MAX_LISTENERS
+#define SETTINGS_MAX_LISTENERS 6
+#endif
+
+enum SettingsGroup : uint16_t {
+  SET_WIFI      = 1 << 0,   // wifi[] credentials
+  SET_WIFI_LAST = 1 << 1,   // last joined AP (wifi_manager fast path)
+  SET_COORDS    = 1 << 2,
+  SET_UPLOAD    = 1 << 3,   // tsAuto / tsIntervalMin
+  SET_NET       = 1 << 4,   // netPref
+  SET_TS_KEY    = 1 << 5,
+  SET_CALIB     = 1 << 6,
+  SET_SMS       = 1 << 7,   // smsPin / smsAllow
+  SET_ALL       = 0xFF
+};
+
+struct WifiCredential {
+  char ssid[33];
+  char pass[65];
+} __attribute__((packed));
+
+// On-flash layout: append new fields at the end, anything else needs a
+// schema step in settings.cpp.
+struct Settings {
+  WifiCredential wifi[SETTINGS_WIFI_SLOTS];
+
+  char    wifiLastSsid[33];
+  uint8_t wifiLastBssid[6];
+  uint8_t wifiLastChannel;       // 0 = nothing stored
+
+  bool    hasCoords;             // else DEFAULT_LAT / DEFAULT_LON
+  double  lat;
+  double  lon;
+
+  bool     tsAuto;
+  uint16_t tsIntervalMin;
+  uint8_t  netPref;              // 0 auto, 1 force WiFi, 2 force LTE
+
+  char    tsKey[33];             // empty = THINGSPEAK_WRITE_APIKEY
+
+  float   calFactor;             // counts per gram, 0 = not calibrated
+  int32_t calOffset;
+  int32_t calKnownGrams;
+
+  char    smsPin[9];             // empty = no PIN access
+  char    smsAllow[SETTINGS_SMS_ALLOW][17];
+} __attribute__((packed));
+
+void settings_init();            // first thing in setup()
+
+// The RAM copy. Fine on the loop task; other tasks use settings_copy().
+const Settings &settings();
+void settings_copy(Settings &out);
+
+// Called after a change, on the task that made it. Listeners that touch
+// state owned by another task should only set a flag.
+typedef void (*SettingsListener)(uint16_t changed);
+bool settings_onChange(SettingsListener cb);
+
+// Setters update RAM first; false means the NVS write failed and the value
+// only lasts until the next reboot.
+bool settings_setWifi(uint8_t slot, const char *ssid, const char *pass);
+bool settings_setWifiLast(const char *ssid, const uint8_t bssid[6], uint8_t channel);
+bool settings_setCoords(double lat, double lon);
+bool settings_setUpload(bool autoOn, uint16_t intervalMin);
+bool settings_setNetPref(uint8_t pref);
+bool settings_setTsKey(const char *key);
+bool settings_setCalibration(float factor, int32_t offset, int32_t knownGrams);
+bool settings_setSmsPin(const char *pin);
+bool settings_setSmsAllow(uint8_t slot, const char *number);   // "" clears the slot
+
+void settings_print(Print &out);  // serial 'settings' (passwords masked)
+
+#endif // SETTINGS_H
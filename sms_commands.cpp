@@ -0,0 +1,275 @@
+// sms_commands.cpp - table-driven SMS command set with PIN / allowlist auth.
+
+#include "sms_commands.h"
+#include "settings.h"
+#include "calibration.h"
+#include "weather_manager.h"
+#include "wifi_manager.h"
+#include "modem_manager.h"
+#include "upload_scheduler.h"
+#include "telemetry_sink.h"
+#include "telemetry_sample.h"
+#include "ts_queue.h"
+#include "config.h"
+#include <WiFi.h>
+#include <stdarg.h>
+
+struct SmsReply {
+  char  *buf;
+  size_t cap;
+  size_t len;
+};
+
+typedef void (*SmsHandler)(char *args, SmsReply &r);
+
+struct SmsCommand {
+  const char *name;
+  bool        secret;        // arguments kept out of the serial log
+  SmsHandler  run;
+};
+
+static bool          s_pendingSend = false;
+static bool          s_pendingReboot = false;
+static uint8_t       s_pinFails = 0;
+static unsigned long s_pinLockedAt = 0;
+
+// Append one answer; answers of one message are separated by "; "
+static void smscmd_reply(SmsReply &r, const char *fmt, ...) {
+  if (r.len + 3 >= r.cap) return;
+  if (r.len) {
+    r.buf[r.len++] = ';';
+    r.buf[r.len++] = ' ';
+  }
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(r.buf + r.len, r.cap - r.len, fmt, ap);
+  va_end(ap);
+  if (n > 0) r.len += (size_t)n < r.cap - r.len ? (size_t)n : r.cap - r.len - 1;
+}
+
+// ---------------------------------------------------------
+// Commands
+// ---------------------------------------------------------
+static void cmd_status(char *, SmsReply &r) {
+  const Settings &c = settings();
+  uint32_t backlog = 0;
+  for (uint8_t k = 0; k < SINK_COUNT; ++k) backlog += tsq_pending(k);
+  char link[16];
+  if (wifi_isConnected()) snprintf(link, sizeof(link), "WiFi %d", (int)WiFi.RSSI());
+  else if (modem_isReady()) snprintf(link, sizeof(link), "LTE csq %d", sched_csq());
+  else snprintf(link, sizeof(link), "offline");
+  unsigned long up = millis() / 60000UL;
+  smscmd_reply(r, "W %.2fkg T %.1f/%.1fC H %.0f%% B %.2fV %d%% %s Q %lu int %u net %s up %lud%02luh",
+               test_weight, test_temp_int, test_temp_ext, test_hum_int, test_batt_voltage, test_batt_percent,
+               link, (unsigned long)backlog, c.tsIntervalMin,
+               c.netPref == 1 ? "wifi" : c.netPref == 2 ? "lte" : "auto", up / 1440, (up / 60) % 24);
+}
+
+static void cmd_interval(char *args, SmsReply &r) {
+  unsigned long v = strtoul(args, nullptr, 10);
+  if (v < 1 || v > 1440) {
+    smscmd_reply(r, "ERR INT 1-1440");
+    return;
+  }
+  bool ok = settings_setUpload(true, (uint16_t)v);
+  smscmd_reply(r, ok ? "INT %lu min" : "INT %lu min (not saved)", v);
+}
+
+static void cmd_net(char *args, SmsReply &r) {
+  static const char *const names[] = { "AUTO", "WIFI", "LTE" };
+  for (uint8_t i = 0; i < 3; ++i) {
+    if (strcasecmp(args, names[i]) == 0) {
+      bool ok = settings_setNetPref(i);
+      smscmd_reply(r, ok ? "NET %s" : "NET %s (not saved)", names[i]);
+      return;
+    }
+  }
+  smscmd_reply(r, "ERR NET AUTO|WIFI|LTE");
+}
+
+static void cmd_send(char *, SmsReply &r) {
+  s_pendingSend = true;
+  smscmd_reply(r, "SEND queued");
+}
+
+static void cmd_tare(char *, SmsReply &r) {
+  long offset = calib_doTare();
+  bool ok = calib_saveFactor(calib_getSavedFactor(), offset, calib_getSavedKnown());
+  smscmd_reply(r, ok ? "TARE offset %ld" : "TARE offset %ld (not saved)", offset);
+}
+
+static void cmd_reboot(char *, SmsReply &r) {
+  s_pendingReboot = true;
+  smscmd_reply(r, "REBOOT");
+}
+
+static void cmd_pin(char *args, SmsReply &r) {
+  size_t n = strlen(args);
+  bool digits = n >= 4 && n < sizeof(settings().smsPin);
+  for (size_t i = 0; digits && i < n; ++i) digits = isdigit((unsigned char)args[i]);
+  if (!digits) {
+    smscmd_reply(r, "ERR PIN 4-8 digits");
+    return;
+  }
+  smscmd_reply(r, settings_setSmsPin(args) ? "PIN changed" : "PIN not saved");
+}
+
+static void cmd_geo(char *args, SmsReply &r) {
+  char *country = strchr(args, ',');
+  if (country) {
+    *country++ = '\0';
+    while (*country == ' ') country++;
+  }
+  char *end = args + strlen(args);
+  while (end > args && end[-1] == ' ') *--end = '\0';
+  if (!*args) {
+    smscmd_reply(r, "ERR GEO city,cc");
+    return;
+  }
+  if (weather_geocodeLocation(args, country && *country ? country : nullptr)) {
+    Serial.println(F("[SMS] Geocode stored from SMS"));
+    smscmd_reply(r, "GEO %.4f,%.4f", settings().lat, settings().lon);
+  } else {
+    Serial.print(F("[SMS] Geocode failed: "));
+    Serial.println(weather_getLastError());
+    smscmd_reply(r, "ERR GEO lookup failed");
+  }
+}
+
+static void cmd_help(char *, SmsReply &r);
+
+static const SmsCommand SMS_COMMANDS[] = {
+  { "STATUS", false, cmd_status },
+  { "INT",    false, cmd_interval },
+  { "NET",    false, cmd_net },
+  { "SEND",   false, cmd_send },
+  { "TARE",   false, cmd_tare },
+  { "REBOOT", false, cmd_reboot },
+  { "PIN",    true,  cmd_pin },
+  { "GEO",    false, cmd_geo },
+  { "HELP",   false, cmd_help },
+};
+#define SMS_COMMAND_COUNT (sizeof(SMS_COMMANDS) / sizeof(SMS_COMMANDS[0]))
+
+static void cmd_help(char *, SmsReply &r) {
+  char list[80];
+  size_t n = 0;
+  for (uint8_t i = 0; i < SMS_COMMAND_COUNT && n < sizeof(list); ++i) {
+    n += snprintf(list + n, sizeof(list) - n, "%s%s", i ? " " : "", SMS_COMMANDS[i].name);
+  }
+  smscmd_reply(r, "%s", list);
+}
+
+// ---------------------------------------------------------
+// Authentication
+// ---------------------------------------------------------
+
+// Numbers match when their last 9 digits agree (+30 69.. vs 0030 69.. vs 69..)
+static bool smscmd_sameNumber(const char *a, const char *b) {
+  char da[20], db[20];
+  uint8_t na = 0, nb = 0;
+  for (; *a && na < sizeof(da); ++a) if (isdigit((unsigned char)*a)) da[na++] = *a;
+  for (; *b && nb < sizeof(db); ++b) if (isdigit((unsigned char)*b)) db[nb++] = *b;
+  if (na < 9 || nb < 9) return na && na == nb && memcmp(da, db, na) == 0;
+  return memcmp(da + na - 9, db + nb - 9, 9) == 0;
+}
+
+static bool smscmd_allowlisted(const char *sender) {
+  const Settings &c = settings();
+  for (uint8_t i = 0; i < SETTINGS_SMS_ALLOW; ++i) {
+    if (c.smsAllow[i][0] && smscmd_sameNumber(sender, c.smsAllow[i])) return true;
+  }
+  return false;
+}
+
+static bool smscmd_pinOk(const char *pin) {
+  const Settings &c = settings();
+  if (!c.smsPin[0]) return false;
+  if (s_pinFails >= SMS_PIN_MAX_FAILS) {
+    if (millis() - s_pinLockedAt < SMS_PIN_LOCK_MS) return false;
+    s_pinFails = 0;
+  }
+  if (strcmp(pin, c.smsPin) == 0) {
+    s_pinFails = 0;
+    return true;
+  }
+  if (++s_pinFails >= SMS_PIN_MAX_FAILS) {
+    s_pinLockedAt = millis();
+    Serial.println(F("[SMS] too many wrong PINs, PIN access locked"));
+  }
+  return false;
+}
+
+// ---------------------------------------------------------
+// Dispatcher
+// ---------------------------------------------------------
+static char *smscmd_trim(char *s) {
+  while (*s == ' ' || *s == '\t' || *s == '\r') s++;
+  char *end = s + strlen(s);
+  while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) *--end = '\0';
+  return s;
+}
+
+static const SmsCommand *smscmd_find(const char *word) {
+  for (uint8_t i = 0; i < SMS_COMMAND_COUNT; ++i) {
+    if (strcasecmp(word, SMS_COMMANDS[i].name) == 0) return &SMS_COMMANDS[i];
+  }
+  return nullptr;
+}
+
+size_t smscmd_run(const char *sender, char *body, char *reply, size_t cap) {
+  SmsReply r = { reply, cap, 0 };
+  if (cap) reply[0] = '\0';
+  bool authed = smscmd_allowlisted(sender);
+  bool first = true;
+  uint8_t denied = 0;
+
+  char *save = nullptr;
+  for (char *cmd = strtok_r(body, ";\n", &save); cmd; cmd = strtok_r(nullptr, ";\n", &save)) {
+    cmd = smscmd_trim(cmd);
+    if (first && cmd[0] == '#') {
+      // "#<pin>" authenticates the whole message
+      char *rest = cmd + 1;
+      while (*rest && *rest != ' ') rest++;
+      if (*rest) *rest++ = '\0';
+      authed = smscmd_pinOk(cmd + 1) || authed;
+      cmd = smscmd_trim(rest);
+    }
+    first = false;
+    if (!*cmd) continue;
+
+    // keyword ends at a space or ':' (legacy "GEO:city,cc")
+    char *args = cmd + strcspn(cmd, " :");
+    if (*args) *args++ = '\0';
+    args = smscmd_trim(args);
+
+    if (!authed) {
+      denied++;
+      continue;
+    }
+    const SmsCommand *c = smscmd_find(cmd);
+    Serial.printf("[SMS] %s %s from %s\n", cmd, c && c->secret ? "***" : args, sender);
+    if (c) c->run(args, r);
+    else smscmd_reply(r, "ERR %s?", cmd);
+  }
+  // No answer to strangers: a reply would cost us and confirm the number
+  if (denied) Serial.printf("[SMS] %u command(s) from %s refused (no PIN / not allowlisted)\n", denied, sender);
+  return r.len;
+}
+
+void smscmd_afterReply() {
+  if (s_pendingSend) {
+    s_pendingSend = false;
+#if NODE_ROLE != NODE_ROLE_SATELLITE
+    TelemetrySample sample;
+    sample_capture(sample);
+    bool ok = sinks_publish(sample);
+    Serial.printf("[SMS] upload: %s\n", ok ? "OK" : "queued for retry");
+#endif
+  }
+  if (s_pendingReboot) {
+    Serial.println(F("[SMS] rebooting on SMS request"));
+    delay(500);
+    ESP.restart();
+  }
+}
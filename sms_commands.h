@@ -0,0 +1,52 @@
+#ifndef SMS_COMMANDS_H
+#define SMS_COMMANDS_H
+
+#include <Arduino.h>
+
+// Remote configuration over SMS. One message carries one or more commands
+// separated by ';' or new lines; keywords are case-insensitive:
+//
+//   #<pin> INT 10; NET LTE; STATUS
+//
+//   STATUS              weight, temperatures, battery, link, backlog, uptime
+//   INT <minutes>       upload interval (also turns auto upload on)
+//   NET AUTO|WIFI|LTE   net_pref
+//   SEND                capture a sample and upload it now
+//   TARE                zero the scale and store the offset
+//   REBOOT              restart after the reply has gone out
+//   PIN <new>           change the PIN (4-8 digits)
+//   GEO <city>[,<cc>]   look up and store the coordinates
+//                       ("GEO:city,cc" still works)
+//   HELP                list the commands
+//
+// Every command needs a sender on the allowlist or the PIN as the first
+// word ("#1234"); both are kept in settings (SET_SMS) and set with the
+// serial 'sms pin' / 'sms allow' commands. With neither configured, SMS
+// control is off. Messages from anyone else run nothing and get no reply.
+// SMS_PIN_MAX_FAILS wrong PINs lock PIN access for SMS_PIN_LOCK_MS.
+//
+// The message is tokenised in place and the commands are looked up in one
+// table; all replies of a message are joined into one buffer and sent as
+// a single SMS when they fit.
+
+#ifndef SMS_REPLY_MAX
+#define SMS_REPLY_MAX 320               // two SMS; one is 160 GSM-7 characters
+#endif
+
+#ifndef SMS_PIN_MAX_FAILS
+#define SMS_PIN_MAX_FAILS 5
+#endif
+
+#ifndef SMS_PIN_LOCK_MS
+#define SMS_PIN_LOCK_MS (60UL * 60UL * 1000UL)
+#endif
+
+// Runs the commands in body (modified in place). Writes the reply into
+// reply[cap] and returns its length, 0 = nothing to answer.
+size_t smscmd_run(const char *sender, char *body, char *reply, size_t cap);
+
+// Actions that must wait until the reply is sent (SEND, REBOOT).
+// Called by sms_handler after each scan; loop task only.
+void smscmd_afterReply();
+
+#endif // SMS_COMMANDS_H
@@ -1,22 +1,35 @@
 // url=https://github.com/manolena/Beehive-Monitor/blob/15cdda164768016a65c047c0ffa437cc69fc5783/sms_handler.cpp
 #include "sms_handler.h"
+#include "sms_commands.h"
+#include "sms_parser.h"
 #include "modem_manager.h"
-#include "weather_manager.h"
 #include "text_strings.h"
 #include <TinyGsmClient.h>
 #include <Arduino.h>
 
 // This SMS handler uses AT commands sent through the TinyGsm modem instance.
 // It attempts to:
-// - set text mode (AT+CMGF=1)
-// - list unread messages (AT+CMGL="REC UNREAD")
-// - parse messages for commands (GEO:city,country)
-// - on success call weather_geocodeLocation()
+// - set text mode with header details (AT+CMGF=1, AT+CSDH=1)
+// - list the stored messages (AT+CMGL="ALL") and note their indexes
+// - read each one (AT+CMGR=index) and run its commands (sms_commands.h)
+// - answer with one batched reply per message (AT+CMGS)
 // - delete processed messages (AT+CMGD=index)
-// - attempt to send a basic SMS reply confirming the action (AT+CMGS)
+// Both answers go through sms_parser as they arrive; a message whose read
+// is cut off stays on the SIM for the next scan.
 
 static unsigned long s_lastCheck = 0;
 static const unsigned long SMS_CHECK_INTERVAL = 30UL * 1000UL; // check every 30s
+static bool s_inited = false;
+
+#define SMS_PART_MAX 160                // GSM-7 characters in one SMS
+#define SMS_SCAN_MAX 30                 // messages handled per scan
+#define SMS_IDLE_MS  3000               // answer is over when the modem stays quiet this long
+
+static char      s_reply[SMS_REPLY_MAX + 1];
+static int16_t   s_listed[SMS_SCAN_MAX];
+static uint8_t   s_listedCount = 0;
+static SmsRecord s_msg;
+static bool      s_haveMsg = false;
 
 void sms_init() {
   // Ensure modem is initialized externally (modemManager_init)
@@ -24,38 +37,49 @@ void sms_init() {
   Serial.println("[SMS] Setting text mode (AT+CMGF=1)...");
   modem.sendAT("+CMGF=1");
   modem.waitResponse(2000);
+  // Body length in the headers, so a body line reading "OK" is not the end
+  modem.sendAT("+CSDH=1");
+  modem.waitResponse(2000);
   s_lastCheck = millis();
+  s_inited = true;
 }
 
-// Helper: send AT and read stream for a short time, return aggregated response
-static String modemReadResponse(unsigned long timeout = 3000) {
-  TinyGsm &modem = modem_get();
-  Stream &s = modem.stream;
-  unsigned long t0 = millis();
-  String resp;
-  while (millis() - t0 < timeout) {
-    while (s.available()) {
-      char c = s.read();
-      resp += c;
+// Feed the modem's answer to the parser until OK/ERROR or a quiet gap
+static SmspResult sms_readAnswer() {
+  Stream &s = modem_get().stream;
+  char chunk[64];
+  unsigned long last = millis();
+  while (smsp_result() == SMSP_PENDING && millis() - last < SMS_IDLE_MS) {
+    size_t n = 0;
+    while (n < sizeof(chunk) && s.available()) chunk[n++] = (char)s.read();
+    if (!n) {
+      delay(10);
+      continue;
     }
-    delay(10);
+    last = millis();
+    for (size_t at = 0; at < n; ) at += smsp_feed(chunk + at, n - at);
   }
-  return resp;
+  smsp_end();
+  return smsp_result();
 }
 
-// Helper: send AT and get response quickly
-static String atSendAndRead(const char *cmd, unsigned long timeout = 3000) {
-  TinyGsm &modem = modem_get();
-  modem.sendAT(cmd);
-  return modemReadResponse(timeout);
+static void sms_onListed(const SmsRecord &rec, void *) {
+  if (rec.index >= 0 && s_listedCount < SMS_SCAN_MAX) s_listed[s_listedCount++] = rec.index;
+}
+
+// +CMGR is the only record of its answer: it stays in the parser buffer
+static void sms_onRead(const SmsRecord &rec, void *) {
+  s_msg = rec;
+  s_haveMsg = true;
 }
 
 // Attempt to send a text SMS (best-effort). number must be in international format.
-static bool sms_send(const String &number, const String &message) {
+static bool sms_send(const char *number, const char *text, size_t len) {
   TinyGsm &modem = modem_get();
   // Set text mode first (already done), then send AT+CMGS="num"
-  String at = String("+CMGS=\"") + number + "\"";
-  modem.sendAT(at.c_str());
+  char at[40];
+  snprintf(at, sizeof(at), "+CMGS=\"%s\"", number);
+  modem.sendAT(at);
   // wait for '>' prompt
   unsigned long t0 = millis();
   bool prompt = false;
@@ -72,119 +96,94 @@ static bool sms_send(const String &number, const String &message) {
     return false;
   }
   // send message then Ctrl+Z
-  modem.stream.print(message);
+  modem.stream.write((const uint8_t *)text, len);
   modem.stream.write(26); // Ctrl+Z
-  // read response
-  String r = modemReadResponse(5000);
-  Serial.print("[SMS] send response: "); Serial.println(r);
-  if (r.indexOf("OK") >= 0) return true;
-  return false;
+  // +CMGS: <mr> then OK once the network took it
+  bool ok = modem.waitResponse(60000) == 1;
+  Serial.printf("[SMS] reply to %s: %s\n", number, ok ? "sent" : "FAILED");
+  return ok;
 }
 
-// Parse and handle messages returned by AT+CMGL (same logic as before)
-static void processSmsListResponse(const String &resp) {
-  int idx = 0;
-  while (true) {
-    int pos = resp.indexOf("\n+CMGL:", idx);
-    if (pos < 0) {
-      if (idx == 0) pos = resp.indexOf("+CMGL:");
-      if (pos < 0) break;
-    }
-    int eol = resp.indexOf('\n', pos+1);
-    if (eol < 0) break;
-    String header = resp.substring(pos, eol);
-    int cidx = -1;
-    {
-      int p1 = header.indexOf(':');
-      int p2 = header.indexOf(',');
-      if (p1 >= 0 && p2 > p1) {
-        String sidx = header.substring(p1+1, p2);
-        sidx.trim();
-        cidx = sidx.toInt();
+// One SMS when the reply fits, else split between answers ("; ")
+static void sms_sendReply(const char *number, const char *text, size_t len) {
+  while (len) {
+    size_t n = len;
+    if (n > SMS_PART_MAX) {
+      n = SMS_PART_MAX;
+      for (size_t i = SMS_PART_MAX; i > SMS_PART_MAX / 2; --i) {
+        if (text[i - 1] == ';') { n = i; break; }
       }
     }
-    int bodyStart = eol + 1;
-    int nextHeader = resp.indexOf("\n+CMGL:", bodyStart);
-    if (nextHeader < 0) nextHeader = resp.length();
-    String body = resp.substring(bodyStart, nextHeader);
-    body.trim();
-    if (body.length() == 0) {
-      idx = nextHeader;
-      continue;
-    }
-    Serial.print("[SMS] Msg idx="); Serial.print(cidx); Serial.print(" body='"); Serial.print(body); Serial.println("'");
-    String u = body;
-    u.toUpperCase();
-    bool handled = false;
-
-    // Support GEO:city,country messages only; ignore API key commands
-    if (u.startsWith("GEO:")) {
-      int colon = body.indexOf(':');
-      String payload = (colon>=0) ? body.substring(colon+1) : "";
-      payload.trim();
-      int comma = payload.indexOf(',');
-      String city = payload;
-      String country = "";
-      if (comma >= 0) {
-        city = payload.substring(0, comma);
-        country = payload.substring(comma+1);
-      }
-      city.trim();
-      country.trim();
-      if (city.length() > 0) {
-        if (weather_geocodeLocation(city.c_str(), country.length() ? country.c_str() : nullptr)) {
-          Serial.println("[SMS] Geocode stored from SMS");
-          int q1 = header.indexOf('"', header.indexOf(',')+1);
-          int q2 = -1;
-          if (q1 >= 0) q2 = header.indexOf('"', q1+1);
-          String from = "";
-          if (q1 >= 0 && q2 > q1) from = header.substring(q1+1, q2);
-          if (from.length()) sms_send(from, "OK: Geocode stored");
-          handled = true;
-        } else {
-          Serial.print("[SMS] Geocode failed: ");
-          Serial.println(weather_getLastError());
-        }
-      }
-    } else {
-      Serial.println("[SMS] Unknown or unsupported command in SMS");
-    }
+    if (!sms_send(number, text, n)) return;
+    text += n;
+    len -= n;
+    while (len && (*text == ' ' || *text == ';')) { text++; len--; }
+  }
+}
 
-    if (cidx >= 0) {
-      char cmd[32];
-      snprintf(cmd, sizeof(cmd), "+CMGD=%d", cidx);
-      TinyGsm &modem = modem_get();
-      modem.sendAT(cmd);
-      modem.waitResponse(2000);
-    }
+// Read, run, answer and delete the message at one SIM index
+static void sms_process(int16_t index) {
+  TinyGsm &modem = modem_get();
+  char cmd[32];
+  snprintf(cmd, sizeof(cmd), "+CMGR=%d", index);
+  s_haveMsg = false;
+  smsp_begin(sms_onRead, nullptr);
+  modem.sendAT(cmd);
+  if (sms_readAnswer() != SMSP_OK || !s_haveMsg) {
+    Serial.printf("[SMS] Msg idx=%d unreadable, kept for the next scan\n", index);
+    return;
+  }
+  // not the body: it carries the #<pin> prefix and PIN arguments;
+  // smscmd_run() logs each command with its secrets masked
+  Serial.printf("[SMS] Msg idx=%d from %s, %u bytes\n", index, s_msg.sender, (unsigned)strlen(s_msg.body));
+
+  // the body is run in place in the parser buffer
+  size_t replyLen = smscmd_run(s_msg.sender, s_msg.body, s_reply, sizeof(s_reply));
+  if (replyLen && s_msg.sender[0]) sms_sendReply(s_msg.sender, s_reply, replyLen);
 
-    idx = nextHeader;
-  } // while
+  snprintf(cmd, sizeof(cmd), "+CMGD=%d", index);
+  modem.sendAT(cmd);
+  modem.waitResponse(2000);
 }
 
 /*
  * New: sms_scan_now()
- * Performs an immediate scan for unread messages, processes them and deletes them.
+ * Performs an immediate scan for stored messages, processes them and deletes them.
  * Safe to call from serial command handler or from code.
  */
 void sms_scan_now() {
+  if (!modem_isReady()) {
+    Serial.println("[SMS] Modem not ready - scan skipped");
+    return;
+  }
   TinyGsm &modem = modem_get();
-  Serial.println("[SMS] Manual scan: Checking unread messages...");
+  Serial.println("[SMS] Manual scan: Checking stored messages...");
   modem.sendAT("+CMGF=1");
   modem.waitResponse(1000);
 
-  modem.sendAT("+CMGL=\"REC UNREAD\"");
-  String resp = modemReadResponse(3000);
-  Serial.print("[SMS] CMGL response: "); Serial.println(resp);
+  // "ALL": a message whose read was cut off last time is already marked read
+  s_listedCount = 0;
+  smsp_begin(sms_onListed, nullptr);
+  modem.sendAT("+CMGL=\"ALL\"");
+  SmspResult listed = sms_readAnswer();
+  if (listed != SMSP_OK || smsp_dropped()) {
+    Serial.printf("[SMS] CMGL %s, %u message(s) dropped\n", listed == SMSP_OK ? "OK" : "incomplete", smsp_dropped());
+  }
 
-  if (resp.indexOf("+CMGL:") >= 0) {
-    processSmsListResponse(resp);
-  } else {
-    Serial.println("[SMS] No unread messages (manual scan)");
+  if (!s_listedCount) {
+    Serial.println("[SMS] No messages (manual scan)");
+    return;
   }
+  for (uint8_t i = 0; i < s_listedCount; ++i) sms_process(s_listed[i]);
+  smscmd_afterReply();
 }
 
 void sms_loop() {
+  // Text mode is set lazily once the background modem bring-up completes.
+  if (!s_inited) {
+    if (!modem_isReady()) return;
+    sms_init();
+  }
   if (millis() - s_lastCheck < SMS_CHECK_INTERVAL) return;
   s_lastCheck = millis();
 
@@ -3,7 +3,8 @@
 
 #include <Arduino.h>
 
-// Initialize SMS handler (call during setup after modemManager_init).
+// Initialize SMS handler. Called lazily from sms_loop() once modem_isReady();
+// may also be called explicitly after a blocking modemManager_init().
 void sms_init();
 
 // Call periodically from loop() to check for unread messages and process them.
@@ -0,0 +1,180 @@
+// sms_parser.cpp - in-place +CMGL / +CMGR tokenizer over a fixed buffer.
+
+#include "sms_parser.h"
+
+#define SMSP_MAX_FIELDS 12
+
+enum SmspState {
+  SMSP_IDLE = 0,           // between messages: headers, result codes, echo
+  SMSP_BODY,               // header parsed, collecting body lines
+  SMSP_SKIP                // dropping the rest of a message that did not fit
+};
+
+static char        s_buf[SMS_RX_BYTES + 1];
+static uint16_t    s_len = 0;          // bytes in s_buf
+static uint16_t    s_line = 0;         // start of the first unprocessed line
+static uint16_t    s_keep = 0;         // bytes before this are consumed
+static SmspState   s_state = SMSP_IDLE;
+static SmspResult  s_result = SMSP_PENDING;
+static uint16_t    s_dropped = 0;
+static SmsRecordCb s_cb = nullptr;
+static void       *s_ctx = nullptr;
+
+// Current message, as offsets so that sliding the buffer keeps them valid
+static int16_t  s_index = -1;
+static uint16_t s_stat, s_sender, s_time;
+static uint16_t s_bodyStart = 0;
+static uint16_t s_bodyMin = 0;          // length from the header (AT+CSDH=1)
+static char     s_empty[1] = "";
+
+void smsp_begin(SmsRecordCb cb, void *ctx) {
+  s_cb = cb;
+  s_ctx = ctx;
+  s_len = s_line = s_keep = 0;
+  s_state = SMSP_IDLE;
+  s_result = SMSP_PENDING;
+  s_dropped = 0;
+}
+
+static SmspResult smsp_final(const char *l, size_t n) {
+  if (n == 2 && memcmp(l, "OK", 2) == 0) return SMSP_OK;
+  if (n == 5 && memcmp(l, "ERROR", 5) == 0) return SMSP_ERROR;
+  if (n >= 10 && (memcmp(l, "+CMS ERROR", 10) == 0 || memcmp(l, "+CME ERROR", 10) == 0)) return SMSP_ERROR;
+  return SMSP_PENDING;
+}
+
+static bool smsp_isHeader(const char *l, size_t n) {
+  return n >= 6 && (memcmp(l, "+CMGL:", 6) == 0 || memcmp(l, "+CMGR:", 6) == 0);
+}
+
+// Split the header line in place; quoted fields may hold commas
+static void smsp_header(uint16_t off, size_t n) {
+  bool list = s_buf[off + 4] == 'L';
+  s_buf[off + n] = '\0';
+  uint16_t field[SMSP_MAX_FIELDS];
+  uint8_t count = 0;
+  uint16_t p = off + 6;
+  while (s_buf[p] == ' ') p++;
+  while (count < SMSP_MAX_FIELDS) {
+    bool quoted = s_buf[p] == '"';
+    if (quoted) p++;
+    field[count++] = p;
+    while (s_buf[p] && (quoted ? s_buf[p] != '"' : s_buf[p] != ',')) p++;
+    if (quoted && s_buf[p] == '"') s_buf[p++] = '\0';
+    while (s_buf[p] && s_buf[p] != ',') p++;   // anything after a closing quote
+    if (!s_buf[p]) break;
+    s_buf[p++] = '\0';
+  }
+  // +CMGL: <index>,<stat>,<oa>,[<alpha>],[<scts>][,<tooa>,<length>]
+  // +CMGR: <stat>,<oa>,[<alpha>],<scts>[,<tooa>,<fo>,<pid>,<dcs>,<sca>,<tosca>,<length>]
+  uint8_t base = list ? 1 : 0;
+  s_index = list ? (int16_t)atoi(s_buf + field[0]) : -1;
+  s_stat = base < count ? field[base] : off + n;
+  s_sender = base + 1 < count ? field[base + 1] : off + n;
+  s_time = base + 3 < count ? field[base + 3] : off + n;
+  s_bodyMin = count == (list ? 7 : 11) ? (uint16_t)atoi(s_buf + field[count - 1]) : 0;
+}
+
+// Body is [s_bodyStart, end) minus its line break
+static void smsp_emit(uint16_t end) {
+  SmsRecord rec;
+  uint16_t bodyEnd = end;
+  while (bodyEnd > s_bodyStart && (s_buf[bodyEnd - 1] == '\r' || s_buf[bodyEnd - 1] == '\n')) bodyEnd--;
+  if (end > s_bodyStart) {
+    s_buf[bodyEnd] = '\0';             // on a line break, never on the next line
+    rec.body = s_buf + s_bodyStart;
+  } else {
+    rec.body = s_empty;                // header straight followed by OK
+  }
+  rec.index = s_index;
+  rec.stat = s_buf + s_stat;
+  rec.sender = s_buf + s_sender;
+  rec.time = s_buf + s_time;
+  rec.bodyLen = bodyEnd - s_bodyStart;
+  s_keep = end;
+  if (s_cb) s_cb(rec, s_ctx);
+}
+
+static void smsp_lineDone(uint16_t off, size_t n, uint16_t next) {
+  const char *l = s_buf + off;
+  bool header = smsp_isHeader(l, n);
+  SmspResult fin = smsp_final(l, n);
+
+  if (s_state == SMSP_BODY) {
+    // a line that merely looks like OK inside a body of known length stays body
+    if ((!header && fin == SMSP_PENDING) || off - s_bodyStart < s_bodyMin) return;
+    smsp_emit(off);
+  } else if (s_state == SMSP_SKIP && !header && fin == SMSP_PENDING) {
+    s_keep = next;
+    return;
+  }
+
+  s_state = SMSP_IDLE;
+  if (header) {
+    smsp_header(off, n);
+    s_bodyStart = next;
+    s_keep = off;
+    s_state = SMSP_BODY;
+    return;
+  }
+  if (fin != SMSP_PENDING) s_result = fin;
+  s_keep = next;                        // result code, echo, blank line, URC
+}
+
+static void smsp_lines() {
+  for (;;) {
+    char *start = s_buf + s_line;
+    char *nl = (char *)memchr(start, '\n', s_len - s_line);
+    if (!nl) return;
+    size_t n = nl - start;
+    if (n && start[n - 1] == '\r') n--;
+    uint16_t next = (uint16_t)(nl - s_buf + 1);
+    smsp_lineDone(s_line, n, next);
+    s_line = next;
+  }
+}
+
+// Drop consumed bytes; offsets of the open message move with the tail
+static void smsp_slide() {
+  uint16_t d = s_keep;
+  memmove(s_buf, s_buf + d, s_len - d);
+  s_len -= d;
+  s_line -= d;
+  s_keep = 0;
+  if (s_state == SMSP_BODY) {
+    s_stat -= d;
+    s_sender -= d;
+    s_time -= d;
+    s_bodyStart -= d;
+  }
+}
+
+size_t smsp_feed(const char *data, size_t len) {
+  if (s_keep) smsp_slide();
+  if (s_len == SMS_RX_BYTES) {
+    // one message (or junk line) fills the whole buffer: drop it
+    if (s_state == SMSP_BODY) s_dropped++;
+    s_state = SMSP_SKIP;
+    s_len = s_line = 0;
+  }
+  size_t k = SMS_RX_BYTES - s_len;
+  if (k > len) k = len;
+  memcpy(s_buf + s_len, data, k);
+  s_len += k;
+  s_buf[s_len] = '\0';
+  smsp_lines();
+  return k;
+}
+
+void smsp_end() {
+  if (s_state == SMSP_BODY && s_result == SMSP_PENDING) s_dropped++;   // answer cut off
+  s_state = SMSP_IDLE;
+}
+
+SmspResult smsp_result() {
+  return s_result;
+}
+
+uint16_t smsp_dropped() {
+  return s_dropped;
+}
@@ -0,0 +1,49 @@
+#ifndef SMS_PARSER_H
+#define SMS_PARSER_H
+
+#include <Arduino.h>
+
+// Streaming parser for text-mode +CMGL / +CMGR answers.
+//
+// Modem output is fed in whatever pieces the UART delivers into one fixed
+// receive buffer and tokenised there: header fields are split in place
+// (commas inside quotes are kept, the quotes dropped) and every complete
+// message is handed to the callback as pointers into the buffer - no
+// String, no copy. Consumed bytes are dropped by sliding the unfinished
+// tail to the front at the start of the next smsp_feed().
+//
+// A message ends at the next +CMGL/+CMGR header or the final result code.
+// With AT+CSDH=1 the header carries the body length, so a body line that
+// reads "OK" is not mistaken for the end. A message that does not fit the
+// buffer, or whose answer stops before OK/ERROR (smsp_end() after a
+// timeout), is dropped and counted, never delivered half.
+
+#ifndef SMS_RX_BYTES
+#define SMS_RX_BYTES 1024               // one header + the longest body we accept
+#endif
+
+struct SmsRecord {
+  int16_t  index;          // +CMGL index, -1 for +CMGR (the caller asked for it)
+  const char *stat;        // "REC UNREAD", "REC READ", ...
+  const char *sender;
+  const char *time;        // service centre timestamp, "" if absent
+  char    *body;           // NUL-terminated, may be tokenised in place
+  uint16_t bodyLen;
+};
+
+// Pointers stay valid until the next smsp_feed() / smsp_begin()
+typedef void (*SmsRecordCb)(const SmsRecord &rec, void *ctx);
+
+enum SmspResult {
+  SMSP_PENDING = 0,        // no final result code yet
+  SMSP_OK,
+  SMSP_ERROR               // ERROR, +CMS ERROR, +CME ERROR
+};
+
+void       smsp_begin(SmsRecordCb cb, void *ctx);
+size_t     smsp_feed(const char *data, size_t len);   // bytes taken; call again with the rest
+void       smsp_end();                                // input stopped (timeout)
+SmspResult smsp_result();
+uint16_t   smsp_dropped();                            // messages lost since smsp_begin()
+
+#endif // SMS_PARSER_H
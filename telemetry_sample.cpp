@@ -0,0 +1,45 @@
+#include "telemetry_sample.h"
+#include "config.h"
+#include "time_manager.h"
+#include <time.h>
+
+// channel -> multiplier from display unit to stored integer
+static const float s_scale[CH_COUNT] = {
+  1000.0f,  // weight kg -> g
+  100.0f,   // temp_int
+  10.0f,    // hum_int
+  100.0f,   // temp_ext
+  10.0f,    // hum_ext
+  10.0f,    // pressure
+  1000.0f   // battery V -> mV
+};
+
+static const char* const s_names[CH_COUNT] = {
+  "weight", "temp_int", "hum_int", "temp_ext", "hum_ext", "pressure", "batt"
+};
+
+static int32_t toFixed(float v, float scale) {
+  float f = v * scale;
+  return (int32_t)(f >= 0 ? f + 0.5f : f - 0.5f);
+}
+
+void sample_capture(TelemetrySample &out) {
+  out.ts = timeManager_isTimeValid() ? (uint32_t)time(nullptr) : 0;
+  out.v[CH_WEIGHT]   = toFixed(test_weight,       s_scale[CH_WEIGHT]);
+  out.v[CH_TEMP_INT] = toFixed(test_temp_int,     s_scale[CH_TEMP_INT]);
+  out.v[CH_HUM_INT]  = toFixed(test_hum_int,      s_scale[CH_HUM_INT]);
+  out.v[CH_TEMP_EXT] = toFixed(test_temp_ext,     s_scale[CH_TEMP_EXT]);
+  out.v[CH_HUM_EXT]  = toFixed(test_hum_ext,      s_scale[CH_HUM_EXT]);
+  out.v[CH_PRESSURE] = toFixed(test_pressure,     s_scale[CH_PRESSURE]);
+  out.v[CH_BATT]     = toFixed(test_batt_voltage, s_scale[CH_BATT]);
+}
+
+float sample_value(const TelemetrySample &s, SampleChannel ch) {
+  if (ch >= CH_COUNT) return 0.0f;
+  return (float)s.v[ch] / s_scale[ch];
+}
+
+const char* sample_channelName(SampleChannel ch) {
+  if (ch >= CH_COUNT) return "?";
+  return s_names[ch];
+}
@@ -0,0 +1,35 @@
+#ifndef TELEMETRY_SAMPLE_H
+#define TELEMETRY_SAMPLE_H
+
+#include <Arduino.h>
+
+// One measurement of the hive, in fixed-point integer units.
+// Used by the local time-series store (tsdb) so that records have a fixed
+// size and aggregates (min/max/mean) can be computed without float drift.
+
+enum SampleChannel {
+  CH_WEIGHT = 0,    // grams
+  CH_TEMP_INT,      // 0.01 degC
+  CH_HUM_INT,       // 0.1 %RH
+  CH_TEMP_EXT,      // 0.01 degC
+  CH_HUM_EXT,       // 0.1 %RH
+  CH_PRESSURE,      // 0.1 hPa
+  CH_BATT,          // mV
+  CH_COUNT
+};
+
+struct TelemetrySample {
+  uint32_t ts;            // UTC epoch seconds (0 = time unknown)
+  int32_t  v[CH_COUNT];
+} __attribute__((packed));
+
+// Fill from the sensor globals (test_*) and the current time
+void sample_capture(TelemetrySample &out);
+
+// Convert one channel back to its display unit (kg, degC, %, hPa, V)
+float sample_value(const TelemetrySample &s, SampleChannel ch);
+
+// Short JSON/CSV-friendly channel name ("weight", "temp_int", ...)
+const char* sample_channelName(SampleChannel ch);
+
+#endif // TELEMETRY_SAMPLE_H
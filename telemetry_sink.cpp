@@ -0,0 +1,144 @@
+// telemetry_sink.cpp - sink registry, per-sink pacing/backoff over ts_queue.
+
+#include "telemetry_sink.h"
+#include "ts_queue.h"
+#include "upload_scheduler.h"
+#include "config.h"
+#include <WiFi.h>
+
+#ifndef SINK_BATCH_MAX
+#define SINK_BATCH_MAX 16
+#endif
+
+static_assert(SINK_COUNT <= TSQ_MAX_SINKS, "queue cursor has no position for every sink");
+
+static const TelemetrySink *s_sinks[SINK_COUNT];
+static uint8_t       s_active = 0;
+static unsigned long s_nextMs[SINK_COUNT];
+static unsigned long s_lastSendMs[SINK_COUNT];
+static uint32_t      s_backoffMs[SINK_COUNT];
+static uint32_t      s_sent[SINK_COUNT];
+static uint32_t      s_failed[SINK_COUNT];
+
+void sinks_init() {
+  s_sinks[SINK_THINGSPEAK] = &thingspeak_sink();
+  s_sinks[SINK_MQTT] = &mqtt_sink();
+  s_sinks[SINK_HTTP] = &http_sink();
+
+  s_active = 0;
+  for (uint8_t k = 0; k < SINK_COUNT; ++k) {
+    s_backoffMs[k] = s_sinks[k]->retryMinMs;
+    s_nextMs[k] = millis();
+    if (s_sinks[k]->enabled()) s_active |= 1 << k;
+  }
+  // disabled sinks must not hold queued samples back
+  tsq_setActive(s_active);
+#if ENABLE_DEBUG
+  for (uint8_t k = 0; k < SINK_COUNT; ++k) {
+    Serial.printf("[SINK] %s %s\n", s_sinks[k]->name, (s_active & (1 << k)) ? "enabled" : "off");
+  }
+#endif
+}
+
+// One batch for one sink. Returns false when the sink failed.
+static bool sinks_service(uint8_t k) {
+  const TelemetrySink &sk = *s_sinks[k];
+  TelemetrySample batch[SINK_BATCH_MAX];
+  uint8_t max = sk.batchMax < SINK_BATCH_MAX ? sk.batchMax : SINK_BATCH_MAX;
+  uint8_t n = (uint8_t)tsq_peek(k, batch, max);
+  if (!n) return true;
+
+  unsigned long t0 = millis();
+  uint8_t ok = sk.send(batch, n);
+  sched_noteSend(millis() - t0, ok);
+  if (ok) tsq_ack(k, ok);
+  s_sent[k] += ok;
+  s_lastSendMs[k] = millis();
+
+  if (ok == n) {
+    s_backoffMs[k] = sk.retryMinMs;
+    s_nextMs[k] = s_lastSendMs[k] + sk.minIntervalMs;
+    return true;
+  }
+  s_failed[k]++;
+  s_nextMs[k] = s_lastSendMs[k] + s_backoffMs[k];
+  Serial.printf("[SINK] %s: %u/%u sent, retry in %lu s\n", sk.name, ok, n,
+                (unsigned long)(s_backoffMs[k] / 1000UL));
+  s_backoffMs[k] = min(s_backoffMs[k] * 2, sk.retryMaxMs);
+  return false;
+}
+
+void sinks_loop() {
+  // while the scheduler holds uploads back the sinks stay idle too, so an
+  // LTE-only MQTT session is not kept alive just to wait
+  if (!sched_uploadAllowed()) return;
+  for (uint8_t k = 0; k < SINK_COUNT; ++k) {
+    if (!(s_active & (1 << k))) continue;
+    const TelemetrySink &sk = *s_sinks[k];
+    if (sk.loop) sk.loop();
+    if ((long)(millis() - s_nextMs[k]) < 0) continue;
+    if (tsq_pending(k) == 0 || !sk.ready()) continue;
+    sinks_service(k);
+  }
+}
+
+bool sinks_publish(const TelemetrySample &s) {
+  if (tsq_push(s)) {
+    // a new sample ends any backoff wait, but not the service rate limit
+    for (uint8_t k = 0; k < SINK_COUNT; ++k) {
+      if (!(s_active & (1 << k))) continue;
+      s_backoffMs[k] = s_sinks[k]->retryMinMs;
+      s_nextMs[k] = s_lastSendMs[k] + s_sinks[k]->minIntervalMs;
+    }
+    sinks_loop();
+    return true;
+  }
+
+  Serial.println(F("[SINK] queue unavailable - sending directly"));
+  bool any = false;
+  for (uint8_t k = 0; k < SINK_COUNT; ++k) {
+    if (!(s_active & (1 << k)) || !s_sinks[k]->ready()) continue;
+    if (s_sinks[k]->send(&s, 1) == 1) {
+      s_sent[k]++;
+      any = true;
+    } else {
+      s_failed[k]++;
+    }
+    s_lastSendMs[k] = millis();
+  }
+  return any;
+}
+
+const char *sinks_deviceId() {
+  static char id[12] = "";
+  if (!id[0]) {
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    snprintf(id, sizeof(id), "bh-%02x%02x%02x", mac[3], mac[4], mac[5]);
+  }
+  return id;
+}
+
+bool sinks_stats(uint8_t sink, SinkStats &out) {
+  if (sink >= SINK_COUNT || !s_sinks[sink]) return false;
+  out.name = s_sinks[sink]->name;
+  out.active = s_active & (1 << sink);
+  out.sent = s_sent[sink];
+  out.failed = s_failed[sink];
+  return true;
+}
+
+void sinks_print(Print &out) {
+  unsigned long now = millis();
+  out.printf("[SINK] device %s\n", sinks_deviceId());
+  for (uint8_t k = 0; k < SINK_COUNT; ++k) {
+    if (!s_sinks[k]) continue;
+    const TelemetrySink &sk = *s_sinks[k];
+    bool active = s_active & (1 << k);
+    long wait = (long)(s_nextMs[k] - now);
+    out.printf("[SINK] %-10s %-3s %-8s pending %lu, sent %lu, failures %lu, next in %ld s\n", sk.name,
+               active ? "on" : "off", active && sk.ready() ? "link up" : "no link",
+               (unsigned long)tsq_pending(k), (unsigned long)s_sent[k], (unsigned long)s_failed[k],
+               wait > 0 ? wait / 1000L : 0L);
+  }
+}
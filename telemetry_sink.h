@@ -0,0 +1,61 @@
+#ifndef TELEMETRY_SINK_H
+#define TELEMETRY_SINK_H
+
+#include <Arduino.h>
+#include "telemetry_sample.h"
+
+// Upload destinations for samples. Every sample goes into the SD queue once
+// (ts_queue.h); each sink reads it from there with its own position, batch
+// size, pacing and retry backoff, so a broker that is down does not hold
+// back ThingSpeak and vice versa.
+//
+// The sink id is its read position in the queue cursor, so ids are part of
+// the on-disk format: append new sinks, never renumber.
+
+enum SinkId {
+  SINK_THINGSPEAK = 0,
+  SINK_MQTT,
+  SINK_HTTP,
+  SINK_COUNT
+};
+
+struct TelemetrySink {
+  const char *name;
+  bool    (*enabled)();          // configured at all (checked by sinks_init)
+  bool    (*ready)();            // a link is up right now
+  // Deliver batch[0..n). Returns how many leading samples were accepted.
+  uint8_t (*send)(const TelemetrySample *batch, uint8_t n);
+  void    (*loop)();             // keepalive etc., may be nullptr
+  uint8_t  batchMax;
+  uint32_t minIntervalMs;        // between sends (service rate limits)
+  uint32_t retryMinMs;           // backoff after a failed send, doubles up to retryMaxMs
+  uint32_t retryMaxMs;
+};
+
+// Provided by thingspeak_client.cpp, mqtt_sink.cpp, http_sink.cpp
+const TelemetrySink &thingspeak_sink();
+const TelemetrySink &mqtt_sink();
+const TelemetrySink &http_sink();
+
+void sinks_init();               // after tsq_init()
+void sinks_loop();               // idle while upload_scheduler defers uploads
+
+// Queue a fresh sample and give every sink a chance to send it now.
+// Without an SD card the sample is sent directly (best effort, no retry).
+// Returns true if the sample was queued or delivered somewhere.
+bool sinks_publish(const TelemetrySample &s);
+
+// "bh-" + the last three MAC bytes, used as MQTT client id / HTTP device id
+const char *sinks_deviceId();
+
+struct SinkStats {
+  const char *name;
+  bool     active;
+  uint32_t sent;                 // samples delivered since boot
+  uint32_t failed;               // failed send attempts since boot
+};
+bool sinks_stats(uint8_t sink, SinkStats &out);   // false: sink not built in
+
+void sinks_print(Print &out);    // serial 'sinks'
+
+#endif // TELEMETRY_SINK_H
@@ -0,0 +1,152 @@
+// Arduino.h - the part of the Arduino-ESP32 core the host tests need.
+// Time is virtual: millis() only moves when delay() is called.
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/types.h>
+#include <string>
+#include <algorithm>
+
+typedef uint8_t byte;
+
+class __FlashStringHelper;
+#define F(x) (reinterpret_cast<const __FlashStringHelper *>(x))
+#define PROGMEM
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+inline void yield() {}
+uint32_t esp_random();
+
+template <class T, class L, class H>
+T constrain(T v, L lo, H hi) { return v < lo ? lo : (v > hi ? hi : v); }
+using std::min;
+using std::max;
+
+// newlib has it; glibc only from 2.38
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+inline size_t strlcpy(char *dst, const char *src, size_t size) {
+  size_t n = strlen(src);
+  if (size) {
+    size_t k = n < size - 1 ? n : size - 1;
+    memcpy(dst, src, k);
+    dst[k] = '\0';
+  }
+  return n;
+}
+#endif
+
+class String {
+public:
+  String() {}
+  String(const char *s) : _s(s ? s : "") {}
+  String(const std::string &s) : _s(s) {}
+  const char *c_str() const { return _s.c_str(); }
+  unsigned length() const { return _s.size(); }
+  long toInt() const { return atol(_s.c_str()); }
+  float toFloat() const { return (float)atof(_s.c_str()); }
+  double toDouble() const { return atof(_s.c_str()); }
+  String &operator+=(char c) { _s += c; return *this; }
+  String &operator+=(const char *s) { _s += s; return *this; }
+  String &operator+=(const String &s) { _s += s._s; return *this; }
+  void reserve(unsigned n) { _s.reserve(n); }
+  bool operator==(const char *s) const { return _s == s; }
+private:
+  std::string _s;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *b, size_t n) {
+    for (size_t i = 0; i < n; ++i) write(b[i]);
+    return n;
+  }
+  size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t print(const char *s) { return write(s); }
+  size_t print(const __FlashStringHelper *s) { return write((const char *)s); }
+  size_t println() { return print("\n"); }
+  size_t println(const char *s) { return print(s) + print("\n"); }
+  size_t println(const __FlashStringHelper *s) { return print(s) + print("\n"); }
+  size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[512];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return n > 0 ? write((const uint8_t *)buf, strlen(buf)) : 0;
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  void setTimeout(unsigned long ms) { _timeout = ms; }
+  // Stops at the terminator or after _timeout ms without data, like Stream
+  String readStringUntil(char end) {
+    String s;
+    unsigned long t0 = millis();
+    while (millis() - t0 < _timeout) {
+      if (!available()) {
+        delay(1);
+        continue;
+      }
+      int c = read();
+      if (c == end) break;
+      s += (char)c;
+      t0 = millis();
+    }
+    return s;
+  }
+protected:
+  unsigned long _timeout = 1000;
+};
+
+// A TCP connection (WiFiClient, TinyGsmClient); tests script their own
+class Client : public Stream {
+public:
+  virtual int connect(const char *host, uint16_t port) = 0;
+  virtual size_t write(uint8_t c) override = 0;
+  virtual size_t write(const uint8_t *buf, size_t size) override = 0;
+  virtual int read(uint8_t *buf, size_t size) = 0;
+  virtual int read() override = 0;
+  virtual void flush() = 0;
+  virtual void stop() = 0;
+  virtual uint8_t connected() = 0;
+  virtual operator bool() = 0;
+};
+
+// Serial goes to stdout, so a failing test shows the module's own log
+class HardwareSerial : public Stream {
+public:
+  size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+// ESP.restart() returns here; tests count the calls
+class EspClass {
+public:
+  void restart() { hostRestarts++; }
+  int hostRestarts = 0;
+};
+
+extern EspClass ESP;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,42 @@
+// FS.h - File on the host file system, below the directory sdhost_begin() set.
+// Writes can be cut short to simulate a power loss (SD.h).
+
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+class File {
+public:
+  File() {}
+  File(const std::string &hostPath, const std::string &name, const char *mode);
+
+  size_t write(const uint8_t *buf, size_t len);
+  size_t write(uint8_t c) { return write(&c, 1); }
+  int read();
+  size_t read(uint8_t *buf, size_t len);
+  int available();
+  bool seek(uint32_t pos);
+  size_t position();
+  size_t size();
+  void flush() {}
+  void close();
+  const char *name() const { return _name.c_str(); }
+  bool isDirectory() const { return _dir; }
+  File openNextFile();
+  explicit operator bool() const { return _fp || _dir; }
+
+private:
+  std::shared_ptr<FILE> _fp;          // closed with the last copy, like the core's File
+  std::string _host, _name;
+  bool _dir = false;
+  size_t _dirAt = 0;
+};
+
+#endif // HOST_FS_H
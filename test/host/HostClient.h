@@ -0,0 +1,37 @@
+// HostClient.h - a Client that forwards to the peer a test installed for its
+// link (WiFiClient::hostPeer, TinyGsmClient::hostPeer). Without a peer every
+// connect fails.
+
+#ifndef HOST_HOSTCLIENT_H
+#define HOST_HOSTCLIENT_H
+
+#include <Arduino.h>
+
+class HostClient : public Client {
+public:
+  explicit HostClient(Client *const &peer) : _peer(peer) {}
+
+  int connect(const char *host, uint16_t port) override {
+    _on = _peer;
+    return _on ? _on->connect(host, port) : 0;
+  }
+  size_t write(uint8_t c) override { return _on ? _on->write(c) : 0; }
+  size_t write(const uint8_t *buf, size_t size) override { return _on ? _on->write(buf, size) : 0; }
+  int available() override { return _on ? _on->available() : 0; }
+  int read() override { return _on ? _on->read() : -1; }
+  int read(uint8_t *buf, size_t size) override { return _on ? _on->read(buf, size) : -1; }
+  int peek() override { return _on ? _on->peek() : -1; }
+  void flush() override {}
+  void stop() override {
+    if (_on) _on->stop();
+    _on = nullptr;
+  }
+  uint8_t connected() override { return _on ? _on->connected() : 0; }
+  operator bool() override { return connected(); }
+
+private:
+  Client *const &_peer;
+  Client *_on = nullptr;               // peer of the current connection
+};
+
+#endif // HOST_HOSTCLIENT_H
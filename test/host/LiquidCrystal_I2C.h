@@ -0,0 +1,8 @@
+// LiquidCrystal_I2C.h - config.h declares the lcd; nothing under test uses it.
+
+#ifndef HOST_LIQUIDCRYSTAL_I2C_H
+#define HOST_LIQUIDCRYSTAL_I2C_H
+
+class LiquidCrystal_I2C;
+
+#endif // HOST_LIQUIDCRYSTAL_I2C_H
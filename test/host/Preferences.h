@@ -0,0 +1,92 @@
+// Preferences.h - NVS kept in memory. Tests seed and inspect it through
+// g_nvs (namespace -> key -> value bytes), which outlives every Preferences.
+
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+typedef std::map<std::string, std::map<std::string, std::vector<uint8_t>>> HostNvs;
+extern HostNvs g_nvs;
+
+class Preferences {
+public:
+  // Read-only opens of a namespace that was never written fail, as on NVS
+  bool begin(const char *ns, bool readOnly = false) {
+    if (readOnly && !g_nvs.count(ns)) return false;
+    _ns = &g_nvs[ns];
+    return true;
+  }
+  void end() { _ns = nullptr; }
+
+  bool isKey(const char *k) { return _ns && _ns->count(k); }
+  bool remove(const char *k) { return _ns && _ns->erase(k); }
+  bool clear() {
+    if (_ns) _ns->clear();
+    return _ns != nullptr;
+  }
+
+  size_t putBytes(const char *k, const void *b, size_t n) {
+    if (!_ns) return 0;
+    (*_ns)[k].assign((const uint8_t *)b, (const uint8_t *)b + n);
+    return n;
+  }
+  size_t getBytesLength(const char *k) {
+    const std::vector<uint8_t> *v = find(k);
+    return v ? v->size() : 0;
+  }
+  size_t getBytes(const char *k, void *b, size_t n) {
+    const std::vector<uint8_t> *v = find(k);
+    if (!v || v->size() > n) return 0;
+    memcpy(b, v->data(), v->size());
+    return v->size();
+  }
+
+  size_t putString(const char *k, const char *v) { return putBytes(k, v, strlen(v)); }
+  size_t putString(const char *k, const String &v) { return putString(k, v.c_str()); }
+  String getString(const char *k, const String &def = String()) {
+    const std::vector<uint8_t> *v = find(k);
+    return v ? String(std::string(v->begin(), v->end())) : def;
+  }
+
+  size_t putBool(const char *k, bool v) { return put<uint8_t>(k, v); }
+  size_t putUChar(const char *k, uint8_t v) { return put(k, v); }
+  size_t putUShort(const char *k, uint16_t v) { return put(k, v); }
+  size_t putInt(const char *k, int32_t v) { return put(k, v); }
+  size_t putUInt(const char *k, uint32_t v) { return put(k, v); }
+  size_t putLong(const char *k, int32_t v) { return put(k, v); }
+  size_t putFloat(const char *k, float v) { return put(k, v); }
+  size_t putDouble(const char *k, double v) { return put(k, v); }
+
+  bool getBool(const char *k, bool def = false) { return get<uint8_t>(k, def) != 0; }
+  uint8_t getUChar(const char *k, uint8_t def = 0) { return get(k, def); }
+  uint16_t getUShort(const char *k, uint16_t def = 0) { return get(k, def); }
+  int32_t getInt(const char *k, int32_t def = 0) { return get(k, def); }
+  uint32_t getUInt(const char *k, uint32_t def = 0) { return get(k, def); }
+  int32_t getLong(const char *k, int32_t def = 0) { return get(k, def); }
+  float getFloat(const char *k, float def = 0) { return get(k, def); }
+  double getDouble(const char *k, double def = 0) { return get(k, def); }
+
+private:
+  std::map<std::string, std::vector<uint8_t>> *_ns = nullptr;
+
+  const std::vector<uint8_t> *find(const char *k) {
+    if (!_ns) return nullptr;
+    auto it = _ns->find(k);
+    return it == _ns->end() ? nullptr : &it->second;
+  }
+  template <class T> size_t put(const char *k, T v) { return putBytes(k, &v, sizeof(v)); }
+  // A value stored with another type reads as missing, like NVS
+  template <class T> T get(const char *k, T def) {
+    const std::vector<uint8_t> *v = find(k);
+    if (!v || v->size() != sizeof(T)) return def;
+    T out;
+    memcpy(&out, v->data(), sizeof(out));
+    return out;
+  }
+};
+
+#endif // HOST_PREFERENCES_H
@@ -0,0 +1,34 @@
+// SD.h - the SD card as a host directory, with power-loss injection.
+
+#ifndef HOST_SD_H
+#define HOST_SD_H
+
+#include "FS.h"
+
+class SDFS {
+public:
+  File open(const char *path, const char *mode = FILE_READ);
+  bool exists(const char *path);
+  bool mkdir(const char *path);
+  bool remove(const char *path);
+  bool rmdir(const char *path);
+  bool rename(const char *from, const char *to);
+};
+
+extern SDFS SD;
+
+// Start on an empty card kept in dir (created, old contents deleted)
+void sdhost_begin(const char *dir);
+std::string sdhost_path(const char *path);       // host path of a card path
+
+// The card loses power once this many more bytes have been written: the
+// write that crosses the limit is cut there and throws SdHostPowerCut.
+// A negative budget never cuts.
+struct SdHostPowerCut {};
+void sdhost_powerCutAfter(long bytes);
+long sdhost_bytesWritten();                      // since sdhost_begin()
+
+// sd_mountCount() moves on, as after a remount (modules rescan the card)
+void sdhost_remount();
+
+#endif // HOST_SD_H
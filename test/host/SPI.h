@@ -0,0 +1 @@
+// SPI.h - included by config.h; nothing under test uses it.
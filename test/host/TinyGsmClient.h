@@ -0,0 +1,77 @@
+// TinyGsmClient.h - the part of TinyGsm that modem_http.cpp uses: sendAT()
+// and waitResponse() over a Stream the test scripts. Like the library,
+// waitResponse() takes the socket URCs it meets out of the reply; here they
+// land in urcs, so a test can see none was swallowed or lost.
+// TinyGsmClient sockets connect to the peer in TinyGsmClient::hostPeer;
+// the data connection is up while hostGprs is set.
+
+#ifndef HOST_TINYGSMCLIENT_H
+#define HOST_TINYGSMCLIENT_H
+
+#include <Arduino.h>
+#include "HostClient.h"
+#include <string>
+#include <vector>
+
+#define GF(x) x
+#define GSM_NL "\r\n"
+
+class TinyGsm {
+public:
+  explicit TinyGsm(Stream &s) : stream(s) {}
+
+  void sendAT(const char *cmd = "") {
+    stream.print("AT");
+    stream.print(cmd);
+    stream.print(GSM_NL);
+  }
+
+  // 1: r1 seen, 2: ERROR, 3: +CME ERROR, 0: timeout
+  int8_t waitResponse(uint32_t timeoutMs, const char *r1 = "OK" GSM_NL, const char *r2 = "ERROR" GSM_NL,
+                      const char *r3 = "+CME ERROR:") {
+    std::string data;
+    unsigned long t0 = millis();
+    do {
+      while (stream.available() > 0) {
+        data += (char)stream.read();
+        if (endsWith(data, r1)) return 1;
+        if (r2 && endsWith(data, r2)) return 2;
+        if (r3 && endsWith(data, r3)) {
+          stream.readStringUntil('\n');
+          return 3;
+        }
+        if (endsWith(data, "+CIPRXGET:") || endsWith(data, "+IPCLOSE:")) {
+          urcs.push_back(data.substr(data.rfind('+')) + stream.readStringUntil('\n').c_str());
+          data.clear();
+        }
+      }
+      delay(0);
+    } while (millis() - t0 < timeoutMs);
+    return 0;
+  }
+  int8_t waitResponse() { return waitResponse(1000); }
+
+  bool isGprsConnected() { return hostGprs; }
+  bool gprsConnect(const char *, const char * = nullptr, const char * = nullptr) { return hostGprs; }
+
+  Stream &stream;
+  bool hostGprs = false;               // PDP context up; gprsConnect() does not change it
+  std::vector<std::string> urcs;       // socket URCs handed on, CRs included
+
+private:
+  static bool endsWith(const std::string &s, const char *t) {
+    size_t n = strlen(t);
+    return s.size() >= n && s.compare(s.size() - n, n, t) == 0;
+  }
+};
+
+class TinyGsmClient : public HostClient {
+public:
+  explicit TinyGsmClient(TinyGsm &, uint8_t mux = 0) : HostClient(hostPeer), mux(mux) {}
+  using HostClient::connect;
+  int connect(const char *host, uint16_t port, int timeoutS) { return connect(host, port); }
+  inline static Client *hostPeer = nullptr;
+  uint8_t mux;
+};
+
+#endif // HOST_TINYGSMCLIENT_H
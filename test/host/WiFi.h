@@ -0,0 +1,49 @@
+// WiFi.h - the station as a few fields the tests set (WiFi.hostStatus, ...),
+// and WiFiClient connections to the peer in WiFiClient::hostPeer.
+
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+#include "HostClient.h"
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+class WiFiClass {
+public:
+  wifi_mode_t getMode() { return hostMode; }
+  bool mode(wifi_mode_t m) {
+    hostMode = m;
+    return true;
+  }
+  wl_status_t status() { return hostStatus; }
+  int32_t RSSI() { return hostStatus == WL_CONNECTED ? hostRssi : 0; }
+  uint8_t *macAddress(uint8_t *mac) {
+    memcpy(mac, hostMac, 6);
+    return mac;
+  }
+
+  wifi_mode_t hostMode = WIFI_OFF;
+  wl_status_t hostStatus = WL_DISCONNECTED;
+  int32_t     hostRssi = -60;
+  uint8_t     hostMac[6] = { 0x02, 0, 0, 0, 0, 0x01 };
+};
+
+extern WiFiClass WiFi;
+
+class WiFiClient : public HostClient {
+public:
+  WiFiClient() : HostClient(hostPeer) {}
+  inline static Client *hostPeer = nullptr;
+};
+
+#endif // HOST_WIFI_H
@@ -0,0 +1 @@
+// Wire.h - included by config.h; nothing under test uses it.
@@ -0,0 +1,23 @@
+// check.h - assertions for the host tests: report every failure, exit 1 at the end.
+
+#ifndef HOST_CHECK_H
+#define HOST_CHECK_H
+
+#include <stdio.h>
+
+static int g_checkFails = 0;
+
+#define CHECK(cond)                                                       \
+  do {                                                                    \
+    if (!(cond)) {                                                        \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);              \
+      g_checkFails++;                                                     \
+    }                                                                     \
+  } while (0)
+
+static inline int check_done(const char *name) {
+  printf("%s: %s\n", name, g_checkFails ? "FAILED" : "ok");
+  return g_checkFails ? 1 : 0;
+}
+
+#endif // HOST_CHECK_H
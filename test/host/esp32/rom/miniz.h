@@ -0,0 +1,41 @@
+// esp32/rom/miniz.h - the ROM's tinfl interface, implemented with zlib.
+
+#ifndef HOST_MINIZ_H
+#define HOST_MINIZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zlib.h>
+
+typedef enum {
+  TINFL_STATUS_BAD_PARAM = -3,
+  TINFL_STATUS_ADLER32_MISMATCH = -2,
+  TINFL_STATUS_FAILED = -1,
+  TINFL_STATUS_DONE = 0,
+  TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+  TINFL_STATUS_HAS_MORE_OUTPUT = 2
+} tinfl_status;
+
+enum {
+  TINFL_FLAG_PARSE_ZLIB_HEADER = 1,
+  TINFL_FLAG_HAS_MORE_INPUT = 2,
+  TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF = 4,
+  TINFL_FLAG_COMPUTE_ADLER32 = 8
+};
+
+// zlib's state is carved out of the struct itself, so free() of the
+// decompressor releases everything, as with the ROM's flat struct
+typedef struct {
+  z_stream z;
+  int      started;
+  size_t   used;
+  uint8_t  arena[48 * 1024];
+} tinfl_decompressor;
+
+#define tinfl_init(r) ((r)->started = 0)
+
+tinfl_status tinfl_decompress(tinfl_decompressor *r, const uint8_t *pIn_buf_next, size_t *pIn_buf_size,
+                              uint8_t *pOut_buf_start, uint8_t *pOut_buf_next, size_t *pOut_buf_size,
+                              const uint32_t decomp_flags);
+
+#endif // HOST_MINIZ_H
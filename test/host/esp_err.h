@@ -0,0 +1,19 @@
+// esp_err.h - the error codes the modules under test compare against;
+// esp_err_to_name() is in esp_host.cpp.
+
+#ifndef HOST_ESP_ERR_H
+#define HOST_ESP_ERR_H
+
+typedef int esp_err_t;
+#define ESP_OK                      0
+#define ESP_FAIL                    (-1)
+#define ESP_ERR_INVALID_ARG         0x102
+#define ESP_ERR_INVALID_STATE       0x103
+#define ESP_ERR_INVALID_SIZE        0x104
+#define ESP_ERR_NOT_FOUND           0x105
+#define ESP_ERR_OTA_VALIDATE_FAILED 0x1503
+#define ESP_ERR_IMAGE_INVALID       0x2002
+
+const char *esp_err_to_name(esp_err_t err);
+
+#endif // HOST_ESP_ERR_H
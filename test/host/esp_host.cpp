@@ -0,0 +1,165 @@
+// esp_host.cpp - the running app partition and the update slot for the OTA tests.
+
+#include <esp_ota_ops.h>
+#include <openssl/sha.h>
+#include <string.h>
+#include <vector>
+
+static esp_partition_t      s_part = { 0x10000, 0, "app0" };
+static std::vector<uint8_t> s_flash;
+
+void esphost_setRunning(const uint8_t *image, size_t len, uint32_t slotSize) {
+  s_flash.assign(slotSize, 0xFF);
+  memcpy(s_flash.data(), image, len < slotSize ? len : slotSize);
+  s_part.size = slotSize;
+}
+
+const esp_partition_t *esp_ota_get_running_partition(void) {
+  return s_part.size ? &s_part : nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t len) {
+  if (part != &s_part || offset > s_flash.size() || len > s_flash.size() - offset) return ESP_ERR_INVALID_ARG;
+  memcpy(dst, s_flash.data() + offset, len);
+  return ESP_OK;
+}
+
+// Walk the esptool layout: 24-byte header, segments (8-byte header + data),
+// zero padding up to the checksum byte at the end of a 16-byte block, then
+// the 32-byte digest if header byte 23 (hash_appended) is set.
+static esp_err_t imageSha256(const std::vector<uint8_t> &img, uint8_t *sha256) {
+  if (img.size() < 24 || img[0] != 0xE9) return ESP_ERR_IMAGE_INVALID;
+  size_t at = 24;
+  uint8_t checksum = 0xEF;
+  for (uint8_t seg = 0; seg < img[1]; ++seg) {
+    if (at + 8 > img.size()) return ESP_ERR_IMAGE_INVALID;
+    uint32_t len;
+    memcpy(&len, &img[at + 4], 4);
+    at += 8;
+    if (len > img.size() - at) return ESP_ERR_IMAGE_INVALID;
+    for (uint32_t i = 0; i < len; ++i) checksum ^= img[at + i];
+    at += len;
+  }
+  at = (at | 15) + 1;                  // padding and the checksum byte
+  if (at > img.size() || img[at - 1] != checksum) return ESP_ERR_IMAGE_INVALID;
+  SHA256(img.data(), at, sha256);
+  if (img[23] == 1) {
+    if (at + 32 > img.size() || memcmp(&img[at], sha256, 32) != 0) return ESP_ERR_IMAGE_INVALID;
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_get_sha256(const esp_partition_t *part, uint8_t *sha256) {
+  if (part != &s_part) return ESP_ERR_IMAGE_INVALID;
+  return imageSha256(s_flash, sha256);
+}
+
+// ---------------------------------------------------------
+// The update slot
+// ---------------------------------------------------------
+static esp_partition_t       s_next = { 0x210000, 0, "app1" };
+static std::vector<uint8_t>  s_nextFlash;
+static esp_ota_handle_t      s_handle = 0;      // open handle, 0: none
+static esp_ota_handle_t      s_lastHandle = 0;
+static bool                  s_nextValid = false;
+static const esp_partition_t *s_boot = nullptr;
+static esp_ota_img_states_t  s_runningState = ESP_OTA_IMG_VALID;
+
+void esphost_resetOta(uint32_t slotSize, esp_ota_img_states_t st) {
+  s_next.size = slotSize;
+  s_nextFlash.clear();
+  s_handle = 0;
+  s_nextValid = false;
+  s_boot = &s_part;
+  s_runningState = st;
+}
+
+const uint8_t *esphost_updateSlot(size_t *len) {
+  *len = s_nextFlash.size();
+  return s_nextFlash.data();
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *) {
+  return s_next.size ? &s_next : nullptr;
+}
+
+const esp_partition_t *esp_ota_get_boot_partition(void) {
+  return s_boot;
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t *part, size_t imageSize, esp_ota_handle_t *handle) {
+  if (part != &s_next || !handle) return ESP_ERR_INVALID_ARG;
+  if (imageSize != OTA_WITH_SEQUENTIAL_WRITES && imageSize != OTA_SIZE_UNKNOWN && imageSize > part->size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  s_nextFlash.clear();
+  s_nextValid = false;
+  s_handle = *handle = ++s_lastHandle;
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size) {
+  if (!handle || handle != s_handle) return ESP_ERR_INVALID_ARG;
+  if (size > s_next.size - s_nextFlash.size()) return ESP_ERR_INVALID_SIZE;
+  const uint8_t *p = (const uint8_t *)data;
+  s_nextFlash.insert(s_nextFlash.end(), p, p + size);
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle) {
+  if (!handle || handle != s_handle) return ESP_ERR_INVALID_ARG;
+  s_handle = 0;
+  uint8_t sha[32];
+  s_nextValid = imageSha256(s_nextFlash, sha) == ESP_OK;
+  return s_nextValid ? ESP_OK : ESP_ERR_OTA_VALIDATE_FAILED;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle) {
+  if (!handle || handle != s_handle) return ESP_ERR_NOT_FOUND;
+  s_handle = 0;
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *part) {
+  if (part == &s_part) {
+    s_boot = part;
+    return ESP_OK;
+  }
+  if (part != &s_next) return ESP_ERR_INVALID_ARG;
+  if (!s_nextValid || s_handle) return ESP_ERR_OTA_VALIDATE_FAILED;
+  s_boot = part;
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t *part, esp_ota_img_states_t *state) {
+  if (!part || !state) return ESP_ERR_INVALID_ARG;
+  if (part != &s_part) return ESP_ERR_NOT_FOUND;
+  *state = s_runningState;
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void) {
+  s_runningState = ESP_OTA_IMG_VALID;
+  return ESP_OK;
+}
+
+// On the device this reboots into the previous slot
+esp_err_t esp_ota_mark_app_invalid_rollback_and_reboot(void) {
+  if (s_runningState != ESP_OTA_IMG_PENDING_VERIFY) return ESP_ERR_INVALID_STATE;
+  s_runningState = ESP_OTA_IMG_ABORTED;
+  return ESP_OK;
+}
+
+const char *esp_err_to_name(esp_err_t err) {
+  switch (err) {
+    case ESP_OK:                      return "ESP_OK";
+    case ESP_FAIL:                    return "ESP_FAIL";
+    case ESP_ERR_INVALID_ARG:         return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:       return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:           return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_OTA_VALIDATE_FAILED: return "ESP_ERR_OTA_VALIDATE_FAILED";
+    case ESP_ERR_IMAGE_INVALID:       return "ESP_ERR_IMAGE_INVALID";
+    default:                          return "UNKNOWN ERROR";
+  }
+}
@@ -0,0 +1,68 @@
+// esp_http_server.h - one request as the test scripts it: headers, the
+// body the client manages to send, and what httpd_req_recv() returns once
+// that runs out before content_len (0: connection closed, or
+// HTTPD_SOCK_ERR_TIMEOUT). The test's http_sendStatus() fills in the reply.
+
+#ifndef HOST_ESP_HTTP_SERVER_H
+#define HOST_ESP_HTTP_SERVER_H
+
+#include <map>
+#include <string>
+#include <string.h>
+#include <strings.h>
+#include "esp_err.h"
+
+typedef void *httpd_handle_t;
+
+typedef enum {
+  HTTP_DELETE = 0,
+  HTTP_GET = 1,
+  HTTP_HEAD = 2,
+  HTTP_POST = 3,
+  HTTP_PUT = 4
+} httpd_method_t;
+
+#define HTTPD_RESP_USE_STRLEN  -1
+#define HTTPD_SOCK_ERR_FAIL    -1
+#define HTTPD_SOCK_ERR_INVALID -2
+#define HTTPD_SOCK_ERR_TIMEOUT -3
+
+#define ESP_ERR_HTTPD_RESULT_TRUNC 0xb003
+
+struct httpd_req_t {
+  int    method = HTTP_GET;
+  size_t content_len = 0;
+
+  std::map<std::string, std::string> hostHeaders;
+  std::string hostBody;
+  size_t      hostAt = 0;
+  size_t      hostRecvBytes = 1460;    // most one recv returns
+  int         hostEnd = 0;             // recv once hostBody is used up
+  int         hostRecvs = 0;           // httpd_req_recv() calls
+  std::string hostStatus, hostReply;
+};
+
+inline esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *req, const char *field, char *val, size_t len) {
+  for (const auto &h : req->hostHeaders) {
+    if (strcasecmp(h.first.c_str(), field) != 0) continue;
+    if (!len) return ESP_ERR_INVALID_ARG;
+    size_t n = h.second.size() < len - 1 ? h.second.size() : len - 1;
+    memcpy(val, h.second.c_str(), n);
+    val[n] = '\0';
+    return n < h.second.size() ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+  }
+  return ESP_ERR_NOT_FOUND;
+}
+
+inline int httpd_req_recv(httpd_req_t *req, char *buf, size_t len) {
+  req->hostRecvs++;
+  size_t left = req->hostBody.size() - req->hostAt;
+  if (!left) return req->hostEnd;
+  size_t n = len < left ? len : left;
+  if (n > req->hostRecvBytes) n = req->hostRecvBytes;
+  memcpy(buf, req->hostBody.data() + req->hostAt, n);
+  req->hostAt += n;
+  return (int)n;
+}
+
+#endif // HOST_ESP_HTTP_SERVER_H
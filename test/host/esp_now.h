@@ -0,0 +1,36 @@
+// esp_now.h - ESP-NOW over UDP on 127.0.0.1. A node with MAC ..:xx listens
+// on port base + xx, so a test can talk to the firmware from plain sockets.
+// Nothing arrives by itself: espnowhost_poll() stands in for the WiFi task
+// and calls the receive callback.
+
+#ifndef HOST_ESP_NOW_H
+#define HOST_ESP_NOW_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_wifi.h"
+
+#define ESP_NOW_MAX_DATA_LEN 250
+
+typedef struct {
+  uint8_t          peer_addr[6];
+  uint8_t          channel;
+  wifi_interface_t ifidx;
+  bool             encrypt;
+} esp_now_peer_info_t;
+
+typedef void (*esp_now_recv_cb_t)(const uint8_t *mac, const uint8_t *data, int len);
+
+esp_err_t esp_now_init(void);          // binds the port of WiFi.macAddress()
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb);
+esp_err_t esp_now_send(const uint8_t *mac, const uint8_t *data, size_t len);
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer);
+bool      esp_now_is_peer_exist(const uint8_t *mac);
+
+// Test control
+void     espnowhost_begin(uint16_t basePort);
+uint16_t espnowhost_port(const uint8_t *mac);
+int      espnowhost_poll(int max);     // deliver up to max waiting packets, returns the count
+uint32_t espnowhost_sent();            // packets sent by the firmware
+
+#endif // HOST_ESP_NOW_H
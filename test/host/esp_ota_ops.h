@@ -0,0 +1,45 @@
+// esp_ota_ops.h - the running partition (esp_partition.h) and one update
+// slot held in memory (esp_host.cpp). esp_ota_end() validates the image
+// like the bootloader would; the image states and the boot partition are
+// recorded for the tests to check.
+
+#ifndef HOST_ESP_OTA_OPS_H
+#define HOST_ESP_OTA_OPS_H
+
+#include "esp_partition.h"
+
+typedef uint32_t esp_ota_handle_t;
+
+#define OTA_SIZE_UNKNOWN           0xFFFFFFFFu
+#define OTA_WITH_SEQUENTIAL_WRITES 0xFFFFFFFEu
+
+typedef enum {
+  ESP_OTA_IMG_NEW = 0,
+  ESP_OTA_IMG_PENDING_VERIFY = 1,
+  ESP_OTA_IMG_VALID = 2,
+  ESP_OTA_IMG_INVALID = 3,
+  ESP_OTA_IMG_ABORTED = 4,
+  ESP_OTA_IMG_UNDEFINED = 0xFFFFFFFFu
+} esp_ota_img_states_t;
+
+const esp_partition_t *esp_ota_get_running_partition(void);
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start);
+const esp_partition_t *esp_ota_get_boot_partition(void);
+
+esp_err_t esp_ota_begin(const esp_partition_t *part, size_t imageSize, esp_ota_handle_t *handle);
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size);
+esp_err_t esp_ota_end(esp_ota_handle_t handle);
+esp_err_t esp_ota_abort(esp_ota_handle_t handle);
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *part);
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t *part, esp_ota_img_states_t *state);
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void);
+esp_err_t esp_ota_mark_app_invalid_rollback_and_reboot(void);   // returns here
+
+// Test control: an empty update slot of slotSize, nothing open, booting the
+// running slot in state st
+void esphost_resetOta(uint32_t slotSize, esp_ota_img_states_t st);
+// What has been written to the update slot since esp_ota_begin()
+const uint8_t *esphost_updateSlot(size_t *len);
+
+#endif // HOST_ESP_OTA_OPS_H
@@ -0,0 +1,26 @@
+// esp_partition.h - one app partition held in memory (esphost_setRunning()).
+
+#ifndef HOST_ESP_PARTITION_H
+#define HOST_ESP_PARTITION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct {
+  uint32_t address;
+  uint32_t size;
+  char     label[17];
+} esp_partition_t;
+
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t len);
+
+// As ESP-IDF does for an app partition: the SHA-256 of the image (header,
+// segments, padding, checksum) without the digest esptool appends. Fails
+// if the image is malformed or the appended digest does not match.
+esp_err_t esp_partition_get_sha256(const esp_partition_t *part, uint8_t *sha256);
+
+// Test control: the running slot holds image[len], erased (0xFF) up to slotSize
+void esphost_setRunning(const uint8_t *image, size_t len, uint32_t slotSize);
+
+#endif // HOST_ESP_PARTITION_H
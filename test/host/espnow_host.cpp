@@ -0,0 +1,84 @@
+// espnow_host.cpp - ESP-NOW frames as UDP datagrams on the loopback.
+
+#include <WiFi.h>
+#include <esp_now.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <set>
+
+static uint16_t s_base = 0;
+static int s_sock = -1;
+static esp_now_recv_cb_t s_cb = nullptr;
+static std::set<uint8_t> s_peers;
+static uint32_t s_sent = 0;
+
+void espnowhost_begin(uint16_t basePort) {
+  s_base = basePort;
+}
+
+uint16_t espnowhost_port(const uint8_t *mac) {
+  return s_base + mac[5];
+}
+
+static sockaddr_in loopback(uint16_t port) {
+  sockaddr_in a = {};
+  a.sin_family = AF_INET;
+  a.sin_port = htons(port);
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return a;
+}
+
+// A reboot calls this again: frames still in the old socket are lost, as on air
+esp_err_t esp_now_init(void) {
+  if (s_sock >= 0) close(s_sock);
+  s_peers.clear();
+  s_cb = nullptr;
+  s_sock = socket(AF_INET, SOCK_DGRAM, 0);
+  uint8_t mac[6];
+  sockaddr_in a = loopback(espnowhost_port(WiFi.macAddress(mac)));
+  if (s_sock < 0 || bind(s_sock, (sockaddr *)&a, sizeof(a)) != 0) return ESP_FAIL;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb) {
+  s_cb = cb;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_send(const uint8_t *mac, const uint8_t *data, size_t len) {
+  if (s_sock < 0 || len > ESP_NOW_MAX_DATA_LEN || !s_peers.count(mac[5])) return ESP_FAIL;
+  sockaddr_in to = loopback(espnowhost_port(mac));
+  if (sendto(s_sock, data, len, 0, (sockaddr *)&to, sizeof(to)) != (ssize_t)len) return ESP_FAIL;
+  s_sent++;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer) {
+  s_peers.insert(peer->peer_addr[5]);
+  return ESP_OK;
+}
+
+bool esp_now_is_peer_exist(const uint8_t *mac) {
+  return s_peers.count(mac[5]) != 0;
+}
+
+int espnowhost_poll(int max) {
+  int n = 0;
+  uint8_t buf[512];
+  while (s_sock >= 0 && n < max) {
+    sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    ssize_t len = recvfrom(s_sock, buf, sizeof(buf), MSG_DONTWAIT, (sockaddr *)&from, &fromLen);
+    if (len < 0) break;
+    uint8_t mac[6] = { 0x02, 0, 0, 0, 0, (uint8_t)(ntohs(from.sin_port) - s_base) };
+    if (s_cb) s_cb(mac, buf, (int)len);
+    n++;
+  }
+  return n;
+}
+
+uint32_t espnowhost_sent() {
+  return s_sent;
+}
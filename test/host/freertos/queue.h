@@ -0,0 +1,33 @@
+// freertos/queue.h - a copying FIFO; the tests run on one thread.
+
+#ifndef HOST_QUEUE_H
+#define HOST_QUEUE_H
+
+#include "FreeRTOS.h"
+#include <deque>
+#include <string.h>
+#include <vector>
+
+struct HostQueue {
+  size_t len, item;
+  std::deque<std::vector<uint8_t>> items;
+};
+typedef HostQueue *QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(size_t len, size_t item) {
+  return new HostQueue{ len, item, {} };
+}
+inline BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t) {
+  if (q->items.size() >= q->len) return pdFALSE;
+  const uint8_t *p = (const uint8_t *)item;
+  q->items.emplace_back(p, p + q->item);
+  return pdTRUE;
+}
+inline BaseType_t xQueueReceive(QueueHandle_t q, void *out, TickType_t) {
+  if (q->items.empty()) return pdFALSE;
+  memcpy(out, q->items.front().data(), q->item);
+  q->items.pop_front();
+  return pdTRUE;
+}
+
+#endif // HOST_QUEUE_H
@@ -0,0 +1,32 @@
+// host.cpp - Serial, ESP, NVS, WiFi, the virtual clock and esp_random() for the host tests.
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WiFi.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+HostNvs g_nvs;
+WiFiClass WiFi;
+
+static unsigned long s_ms = 0;
+
+unsigned long millis() {
+  return s_ms;
+}
+
+unsigned long micros() {
+  return s_ms * 1000UL;
+}
+
+void delay(unsigned long ms) {
+  s_ms += ms ? ms : 1;
+}
+
+uint32_t esp_random() {
+  static uint32_t x = 2463534242u;      // xorshift32, same sequence every run
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return x;
+}
@@ -0,0 +1,29 @@
+// mbedtls/sha256.h - the streaming SHA-256 calls, on OpenSSL's EVP digest.
+
+#ifndef HOST_MBEDTLS_SHA256_H
+#define HOST_MBEDTLS_SHA256_H
+
+#include <openssl/evp.h>
+
+typedef struct {
+  EVP_MD_CTX *md;
+} mbedtls_sha256_context;
+
+inline void mbedtls_sha256_init(mbedtls_sha256_context *ctx) {
+  ctx->md = EVP_MD_CTX_new();
+}
+inline void mbedtls_sha256_free(mbedtls_sha256_context *ctx) {
+  EVP_MD_CTX_free(ctx->md);
+  ctx->md = nullptr;
+}
+inline int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224) {
+  return EVP_DigestInit_ex(ctx->md, is224 ? EVP_sha224() : EVP_sha256(), nullptr) == 1 ? 0 : -1;
+}
+inline int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input, size_t len) {
+  return EVP_DigestUpdate(ctx->md, input, len) == 1 ? 0 : -1;
+}
+inline int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char output[32]) {
+  return EVP_DigestFinal_ex(ctx->md, output, nullptr) == 1 ? 0 : -1;
+}
+
+#endif // HOST_MBEDTLS_SHA256_H
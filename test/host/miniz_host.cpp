@@ -0,0 +1,47 @@
+// miniz_host.cpp - tinfl_decompress() on top of zlib's inflate().
+
+#include <esp32/rom/miniz.h>
+#include <string.h>
+
+static voidpf tinfl_alloc(voidpf opaque, uInt items, uInt size) {
+  tinfl_decompressor *r = (tinfl_decompressor *)opaque;
+  size_t n = ((size_t)items * size + 15) & ~(size_t)15;
+  if (n > sizeof(r->arena) - r->used) return Z_NULL;
+  voidpf p = r->arena + r->used;
+  r->used += n;
+  return p;
+}
+
+static void tinfl_free(voidpf, voidpf) {}
+
+tinfl_status tinfl_decompress(tinfl_decompressor *r, const uint8_t *in, size_t *inSize, uint8_t *,
+                              uint8_t *out, size_t *outSize, const uint32_t flags) {
+  if (!r->started) {
+    r->used = 0;
+    r->z = z_stream();
+    r->z.zalloc = tinfl_alloc;
+    r->z.zfree = tinfl_free;
+    r->z.opaque = r;
+    if (inflateInit2(&r->z, (flags & TINFL_FLAG_PARSE_ZLIB_HEADER) ? 15 : -15) != Z_OK) return TINFL_STATUS_BAD_PARAM;
+    r->started = 1;
+  }
+  r->z.next_in = (Bytef *)in;
+  r->z.avail_in = (uInt)*inSize;
+  r->z.next_out = out;
+  r->z.avail_out = (uInt)*outSize;
+  int ret = inflate(&r->z, Z_NO_FLUSH);
+  *inSize -= r->z.avail_in;
+  *outSize -= r->z.avail_out;
+  switch (ret) {
+    case Z_STREAM_END:
+      return TINFL_STATUS_DONE;
+    case Z_OK:
+    case Z_BUF_ERROR:
+      return r->z.avail_out ? TINFL_STATUS_NEEDS_MORE_INPUT : TINFL_STATUS_HAS_MORE_OUTPUT;
+    case Z_DATA_ERROR:
+      return r->z.msg && !strcmp(r->z.msg, "incorrect data check") ? TINFL_STATUS_ADLER32_MISMATCH
+                                                                    : TINFL_STATUS_FAILED;
+    default:
+      return TINFL_STATUS_FAILED;
+  }
+}
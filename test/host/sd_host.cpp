@@ -0,0 +1,166 @@
+// sd_host.cpp - SD.h / FS.h and sd_storage.h on a host directory.
+
+#include <SD.h>
+#include "../../sd_storage.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+SDFS SD;
+
+static std::string s_root;
+static long        s_budget = -1;
+static long        s_written = 0;
+static uint32_t    s_mounts = 1;
+
+void sdhost_begin(const char *dir) {
+  s_root = dir;
+  std::filesystem::remove_all(s_root);
+  std::filesystem::create_directories(s_root);
+  s_budget = -1;
+  s_written = 0;
+  s_mounts++;
+}
+
+std::string sdhost_path(const char *path) {
+  return s_root + path;
+}
+
+void sdhost_powerCutAfter(long bytes) {
+  s_budget = bytes;
+}
+
+long sdhost_bytesWritten() {
+  return s_written;
+}
+
+void sdhost_remount() {
+  s_mounts++;
+}
+
+// ---------------------------------------------------------
+// File
+// ---------------------------------------------------------
+File::File(const std::string &hostPath, const std::string &name, const char *mode) : _host(hostPath), _name(name) {
+  struct stat st;
+  if (mode[0] == 'r' && stat(hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+    _dir = true;
+    return;
+  }
+  FILE *fp = fopen(hostPath.c_str(), mode[0] == 'r' ? "rb" : mode[0] == 'w' ? "wb" : "ab");
+  if (fp) _fp.reset(fp, fclose);
+}
+
+size_t File::write(const uint8_t *buf, size_t len) {
+  if (!_fp) return 0;
+  size_t n = len;
+  if (s_budget >= 0 && (long)n > s_budget) n = (size_t)s_budget;
+  n = fwrite(buf, 1, n, _fp.get());
+  fflush(_fp.get());
+  s_written += n;
+  if (s_budget >= 0) {
+    s_budget -= n;
+    if (n < len) throw SdHostPowerCut();
+  }
+  return n;
+}
+
+int File::read() {
+  return _fp ? fgetc(_fp.get()) : -1;
+}
+
+size_t File::read(uint8_t *buf, size_t len) {
+  return _fp ? fread(buf, 1, len, _fp.get()) : 0;
+}
+
+int File::available() {
+  return _fp ? (int)(size() - position()) : 0;
+}
+
+bool File::seek(uint32_t pos) {
+  return _fp && fseek(_fp.get(), pos, SEEK_SET) == 0;
+}
+
+size_t File::position() {
+  return _fp ? (size_t)ftell(_fp.get()) : 0;
+}
+
+size_t File::size() {
+  struct stat st;
+  if (_fp) fflush(_fp.get());
+  return stat(_host.c_str(), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::close() {
+  _fp.reset();
+  _dir = false;
+}
+
+// Entries in name order, so a test sees the same sequence on every host
+File File::openNextFile() {
+  if (!_dir) return File();
+  std::vector<std::string> names;
+  if (DIR *d = opendir(_host.c_str())) {
+    while (struct dirent *e = readdir(d)) {
+      if (e->d_name[0] != '.') names.push_back(e->d_name);
+    }
+    closedir(d);
+  }
+  std::sort(names.begin(), names.end());
+  if (_dirAt >= names.size()) return File();
+  const std::string &n = names[_dirAt++];
+  return File(_host + "/" + n, _name + "/" + n, FILE_READ);
+}
+
+// ---------------------------------------------------------
+// SDFS
+// ---------------------------------------------------------
+File SDFS::open(const char *path, const char *mode) {
+  return File(sdhost_path(path), path, mode);
+}
+
+bool SDFS::exists(const char *path) {
+  struct stat st;
+  return stat(sdhost_path(path).c_str(), &st) == 0;
+}
+
+bool SDFS::mkdir(const char *path) {
+  return ::mkdir(sdhost_path(path).c_str(), 0755) == 0;
+}
+
+bool SDFS::remove(const char *path) {
+  return ::unlink(sdhost_path(path).c_str()) == 0;
+}
+
+bool SDFS::rmdir(const char *path) {
+  return ::rmdir(sdhost_path(path).c_str()) == 0;
+}
+
+bool SDFS::rename(const char *from, const char *to) {
+  return ::rename(sdhost_path(from).c_str(), sdhost_path(to).c_str()) == 0;
+}
+
+// ---------------------------------------------------------
+// sd_storage.h: always mounted, the lock is a no-op (single thread)
+// ---------------------------------------------------------
+SdLock::SdLock() : _ok(true) {}
+SdLock::~SdLock() {}
+
+uint32_t sd_mountCount() {
+  return s_mounts;
+}
+
+void sd_noteError(const char *what) {
+  Serial.printf("[SD] error: %s\n", what);
+}
+
+size_t sd_write(File &f, const uint8_t *buf, size_t len) {
+  return f.write(buf, len);
+}
+
+bool sd_truncate(const char *path, uint32_t len) {
+  return ::truncate(sdhost_path(path).c_str(), len) == 0;
+}
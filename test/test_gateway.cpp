@@ -0,0 +1,280 @@
+// test_gateway.cpp - an apiary of 30 satellites and one gateway, with UDP on
+// the loopback standing in for ESP-NOW. Over a few simulated hours the
+// gateway boots without a clock, loses LTE for an hour, reboots, and loses
+// power while writing its journal; every sample a satellite took must still
+// reach ThingSpeak, dated.
+//
+// gateway.cpp (NODE_ROLE_GATEWAY) is compiled into this file so a reboot
+// can clear its RAM. The satellites speak its packet format from plain UDP
+// sockets, one per node, following sat_send() / sat_onAck().
+
+#include <Arduino.h>
+#include <SD.h>
+#include <esp_now.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include "check.h"
+#include "../gateway.cpp"
+
+#define NODES      30
+#define GW_MAC_ID  0xFE
+#define HOUR_MS    3600000UL
+#define CHANNEL(n) (100000u + (n))
+
+// ---------------------------------------------------------
+// What the gateway uploads through
+// ---------------------------------------------------------
+static bool s_clock = false;
+static bool s_lte = true;
+static uint32_t s_lteSessions = 0;
+static uint32_t s_bulkRequests = 0;
+static uint32_t s_untimed = 0;
+static std::map<std::pair<long, long>, int> s_uploaded;   // (node, sample number) -> times
+
+bool timeManager_isTimeValid() {
+  return s_clock;
+}
+
+bool modem_isNetworkRegistered() {
+  if (s_lte) s_lteSessions++;         // asked once per upload round
+  return s_lte;
+}
+
+// The satellite's node id and sample number travel in field1 / field2
+String thingspeak_bulkEntry(const TelemetrySample &s) {
+  char b[96];
+  if (s.ts) snprintf(b, sizeof(b), "{\"created_at\":%lu,\"field1\":%ld,\"field2\":%ld}", (unsigned long)s.ts,
+                     (long)s.v[0], (long)s.v[1]);
+  else snprintf(b, sizeof(b), "{\"field1\":%ld,\"field2\":%ld}", (long)s.v[0], (long)s.v[1]);
+  return String(b);
+}
+
+// Every 40th request fails on the cell
+bool thingspeak_bulk_via_modem(uint32_t channelId, const String &json) {
+  if (++s_bulkRequests % 40 == 0) return false;
+  const char *p = strstr(json.c_str(), "\"updates\":[");
+  CHECK(p && strstr(json.c_str(), "\"write_api_key\":\"KEY\""));
+  while (p && (p = strchr(p + 1, '{')) != nullptr) {
+    unsigned long ts = 0;
+    long node = 0, num = 0;
+    if (sscanf(p, "{\"created_at\":%lu,\"field1\":%ld,\"field2\":%ld}", &ts, &node, &num) != 3) {
+      sscanf(p, "{\"field1\":%ld,\"field2\":%ld}", &node, &num);
+      s_untimed++;
+    }
+    CHECK(CHANNEL(node) == channelId);
+    s_uploaded[{ node, num }]++;
+  }
+  return true;
+}
+
+// ---------------------------------------------------------
+// Satellites
+// ---------------------------------------------------------
+struct Sat {
+  uint8_t  id;
+  int      sock;
+  uint16_t boot;
+  std::deque<TelemetrySample> backlog;
+  uint32_t first = 0;                 // number of backlog.front()
+  uint8_t  seq = 0;
+  uint8_t  inFlight = 0;
+  unsigned long nextSampleMs;
+  unsigned long lastSendMs = 0;
+  bool     clock = false;
+  long     epochAtZero = 0;           // gateway time minus millis() / 1000
+  uint32_t made = 0, overflow = 0, packets = 0, bytes = 0;
+  size_t   maxBacklog = 0;
+};
+
+static Sat s_sats[NODES];
+static uint16_t s_gwPort;
+
+static void satSend(Sat &t) {
+  if (t.backlog.empty()) return;
+  uint8_t pkt[GW_PKT_MAX];
+  GwDataHdr h = { GW_MAGIC_DATA, GW_VERSION, t.id, ++t.seq, 0, 0, t.boot, t.first };
+  size_t pos = sizeof(h);
+  SampleEncoder enc;
+  sample_encoderReset(enc);
+  uint8_t n = 0;
+  while (n < t.backlog.size()) {
+    uint8_t frame[SAMPLE_FRAME_MAX];
+    size_t len = sample_encodeNext(enc, t.backlog[n], frame, sizeof(frame));
+    if (!len || pos + 1 + len > sizeof(pkt)) break;
+    pkt[pos++] = (uint8_t)len;
+    memcpy(pkt + pos, frame, len);
+    pos += len;
+    n++;
+  }
+  h.count = n;
+  h.behind = (uint8_t)(t.backlog.size() - n);
+  memcpy(pkt, &h, sizeof(h));
+  t.inFlight = n;
+  t.lastSendMs = millis();
+  sockaddr_in to = {};
+  to.sin_family = AF_INET;
+  to.sin_port = htons(s_gwPort);
+  to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  CHECK(sendto(t.sock, pkt, pos, 0, (sockaddr *)&to, sizeof(to)) == (ssize_t)pos);
+  t.packets++;
+  t.bytes += pos;
+}
+
+static void satTick(Sat &t, bool sampling) {
+  unsigned long now = millis();
+  if (sampling && now >= t.nextSampleMs) {
+    t.nextSampleMs += GW_SAT_INTERVAL_S * 1000UL;
+    TelemetrySample s = {};
+    s.ts = t.clock ? (uint32_t)(t.epochAtZero + now / 1000) : 0;
+    s.v[0] = t.id;
+    s.v[1] = (int32_t)t.made++;
+    s.v[CH_BATT] = 4100 - (int32_t)(now / 600000);
+    if (t.backlog.size() == GW_SAT_BACKLOG) {
+      t.backlog.pop_front();
+      t.first++;
+      if (t.inFlight) t.inFlight--;
+      t.overflow++;
+    }
+    t.backlog.push_back(s);
+    if (t.backlog.size() > t.maxBacklog) t.maxBacklog = t.backlog.size();
+    satSend(t);
+  } else if (!t.backlog.empty() && now - t.lastSendMs >= GW_SAT_RETRY_MS) {
+    satSend(t);
+  }
+}
+
+static void satReceive(Sat &t) {
+  GwAck a;
+  while (recv(t.sock, &a, sizeof(a), MSG_DONTWAIT) == (ssize_t)sizeof(a)) {
+    if (a.magic != GW_MAGIC_ACK || a.version != GW_VERSION || a.node != t.id) continue;
+    if (a.gwTime >= GW_MIN_VALID_TS && !t.clock) {
+      t.clock = true;
+      t.epochAtZero = (long)a.gwTime - (long)(millis() / 1000);
+    }
+    if (a.seq != t.seq || !t.inFlight) continue;
+    t.backlog.erase(t.backlog.begin(), t.backlog.begin() + t.inFlight);
+    t.first += t.inFlight;
+    t.inFlight = 0;
+    if (!t.backlog.empty()) satSend(t);
+  }
+}
+
+// ---------------------------------------------------------
+// Gateway
+// ---------------------------------------------------------
+// RAM is lost, the card and NVS (channel table) stay. Returns the samples
+// reloaded from the journal.
+static uint16_t gwReboot() {
+  memset(s_nodes, 0, sizeof(s_nodes));
+  s_ringHead = 0;
+  s_ringCount = 0;
+  s_ready = false;
+  gateway_init();
+  return s_ringCount;
+}
+
+// What the WiFi task and loop() do between two ticks
+static bool gwRun() {
+  try {
+    while (espnowhost_poll(GW_RX_QUEUE_LEN)) gateway_loop();
+    gateway_loop();
+  } catch (SdHostPowerCut &) {
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  std::string card = std::filesystem::temp_directory_path() / ("beehive_gw_" + std::to_string(getpid()));
+  sdhost_begin(card.c_str());
+  uint16_t base = 20000 + getpid() % 30000;
+  espnowhost_begin(base);
+  WiFi.hostMac[5] = GW_MAC_ID;
+  s_gwPort = espnowhost_port(WiFi.hostMac);
+  for (uint8_t n = 1; n <= NODES; ++n) CHECK(gateway_setNode(n, CHANNEL(n), "KEY"));
+  gateway_init();
+  CHECK(s_ready);
+
+  for (int i = 0; i < NODES; ++i) {
+    Sat &t = s_sats[i];
+    t.id = (uint8_t)(i + 1);
+    t.boot = (uint16_t)esp_random();
+    t.nextSampleMs = (unsigned long)i * 9000UL;       // spread over the interval
+    t.sock = socket(AF_INET, SOCK_DGRAM, 0);
+    uint8_t mac[6] = { 0x02, 0, 0, 0, 0, t.id };
+    sockaddr_in a = {};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(espnowhost_port(mac));
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(t.sock >= 0 && bind(t.sock, (sockaddr *)&a, sizeof(a)) == 0);
+  }
+
+  // the gateway gets its clock after 10 min, has no LTE in the second hour,
+  // reboots at 2.5 h and loses power during an SD write after 3 h
+  const unsigned long stopMs = 4 * HOUR_MS, endMs = stopMs + HOUR_MS / 2;
+  uint16_t reloaded = 0;
+  int cuts = 0;
+  bool rebooted = false, cutArmed = false;
+  auto t0 = std::chrono::steady_clock::now();
+  for (unsigned long now = 0; now < endMs; now = millis()) {
+    s_clock = now >= 600000UL;
+    s_lte = now < HOUR_MS || now >= 2 * HOUR_MS;
+    if (!rebooted && now >= 5 * HOUR_MS / 2) {
+      rebooted = true;
+      reloaded = gwReboot();
+    }
+    if (!cutArmed && now >= 3 * HOUR_MS) {
+      cutArmed = true;
+      sdhost_powerCutAfter(1000);
+    }
+    for (Sat &t : s_sats) satTick(t, now < stopMs);
+    if (!gwRun()) {
+      cuts++;
+      sdhost_powerCutAfter(-1);
+      gwReboot();
+    }
+    for (Sat &t : s_sats) satReceive(t);
+    delay(1000);
+  }
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  // the scenario happened
+  CHECK(s_noClock > 0 && s_ringFull > 0 && reloaded > 0 && cuts == 1);
+  CHECK(s_ringCount == 0);
+
+  uint32_t made = 0, packets = 0, bytes = 0, missing = 0, dups = 0;
+  size_t maxBacklog = 0;
+  for (const Sat &t : s_sats) {
+    CHECK(t.overflow == 0 && t.backlog.empty());
+    made += t.made;
+    packets += t.packets;
+    bytes += t.bytes;
+    if (t.maxBacklog > maxBacklog) maxBacklog = t.maxBacklog;
+    for (uint32_t k = 0; k < t.made; ++k) {
+      auto it = s_uploaded.find({ t.id, (long)k });
+      if (it == s_uploaded.end()) missing++;
+      else dups += it->second - 1;
+    }
+  }
+  CHECK(made == NODES * (stopMs / (GW_SAT_INTERVAL_S * 1000UL)));
+  CHECK(missing == 0 && s_uploaded.size() == made);
+  CHECK(s_untimed == 0);
+  CHECK(dups <= GW_RING_LEN);         // only around the power cut
+  CHECK(s_lteSessions * 10 < made);   // an order of magnitude fewer than one per sample
+
+  printf("%d nodes, %u samples in %.1f h: %u radio packets (%.1f samples, %.0f B each), largest backlog %zu\n",
+         NODES, made, stopMs / (double)HOUR_MS, packets, (double)made / packets, (double)bytes / packets,
+         maxBacklog);
+  printf("LTE sessions %u (one modem per hive: %u), bulk requests %u, duplicates %u; host %.0f samples/s\n",
+         s_lteSessions, made, s_bulkRequests, dups, made / secs);
+
+  for (Sat &t : s_sats) close(t.sock);
+  std::filesystem::remove_all(card);
+  return check_done("gateway");
+}
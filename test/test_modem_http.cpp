@@ -0,0 +1,182 @@
+// test_modem_http.cpp - mhttp_post() against a scripted A7670: every command
+// it sends is checked against the script, which answers with the modem's
+// replies, socket URCs mixed in.
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "../modem_http.h"
+#include "../modem_manager.h"
+
+struct Step {
+  std::string expect;                  // bytes mhttp_post must write
+  std::string reply;                   // what the modem answers
+};
+
+class FakeModem : public Stream {
+public:
+  void load(const std::vector<Step> &script) {
+    _script = script;
+    _next = 0;
+    _tx.clear();
+    _rx.clear();
+    _at = 0;
+    bad = false;
+  }
+  bool done() const { return _next == _script.size() && _tx.empty() && !bad; }
+
+  size_t write(uint8_t c) override {
+    _tx += (char)c;
+    if (_next == _script.size() || _script[_next].expect.compare(0, _tx.size(), _tx) != 0) {
+      if (c != '\n') return 1;        // report whole lines
+      printf("unexpected: %s", _tx.c_str());
+      bad = true;
+      _tx.clear();
+      return 1;
+    }
+    if (_tx == _script[_next].expect) {
+      _rx += _script[_next++].reply;
+      _tx.clear();
+    }
+    return 1;
+  }
+  using Print::write;
+  int available() override { return (int)(_rx.size() - _at); }
+  int read() override { return _at < _rx.size() ? (uint8_t)_rx[_at++] : -1; }
+  int peek() override { return _at < _rx.size() ? (uint8_t)_rx[_at] : -1; }
+
+  bool bad = false;
+
+private:
+  std::vector<Step> _script;
+  size_t _next = 0;
+  std::string _tx, _rx;
+  size_t _at = 0;
+};
+
+static FakeModem s_uart;
+static TinyGsm s_modem(s_uart);
+
+TinyGsm &modem_get() {
+  return s_modem;
+}
+
+static const char *OK = "\r\nOK\r\n";
+static const char *ERR = "\r\nERROR\r\n";
+
+// Session setup up to HTTPACTION, as the modem answers it for a good request
+static std::vector<Step> setup(const char *url, const std::string &body, bool https) {
+  std::vector<Step> s = { { "AT+HTTPTERM\r\n", ERR }, { "AT+HTTPINIT\r\n", OK } };
+  if (https) {
+    s.push_back({ "AT+CSSLCFG=\"sslversion\",0,4\r\n", OK });
+    s.push_back({ "AT+CSSLCFG=\"authmode\",0,0\r\n", OK });
+    s.push_back({ "AT+CSSLCFG=\"enableSNI\",0,1\r\n", OK });
+    s.push_back({ "AT+HTTPPARA=\"SSLCFG\",0\r\n", OK });
+  }
+  s.push_back({ std::string("AT+HTTPPARA=\"URL\",\"") + url + "\"\r\n", OK });
+  s.push_back({ "AT+HTTPPARA=\"CONTENT\",\"application/json\"\r\n", OK });
+  s.push_back({ "AT+HTTPDATA=" + std::to_string(body.size()) + ",5\r\n", "\r\nDOWNLOAD\r\n" });
+  s.push_back({ body, OK });
+  return s;
+}
+
+static int post(const char *url, const std::string &body, char *resp, size_t cap) {
+  s_modem.urcs.clear();
+  return mhttp_post(url, "application/json", body.data(), body.size(), resp, cap);
+}
+
+// https: TLS setup, the reply read back, URCs for the MQTT socket on the way
+static void testHttps() {
+  const char *url = "https://api.thingspeak.com/update.json";
+  std::string body = "{\"api_key\":\"KEY\",\"field1\":\"12.5\"}";
+  std::vector<Step> s = setup(url, body, true);
+  s.push_back({ "AT+HTTPACTION=1\r\n", "\r\nOK\r\n\r\n+CIPRXGET: 1,1\r\n\r\n+HTTPACTION: 1,200,4\r\n" });
+  s.push_back({ "AT+HTTPREAD=0,4\r\n", "\r\nOK\r\n\r\n+HTTPREAD: 4\r\n1234\r\n+IPCLOSE: 1,2\r\n\r\n+HTTPREAD: 0\r\n" });
+  s.push_back({ "AT+HTTPTERM\r\n", OK });
+  s_uart.load(s);
+
+  char resp[64];
+  CHECK(post(url, body, resp, sizeof(resp)) == 200);
+  CHECK(!strcmp(resp, "1234"));
+  CHECK(s_uart.done());
+  std::vector<std::string> want = { "+CIPRXGET: 1,1\r", "+IPCLOSE: 1,2\r" };
+  CHECK(s_modem.urcs == want);
+}
+
+// http: no TLS commands; the reply is cut to the buffer
+static void testCap() {
+  const char *url = "http://api.thingspeak.com/update";
+  std::string body = "api_key=KEY&field1=12.5";
+  std::vector<Step> s = setup(url, body, false);
+  s.push_back({ "AT+HTTPACTION=1\r\n", "\r\nOK\r\n\r\n+HTTPACTION: 1,200,4\r\n" });
+  s.push_back({ "AT+HTTPREAD=0,2\r\n", "\r\nOK\r\n\r\n+HTTPREAD: 2\r\n12\r\n+HTTPREAD: 0\r\n" });
+  s.push_back({ "AT+HTTPTERM\r\n", OK });
+  s_uart.load(s);
+
+  char resp[3];
+  CHECK(post(url, body, resp, sizeof(resp)) == 200);
+  CHECK(!strcmp(resp, "12") && s_uart.done());
+
+  // no reply body: nothing read
+  s = setup(url, body, false);
+  s.push_back({ "AT+HTTPACTION=1\r\n", "\r\nOK\r\n\r\n+HTTPACTION: 1,204,0\r\n" });
+  s.push_back({ "AT+HTTPTERM\r\n", OK });
+  s_uart.load(s);
+  char none[8] = "stale";
+  CHECK(post(url, body, none, sizeof(none)) == 204);
+  CHECK(none[0] == 0 && s_uart.done());
+}
+
+// Refused before HTTPACTION: MHTTP_NOT_SENT, and the session is closed
+static void testNotSent() {
+  const char *url = "http://example.com/x";
+  char resp[16];
+
+  s_uart.load({ { "AT+HTTPTERM\r\n", ERR }, { "AT+HTTPINIT\r\n", ERR }, { "AT+HTTPTERM\r\n", ERR } });
+  CHECK(post(url, "a", resp, sizeof(resp)) == MHTTP_NOT_SENT && s_uart.done());
+
+  std::vector<Step> s = setup(url, "abc", false);
+  s.pop_back();
+  s.back().reply = ERR;                // no DOWNLOAD prompt
+  s.push_back({ "AT+HTTPTERM\r\n", OK });
+  s_uart.load(s);
+  CHECK(post(url, "abc", resp, sizeof(resp)) == MHTTP_NOT_SENT && s_uart.done());
+
+  // a URL that does not fit the command is never sent
+  std::string longUrl = "http://example.com/" + std::string(150, 'a');
+  s_uart.load({ { "AT+HTTPTERM\r\n", ERR }, { "AT+HTTPINIT\r\n", OK }, { "AT+HTTPTERM\r\n", OK } });
+  CHECK(post(longUrl.c_str(), "a", resp, sizeof(resp)) == MHTTP_NOT_SENT && s_uart.done());
+}
+
+// Sent, but no usable answer: 0, never a retry over another transport
+static void testNoAnswer() {
+  const char *url = "https://example.com/x";
+  char resp[16];
+
+  // 7xx: the modem's own error (here a TLS handshake failure)
+  std::vector<Step> s = setup(url, "abc", true);
+  s.push_back({ "AT+HTTPACTION=1\r\n", "\r\nOK\r\n\r\n+HTTPACTION: 1,715,0\r\n" });
+  s.push_back({ "AT+HTTPTERM\r\n", OK });
+  s_uart.load(s);
+  CHECK(post(url, "abc", resp, sizeof(resp)) == 0 && resp[0] == 0 && s_uart.done());
+
+  // no +HTTPACTION within MODEM_HTTP_ACTION_MS
+  s = setup(url, "abc", true);
+  s.push_back({ "AT+HTTPACTION=1\r\n", "\r\nOK\r\n\r\n+CIPRXGET: 1,1\r\n" });
+  s.push_back({ "AT+HTTPTERM\r\n", OK });
+  s_uart.load(s);
+  unsigned long t0 = millis();
+  CHECK(post(url, "abc", resp, sizeof(resp)) == 0 && s_uart.done());
+  CHECK(millis() - t0 >= MODEM_HTTP_ACTION_MS);
+  CHECK(s_modem.urcs.size() == 1);
+}
+
+int main() {
+  s_uart.setTimeout(1000);
+  testHttps();
+  testCap();
+  testNotSent();
+  testNoAnswer();
+  return check_done("modem_http");
+}
@@ -0,0 +1,311 @@
+// test_mqtt_sink.cpp - the MQTT sink, driven by sinks_loop() over the SD
+// queue, against a broker stand-in that decodes what the sink writes and
+// answers as scripted: CONNACK codes, PUBACKs for only some publishes,
+// ignored pings, dropped connections.
+
+#include <Arduino.h>
+#include <SD.h>
+#include <WiFi.h>
+#include <TinyGsmClient.h>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "check.h"
+#include "../mqtt_sink.h"
+#include "../ts_queue.h"
+#include "../upload_scheduler.h"
+
+namespace fs = std::filesystem;
+
+class Broker : public Client {
+public:
+  // script
+  uint8_t  connackRc = 0;
+  int      acksLeft = -1;              // PUBACK only this many more publishes (-1: all)
+  std::set<uint16_t> extraAcks;        // ...and these packet ids
+  bool     answerPings = true;
+
+  // what it saw
+  int      tcpConnects = 0, sessions = 0, pings = 0;
+  std::vector<std::string> payloads;   // every PUBLISH, resends included
+  std::string clientId, topic;
+  uint16_t keepalive = 0;
+  uint8_t  connectFlags = 0;
+
+  int connect(const char *host, uint16_t port) override {
+    CHECK(!strcmp(host, MQTT_HOST) && port == MQTT_PORT);
+    tcpConnects++;
+    _up = true;
+    _rx.clear();
+    _tx.clear();
+    _at = 0;
+    return 1;
+  }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buf, size_t size) override {
+    if (!_up) return 0;
+    _rx.append((const char *)buf, size);
+    while (parse()) {}
+    return size;
+  }
+  int available() override { return (int)(_tx.size() - _at); }
+  int read() override { return _at < _tx.size() ? (uint8_t)_tx[_at++] : -1; }
+  int read(uint8_t *buf, size_t size) override {
+    size_t n = 0;
+    while (n < size && _at < _tx.size()) buf[n++] = (uint8_t)_tx[_at++];
+    return (int)n;
+  }
+  int peek() override { return _at < _tx.size() ? (uint8_t)_tx[_at] : -1; }
+  void flush() override {}
+  void stop() override { _up = false; }
+  uint8_t connected() override { return _up; }
+  operator bool() override { return _up; }
+
+  void drop() { _up = false; }          // the broker or the network closes the session
+
+private:
+  bool _up = false;
+  std::string _rx, _tx;                 // from / to the sink
+  size_t _at = 0;
+
+  static uint16_t u16(const std::string &b, size_t at) { return (uint8_t)b[at] << 8 | (uint8_t)b[at + 1]; }
+
+  void send(std::initializer_list<uint8_t> pkt) { _tx.append(pkt.begin(), pkt.end()); }
+
+  // Handle one whole packet from _rx; false if none is complete yet
+  bool parse() {
+    size_t at = 1;
+    uint32_t rem = 0;
+    for (int shift = 0;; shift += 7) {
+      if (at >= _rx.size()) return false;
+      uint8_t b = _rx[at++];
+      rem |= (uint32_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) break;
+    }
+    if (_rx.size() < at + rem) return false;
+    uint8_t type = _rx[0];
+    std::string body = _rx.substr(at, rem);
+    _rx.erase(0, at + rem);
+
+    if (type == 0x10) {
+      CHECK(body.compare(0, 7, std::string("\0\4MQTT\4", 7)) == 0);
+      connectFlags = body[7];
+      keepalive = u16(body, 8);
+      clientId = body.substr(12, u16(body, 10));
+      if (!connackRc) sessions++;
+      send({ 0x20, 2, 0, connackRc });
+    } else if (type == 0x32) {
+      size_t tl = u16(body, 0);
+      topic = body.substr(2, tl);
+      uint16_t id = u16(body, 2 + tl);
+      payloads.push_back(body.substr(4 + tl));
+      if (acksLeft != 0 || extraAcks.count(id)) send({ 0x40, 2, (uint8_t)(id >> 8), (uint8_t)id });
+      if (acksLeft > 0) acksLeft--;
+    } else if (type == 0xC0) {
+      pings++;
+      if (answerPings) send({ 0xD0, 0 });
+    } else if (type == 0xE0) {
+      _up = false;
+    }
+    return true;
+  }
+};
+
+static Broker s_wifiBroker, s_lteBroker;
+
+// ---------------------------------------------------------
+// What the sinks link against
+// ---------------------------------------------------------
+static bool s_lte = false;
+static TinyGsm *s_modem;
+
+bool modem_isNetworkRegistered() {
+  return s_lte;
+}
+TinyGsm &modem_get() {
+  return *s_modem;
+}
+bool sched_uploadAllowed() {
+  return true;
+}
+void sched_noteSend(uint32_t, uint8_t) {}
+
+static bool off() { return false; }
+const TelemetrySink &thingspeak_sink() {
+  static const TelemetrySink sink = { "thingspeak", off, off, nullptr, nullptr, 1, 0, 1000, 1000 };
+  return sink;
+}
+const TelemetrySink &http_sink() {
+  static const TelemetrySink sink = { "http", off, off, nullptr, nullptr, 1, 0, 1000, 1000 };
+  return sink;
+}
+
+// ---------------------------------------------------------
+static uint32_t s_next = 0;
+
+static TelemetrySample mk(uint32_t i) {
+  TelemetrySample s = {};
+  s.ts = 1717200000u + i * 300u;
+  for (int c = 0; c < CH_COUNT; ++c) s.v[c] = (int32_t)(i * 10 + c) * (c % 2 ? -1 : 1);
+  return s;
+}
+
+static std::string payloadOf(uint32_t i) {
+  TelemetrySample s = mk(i);
+  std::string p = std::to_string(s.ts);
+  for (int c = 0; c < CH_COUNT; ++c) p += "," + std::to_string(s.v[c]);
+  return p;
+}
+
+// Queue samples for the next sinks_loop() pass
+static void queue(uint32_t n) {
+  for (uint32_t k = 0; k < n; ++k) CHECK(tsq_push(mk(s_next++)));
+}
+
+// A fresh sample, as loop() publishes it: sent right away
+static void publish() {
+  CHECK(sinks_publish(mk(s_next++)));
+}
+
+// Run the loop for ms of virtual time, a tick every 100 ms
+static void run(unsigned long ms) {
+  unsigned long end = millis() + ms;
+  while ((long)(millis() - end) < 0) {
+    sinks_loop();
+    delay(100);
+  }
+}
+
+static uint32_t failures() {
+  SinkStats st;
+  sinks_stats(SINK_MQTT, st);
+  return st.failed;
+}
+
+// CONNECT / CONNACK, then one pipelined batch of QoS 1 publishes
+static void testConnectPublish() {
+  queue(5);
+  run(100);
+  CHECK(s_wifiBroker.tcpConnects == 1 && s_wifiBroker.sessions == 1 && mqtt_isConnected());
+  CHECK(s_wifiBroker.clientId == sinks_deviceId() && s_wifiBroker.clientId == "bh-a1b2c3");
+  CHECK(s_wifiBroker.keepalive == MQTT_KEEPALIVE_S && s_wifiBroker.connectFlags == 0x02);
+  CHECK(s_wifiBroker.topic == "beehive/bh-a1b2c3/t");
+  std::vector<std::string> want;
+  for (uint32_t i = 0; i < 5; ++i) want.push_back(payloadOf(i));
+  CHECK(s_wifiBroker.payloads == want);
+  CHECK(tsq_pending(SINK_MQTT) == 0);
+}
+
+// Only some PUBACKs come back: the queue moves past the leading acked
+// samples only, the session is dropped and the rest is sent again
+static void testPartialAck() {
+  s_wifiBroker.payloads.clear();
+  s_wifiBroker.acksLeft = 4;
+  s_wifiBroker.extraAcks = { 5 + 7, 5 + 8 };   // the 7th and 8th of this batch, not the 5th
+  uint32_t from = s_next;
+  queue(10);
+  uint32_t failed = failures();
+  run(100);
+  CHECK(s_wifiBroker.payloads.size() == 10);
+  CHECK(tsq_pending(SINK_MQTT) == 6);
+  CHECK(failures() == failed + 1 && !mqtt_isConnected());
+
+  // after the retry backoff a new session resends from the first unacked sample
+  s_wifiBroker.acksLeft = -1;
+  s_wifiBroker.extraAcks.clear();
+  run(9000);
+  CHECK(tsq_pending(SINK_MQTT) == 6 && s_wifiBroker.tcpConnects == 1);
+  run(2000);
+  CHECK(tsq_pending(SINK_MQTT) == 0 && s_wifiBroker.tcpConnects == 2 && mqtt_isConnected());
+  std::vector<std::string> resent(s_wifiBroker.payloads.begin() + 10, s_wifiBroker.payloads.end());
+  std::vector<std::string> want;
+  for (uint32_t i = from + 4; i < from + 10; ++i) want.push_back(payloadOf(i));
+  CHECK(resent == want);
+}
+
+// A refused CONNECT publishes nothing and moves nothing
+static void testRefused() {
+  s_wifiBroker.drop();
+  run(100);
+  s_wifiBroker.connackRc = 5;          // not authorised
+  size_t seen = s_wifiBroker.payloads.size();
+  uint32_t failed = failures();
+  queue(2);
+  publish();
+  CHECK(!mqtt_isConnected() && s_wifiBroker.payloads.size() == seen);
+  CHECK(tsq_pending(SINK_MQTT) == 3 && failures() == failed + 1);
+  s_wifiBroker.connackRc = 0;
+  run(5000);
+  CHECK(tsq_pending(SINK_MQTT) == 3);  // still in the retry backoff
+  run(6000);
+  CHECK(tsq_pending(SINK_MQTT) == 0 && mqtt_isConnected());
+}
+
+// PINGREQ at half the keepalive; a broker that stops answering is dropped
+// and the next sample opens a new session
+static void testKeepalive() {
+  publish();
+  int pings = s_wifiBroker.pings;
+  run(MQTT_KEEPALIVE_S * 1000UL / 2 + 500);
+  CHECK(s_wifiBroker.pings == pings + 1 && mqtt_isConnected());
+  run(MQTT_KEEPALIVE_S * 1000UL / 2);
+  CHECK(s_wifiBroker.pings == pings + 2 && mqtt_isConnected());
+
+  s_wifiBroker.answerPings = false;
+  run(MQTT_KEEPALIVE_S * 1000UL / 2 + MQTT_ACK_TIMEOUT_MS + 500);
+  CHECK(!mqtt_isConnected());
+  s_wifiBroker.answerPings = true;
+
+  int sessions = s_wifiBroker.sessions;
+  publish();
+  CHECK(s_wifiBroker.sessions == sessions + 1 && tsq_pending(SINK_MQTT) == 0);
+
+  // the network drops the session: noticed by the loop, reopened on the next sample
+  s_wifiBroker.drop();
+  run(100);
+  CHECK(!mqtt_isConnected());
+  publish();
+  CHECK(s_wifiBroker.sessions == sessions + 2 && mqtt_isConnected());
+}
+
+// No WiFi: the session moves to the modem socket, and back once WiFi returns
+static void testLinks() {
+  WiFi.hostStatus = WL_DISCONNECTED;
+  s_lte = true;
+  run(100);
+  CHECK(!mqtt_isConnected());
+  publish();
+  publish();
+  CHECK(s_lteBroker.sessions == 1 && s_lteBroker.payloads.size() == 2 && tsq_pending(SINK_MQTT) == 0);
+
+  WiFi.hostStatus = WL_CONNECTED;
+  run(100);
+  CHECK(!mqtt_isConnected() && !s_lteBroker.connected());
+  int sessions = s_wifiBroker.sessions;
+  publish();
+  CHECK(s_wifiBroker.sessions == sessions + 1 && s_lteBroker.sessions == 1 && tsq_pending(SINK_MQTT) == 0);
+}
+
+int main() {
+  std::string card = fs::temp_directory_path() / ("beehive_mqtt_" + std::to_string(getpid()));
+  sdhost_begin(card.c_str());
+  uint8_t mac[6] = { 0x24, 0x6f, 0x28, 0xa1, 0xb2, 0xc3 };
+  memcpy(WiFi.hostMac, mac, 6);
+  WiFi.hostStatus = WL_CONNECTED;
+  WiFiClient::hostPeer = &s_wifiBroker;
+  TinyGsmClient::hostPeer = &s_lteBroker;
+  s_modem = new TinyGsm(Serial);
+
+  tsq_init();
+  sinks_init();
+  testConnectPublish();
+  testPartialAck();
+  testRefused();
+  testKeepalive();
+  testLinks();
+
+  fs::remove_all(card);
+  return check_done("mqtt_sink");
+}
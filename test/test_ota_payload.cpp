@@ -0,0 +1,261 @@
+// test_ota_payload.cpp - tools/ota_pack.py output through ota_payload.cpp.
+//
+// Builds two app images in esptool's layout (segments, checksum, appended
+// SHA-256), packs the newer one raw, zlib and as a delta against the older
+// one with the real packer, and decodes each payload as a transport would
+// deliver it: in uneven reads, across dropped links resumed at the byte
+// offset, cut short, and corrupted.
+
+#include <Arduino.h>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <openssl/sha.h>
+#include <esp_ota_ops.h>
+#include "check.h"
+#include "../ota_payload.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+static uint32_t s_rng = 1;
+static uint32_t rnd() {
+  s_rng = s_rng * 1103515245u + 12345u;
+  return s_rng >> 8;
+}
+
+// ---------------------------------------------------------
+// esptool images
+// ---------------------------------------------------------
+struct Segment {
+  uint32_t addr;
+  Bytes data;
+};
+
+// header, segments, zero padding up to the checksum byte, then the digest
+static Bytes esptoolImage(const std::vector<Segment> &segs, bool appendDigest) {
+  Bytes img(24, 0);
+  img[0] = 0xE9;
+  img[1] = (uint8_t)segs.size();
+  img[2] = 2;                          // DIO
+  img[3] = 0x20;                       // 4 MB, 40 MHz
+  uint32_t entry = 0x40080000;
+  memcpy(&img[4], &entry, 4);
+  img[8] = 0xEE;                       // no WP pin
+  img[23] = appendDigest ? 1 : 0;
+  uint8_t checksum = 0xEF;
+  for (const Segment &s : segs) {
+    uint32_t len = (uint32_t)s.data.size();
+    img.insert(img.end(), (const uint8_t *)&s.addr, (const uint8_t *)&s.addr + 4);
+    img.insert(img.end(), (const uint8_t *)&len, (const uint8_t *)&len + 4);
+    img.insert(img.end(), s.data.begin(), s.data.end());
+    for (uint8_t b : s.data) checksum ^= b;
+  }
+  img.resize((img.size() | 15), 0);
+  img.push_back(checksum);
+  if (appendDigest) {
+    uint8_t sha[32];
+    SHA256(img.data(), img.size(), sha);
+    img.insert(img.end(), sha, sha + 32);
+  }
+  return img;
+}
+
+// Code-like bytes: instructions drawn from a small vocabulary
+static Bytes code(size_t n) {
+  static uint8_t ops[64][3];
+  static bool init = false;
+  if (!init) {
+    for (auto &op : ops) for (uint8_t &b : op) b = (uint8_t)rnd();
+    init = true;
+  }
+  Bytes b;
+  while (b.size() < n) {
+    const uint8_t *op = ops[rnd() % 64];
+    b.insert(b.end(), op, op + 3);
+    if (rnd() % 4 == 0) b.push_back((uint8_t)rnd());     // immediate operand
+  }
+  b.resize(n & ~(size_t)3);
+  return b;
+}
+
+static Bytes text(const char *s, size_t n) {
+  Bytes b;
+  while (b.size() < n) b.insert(b.end(), s, s + strlen(s) + 1);
+  b.resize(n & ~(size_t)3);
+  return b;
+}
+
+static std::vector<Segment> s_baseSegs;
+
+static Bytes baseImage() {
+  s_baseSegs = {
+    { 0x3F400020, text("[OTA] payload %lu bytes, sha256 %s\n", 24000) },
+    { 0x3FFB0000, code(4000) },
+    { 0x40080000, code(40000) },
+    { 0x400D0020, code(120000) },
+  };
+  return esptoolImage(s_baseSegs, true);
+}
+
+// The next release: relocated addresses, a function inserted, a new string
+static Bytes newImage() {
+  std::vector<Segment> segs = s_baseSegs;
+  Bytes &irom = segs[3].data;
+  for (int i = 0; i < 40; ++i) {
+    size_t at = rnd() % (irom.size() - 4);
+    for (int k = 0; k < 4; ++k) irom[at + k] += (uint8_t)(1 + k);
+  }
+  Bytes fn = code(640);
+  irom.insert(irom.begin() + irom.size() / 2, fn.begin(), fn.end());
+  Bytes s = text("[OTA] resumed at %lu\n", 64);
+  segs[0].data.insert(segs[0].data.begin() + 4096, s.begin(), s.end());
+  segs[2].data[100] ^= 0x5A;
+  return esptoolImage(segs, true);
+}
+
+// ---------------------------------------------------------
+// Packing with tools/ota_pack.py
+// ---------------------------------------------------------
+static std::string s_dir;
+
+static void writeFile(const std::string &path, const Bytes &b) {
+  std::ofstream f(path, std::ios::binary);
+  f.write((const char *)b.data(), b.size());
+}
+
+static Bytes readFile(const std::string &path) {
+  std::ifstream f(path, std::ios::binary);
+  return Bytes(std::istreambuf_iterator<char>(f), {});
+}
+
+// Returns the payload, empty if the packer refused
+static Bytes pack(const Bytes &image, const Bytes *base) {
+  writeFile(s_dir + "/new.bin", image);
+  std::string cmd = std::string(PYTHON3) + " " OTA_PACK_PY " " + s_dir + "/new.bin -o " + s_dir + "/out.ota";
+  if (base) {
+    writeFile(s_dir + "/base.bin", *base);
+    cmd += " --base " + s_dir + "/base.bin";
+  }
+  unlink((s_dir + "/out.ota").c_str());
+  if (system((cmd + " > " + s_dir + "/pack.log 2>&1").c_str()) != 0) return Bytes();
+  return readFile(s_dir + "/out.ota");
+}
+
+// ---------------------------------------------------------
+// Decoding
+// ---------------------------------------------------------
+static Bytes s_out;
+
+static bool collect(const uint8_t *data, size_t len) {
+  s_out.insert(s_out.end(), data, data + len);
+  return true;
+}
+
+// Deliver the payload as sessions of uneven reads that may drop. A dropped
+// link resumes at the next byte, with a Range request or by skipping what
+// was already fed (ota_update.cpp), so the decoder sees one unbroken stream.
+static bool decode(const Bytes &payload, size_t maxRead, bool drops) {
+  s_out.clear();
+  otap_begin(collect);
+  size_t at = 0;
+  bool ok = true;
+  while (ok && at < payload.size()) {
+    size_t session = drops ? 1 + rnd() % 20000 : payload.size();
+    while (ok && session && at < payload.size()) {
+      size_t n = 1 + rnd() % maxRead;
+      if (n > session) n = session;
+      if (n > payload.size() - at) n = payload.size() - at;
+      ok = otap_feed(payload.data() + at, n);
+      at += n;
+      session -= n;
+    }
+  }
+  ok = ok && otap_finish();
+  otap_end();
+  return ok;
+}
+
+static bool isPrefix(const Bytes &out, const Bytes &image) {
+  return out.size() <= image.size() && std::equal(out.begin(), out.end(), image.begin());
+}
+
+static void checkDecodes(const char *name, const Bytes &payload, const Bytes &image, OtaPayloadFormat format) {
+  for (int run = 0; run < 12; ++run) {
+    size_t maxRead = run == 0 ? 1 : run < 6 ? 1460 : 4096;   // byte by byte, TCP segments, SD reads
+    bool ok = decode(payload, maxRead, run % 2);
+    CHECK(ok && otap_format() == format && s_out == image);
+    if (!ok) printf("%s run %d: %s\n", name, run, otap_error());
+  }
+  if (format == OTAP_DELTA) CHECK(otap_targetBytes() == image.size());
+
+  // raw images are only checked by esp_ota_end(), not here
+  if (format == OTAP_RAW) return;
+
+  // cut short anywhere: never finishes, never emits anything but a prefix
+  for (size_t cut = 0; cut < payload.size(); cut += 1 + payload.size() / 97) {
+    Bytes part(payload.begin(), payload.begin() + cut);
+    bool ok = decode(part, 1460, false);
+    CHECK(!ok && isPrefix(s_out, image));
+  }
+  // corrupted anywhere: refused
+  for (size_t at = 2; at < payload.size(); at += 1 + payload.size() / 31) {
+    Bytes bad = payload;
+    bad[at] ^= 0x08;
+    CHECK(!decode(bad, 1460, false));
+  }
+}
+
+static void bench(const char *name, const Bytes &payload, size_t imageBytes) {
+  auto t0 = std::chrono::steady_clock::now();
+  const int rounds = 5;
+  for (int i = 0; i < rounds; ++i) decode(payload, 1460, false);
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() / rounds;
+  printf("%-5s payload %7zu B (%5.1f%% of image), host decode %6.1f MB/s of image\n", name, payload.size(),
+         100.0 * payload.size() / imageBytes, imageBytes / s / 1e6);
+}
+
+int main() {
+  char dir[] = "/tmp/beehive_ota_XXXXXX";
+  s_dir = mkdtemp(dir);
+
+  Bytes base = baseImage();
+  Bytes image = newImage();
+  esphost_setRunning(base.data(), base.size(), 0x140000);
+
+  // the running slot reports the digest esptool appended to its image
+  uint8_t sha[32];
+  CHECK(esp_partition_get_sha256(nullptr, sha) != ESP_OK);
+  CHECK(esp_partition_get_sha256(esp_ota_get_running_partition(), sha) == ESP_OK);
+  CHECK(!memcmp(sha, &base[base.size() - 32], 32));
+
+  Bytes zlib = pack(image, nullptr);
+  Bytes delta = pack(image, &base);
+  CHECK(!zlib.empty() && !delta.empty());
+  if (zlib.empty() || delta.empty()) return check_done("ota_payload");
+  CHECK(!memcmp(&delta[12], &base[base.size() - 32], 32));
+
+  checkDecodes("raw", image, image, OTAP_RAW);
+  checkDecodes("zlib", zlib, image, OTAP_ZLIB);
+  checkDecodes("delta", delta, image, OTAP_DELTA);
+
+  // a delta for another firmware is refused at its header
+  esphost_setRunning(image.data(), image.size(), 0x140000);
+  CHECK(!decode(delta, 1460, false) && s_out.empty());
+  CHECK(!strcmp(otap_error(), "delta was made for another firmware"));
+  esphost_setRunning(base.data(), base.size(), 0x140000);
+
+  // the packer only takes a base that carries its digest
+  Bytes bare = esptoolImage(s_baseSegs, false);
+  CHECK(pack(image, &bare).empty());
+
+  bench("zlib", zlib, image.size());
+  bench("delta", delta, image.size());
+  printf("image %zu B; decoder RAM: %lu B window + tinfl state, %u B base buffer\n", image.size(),
+         1UL << OTA_INFLATE_WINDOW_BITS, OTA_PAYLOAD_BASE_BYTES);
+
+  system(("rm -rf " + s_dir).c_str());
+  return check_done("ota_payload");
+}
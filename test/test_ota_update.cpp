@@ -0,0 +1,395 @@
+// test_ota_update.cpp - the streaming OTA writer and POST /ota against the
+// host update slot (esp_host.cpp): whole and uneven writes, announced
+// length and SHA-256 checks, an image esp_ota_end() rejects, uploads cut
+// off and resumed with X-OTA-Offset, and the health check that confirms or
+// rolls back a trial boot.
+//
+// ota_update.cpp is compiled into this file to reach the health check and
+// to clear OTA_DONE, which on the device only a reboot does.
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include <openssl/sha.h>
+#include <zlib.h>
+#include "check.h"
+#include "../ota_update.cpp"
+
+typedef std::vector<uint8_t> Bytes;
+
+#define SLOT_BYTES 0x40000
+
+static uint32_t s_rng = 7;
+static uint32_t rnd() {
+  s_rng = s_rng * 1103515245u + 12345u;
+  return s_rng >> 8;
+}
+
+// An esptool image: header, segments, padding to the checksum, digest
+static Bytes image(size_t segBytes) {
+  Bytes img(24, 0);
+  img[0] = 0xE9;
+  img[1] = 3;
+  img[23] = 1;
+  uint8_t checksum = 0xEF;
+  for (uint32_t seg = 0; seg < 3; ++seg) {
+    uint32_t addr = 0x40080000 + seg * 0x10000, len = (uint32_t)(segBytes & ~(size_t)3);
+    img.insert(img.end(), (const uint8_t *)&addr, (const uint8_t *)&addr + 4);
+    img.insert(img.end(), (const uint8_t *)&len, (const uint8_t *)&len + 4);
+    for (uint32_t i = 0; i < len; ++i) {
+      uint8_t b = (uint8_t)(rnd() % 16);    // compressible, like code
+      img.push_back(b);
+      checksum ^= b;
+    }
+  }
+  img.resize(img.size() | 15, 0);
+  img.push_back(checksum);
+  uint8_t sha[32];
+  SHA256(img.data(), img.size(), sha);
+  img.insert(img.end(), sha, sha + 32);
+  return img;
+}
+
+static std::string shaHex(const Bytes &b) {
+  uint8_t sha[32];
+  SHA256(b.data(), b.size(), sha);
+  char hex[65];
+  for (int i = 0; i < 32; ++i) snprintf(hex + 2 * i, 3, "%02x", sha[i]);
+  return hex;
+}
+
+static Bytes deflate(const Bytes &b) {
+  uLongf n = compressBound(b.size());
+  Bytes out(n);
+  CHECK(compress2(out.data(), &n, b.data(), b.size(), 9) == Z_OK);
+  out.resize(n);
+  return out;
+}
+
+static bool slotHolds(const Bytes &img) {
+  size_t n;
+  const uint8_t *p = esphost_updateSlot(&n);
+  return n == img.size() && !memcmp(p, img.data(), n);
+}
+
+static bool bootsUpdate() {
+  return esp_ota_get_boot_partition() == esp_ota_get_next_update_partition(nullptr);
+}
+
+// After OTA_DONE the device reboots; here the writer is simply idle again
+static void rebooted() {
+  s_state = OTA_IDLE;
+  esphost_resetOta(SLOT_BYTES, ESP_OTA_IMG_VALID);
+}
+
+// ---------------------------------------------------------
+// What ota_update.cpp links against
+// ---------------------------------------------------------
+static bool s_wifi = false, s_modemReady = false;
+static uint32_t s_sent = 0;
+static TinyGsm *s_modem;
+
+bool wifi_isConnected() {
+  return s_wifi;
+}
+bool modem_isReady() {
+  return s_modemReady;
+}
+TinyGsm &modem_get() {
+  return *s_modem;
+}
+bool sinks_stats(uint8_t sink, SinkStats &out) {
+  if (sink != SINK_HTTP) return false;
+  out = { "http", true, s_sent, 0 };
+  return true;
+}
+
+struct Route {
+  std::string uri;
+  httpd_method_t method;
+  HttpHandler handler;
+};
+static std::vector<Route> s_routes;
+
+bool http_on(const char *uri, httpd_method_t method, HttpHandler handler) {
+  s_routes.push_back({ uri, method, handler });
+  return true;
+}
+esp_err_t http_sendStatus(httpd_req_t *req, const char *status, const char *json) {
+  req->hostStatus = status;
+  req->hostReply = json ? json : "";
+  return ESP_OK;
+}
+
+static httpd_req_t request(httpd_method_t method, httpd_req_t req) {
+  req.method = method;
+  bool routed = false;
+  for (const Route &r : s_routes) {
+    if (r.uri == "/ota" && r.method == method && !routed) {
+      r.handler(&req);
+      routed = true;
+    }
+  }
+  CHECK(routed);
+  return req;
+}
+
+// POST /ota announcing len bytes from payload[from], of which the client
+// gets sent through before the link does end (0: closed)
+static httpd_req_t upload(const Bytes &payload, size_t from, size_t len, size_t sent, bool resume,
+                          const std::string &sha = "", int end = 0) {
+  httpd_req_t req;
+  req.hostHeaders["X-OTA-Key"] = OTA_PASSWORD;
+  if (resume) req.hostHeaders["X-OTA-Offset"] = std::to_string(from);
+  else if (!sha.empty()) req.hostHeaders["X-SHA256"] = sha;
+  req.content_len = len;
+  size_t n = std::min(sent, payload.size() - std::min(from, payload.size()));
+  req.hostBody.assign((const char *)payload.data() + from, n);
+  req.hostEnd = end;
+  return request(HTTP_POST, req);
+}
+
+static uint32_t replyOffset(const httpd_req_t &req) {
+  size_t at = req.hostReply.find("\"offset\":");
+  return at == std::string::npos ? UINT32_MAX : strtoul(req.hostReply.c_str() + at + 9, nullptr, 10);
+}
+
+static bool replied(const httpd_req_t &req, const char *status, const char *result) {
+  return req.hostStatus == status && req.hostReply.find(std::string("\"status\":\"") + result + "\"") != std::string::npos;
+}
+
+// ---------------------------------------------------------
+// Writer
+// ---------------------------------------------------------
+static void testWriter(const Bytes &img) {
+  std::string sha = shaHex(img);
+
+  // uneven writes; the offset counts the payload accepted
+  CHECK(ota_begin(img.size(), sha.c_str()) && ota_state() == OTA_RECEIVING && ota_offset() == 0);
+  size_t at = 0;
+  bool offsets = true;
+  while (at < img.size()) {
+    size_t n = std::min<size_t>(1 + rnd() % 3000, img.size() - at);
+    CHECK(ota_write(&img[at], n));
+    at += n;
+    offsets &= ota_offset() == at;
+  }
+  CHECK(offsets);
+  CHECK(ota_finish() && ota_state() == OTA_DONE);
+  CHECK(slotHolds(img) && bootsUpdate() && sha == s_digest);
+  CHECK(!ota_begin(img.size(), nullptr));      // nothing more until the reboot
+
+  // ota_loop() reboots two seconds later
+  int restarts = ESP.hostRestarts;
+  delay(1000);
+  ota_loop();
+  CHECK(ESP.hostRestarts == restarts);
+  delay(1000);
+  ota_loop();
+  CHECK(ESP.hostRestarts == restarts + 1);
+  rebooted();
+
+  // no size, no SHA-256: the image is checked by esp_ota_end() only
+  CHECK(ota_begin(0, nullptr));
+  CHECK(ota_write(img.data(), img.size()) && ota_finish() && slotHolds(img) && bootsUpdate());
+  rebooted();
+
+  // longer than announced: refused at the byte that overruns
+  CHECK(ota_begin(img.size() - 1, nullptr));
+  CHECK(!ota_write(img.data(), img.size()) && ota_state() == OTA_FAILED);
+  CHECK(!strcmp(s_error, "payload longer than announced") && !bootsUpdate());
+  CHECK(!ota_write(img.data(), 1) && !ota_finish());
+
+  // shorter than announced
+  CHECK(ota_begin(img.size(), sha.c_str()));
+  CHECK(ota_write(img.data(), img.size() - 100) && ota_offset() == img.size() - 100);
+  CHECK(!ota_finish() && !strcmp(s_error, "payload truncated") && !bootsUpdate());
+
+  // wrong SHA-256: the slot is written, but never selected
+  std::string other = shaHex(Bytes(img.begin(), img.end() - 1));
+  CHECK(ota_begin(img.size(), other.c_str()));
+  CHECK(ota_write(img.data(), img.size()));
+  CHECK(!ota_finish() && !strcmp(s_error, "SHA-256 mismatch") && !bootsUpdate());
+  CHECK(ota_state() == OTA_FAILED && sha == s_digest);
+
+  // a malformed hash, a payload larger than the slot
+  CHECK(!ota_begin(img.size(), "12ab") && !strcmp(s_error, "bad SHA-256"));
+  CHECK(!ota_begin(img.size(), std::string(64, 'g').c_str()));
+  CHECK(!ota_begin(SLOT_BYTES + 1, nullptr) && !strcmp(s_error, "payload larger than the slot"));
+
+  // the payload matches its hash, but esp_ota_end() rejects the image
+  Bytes bad = img;
+  bad[100] ^= 1;
+  CHECK(ota_begin(bad.size(), shaHex(bad).c_str()));
+  CHECK(ota_write(bad.data(), bad.size()));
+  CHECK(!ota_finish() && !strcmp(s_error, "ESP_ERR_OTA_VALIDATE_FAILED") && !bootsUpdate());
+
+  // ota_abort() closes an open image, a new ota_begin() replaces it
+  CHECK(ota_begin(img.size(), nullptr) && ota_write(img.data(), 1000));
+  ota_abort("test");
+  CHECK(ota_state() == OTA_FAILED && !strcmp(s_error, "test"));
+  CHECK(ota_begin(img.size(), nullptr) && ota_write(img.data(), 1000));
+  CHECK(ota_begin(img.size(), sha.c_str()) && ota_offset() == 0);
+  CHECK(ota_write(img.data(), img.size()) && ota_finish() && slotHolds(img));
+  rebooted();
+}
+
+// ---------------------------------------------------------
+// POST /ota
+// ---------------------------------------------------------
+static void testUpload(const Bytes &img) {
+  std::string sha = shaHex(img);
+  size_t size = img.size();
+
+  // key and body are checked before anything is opened
+  httpd_req_t req;
+  CHECK(request(HTTP_POST, req).hostStatus == "403 Forbidden");
+  req.hostHeaders["X-OTA-Key"] = "hive-kez";
+  CHECK(request(HTTP_POST, req).hostStatus == "403 Forbidden");
+  req.hostHeaders["X-OTA-Key"] = OTA_PASSWORD;
+  CHECK(request(HTTP_POST, req).hostStatus == "400 Bad Request");
+  CHECK(ota_state() == OTA_IDLE);
+
+  // one request
+  CHECK(replied(upload(img, 0, size, size, false, sha), "200 OK", "rebooting"));
+  CHECK(slotHolds(img) && bootsUpdate());
+  rebooted();
+
+  // the link drops: the image stays open at the bytes that arrived
+  req = upload(img, 0, size, 20000, false, sha);
+  CHECK(replied(req, "408 Request Timeout", "partial") && replyOffset(req) == 20000);
+  CHECK(ota_state() == OTA_RECEIVING && ota_offset() == 20000);
+  req = request(HTTP_GET, httpd_req_t());
+  CHECK(req.hostStatus == "200 OK" && replyOffset(req) == 20000);
+  CHECK(req.hostReply.find("\"state\":\"receiving\"") != std::string::npos);
+
+  // resuming anywhere else is refused and changes nothing
+  CHECK(replied(upload(img, 15000, size - 15000, size, true), "409 Conflict", "error"));
+  CHECK(replied(upload(img, 25000, size - 25000, size, true), "409 Conflict", "error"));
+  CHECK(ota_state() == OTA_RECEIVING && ota_offset() == 20000);
+
+  // a stall: given up after five socket timeouts, the image stays open
+  req = upload(img, 20000, size - 20000, 10000, true, "", HTTPD_SOCK_ERR_TIMEOUT);
+  CHECK(replied(req, "408 Request Timeout", "partial") && ota_offset() == 30000);
+  CHECK(req.hostRecvs == (10000 + 1023) / 1024 + 5);
+
+  // a request for only part of the rest
+  req = upload(img, 30000, 5000, 5000, true);
+  CHECK(replied(req, "202 Accepted", "partial") && replyOffset(req) == 35000);
+
+  // the rest
+  CHECK(replied(upload(img, 35000, size - 35000, size, true), "200 OK", "rebooting"));
+  CHECK(slotHolds(img) && bootsUpdate() && sha == s_digest);
+  rebooted();
+
+  // compressed: the decoder state carries across the resumes too
+  Bytes z = deflate(img);
+  CHECK(z.size() < size);
+  req = upload(z, 0, z.size(), z.size() / 3, false, shaHex(z));
+  CHECK(replied(req, "408 Request Timeout", "partial"));
+  size_t from = ota_offset();
+  CHECK(replied(upload(z, from, z.size() - from, z.size(), true), "200 OK", "rebooting"));
+  CHECK(slotHolds(img) && bootsUpdate() && otap_format() == OTAP_ZLIB);
+  rebooted();
+
+  // wrong SHA-256, found at the end of a resumed upload
+  std::string other = shaHex(z);
+  CHECK(replied(upload(img, 0, size, 10000, false, other), "408 Request Timeout", "partial"));
+  req = upload(img, 10000, size - 10000, size, true);
+  CHECK(replied(req, "500 Internal Server Error", "error") && !bootsUpdate());
+  CHECK(req.hostReply.find("SHA-256 mismatch") != std::string::npos && ota_state() == OTA_FAILED);
+  CHECK(replied(upload(img, size, 10, 10, true), "409 Conflict", "error"));
+
+  // a resume that announces more than the payload has left
+  CHECK(replied(upload(img, 0, size, 10000, false, sha), "408 Request Timeout", "partial"));
+  Bytes longer = img;
+  longer.resize(size + 10, 0);
+  req = upload(longer, 10000, size + 10 - 10000, size, true);
+  CHECK(replied(req, "500 Internal Server Error", "error"));
+  CHECK(req.hostReply.find("payload longer than announced") != std::string::npos && !bootsUpdate());
+
+  // an offset with nothing open, a body larger than the slot
+  CHECK(replied(upload(img, 10000, size - 10000, size, true), "409 Conflict", "error"));
+  CHECK(replied(upload(img, 0, SLOT_BYTES + 1, 100, false), "409 Conflict", "error"));
+  CHECK(ota_state() == OTA_FAILED && !strcmp(s_error, "payload larger than the slot"));
+}
+
+// ---------------------------------------------------------
+// Trial boot
+// ---------------------------------------------------------
+static void setLinks(bool wifi, bool modemReady, bool gprs, uint32_t sent) {
+  s_wifi = wifi;
+  s_modemReady = modemReady;
+  s_modem->hostGprs = gprs;
+  s_sent = sent;
+}
+
+static esp_ota_img_states_t runningState() {
+  esp_ota_img_states_t st;
+  CHECK(esp_ota_get_state_partition(esp_ota_get_running_partition(), &st) == ESP_OK);
+  return st;
+}
+
+// A boot, as far as the rollback check goes (the clock keeps running)
+static void boot(esp_ota_img_states_t st) {
+  esphost_resetOta(SLOT_BYTES, st);
+  s_trial = false;
+  s_healthAtMs = 0;
+  s_routes.clear();
+  ota_init();
+}
+
+// Boot an update on trial and run the loop until it is confirmed or rolled back
+static esp_ota_img_states_t trial(unsigned long maxMs = OTA_HEALTH_CHECK_MS + 1000) {
+  boot(ESP_OTA_IMG_PENDING_VERIFY);
+  CHECK(s_trial);
+  unsigned long end = millis() + maxMs;
+  while (runningState() == ESP_OTA_IMG_PENDING_VERIFY && millis() < end) {
+    ota_loop();
+    delay(1000);
+  }
+  return runningState();
+}
+
+// Runs first: the health check counts from boot (millis() 0)
+static void testTrial() {
+  // WiFi is up: confirmed once the image has run OTA_HEALTH_MIN_MS
+  setLinks(true, false, false, 0);
+  CHECK(trial(OTA_HEALTH_TIMEOUT_MS) == ESP_OTA_IMG_VALID);
+  CHECK(millis() > OTA_HEALTH_MIN_MS && millis() <= OTA_HEALTH_MIN_MS + 1000);
+
+  // a modem that answers AT but carries nothing: rolled back at the timeout
+  setLinks(false, true, false, 0);
+  CHECK(trial(OTA_HEALTH_TIMEOUT_MS) == ESP_OTA_IMG_ABORTED);
+  CHECK(millis() > OTA_HEALTH_TIMEOUT_MS && millis() <= OTA_HEALTH_TIMEOUT_MS + OTA_HEALTH_CHECK_MS + 1000);
+
+  // past the timeout, every case is settled at the next check
+  setLinks(false, true, true, 0);
+  CHECK(trial() == ESP_OTA_IMG_VALID);
+  setLinks(false, false, true, 0);               // a stale attach flag without the modem
+  CHECK(trial() == ESP_OTA_IMG_ABORTED);
+  setLinks(false, false, false, 1);              // a sample got through
+  CHECK(trial() == ESP_OTA_IMG_VALID);
+  setLinks(true, false, false, 0);
+  CHECK(trial() == ESP_OTA_IMG_VALID);
+  setLinks(false, false, false, 0);
+  CHECK(trial() == ESP_OTA_IMG_ABORTED);
+
+  // not a trial boot: confirmed at init, no health check
+  boot(ESP_OTA_IMG_NEW);
+  CHECK(!s_trial && runningState() == ESP_OTA_IMG_VALID);
+}
+
+int main() {
+  Bytes running = image(20000);
+  esphost_setRunning(running.data(), running.size(), SLOT_BYTES);
+  esphost_resetOta(SLOT_BYTES, ESP_OTA_IMG_VALID);
+  s_modem = new TinyGsm(Serial);
+
+  testTrial();
+  Bytes img = image(24000);
+  testWriter(img);
+  testUpload(img);
+
+  return check_done("ota_update");
+}
@@ -0,0 +1,173 @@
+// test_sample_codec.cpp - sample_codec round trips, malformed frames and the
+// size of a week of hive data.
+
+#include <chrono>
+#include <vector>
+#include <math.h>
+#include <Arduino.h>
+#include "check.h"
+#include "../sample_codec.h"
+
+static bool same(const TelemetrySample &a, const TelemetrySample &b) {
+  return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static uint32_t s_rng = 12345;
+static uint32_t rnd() {
+  s_rng = s_rng * 1103515245u + 12345u;
+  return s_rng >> 1;
+}
+
+static void roundTrip(const TelemetrySample *prev, const TelemetrySample &cur) {
+  uint8_t buf[SAMPLE_FRAME_MAX];
+  size_t n = sample_encode(prev, cur, buf, sizeof(buf));
+  CHECK(n > 0 && n <= SAMPLE_FRAME_MAX);
+  TelemetrySample out;
+  CHECK(sample_decode(prev, buf, n, out) == n);
+  CHECK(same(out, cur));
+  // every cut-off frame is refused, and so is a too small output buffer
+  for (size_t k = 0; k < n; ++k) CHECK(sample_decode(prev, buf, k, out) == 0);
+  CHECK(sample_encode(prev, cur, buf, n - 1) == 0);
+}
+
+static void testEdges() {
+  TelemetrySample zero = {};
+  TelemetrySample lo, hi;
+  lo.ts = 0;
+  hi.ts = 0xFFFFFFFF;
+  for (int c = 0; c < CH_COUNT; ++c) {
+    lo.v[c] = INT32_MIN;
+    hi.v[c] = INT32_MAX;
+  }
+  roundTrip(nullptr, zero);
+  roundTrip(nullptr, lo);
+  roundTrip(nullptr, hi);
+  roundTrip(&lo, hi);                 // deltas that wrap around 32 bits
+  roundTrip(&hi, lo);
+  roundTrip(&hi, zero);               // clock going backwards
+
+  uint8_t buf[SAMPLE_FRAME_MAX];
+  TelemetrySample out;
+  CHECK(sample_encode(nullptr, zero, buf, sizeof(buf)) == 2);   // header + ts, no channels
+  size_t n = sample_encode(&zero, zero, buf, sizeof(buf));
+  CHECK(n == 2);
+  CHECK(sample_decode(nullptr, buf, n, out) == 0);              // delta frame needs a previous sample
+  const uint8_t longVarint[] = { SAMPLE_FRAME_KEY, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01 };
+  CHECK(sample_decode(nullptr, longVarint, sizeof(longVarint), out) == 0);
+}
+
+// Random walks through the streaming encoder/decoder, keyframes forced at random
+static void testStreams() {
+  SampleEncoder enc;
+  SampleDecoder dec;
+  sample_encoderReset(enc);
+  sample_decoderReset(dec);
+  TelemetrySample s = {};
+  std::string stream;
+  std::vector<TelemetrySample> sent;
+  for (int i = 0; i < 20000; ++i) {
+    s.ts += rnd() % 600;
+    for (int c = 0; c < CH_COUNT; ++c) {
+      uint32_t r = rnd();
+      if (r % 4 == 0) continue;
+      s.v[c] += (r % 7 == 0) ? (int32_t)rnd() : (int32_t)(r % 201) - 100;
+    }
+    uint8_t buf[SAMPLE_FRAME_MAX];
+    size_t n = sample_encodeNext(enc, s, buf, sizeof(buf), rnd() % 50 == 0);
+    CHECK(n > 0);
+    stream.append((const char *)buf, n);
+    sent.push_back(s);
+  }
+  size_t at = 0;
+  for (size_t i = 0; i < sent.size(); ++i) {
+    TelemetrySample out;
+    size_t n = sample_decodeNext(dec, (const uint8_t *)stream.data() + at, stream.size() - at, out);
+    CHECK(n > 0);
+    if (!n) return;
+    CHECK(same(out, sent[i]));
+    at += n;
+  }
+  CHECK(at == stream.size());
+}
+
+// A week at the 5 min sampling interval, shaped like hive data: weight with a
+// daily foraging dip, a steady brood nest, outside temperature and humidity
+// following the sun, sensors jittering by a few counts.
+static std::vector<TelemetrySample> hiveWeek() {
+  std::vector<TelemetrySample> w;
+  TelemetrySample s;
+  for (int i = 0; i < 7 * 288; ++i) {
+    double day = (i % 288) / 288.0;
+    double sun = sin(2 * M_PI * (day - 0.25));
+    int jitter = (int)(rnd() % 5) - 2;
+    s.ts = 1717200000u + i * 300u;
+    s.v[CH_WEIGHT] = 42000 + i * 3 - (int32_t)(sun > 0 ? 600 * sun : 0) + jitter * 5;
+    s.v[CH_TEMP_INT] = 3450 + jitter;
+    s.v[CH_HUM_INT] = 610 + (int32_t)(rnd() % 3);
+    s.v[CH_TEMP_EXT] = 1800 + (int32_t)(900 * sun) + jitter;
+    s.v[CH_HUM_EXT] = 650 - (int32_t)(200 * sun) + (int32_t)(rnd() % 3);
+    s.v[CH_PRESSURE] = 10130 + (int32_t)(15 * sin(2 * M_PI * i / 2016.0));
+    s.v[CH_BATT] = 3950 + (int32_t)(100 * sun) - (int32_t)(rnd() % 2);
+    w.push_back(s);
+  }
+  return w;
+}
+
+// ThingSpeak form fields as the SD queue used to store them
+static size_t asciiBytes(const TelemetrySample &s) {
+  char line[160];
+  return snprintf(line, sizeof(line),
+                  "field1=%.2f&field2=%.2f&field3=%.1f&field4=%.2f&field5=%.1f&field6=%.1f&field7=%.2f&created_at=%lu\n",
+                  s.v[CH_WEIGHT] / 1000.0, s.v[CH_TEMP_INT] / 100.0, s.v[CH_HUM_INT] / 10.0,
+                  s.v[CH_TEMP_EXT] / 100.0, s.v[CH_HUM_EXT] / 10.0, s.v[CH_PRESSURE] / 10.0,
+                  s.v[CH_BATT] / 1000.0, (unsigned long)s.ts);
+}
+
+static void testWeek() {
+  std::vector<TelemetrySample> week = hiveWeek();
+  std::vector<uint8_t> buf(week.size() * SAMPLE_FRAME_MAX);
+  size_t ascii = 0;
+  for (const TelemetrySample &s : week) ascii += asciiBytes(s);
+
+  SampleEncoder enc;
+  SampleDecoder dec;
+  const int rounds = 200;
+  size_t coded = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r) {
+    sample_encoderReset(enc);
+    coded = 0;
+    for (const TelemetrySample &s : week) coded += sample_encodeNext(enc, s, buf.data() + coded, buf.size() - coded);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  size_t bad = 0;
+  for (int r = 0; r < rounds; ++r) {
+    sample_decoderReset(dec);
+    size_t at = 0;
+    for (const TelemetrySample &s : week) {
+      TelemetrySample out;
+      size_t n = sample_decodeNext(dec, buf.data() + at, coded - at, out);
+      if (!n || !same(out, s)) bad++;
+      at += n;
+    }
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  CHECK(bad == 0);
+
+  double perSample = (double)coded / week.size();
+  double encUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / (rounds * week.size());
+  double decUs = std::chrono::duration<double, std::micro>(t2 - t1).count() / (rounds * week.size());
+  printf("week: %zu samples, ascii %zu B (%.1f B/sample), codec %zu B (%.1f B/sample), ratio %.1fx, raw struct %.1fx\n",
+         week.size(), ascii, (double)ascii / week.size(), coded, perSample, (double)ascii / coded,
+         (double)sizeof(TelemetrySample) * week.size() / coded);
+  printf("host throughput: encode %.3f us/sample, decode %.3f us/sample\n", encUs, decUs);
+  CHECK(perSample < 14.0);
+  CHECK(ascii > 8 * coded);
+}
+
+int main() {
+  testEdges();
+  testStreams();
+  testWeek();
+  return check_done("sample_codec");
+}
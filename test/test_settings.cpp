@@ -0,0 +1,182 @@
+// test_settings.cpp - settings load and migration from every NVS layout.
+//
+// settings.cpp is compiled into this file so a test can reboot: boot()
+// clears the once-per-boot guard and runs settings_init() again on the
+// same g_nvs (the flash).
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <vector>
+#include "check.h"
+#include "../settings.cpp"
+
+static const Settings &boot() {
+  s_mutex = nullptr;
+  settings_init();
+  return settings();
+}
+
+static size_t keys(const char *ns) {
+  return g_nvs.count(ns) ? g_nvs[ns].size() : 0;
+}
+
+static uint32_t crc32(const uint8_t *p, size_t n, uint32_t crc) {
+  while (n--) {
+    crc ^= *p++;
+    for (int i = 0; i < 8; ++i) crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+  }
+  return crc;
+}
+
+// A schema 2 blob as settings_store() writes it, cut to len payload bytes
+static std::vector<uint8_t> blob(const Settings &s, uint16_t schema, size_t len) {
+  struct __attribute__((packed)) { uint16_t schema, size; uint32_t crc; } h = { schema, (uint16_t)len, 0 };
+  std::vector<uint8_t> b(sizeof(h) + len);
+  memcpy(b.data() + sizeof(h), &s, len);
+  memcpy(b.data(), &h, sizeof(h));
+  h.crc = ~crc32(b.data(), b.size(), 0xFFFFFFFF);
+  memcpy(b.data(), &h, sizeof(h));
+  return b;
+}
+
+// Schema 0: the keys the firmware before the settings module wrote
+static void testSchema0() {
+  g_nvs.clear();
+  Preferences p;
+  p.begin("beehive");
+  p.putString("wifi_ssid1", "Home");
+  p.putString("wifi_psk1", "pw1");
+  p.putString("wifi_ssid2", "Barn");
+  p.putString("wifi_last", "Home");
+  uint8_t bssid[6] = { 1, 2, 3, 4, 5, 6 };
+  p.putBytes("wifi_bssid", bssid, 6);
+  p.putUChar("wifi_ch", 11);
+  p.putString("owm_lat", "38.1");
+  p.putString("owm_lon", "23.7");
+  p.putString("ts_key", "KEY0");
+  p.putString("lcd_lang", "el");        // not a setting, must survive
+  p.end();
+  p.begin("beehive_app");
+  p.putBool("ts_auto", true);
+  p.putInt("ts_interval_min", 30);
+  p.putInt("net_pref", 7);              // out of range: clamped
+  p.end();
+  p.begin("wifi_cfg");
+  p.putString("ssid", "Shed");
+  p.putString("pass", "pw3");
+  p.end();
+  p.begin("calib_ns");
+  p.putFloat("factor", 21.5f);
+  p.putLong("offset", -1234);
+  p.putInt("known", 5000);
+  p.end();
+
+  Settings a = boot();
+  CHECK(!strcmp(a.wifi[0].ssid, "Home") && !strcmp(a.wifi[0].pass, "pw1"));
+  CHECK(!strcmp(a.wifi[1].ssid, "Barn") && a.wifi[1].pass[0] == 0);
+  CHECK(!strcmp(a.wifi[2].ssid, "Shed") && !strcmp(a.wifi[2].pass, "pw3"));
+  CHECK(!strcmp(a.wifiLastSsid, "Home") && a.wifiLastChannel == 11 && !memcmp(a.wifiLastBssid, bssid, 6));
+  CHECK(a.hasCoords && a.lat > 38.09 && a.lat < 38.11 && a.lon > 23.69 && a.lon < 23.71);
+  CHECK(!strcmp(a.tsKey, "KEY0"));
+  CHECK(a.tsAuto && a.tsIntervalMin == 30 && a.netPref == 2);
+  CHECK(a.calFactor == 21.5f && a.calOffset == -1234 && a.calKnownGrams == 5000);
+  CHECK(a.smsPin[0] == 0);
+
+  // old keys gone once the blob is written, foreign keys kept
+  CHECK(keys("settings") == 1 && g_nvs["settings"].count("cfg"));
+  CHECK(keys("beehive") == 1 && g_nvs["beehive"].count("lcd_lang"));
+  CHECK(keys("beehive_app") == 0 && keys("wifi_cfg") == 0 && keys("calib_ns") == 0);
+
+  // the next boot reads the blob and gets the same settings
+  CHECK(!memcmp(&a, &boot(), sizeof(Settings)));
+
+  // the three calibration values are one write
+  std::vector<uint8_t> old = g_nvs["settings"]["cfg"];
+  uint32_t writes = s_writes;
+  CHECK(settings_setCalibration(30.0f, 7, 1000));
+  CHECK(s_writes == writes + 1 && g_nvs["settings"]["cfg"] != old && keys("settings") == 1);
+  CHECK(settings_setCalibration(30.0f, 7, 1000));     // unchanged: no write
+  CHECK(s_writes == writes + 1);
+  const Settings &c = boot();
+  CHECK(c.calFactor == 30.0f && c.calOffset == 7 && c.calKnownGrams == 1000 && !strcmp(c.wifi[0].ssid, "Home"));
+}
+
+// Schema 0 on a device that never stored anything: defaults, one blob
+static void testFactoryNew() {
+  g_nvs.clear();
+  const Settings &s = boot();
+  CHECK(s.tsIntervalMin == 60 && !s.tsAuto && !s.hasCoords && s.wifi[0].ssid[0] == 0);
+  CHECK(keys("settings") == 1);
+}
+
+// Schema 1: one key per field in "settings", "ver" = 1
+static void testSchema1() {
+  g_nvs.clear();
+  Preferences p;
+  p.begin("settings");
+  p.putString("w1s", "Phone");
+  p.putString("w1p", "x");
+  p.putString("w2s", "Shed");
+  p.putDouble("lat", 1.5);
+  p.putDouble("lon", 2.5);
+  p.putBool("ts_auto", true);
+  p.putUShort("ts_int", 15);
+  p.putUChar("net", 1);
+  p.putString("ts_key", "KEY1");
+  p.putFloat("cal_f", 3.0f);
+  p.putInt("cal_o", 9);
+  p.putInt("cal_k", 100);
+  uint8_t bssid[6] = { 6, 5, 4, 3, 2, 1 };
+  p.putString("wl_ssid", "Phone");
+  p.putBytes("wl_bssid", bssid, 6);
+  p.putUChar("wl_ch", 6);
+  p.putUChar("ver", 1);
+  p.end();
+
+  const Settings &s = boot();
+  CHECK(s.wifi[0].ssid[0] == 0 && !strcmp(s.wifi[1].ssid, "Phone") && !strcmp(s.wifi[1].pass, "x"));
+  CHECK(!strcmp(s.wifi[2].ssid, "Shed"));
+  CHECK(s.hasCoords && s.lat == 1.5 && s.lon == 2.5);
+  CHECK(s.tsAuto && s.tsIntervalMin == 15 && s.netPref == 1 && !strcmp(s.tsKey, "KEY1"));
+  CHECK(s.calFactor == 3.0f && s.calOffset == 9 && s.calKnownGrams == 100);
+  CHECK(!strcmp(s.wifiLastSsid, "Phone") && s.wifiLastChannel == 6 && s.wifiLastBssid[0] == 6);
+  CHECK(keys("settings") == 1 && g_nvs["settings"].count("cfg"));
+}
+
+// Schema 2: a blob written before the SMS fields existed, then bad blobs
+static void testSchema2() {
+  Settings s;
+  memset(&s, 0, sizeof(s));
+  strcpy(s.wifi[0].ssid, "Old");
+  s.tsIntervalMin = 20;
+  s.calFactor = 4.0f;
+  strcpy(s.smsPin, "garbage");         // past the short blob's end, never read
+
+  g_nvs.clear();
+  g_nvs["settings"]["cfg"] = blob(s, 2, offsetof(Settings, smsPin));
+  const Settings &a = boot();
+  CHECK(!strcmp(a.wifi[0].ssid, "Old") && a.tsIntervalMin == 20 && a.calFactor == 4.0f);
+  CHECK(a.smsPin[0] == 0 && a.smsAllow[0][0] == 0);
+  CHECK(g_nvs["settings"]["cfg"].size() == 8 + offsetof(Settings, smsPin));   // rewritten on the next save only
+
+  // corrupt, or written by a newer firmware: defaults, and the blob is left alone
+  std::vector<uint8_t> bad = blob(s, 2, sizeof(s));
+  bad[20] ^= 1;
+  std::vector<uint8_t> newer = blob(s, 3, sizeof(s));
+  const std::vector<uint8_t> *cases[] = { &bad, &newer };
+  for (const std::vector<uint8_t> *c : cases) {
+    g_nvs.clear();
+    g_nvs["settings"]["cfg"] = *c;
+    const Settings &d = boot();
+    CHECK(d.tsIntervalMin == 60 && d.wifi[0].ssid[0] == 0 && d.calFactor == 0.0f);
+    CHECK(keys("settings") == 1 && g_nvs["settings"]["cfg"] == *c);
+  }
+}
+
+int main() {
+  testSchema0();
+  testFactoryNew();
+  testSchema1();
+  testSchema2();
+  return check_done("settings");
+}
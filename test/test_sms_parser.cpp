@@ -0,0 +1,128 @@
+// test_sms_parser.cpp - sms_parser on +CMGL / +CMGR answers, fed in every
+// possible split the UART could deliver.
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "../sms_parser.h"
+
+struct Rec {
+  int index;
+  std::string stat, sender, time, body;
+  bool operator==(const Rec &o) const {
+    return index == o.index && stat == o.stat && sender == o.sender && time == o.time && body == o.body;
+  }
+};
+
+static std::vector<Rec> s_got;
+
+static void onRecord(const SmsRecord &r, void *) {
+  CHECK(strlen(r.body) == r.bodyLen);
+  s_got.push_back({ r.index, r.stat, r.sender, r.time, std::string(r.body, r.bodyLen) });
+}
+
+// Feed s in pieces of the given sizes (cycled), then end the input
+static SmspResult parse(const std::string &s, const std::vector<size_t> &pieces) {
+  s_got.clear();
+  smsp_begin(onRecord, nullptr);
+  size_t at = 0;
+  for (size_t i = 0; at < s.size(); ++i) {
+    size_t n = pieces[i % pieces.size()];
+    if (n > s.size() - at) n = s.size() - at;
+    size_t end = at + n;
+    while (at < end) at += smsp_feed(s.data() + at, end - at);
+  }
+  smsp_end();
+  return smsp_result();
+}
+
+// The same records, result and drop count however the input is split
+static void checkSplits(const char *name, const std::string &s, const std::vector<Rec> &want, SmspResult result,
+                        uint16_t dropped) {
+  std::vector<std::vector<size_t>> splits = { { s.size() }, { 1 }, { 2 }, { 7 }, { 64 }, { 3, 1, 50, 11 } };
+  for (size_t cut = 1; cut < s.size(); ++cut) splits.push_back({ cut, s.size() });
+  for (const std::vector<size_t> &p : splits) {
+    bool ok = parse(s, p) == result && smsp_dropped() == dropped && s_got == want;
+    CHECK(ok);
+    if (!ok) {
+      printf("%s: split %zu: %zu records, dropped %u\n", name, p[0], s_got.size(), smsp_dropped());
+      return;
+    }
+  }
+}
+
+static const char *TS = "24/05/01,10:00:00+12";
+
+static void testList() {
+  // echo, a body holding "OK" and a line break (CSDH length keeps it body),
+  // a sender with a comma inside its quotes, an empty body
+  std::string s = "AT+CMGL=\"ALL\"\r\r\n"
+                  "+CMGL: 1,\"REC READ\",\"+306912345678\",\"\",\"24/05/01,10:00:00+12\",145,9\r\n"
+                  "OK\r\nline2\r\n"
+                  "+CMGL: 2,\"REC UNREAD\",\"+30 69,1\",\"\",\"24/05/01,10:00:00+12\",145,5\r\n"
+                  "hello\r\n"
+                  "+CMGL: 7,\"REC UNREAD\",\"+306900000000\",\"\",\"24/05/01,10:00:00+12\",145,0\r\n"
+                  "\r\n"
+                  "OK\r\n";
+  checkSplits("list", s,
+              { { 1, "REC READ", "+306912345678", TS, "OK\r\nline2" },
+                { 2, "REC UNREAD", "+30 69,1", TS, "hello" },
+                { 7, "REC UNREAD", "+306900000000", TS, "" } },
+              SMSP_OK, 0);
+
+  checkSplits("empty list", "AT+CMGL=\"ALL\"\r\r\nOK\r\n", {}, SMSP_OK, 0);
+  checkSplits("error", "\r\n+CMS ERROR: 321\r\n", {}, SMSP_ERROR, 0);
+}
+
+// Without AT+CSDH=1 the header has no length: the body ends at the next line
+// that is a header or a result code
+static void testNoLength() {
+  std::string s = "+CMGL: 3,\"REC READ\",\"+306912345678\",,\"24/05/01,10:00:00+12\"\r\n"
+                  "#1234 INT 15;\r\nNET LTE\r\n"
+                  "OK\r\n";
+  checkSplits("no length", s, { { 3, "REC READ", "+306912345678", TS, "#1234 INT 15;\r\nNET LTE" } }, SMSP_OK, 0);
+}
+
+static void testRead() {
+  std::string s = "\r\n+CMGR: \"REC READ\",\"+306912345678\",\"\",\"24/05/01,10:00:00+12\",145,4,0,0,\"+3097100000\",145,"
+                  "12\r\n#1234 STATUS\r\n\r\nOK\r\n";
+  checkSplits("read", s, { { -1, "REC READ", "+306912345678", TS, "#1234 STATUS" } }, SMSP_OK, 0);
+}
+
+// The answer stops (UART timeout): whatever is not terminated is dropped,
+// never delivered half
+static void testTruncated() {
+  std::string first = "+CMGL: 1,\"REC READ\",\"+306912345678\",\"\",\"24/05/01,10:00:00+12\",145,5\r\nfirst\r\n";
+  std::string second = "+CMGL: 2,\"REC READ\",\"+306912345678\",\"\",\"24/05/01,10:00:00+12\",145,6\r\nsecond\r\n";
+
+  checkSplits("cut in body 1", first.substr(0, first.size() - 4), {}, SMSP_PENDING, 1);
+  // the first body ends only once the next header line is complete
+  checkSplits("cut in header 2", first + second.substr(0, 20), {}, SMSP_PENDING, 1);
+  checkSplits("cut in body 2", first + second.substr(0, second.size() - 3),
+              { { 1, "REC READ", "+306912345678", TS, "first" } }, SMSP_PENDING, 1);
+  checkSplits("cut before OK", first + second,
+              { { 1, "REC READ", "+306912345678", TS, "first" } }, SMSP_PENDING, 1);
+}
+
+// A message larger than the buffer is dropped; the ones around it survive
+static void testOversized() {
+  std::string big(SMS_RX_BYTES + 200, 'x');
+  std::string s = "+CMGL: 1,\"REC READ\",\"+1\",\"\",\"24/05/01,10:00:00+12\",145,2\r\nhi\r\n"
+                  "+CMGL: 2,\"REC READ\",\"+2\",\"\",\"24/05/01,10:00:00+12\",145,1224\r\n" + big + "\r\n"
+                  "+CMGL: 3,\"REC READ\",\"+3\",\"\",\"24/05/01,10:00:00+12\",145,3\r\nbye\r\n"
+                  "OK\r\n";
+  CHECK(parse(s, { 1 }) == SMSP_OK && smsp_dropped() == 1);
+  std::vector<Rec> want = { { 1, "REC READ", "+1", TS, "hi" }, { 3, "REC READ", "+3", TS, "bye" } };
+  CHECK(s_got == want);
+  CHECK(parse(s, { 100 }) == SMSP_OK && smsp_dropped() == 1 && s_got == want);
+}
+
+int main() {
+  testList();
+  testNoLength();
+  testRead();
+  testTruncated();
+  testOversized();
+  return check_done("sms_parser");
+}
@@ -0,0 +1,170 @@
+// test_tsdb.cpp - tsdb_queryPage(), the reader behind /api/v1/history: every
+// page size, step and range over raw days, hourly rollups and the midnights
+// between them must give the points of one tsdb_query() call, each once.
+// With the clock set the range is clamped to the days the store keeps.
+
+#include <Arduino.h>
+#include <SD.h>
+#include <filesystem>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+#include "check.h"
+#include "../tsdb.h"
+
+static bool s_clock = false;
+
+bool timeManager_isTimeValid() {
+  return s_clock;
+}
+void sample_capture(TelemetrySample &) {}
+
+static uint32_t s_today;                // UTC day number
+
+static TelemetrySample mk(uint32_t ts) {
+  TelemetrySample s = {};
+  s.ts = ts;
+  for (int c = 0; c < CH_COUNT; ++c) s.v[c] = (int32_t)((ts / 60) % 1000) * (c + 1) - 500;
+  return s;
+}
+
+// Every 5 min of a day, from hour h0 to before h1
+static uint32_t fill(uint32_t day, uint32_t h0, uint32_t h1) {
+  uint32_t n = 0;
+  for (uint32_t ts = day * 86400 + h0 * 3600; ts < day * 86400 + h1 * 3600; ts += TSDB_SAMPLE_INTERVAL_S) {
+    CHECK(tsdb_append(mk(ts)));
+    n++;
+  }
+  return n;
+}
+
+static bool collect(const TsdbRollup &p, void *ctx) {
+  ((std::vector<TsdbRollup> *)ctx)->push_back(p);
+  return true;
+}
+
+static bool same(const TsdbRollup &a, const TsdbRollup &b) {
+  return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// All pages of [from, to] at page size max
+static std::vector<TsdbRollup> pages(uint32_t from, uint32_t to, uint32_t step, uint16_t max, int *calls = nullptr) {
+  std::vector<TsdbRollup> got;
+  std::vector<TsdbRollup> page(max);
+  uint32_t cursor = 0, last = 0;
+  int n = 0;
+  do {
+    uint16_t k = tsdb_queryPage(from, to, step, cursor, page.data(), max);
+    CHECK(k <= max);
+    // a page is short only at the end; the cursor moves forward
+    if (cursor) CHECK(k == max && cursor > last && cursor == page[k - 1].ts + 1);
+    last = cursor;
+    got.insert(got.end(), page.begin(), page.begin() + k);
+  } while (cursor && ++n < 100000);
+  if (calls) *calls = n + 1;
+  return got;
+}
+
+// Pages at several sizes against the single query
+static void checkPaging(const char *name, uint32_t from, uint32_t to, uint32_t step) {
+  std::vector<TsdbRollup> want;
+  tsdb_query(from, to, step, collect, &want);
+  CHECK(!want.empty());
+  for (uint16_t max : { 1, 2, 7, 24, 100, 2000 }) {
+    int calls;
+    std::vector<TsdbRollup> got = pages(from, to, step, max, &calls);
+    bool ok = got.size() == want.size();
+    for (size_t i = 0; ok && i < got.size(); ++i) ok = same(got[i], want[i]);
+    CHECK(ok);
+    CHECK(calls <= (int)(want.size() / max) + 1);
+    if (!ok) {
+      printf("%s: step %u, pages of %u: %zu points, want %zu\n", name, step, max, got.size(), want.size());
+      return;
+    }
+  }
+}
+
+static void testPaging() {
+  uint32_t d = s_today;
+  // rollup days, a gap, raw days with a hole in the middle of one
+  uint32_t full = d * 86400 - 11 * 86400;
+  uint32_t end = d * 86400 + 86399;
+  for (uint32_t step : { 0u, 300u, 3600u, 5400u, 86400u }) {
+    checkPaging("all", full, end, step);
+    // across one midnight, starting and ending inside buckets
+    checkPaging("midnight", (d - 1) * 86400 + 22 * 3600 + 1234, d * 86400 + 2 * 3600 + 17, step);
+    // across the change from rollups to raw records
+    checkPaging("rollup/raw", (d - 9) * 86400 + 20 * 3600, (d - 1) * 86400 + 3 * 3600, step);
+  }
+  // rollups are hourly, raw records every 5 min
+  std::vector<TsdbRollup> p = pages((d - 10) * 86400, (d - 10) * 86400 + 86399, 0, 50);
+  CHECK(p.size() == 24 && p[0].count == 3600 / TSDB_SAMPLE_INTERVAL_S);
+  p = pages((d - 1) * 86400, (d - 1) * 86400 + 3599, 0, 5);
+  CHECK(p.size() == 3600 / TSDB_SAMPLE_INTERVAL_S && p[1].ts - p[0].ts == TSDB_SAMPLE_INTERVAL_S);
+
+  // a page that ends on the last point: one more call returns nothing, cursor 0
+  uint32_t cursor = 0;
+  std::vector<TsdbRollup> page(12);
+  CHECK(tsdb_queryPage((d - 1) * 86400, (d - 1) * 86400 + 3599, 0, cursor, page.data(), 12) == 12 && cursor);
+  CHECK(tsdb_queryPage((d - 1) * 86400, (d - 1) * 86400 + 3599, 0, cursor, page.data(), 12) == 0 && cursor == 0);
+
+  // nothing in range, bad arguments
+  cursor = 0;
+  CHECK(tsdb_queryPage((d - 5) * 86400, (d - 4) * 86400, 0, cursor, page.data(), 12) == 0 && cursor == 0);
+  cursor = 123;
+  CHECK(tsdb_queryPage(end, full, 0, cursor, page.data(), 12) == 0 && cursor == 0);
+  cursor = 123;
+  CHECK(tsdb_queryPage(full, end, 0, cursor, page.data(), 0) == 0 && cursor == 0);
+}
+
+// With the clock set, from is clamped to the rollup horizon and to to today
+static void testClamp() {
+  uint32_t d = s_today;
+  // left behind by a wrong clock: older than the horizon, and days ahead
+  uint32_t old = fill(d - TSDB_ROLLUP_DAYS - 2, 0, 1);
+  uint32_t ahead = fill(d + 3, 0, 1);
+  std::vector<TsdbRollup> all, kept;
+  tsdb_query(0, (d + 5) * 86400, 0, collect, &all);
+  tsdb_query((d - TSDB_ROLLUP_DAYS) * 86400, d * 86400 + 86399, 0, collect, &kept);
+  CHECK(all.size() == kept.size() + old + ahead);
+
+  s_clock = false;
+  CHECK(pages(0, (d + 5) * 86400, 0, 100).size() == all.size());
+  s_clock = true;
+  std::vector<TsdbRollup> got = pages(0, (d + 5) * 86400, 0, 100);
+  bool ok = got.size() == kept.size();
+  for (size_t i = 0; ok && i < got.size(); ++i) ok = same(got[i], kept[i]);
+  CHECK(ok);
+
+  // entirely outside what is kept
+  uint32_t cursor = 0;
+  TsdbRollup page[4];
+  CHECK(tsdb_queryPage(0, (d - TSDB_ROLLUP_DAYS - 1) * 86400, 0, cursor, page, 4) == 0 && cursor == 0);
+  CHECK(tsdb_queryPage((d + 1) * 86400, (d + 5) * 86400, 0, cursor, page, 4) == 0 && cursor == 0);
+}
+
+int main() {
+  std::string card = std::filesystem::temp_directory_path() / ("beehive_tsdb_" + std::to_string(getpid()));
+  sdhost_begin(card.c_str());
+  s_today = (uint32_t)time(nullptr) / 86400;
+  s_clock = true;
+  tsdb_init();
+
+  uint32_t d = s_today;
+  fill(d - 11, 0, 24);
+  fill(d - 10, 0, 24);
+  fill(d - 9, 12, 24);
+  fill(d - 1, 0, 10);
+  fill(d - 1, 13, 24);                  // the card was out for lunch
+  fill(d, 0, 6);
+  // days past TSDB_RAW_DAYS become hourly rollups
+  int compacted = 0;
+  while (tsdb_maintain()) compacted++;
+  CHECK(compacted == 3);
+
+  testPaging();
+  testClamp();
+
+  std::filesystem::remove_all(card);
+  return check_done("tsdb");
+}
@@ -0,0 +1,236 @@
+// test_upload_scheduler.cpp - ten days of hive traces (WiFi, modem CSQ,
+// battery) replayed through sched_loop() and the sink runner, as loop()
+// drives them: a sample every hour, the scheduler and sinks every 10 s.
+// Checks the mode each stretch of the trace gets, how long samples wait,
+// the spacing of the LTE sessions, the CSQ polling and the radio-on time per
+// day.
+//
+// upload_scheduler.cpp is compiled into this file to read its send
+// accounting. The one active sink stands in for the HTTP sink: batches of
+// HTTP_SINK_BATCH, a modem session costs an attach plus a request per batch.
+
+#include <Arduino.h>
+#include <SD.h>
+#include <filesystem>
+#include <vector>
+#include <unistd.h>
+#include "check.h"
+#include "../telemetry_sink.h"
+#include "../http_sink.h"
+#include "../upload_scheduler.cpp"
+
+#define HOUR_MS        3600000UL
+#define TICK_MS        10000UL
+#define SAMPLE_MS      HOUR_MS          // ts_interval_min 60
+#define LTE_ATTACH_MS  8000UL           // PDP context up after an idle radio
+#define LTE_REQUEST_MS 1500UL
+#define LTE_SAMPLE_MS  100UL
+#define LTE_TAIL_MS    10000UL          // connected-mode tail after the last byte
+#define LTE_IDLE_MS    120000UL         // the context is dropped after this long unused
+#define WIFI_SEND_MS   400UL
+
+// ---------------------------------------------------------
+// Traces
+// ---------------------------------------------------------
+struct Leg {
+  const char *name;
+  unsigned long fromH, toH;
+  bool     wifi;
+  int16_t  csq;
+  int      battFrom, battTo;          // %, linear over the leg
+  SchedMode mode;                     // what the scheduler must pick
+  unsigned long holdMin;              // longest a sample may wait (2: the sink's own pacing)
+  unsigned long lteGapMin;            // least spacing of LTE sessions, 0: none
+  uint32_t budgetS;                   // LTE radio-on seconds per day
+};
+
+// Sending each sample on its own costs ~470 s of LTE radio a day here;
+// deferred bursts must cost a third of that, the battery saver a tenth.
+static const Leg LEGS[] = {
+  { "wifi",        0,  24, true,  20, 95, 90, SCHED_FLUSH,  2, 0, 0 },
+  { "lte good",   24,  48, false, 20, 90, 85, SCHED_FLUSH,  2, 60, 600 },
+  { "lte medium", 48,  72, false, 11, 85, 80, SCHED_NORMAL, 2, 60, 600 },
+  { "lte weak",   72, 120, false,  5, 80, 70, SCHED_DEFER,  SCHED_MAX_DEFER_MIN, SCHED_MAX_DEFER_MIN, 157 },
+  { "batt low",  120, 144, false, 12, 29, 16, SCHED_DEFER,  SCHED_MAX_DEFER_MIN, SCHED_MAX_DEFER_MIN, 157 },
+  { "batt crit", 144, 216, false, 20, 14, 10, SCHED_SAVE,   SCHED_MAX_DEFER_MIN * 4, SCHED_MAX_DEFER_MIN * 4, 47 },
+  { "wifi back", 216, 240, true,  20, 10, 10, SCHED_FLUSH,  2, 0, 0 },
+};
+#define LEG_COUNT (sizeof(LEGS) / sizeof(LEGS[0]))
+
+static const Leg *s_leg = &LEGS[0];
+
+// ---------------------------------------------------------
+// What the scheduler and the sinks link against
+// ---------------------------------------------------------
+int test_batt_percent = 100;
+
+static uint32_t s_csqPolls[LEG_COUNT];
+
+bool modem_isReady() {
+  return true;
+}
+int16_t modem_getRSSI() {
+  s_csqPolls[s_leg - LEGS]++;
+  return s_leg->csq;
+}
+
+struct Session {
+  size_t leg;
+  unsigned long startMs, endMs;
+  unsigned long onMs;                   // radio on, the tail after the last request included
+};
+
+static std::vector<Session> s_sessions;   // LTE only
+static std::vector<uint32_t> s_got;       // sample numbers as delivered
+static std::vector<unsigned long> s_waitMs; // by sample number
+static std::vector<size_t> s_madeIn;      // leg, by sample number
+static uint32_t s_wifiSends = 0;
+static unsigned long s_lteSendMs = 0;
+
+static bool sim_on() {
+  return true;
+}
+static bool off() {
+  return false;
+}
+
+static uint8_t sim_send(const TelemetrySample *batch, uint8_t n) {
+  unsigned long now = millis();
+  if (WiFi.status() == WL_CONNECTED) {
+    s_wifiSends++;
+    delay(WIFI_SEND_MS);
+  } else {
+    unsigned long cost = LTE_REQUEST_MS + LTE_SAMPLE_MS * n;
+    if (s_sessions.empty() || now - s_sessions.back().endMs > LTE_IDLE_MS) {
+      s_sessions.push_back({ (size_t)(s_leg - LEGS), now, now, LTE_TAIL_MS });
+      cost += LTE_ATTACH_MS;
+    }
+    Session &ses = s_sessions.back();
+    ses.onMs += min(now - ses.endMs, LTE_TAIL_MS) + cost;
+    delay(cost);
+    ses.endMs = millis();
+    s_lteSendMs += cost;
+  }
+  for (uint8_t i = 0; i < n; ++i) {
+    uint32_t k = batch[i].ts - 1717200000u;
+    s_got.push_back(k);
+    if (k < s_waitMs.size()) s_waitMs[k] = millis() - k * SAMPLE_MS;
+  }
+  return n;
+}
+
+const TelemetrySink &thingspeak_sink() {
+  static const TelemetrySink sink = { "thingspeak", off, off, nullptr, nullptr, 1, 0, 1000, 1000 };
+  return sink;
+}
+const TelemetrySink &mqtt_sink() {
+  static const TelemetrySink sink = { "mqtt", off, off, nullptr, nullptr, 1, 0, 1000, 1000 };
+  return sink;
+}
+const TelemetrySink &http_sink() {
+  static const TelemetrySink sink = { "http", sim_on, sim_on, sim_send, nullptr, HTTP_SINK_BATCH, 60000UL, 30000UL,
+                                      900000UL };
+  return sink;
+}
+
+// ---------------------------------------------------------
+static void setLeg(unsigned long now) {
+  while (s_leg < LEGS + LEG_COUNT - 1 && now >= (s_leg + 1)->fromH * HOUR_MS) s_leg++;
+  const Leg &l = *s_leg;
+  unsigned long span = (l.toH - l.fromH) * HOUR_MS;
+  test_batt_percent = l.battFrom + (int)((long)(l.battTo - l.battFrom) * (long)(now - l.fromH * HOUR_MS) / (long)span);
+  WiFi.hostStatus = l.wifi ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+int main() {
+  std::string card = std::filesystem::temp_directory_path() / ("beehive_sched_" + std::to_string(getpid()));
+  sdhost_begin(card.c_str());
+  tsq_init();
+  sinks_init();
+
+  const unsigned long endMs = LEGS[LEG_COUNT - 1].toH * HOUR_MS;
+  uint32_t made = 0;
+  uint32_t wrongMode[LEG_COUNT] = {};
+  unsigned long nextSampleMs = 0;
+  for (unsigned long now = 0; now < endMs; now = millis()) {
+    setLeg(now);
+    if (now >= nextSampleMs) {
+      nextSampleMs += SAMPLE_MS;
+      TelemetrySample s = {};
+      s_madeIn.push_back(s_leg - LEGS);
+      s_waitMs.push_back(0);
+      s.ts = 1717200000u + made++;
+      s.v[CH_BATT] = test_batt_percent;
+      CHECK(sinks_publish(s));
+    }
+    sched_loop();
+    sinks_loop();
+    size_t leg = s_leg - LEGS;
+    // a mode change takes one pass (the CSQ is sampled on the next one)
+    if (now - s_leg->fromH * HOUR_MS > TICK_MS && sched_mode() != s_leg->mode) wrongMode[leg]++;
+    unsigned long next = now - now % TICK_MS + TICK_MS;
+    if (millis() < next) delay(next - millis());
+  }
+
+  // every sample arrived once, in order; the last leg flushed the backlog
+  CHECK(s_got.size() == made && tsq_depth() == 0);
+  for (uint32_t i = 0; i < s_got.size(); ++i) CHECK(s_got[i] == i);
+  CHECK(s_sends[0] == s_wifiSends && s_delivered[0] + s_delivered[1] == made);
+
+  unsigned long lteRadioMs = 0;
+  for (size_t k = 0; k < LEG_COUNT; ++k) {
+    const Leg &l = LEGS[k];
+    unsigned long hours = l.toH - l.fromH;
+    CHECK(wrongMode[k] == 0);
+
+    // CSQ: never while WiFi is up, at most once a minute otherwise
+    if (l.wifi) CHECK(s_csqPolls[k] == 0);
+    else CHECK(s_csqPolls[k] > 0 && s_csqPolls[k] <= hours * 60 + 1);
+
+    // samples made here wait no longer than this leg allows, or the next
+    // one when they are still held at the change
+    unsigned long holdMin = l.holdMin, maxWaitMs = 0;
+    if (k + 1 < LEG_COUNT && LEGS[k + 1].holdMin > holdMin) holdMin = LEGS[k + 1].holdMin;
+    for (uint32_t i = 0; i < made; ++i) {
+      if (s_madeIn[i] == k && s_waitMs[i] > maxWaitMs) maxWaitMs = s_waitMs[i];
+    }
+    CHECK(maxWaitMs <= holdMin * 60000UL + TICK_MS);
+
+    // LTE sessions: every sample on its own while sending as queued, one
+    // burst per age limit while deferred or saving. The limit counts from
+    // the first held sample, so a burst can come up to a sample interval
+    // later than the limit after the last one.
+    std::vector<unsigned long> starts;
+    unsigned long onMs = 0;
+    for (const Session &s : s_sessions) {
+      if (s.leg != k) continue;
+      starts.push_back(s.startMs);
+      onMs += s.onMs;
+    }
+    lteRadioMs += onMs;
+    if (!l.lteGapMin) {
+      CHECK(starts.empty());
+    } else {
+      CHECK(starts.size() >= 2);
+      CHECK(starts.size() <= hours * 60 / l.lteGapMin + 1);
+      for (size_t i = 1; i < starts.size(); ++i) {
+        long gapMin = (long)((starts[i] - starts[i - 1]) / 60000UL);
+        CHECK(gapMin >= (long)l.lteGapMin && gapMin <= (long)(l.lteGapMin + SAMPLE_MS / 60000UL));
+      }
+    }
+    uint32_t perDayMs = (uint32_t)(onMs * 24 / hours);
+    CHECK(perDayMs <= l.budgetS * 1000UL);
+
+    printf("%-10s %-6s csq %2d batt %2d-%2d%%: longest wait %4lu min, %2zu LTE sessions, radio %5.1f s/day, "
+           "%4u CSQ polls\n",
+           l.name, sched_modeName(l.mode), l.csq, l.battFrom, l.battTo, maxWaitMs / 60000UL, starts.size(),
+           perDayMs / 1000.0, s_csqPolls[k]);
+  }
+  // the scheduler's own accounting saw the same send time
+  CHECK(s_radioMs[1] == s_lteSendMs);
+  printf("%u samples, %u LTE sessions, %lu s LTE radio in %lu days\n", made, (unsigned)s_sessions.size(),
+         lteRadioMs / 1000UL, endMs / (24 * HOUR_MS));
+
+  std::filesystem::remove_all(card);
+  return check_done("upload_scheduler");
+}
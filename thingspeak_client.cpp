@@ -1,12 +1,19 @@
 #include "thingspeak_client.h"
 #include "config.h"
+#include "mem_telemetry.h"
+#include "sd_storage.h"
+#include "time_manager.h"
+#include "modem_manager.h"
+#include "telemetry_sink.h"
+#include "wifi_manager.h"
+#include "settings.h"
 #include <WiFi.h>
 #include <HTTPClient.h>
-#include <Preferences.h>
 #include <SD.h>
-
-// forward to attempt auto connect from stored WiFi credentials
-extern void wifi_connectFromPrefs(unsigned long timeoutMs);
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 
 // minimal URL-encode helper
 static String urlEncode(const String &str) {
@@ -30,29 +37,6 @@ static void fmt2(char *buf, size_t bufsz, double v) {
   snprintf(buf, bufsz, "%.2f", v);
 }
 
-// append a line (bodyPairs) to the SD-backed queue file
-static bool enqueuePost(const String &bodyPairs) {
-  if (!SD.begin(SD_CS)) {
-#if ENABLE_DEBUG
-    Serial.println("[TS] SD.begin failed - cannot enqueue");
-#endif
-    return false;
-  }
-  File f = SD.open(TS_QUEUE_FILENAME, FILE_APPEND);
-  if (!f) {
-#if ENABLE_DEBUG
-    Serial.println("[TS] open queue file failed");
-#endif
-    return false;
-  }
-  f.println(bodyPairs);
-  f.close();
-#if ENABLE_DEBUG
-  Serial.println("[TS] enqueued post");
-#endif
-  return true;
-}
-
 // try to post via HTTPClient over WiFi
 static bool postViaWiFi(const String &postBody) {
   HTTPClient http;
@@ -71,38 +55,119 @@ static bool postViaWiFi(const String &postBody) {
   return false;
 }
 
-bool sendToThingSpeak(const String &bodyPairs) {
-  // Build coordinates field from Preferences
-  Preferences p;
-  p.begin("beehive", true);
-  String latS = p.getString("owm_lat", "");
-  String lonS = p.getString("owm_lon", "");
-  p.end();
-  double lat = DEFAULT_LAT;
-  double lon = DEFAULT_LON;
-  if (latS.length() && lonS.length()) {
-    lat = latS.toDouble();
-    lon = lonS.toDouble();
-  }
-  char latBuf[32], lonBuf[32];
-  snprintf(latBuf, sizeof(latBuf), "%.4f", lat);
-  snprintf(lonBuf, sizeof(lonBuf), "%.4f", lon);
-  // coords as "lat lon" (space separated)
-  String coords = String(latBuf) + String(" ") + String(lonBuf);
-  // use existing urlEncode (which turns spaces -> +)
-  String coordsEnc = urlEncode(coords);
+int thingspeak_httpExchange(Client &client, const char *path, const char *contentType,
+                            const String &postBody, String &respBody) {
+  // build HTTP POST request
+  String req;
+  req.reserve(postBody.length() + 200);
+  req  = String("POST ") + path + String(" HTTP/1.1\r\n");
+  req += String("Host: " TS_HOST "\r\n");
+  req += String("Content-Type: ") + contentType + String("\r\n");
+  req += String("Content-Length: ") + String(postBody.length()) + String("\r\n");
+  req += String("Connection: close\r\n\r\n");
+  req += postBody;
+
+  client.print(req);
+
+  #if ENABLE_DEBUG
+    Serial.println("[TS] Sent HTTP POST, waiting for response...");
+  #endif
+
+  // Headers and body often arrive in separate segments: read until the
+  // body is complete (Content-Length), the server closes (Connection:
+  // close, e.g. chunked replies) or the deadline
+  unsigned long start = millis();
+  String resp;
+  int hdrEnd = -1;
+  long contentLen = -1;
+  bool chunked = false;
+  while (millis() - start < 8000 && resp.length() < 4096) {
+    bool got = false;
+    while (client.available() && resp.length() < 4096) {
+      resp += (char)client.read();
+      got = true;
+    }
+    if (hdrEnd < 0 && (hdrEnd = resp.indexOf("\r\n\r\n")) >= 0) {
+      String hdr = resp.substring(0, hdrEnd);
+      hdr.toLowerCase();
+      int cl = hdr.indexOf("\r\ncontent-length:");
+      if (cl >= 0) contentLen = hdr.substring(cl + 17).toInt();
+      chunked = hdr.indexOf("\r\ntransfer-encoding: chunked") >= 0;
+    }
+    if (hdrEnd >= 0 && !chunked && contentLen >= 0 && (long)resp.length() >= hdrEnd + 4 + contentLen) break;
+    if (!got) {
+      if (!client.connected()) break;
+      delay(20);
+    }
+  }
+
+  client.stop();
+
+  #if ENABLE_DEBUG
+    if (resp.length()) {
+      Serial.print("[TS] HTTP response (truncated 1024): ");
+      if (resp.length() > 1024) Serial.println(resp.substring(0,1024));
+      else Serial.println(resp);
+    } else {
+      Serial.println("[TS] HTTP response empty");
+    }
+  #endif
+
+  // "HTTP/1.1 200 OK"
+  if (!resp.startsWith("HTTP/1.")) return 0;
+  int sp = resp.indexOf(' ');
+  int code = (sp > 0) ? resp.substring(sp + 1).toInt() : 0;
+  respBody = String();
+  if (hdrEnd < 0) return code;
+  if (!chunked) {
+    respBody = resp.substring(hdrEnd + 4);
+  } else {
+    // <hex size>\r\n<data>\r\n ... 0\r\n\r\n
+    int pos = hdrEnd + 4;
+    for (;;) {
+      int eol = resp.indexOf("\r\n", pos);
+      if (eol < 0) break;
+      long n = strtol(resp.c_str() + pos, nullptr, 16);
+      if (n <= 0 || eol + 2 + n > (long)resp.length()) break;
+      respBody += resp.substring(eol + 2, eol + 2 + n);
+      pos = eol + 2 + n + 2;
+    }
+  }
+  respBody.trim();
+  return code;
+}
 
+// field8: "lat lon" from settings (urlEncode turns the space into '+')
+static String coordsField() {
+  const Settings &cfg = settings();
+  char coords[48];
+  snprintf(coords, sizeof(coords), "%.4f %.4f", cfg.hasCoords ? cfg.lat : DEFAULT_LAT,
+           cfg.hasCoords ? cfg.lon : DEFAULT_LON);
+  return urlEncode(coords);
+}
+
+// Write key: settings (set with 'ts key'), else config.h
+const char *thingspeak_apiKey() {
+  const char *key = settings().tsKey;
+  return key[0] ? key : THINGSPEAK_WRITE_APIKEY;
+}
+
+bool thingspeak_setApiKey(const char *key) {
+  return settings_setTsKey(key);
+}
+
+bool sendToThingSpeak(const String &bodyPairs) {
   // Build final POST body: api_key + caller pairs + field8
   String post;
   post.reserve(256);
   post += "api_key=";
-  post += THINGSPEAK_WRITE_APIKEY;
+  post += thingspeak_apiKey();
   if (bodyPairs.length()) {
     post += "&";
     post += bodyPairs;
   }
   post += "&field8=";
-  post += coordsEnc;
+  post += coordsField();
 
   // 1) If WiFi connected, post immediately
   if (WiFi.status() == WL_CONNECTED) {
@@ -110,122 +175,314 @@ bool sendToThingSpeak(const String &bodyPairs) {
     Serial.println("[TS] WiFi connected - posting via WiFi");
 #endif
     bool ok = postViaWiFi(post);
-    if (ok) return true;
 #if ENABLE_DEBUG
-    Serial.println("[TS] WiFi post failed - enqueueing");
+    if (!ok) Serial.println("[TS] WiFi post failed");
 #endif
-    enqueuePost(bodyPairs);  // store original bodyPairs (field8 will be appended when retried)
-    return false;
+    return ok;
   }
 
-// 2) Try to auto-connect to known WiFi briefly
-#if ENABLE_DEBUG
-  Serial.println("[TS] WiFi not connected - attempting auto-connect");
-#endif
-  wifi_connectFromPrefs(8000);
-  delay(200);
-  if (WiFi.status() == WL_CONNECTED) {
-#if ENABLE_DEBUG
-    Serial.println("[TS] Auto-connect succeeded - posting via WiFi");
-#endif
-    bool ok = postViaWiFi(post);
-    if (ok) return true;
+  // 2) Ask wifi_manager to associate; the caller retries later
 #if ENABLE_DEBUG
-    Serial.println("[TS] WiFi post after auto-connect failed - enqueueing");
+  Serial.println("[TS] No WiFi - post not sent, connect requested");
 #endif
-    enqueuePost(bodyPairs);
-    return false;
+  wifi_connectNow();
+  return false;
+}
+
+// field1..field7 in order: weight (kg), internal temp, internal humidity,
+// external temp, external humidity, pressure, battery voltage
+static const struct { SampleChannel ch; const char *fmt; } kTsFields[] = {
+  { CH_WEIGHT,   "%.1f" },
+  { CH_TEMP_INT, "%.1f" },
+  { CH_HUM_INT,  "%.0f" },
+  { CH_TEMP_EXT, "%.1f" },
+  { CH_HUM_EXT,  "%.0f" },
+  { CH_PRESSURE, "%.0f" },
+  { CH_BATT,     "%.2f" },
+};
+
+static void isoTime(char *buf, size_t bufsz, uint32_t ts) {
+  time_t t = (time_t)ts;
+  struct tm tmv;
+  gmtime_r(&t, &tmv);
+  snprintf(buf, bufsz, "%04d-%02d-%02dT%02d:%02d:%02dZ",
+           tmv.tm_year + 1900, tmv.tm_mon + 1, tmv.tm_mday, tmv.tm_hour, tmv.tm_min, tmv.tm_sec);
+}
+
+String thingspeak_samplePairs(const TelemetrySample &s) {
+  char buf[64];
+  String b;
+  b.reserve(200);
+
+  for (size_t i = 0; i < sizeof(kTsFields) / sizeof(kTsFields[0]); ++i) {
+    snprintf(buf, sizeof(buf), kTsFields[i].fmt, sample_value(s, kTsFields[i].ch));
+    b += i ? "&field" : "field";
+    b += String((unsigned)(i + 1));
+    b += "=";
+    b += urlEncode(String(buf));
   }
 
-// 3) No WiFi available - enqueue for later retry
-#if ENABLE_DEBUG
-  Serial.println("[TS] No WiFi - enqueueing post for later");
-#endif
-  enqueuePost(bodyPairs);
-  return false;
+  // created_at keeps queued samples at their measurement time
+  if (s.ts) {
+    isoTime(buf, sizeof(buf), s.ts);
+    b += "&created_at=" + urlEncode(String(buf));
+  }
+  return b;
 }
 
-bool thingspeak_upload_current() {
-  // Build body with fields 1..7 from global test_ variables
+String thingspeak_bulkEntry(const TelemetrySample &s) {
   char buf[64];
   String b;
-  b.reserve(160);
+  b.reserve(200);
+  b += "{";
+  if (s.ts) {
+    isoTime(buf, sizeof(buf), s.ts);
+    b += "\"created_at\":\"";
+    b += buf;
+    b += "\",";
+  }
+  for (size_t i = 0; i < sizeof(kTsFields) / sizeof(kTsFields[0]); ++i) {
+    snprintf(buf, sizeof(buf), kTsFields[i].fmt, sample_value(s, kTsFields[i].ch));
+    if (i) b += ",";
+    b += "\"field";
+    b += String((unsigned)(i + 1));
+    b += "\":";
+    b += buf;
+  }
+  b += "}";
+  return b;
+}
+
+String thingspeak_buildPost(const TelemetrySample &s, bool fresh) {
+  String post;
+  post.reserve(256);
+  post += "api_key=";
+  post += thingspeak_apiKey();
+  post += "&";
+  post += thingspeak_samplePairs(s);
+  post += "&field8=";
+  post += coordsField();
+  if (fresh) mem_appendThingSpeakStatus(post);
+  return post;
+}
+
+bool thingspeak_upload_current() {
+  TelemetrySample s;
+  sample_capture(s);
+  String pairs = thingspeak_samplePairs(s);
+  mem_appendThingSpeakStatus(pairs);
+  return sendToThingSpeak(pairs);
+}
+
+// ---------------------------------------------------------
+// Telemetry sink: one update per 15 s (free channel limit), over WiFi when
+// associated, else over the modem. Link management is left to the loop.
+// ---------------------------------------------------------
+static bool ts_sinkEnabled() {
+  return thingspeak_apiKey()[0] != '\0';
+}
 
-  // field1: weight (kg) 1 decimal
-  snprintf(buf, sizeof(buf), "%.1f", test_weight);
-  b += "field1=" + urlEncode(String(buf));
+static bool ts_sinkReady() {
+  return WiFi.status() == WL_CONNECTED || modem_isNetworkRegistered();
+}
 
-  // field2: internal temp 1 decimal
-  snprintf(buf, sizeof(buf), "%.1f", test_temp_int);
-  b += "&field2=" + urlEncode(String(buf));
+#if TS_LINK_RACE
+// Link race. The WiFi leg runs in its own task (lwIP sockets are thread
+// safe); the LTE leg runs in the caller, which owns the modem. The leg whose
+// TCP connect completes first claims the race and sends; the other one
+// closes its socket without sending, so ThingSpeak gets a single request.
+// A lost reply still leads to a retry of the same sample, which carries the
+// same created_at, so consumers can drop the duplicate by timestamp.
+//
+// The race state is shared by reference count, so the caller never waits
+// for a losing WiFi connect; a losing LTE connect (AT commands in the
+// caller) is cut off by TS_RACE_CONNECT_MS.
+enum { LEG_NONE = -1, LEG_WIFI = 0, LEG_LTE = 1 };
 
-  // field3: internal humidity 0 decimals
-  snprintf(buf, sizeof(buf), "%.0f", test_hum_int);
-  b += "&field3=" + urlEncode(String(buf));
+struct TsRace {
+  String            post;
+  std::atomic<int>  winner;
+  std::atomic<int>  refs;            // the caller and the WiFi task
+  volatile bool     wifiOk;
+  SemaphoreHandle_t wifiDone;        // the WiFi leg has its result
+};
 
-  // field4: external temp 1 decimal
-  snprintf(buf, sizeof(buf), "%.1f", test_temp_ext);
-  b += "&field4=" + urlEncode(String(buf));
+static void ts_raceRelease(TsRace *r) {
+  if (r->refs.fetch_sub(1) == 1) {
+    vSemaphoreDelete(r->wifiDone);
+    delete r;
+  }
+}
 
-  // field5: external humidity 0 decimals
-  snprintf(buf, sizeof(buf), "%.0f", test_hum_ext);
-  b += "&field5=" + urlEncode(String(buf));
+static bool ts_raceClaim(TsRace &r, int leg) {
+  int none = LEG_NONE;
+  return r.winner.compare_exchange_strong(none, leg);
+}
 
-  // field6: pressure 0 decimals
-  snprintf(buf, sizeof(buf), "%.0f", test_pressure);
-  b += "&field6=" + urlEncode(String(buf));
+static bool ts_racePost(Client &client, const String &post) {
+  String body;
+  return thingspeak_httpExchange(client, "/update", "application/x-www-form-urlencoded", post, body) == 200 &&
+         body.toInt() > 0;
+}
 
-  // field7: battery voltage 2 decimals
-  snprintf(buf, sizeof(buf), "%.2f", test_batt_voltage);
-  b += "&field7=" + urlEncode(String(buf));
+static void ts_raceWifiTask(void *arg) {
+  TsRace *r = (TsRace*)arg;
+  WiFiClient client;
+  if (client.connect(TS_HOST, 80, TS_RACE_CONNECT_MS) && ts_raceClaim(*r, LEG_WIFI)) {
+    r->wifiOk = ts_racePost(client, r->post);
+  }
+  client.stop();
+  xSemaphoreGive(r->wifiDone);
+  ts_raceRelease(r);
+  vTaskDelete(nullptr);
+}
 
-  return sendToThingSpeak(b);
+// Both links carry traffic (WiFi associated, GPRS attached) and net_pref
+// lets either one upload
+static bool ts_raceLinks() {
+  return settings().netPref == 0 && WiFi.status() == WL_CONNECTED && modem_isReady() &&
+         modem_get().isGprsConnected();
 }
 
-// Attempt to flush queued posts from SD. Only runs when WiFi is connected.
-void retryQueuedThingSpeak() {
-  if (WiFi.status() != WL_CONNECTED) return;
-  if (!SD.begin(SD_CS)) {
+// Returns true when the winning leg got an entry id back. A winner whose
+// exchange fails hands the sample to the other link once.
+static bool ts_raceSend(const String &post) {
+  TsRace *r = new TsRace;
+  r->post = post;
+  r->winner = LEG_NONE;
+  r->refs = 2;
+  r->wifiOk = false;
+  r->wifiDone = xSemaphoreCreateBinary();
+  if (!r->wifiDone) {
+    delete r;
+    return false;
+  }
+  if (xTaskCreate(ts_raceWifiTask, "TsRace", TS_RACE_TASK_STACK, r, 1, nullptr) != pdPASS) {
+    vSemaphoreDelete(r->wifiDone);
+    delete r;
+    return false;
+  }
+
+  unsigned long t0 = millis();
+  bool lteOk = false;
+  {
+    TinyGsmClient client(modem_get());
+    client.setTimeout(15000);
+    if (r->winner == LEG_NONE && client.connect(TS_HOST, 80, TS_RACE_CONNECT_MS / 1000) &&
+        ts_raceClaim(*r, LEG_LTE)) {
+      lteOk = ts_racePost(client, post);
+    }
+    client.stop();
+  }
+
+  // wait for the WiFi leg only while it can still deliver: it won, or the
+  // LTE connect failed before either leg claimed the race
+  bool wifiOk = false;
+  if (r->winner != LEG_LTE) {
+    xSemaphoreTake(r->wifiDone, portMAX_DELAY);
+    wifiOk = r->wifiOk;
+  }
+  int winner = r->winner;
+  ts_raceRelease(r);
+
+  bool ok = winner == LEG_WIFI ? wifiOk : lteOk;
+  const char *fallback = "";
+  if (!ok && winner == LEG_WIFI) {
+    fallback = ", LTE fallback";
+    ok = thingspeak_post_via_modem(post);
+  } else if (!ok && winner == LEG_LTE && WiFi.status() == WL_CONNECTED) {
+    fallback = ", WiFi fallback";
+    ok = postViaWiFi(post);
+  }
+  Serial.printf("[TS] link race: %s won%s, %s, %lu ms\n",
+                winner == LEG_WIFI ? "WiFi" : winner == LEG_LTE ? "LTE" : "no link", fallback,
+                ok ? "delivered" : "failed", millis() - t0);
+  return ok;
+}
+#endif
+
+static uint8_t ts_sinkSend(const TelemetrySample *batch, uint8_t n) {
+  (void) n;
+  const TelemetrySample &s = batch[0];
+  // the memory status only describes samples taken just now
+  bool fresh = s.ts == 0 || (uint32_t)time(nullptr) - s.ts < 120;
+  String post = thingspeak_buildPost(s, fresh);
+  bool wifi = WiFi.status() == WL_CONNECTED;
+#if TS_LINK_RACE
+  if (wifi && ts_raceLinks()) return ts_raceSend(post) ? 1 : 0;
+#endif
+  if (wifi) {
+    if (postViaWiFi(post)) return 1;
 #if ENABLE_DEBUG
-    Serial.println("[TS] SD.begin failed - cannot retry queue");
+    Serial.println("[TS] WiFi post failed");
 #endif
-    return;
   }
+  if (modem_isNetworkRegistered() && thingspeak_post_via_modem(post)) return 1;
+  return 0;
+}
+
+const TelemetrySink &thingspeak_sink() {
+  static const TelemetrySink sink = {
+    "thingspeak", ts_sinkEnabled, ts_sinkReady, ts_sinkSend, nullptr,
+    1, 15000UL, 30000UL, 900000UL
+  };
+  return sink;
+}
 
-  File f = SD.open(TS_QUEUE_FILENAME, FILE_READ);
-  if (!f) return;  // nothing to do
-
-  // Read all lines into memory (small queue expected). Keep lines that fail.
-  std::vector<String> remaining;
-  while (f.available()) {
-    String line = f.readStringUntil('\n');
-    line.trim();
-    if (line.length() == 0) continue;
-    // attempt send
-    bool ok = sendToThingSpeak(line);
-    if (!ok) {
-      remaining.push_back(line);
-      // if send failed, we stop further sends to avoid hammering; break to rewrite remaining
-      break;
+// Flush the legacy text queue left by older firmware (one form body per line).
+// The card is locked only to read and to rewrite the file, never across a
+// POST, so the web server and the sinks are not held up by the network.
+static void retryLegacyTextQueue() {
+  // Read all lines into memory (small queue expected)
+  std::vector<String> lines;
+  {
+    SdLock lk;
+    if (!lk) {
+#if ENABLE_DEBUG
+      Serial.println("[TS] SD not mounted - cannot retry queue");
+#endif
+      return;
+    }
+    File f = SD.open(TS_QUEUE_FILENAME, FILE_READ);
+    if (!f) return;  // nothing to do
+    while (f.available()) {
+      String line = f.readStringUntil('\n');
+      line.trim();
+      if (line.length()) lines.push_back(line);
     }
-    // success -> continue with next
+    f.close();
   }
-  f.close();
 
-  // Rewrite queue file with remaining entries
-  if (remaining.empty()) {
+  // if a send fails, stop further sends to avoid hammering; keep the line
+  // that failed and everything after it
+  size_t sent = 0;
+  while (sent < lines.size() && sendToThingSpeak(lines[sent])) sent++;
+
+  SdLock lk;
+  if (!lk) return;                     // card gone: the sent lines go again next time
+  if (sent == lines.size()) {
     SD.remove(TS_QUEUE_FILENAME);
 #if ENABLE_DEBUG
-    Serial.println("[TS] queue flushed");
+    Serial.println("[TS] legacy queue flushed");
 #endif
-  } else {
-    File fw = SD.open(TS_QUEUE_FILENAME, FILE_WRITE);
-    if (fw) {
-      fw.seek(0);
-      for (auto &ln : remaining) {
-        fw.println(ln);
-      }
-      fw.close();
+    return;
+  }
+  if (!sent) return;                   // file unchanged
+  File fw = SD.open(TS_QUEUE_FILENAME, FILE_WRITE);
+  if (fw) {
+    for (size_t i = sent; i < lines.size(); ++i) {
+      String &ln = lines[i];
+      ln += '\n';
+      sd_write(fw, (const uint8_t*)ln.c_str(), ln.length());
     }
+    fw.close();
+  } else {
+    sd_noteError(TS_QUEUE_FILENAME);
   }
-}
\ No newline at end of file
+}
+
+// Attempt to flush the legacy queue from SD. Only runs when WiFi is connected.
+void retryQueuedThingSpeak() {
+  if (WiFi.status() != WL_CONNECTED) return;
+  retryLegacyTextQueue();
+}
@@ -1,21 +1,67 @@
 #pragma once
 #include <Arduino.h>
+#include "telemetry_sample.h"
+
+#define TS_HOST "api.thingspeak.com"
+
+// When WiFi is associated, GPRS attached and net_pref is auto, a queued
+// sample is uploaded over whichever link completes its TCP connect first
+// (see ts_raceSend()).
+#ifndef TS_LINK_RACE
+#define TS_LINK_RACE 1
+#endif
+
+#ifndef TS_RACE_CONNECT_MS
+#define TS_RACE_CONNECT_MS 5000      // connect timeout of either leg
+#endif
+
+#ifndef TS_RACE_TASK_STACK
+#define TS_RACE_TASK_STACK 4096
+#endif
 
 // ThingSpeak client API
 bool initThingSpeakClient();
 
 // Send telemetry bodyPairs (e.g. "field1=23.5&field2=60.0").
 // This function implements WiFi-first policy: if WiFi is available it will
-// POST immediately, otherwise it will try to auto-connect to known WiFi and
-// if still unavailable it will enqueue the body for later retry (SD card).
+// POST immediately, otherwise it asks wifi_manager to connect and returns false.
+// Nothing is queued here; samples reach ThingSpeak through its telemetry
+// sink (thingspeak_sink(), see telemetry_sink.h).
 bool sendToThingSpeak(const String &bodyPairs);
 
-// Upload the current telemetry using the project's global test_* variables
-// (used by loop()). Returns true on immediate success.
+// field1..field7 for a sample, plus created_at when the sample has a timestamp
+String thingspeak_samplePairs(const TelemetrySample &s);
+
+// One entry of a bulk_update "updates" array: {"created_at":"...","field1":...}
+String thingspeak_bulkEntry(const TelemetrySample &s);
+
+// Full form body: api_key, sample pairs, field8 coordinates
+// (and the memory status text for fresh samples, see mem_telemetry.h).
+String thingspeak_buildPost(const TelemetrySample &s, bool fresh);
+
+// Write API key: settings.h override ('ts key' serial command), else THINGSPEAK_WRITE_APIKEY.
+// An empty key disables the ThingSpeak sink.
+const char *thingspeak_apiKey();
+bool thingspeak_setApiKey(const char *key);    // empty/nullptr restores the default
+
+// Send one POST to TS_HOST on an already connected client (WiFi or modem)
+// and read the reply; the client is closed afterwards. Returns the HTTP
+// status (0 without a response), body in respBody.
+int thingspeak_httpExchange(Client &client, const char *path, const char *contentType,
+                            const String &postBody, String &respBody);
+
+// Modem (LTE) transport, thingspeak_client_modem.cpp
+bool thingspeak_post_via_modem(const String &postBody);
+// POST /channels/<id>/bulk_update.json, body {"write_api_key":..,"updates":[..]}
+bool thingspeak_bulk_via_modem(uint32_t channelId, const String &json);
+
+// Upload the current telemetry right now, bypassing the queue (serial 'ts send').
+// Returns true on success.
 bool thingspeak_upload_current();
 
-// Attempt to flush queued posts (will only try when WiFi is connected).
+// Flush the legacy text queue (will only try when WiFi is connected).
 void retryQueuedThingSpeak();
 
-// Filename on SD for queued ThingSpeak posts (one per line)
+// Legacy (pre-binary queue) file on SD with one form body per line.
+// Still drained by retryQueuedThingSpeak(); new samples go through the sinks.
 static const char *TS_QUEUE_FILENAME = "/ts_queue.txt";
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "time_manager.h"
 #include "modem_manager.h"
 #include "config.h"
-#include <WiFi.h>
+#include "wifi_manager.h"
 #include <time.h>
 
 // ---------------------------------------------------------
@@ -24,21 +24,6 @@ static int          attempt     = 0;
 static bool        time_valid   = false;
 static TimeSource  time_source  = TSRC_NONE;
 
-// ---------------------------------------------------------
-// WIFI HOTSPOTS (from your previous working setup)
-// ---------------------------------------------------------
-static const char* hotspot_ssids[] = {
-  "COSMOTE-32bssa",
-  "Redmi Note 13",
-  nullptr
-};
-
-static const char* hotspot_pass[] = {
-  "vudvvc5x97s4afpk",
-  "nen57asz5g44sh2",
-  nullptr
-};
-
 // ---------------------------------------------------------
 // INIT
 // ---------------------------------------------------------
@@ -53,25 +38,6 @@ void timeManager_init() {
   time_source = TSRC_NONE;
 }
 
-// ---------------------------------------------------------
-// WIFI HELPER
-// ---------------------------------------------------------
-static bool tryConnectToWifi() {
-  int n = WiFi.scanNetworks();
-  if (n <= 0) return false;
-
-  for (int i = 0; hotspot_ssids[i] != nullptr; i++) {
-    const char* target = hotspot_ssids[i];
-    for (int j = 0; j < n; j++) {
-      if (WiFi.SSID(j) == target) {
-        WiFi.begin(target, hotspot_pass[i]);
-        return true;
-      }
-    }
-  }
-  return false;
-}
-
 // ---------------------------------------------------------
 // UPDATE
 // ---------------------------------------------------------
@@ -86,6 +52,18 @@ void timeManager_update() {
       if (now - last_query < 3000) return;
       last_query = now;
 
+      if (!modem_isReady()) {
+        // Modem still booting in the background. If WiFi came up first, use
+        // NTP right away; otherwise wait for the bring-up to complete.
+        if (wifi_isConnected()) {
+          time_source = TSRC_WIFI;
+          state       = TS_NTP_REQUEST;
+        } else if (modem_isBootDone()) {
+          state = TS_WIFI_SCAN;   // modem failed to come up
+        }
+        break;
+      }
+
       TinyGsm& modem = modem_get();
 
       modem.sendAT("+CCLK?");
@@ -124,21 +102,17 @@ void timeManager_update() {
       if (now - last_query < 5000) return;
       last_query = now;
 
-      WiFi.mode(WIFI_STA);
-      WiFi.disconnect(false);
-
-      if (tryConnectToWifi())
-        state = TS_WIFI_CONNECTING;
-      else
-        state = TS_FAIL;
+      // the hotspot list lives in wifi_manager as fallback credentials
+      wifi_connectNow();
+      state = TS_WIFI_CONNECTING;
       break;
 
     case TS_WIFI_CONNECTING:
-      if (WiFi.status() == WL_CONNECTED) {
+      if (wifi_isConnected()) {
         time_source = TSRC_WIFI;
         state       = TS_NTP_REQUEST;
         last_query  = now;
-      } else if (now - last_query > 8000) {
+      } else if (now - last_query > 30000) {   // scan + every candidate
         state = TS_FAIL;
       }
       break;
@@ -172,6 +146,14 @@ void timeManager_update() {
 // ---------------------------------------------------------
 // ACCESSORS
 // ---------------------------------------------------------
+void timeManager_setExternal(uint32_t epoch) {
+  struct timeval tv = { (time_t)epoch, 0 };
+  settimeofday(&tv, nullptr);
+  time_valid  = true;
+  time_source = TSRC_GATEWAY;
+  state       = TS_DONE;
+}
+
 bool timeManager_isTimeValid() {
   return time_valid;
 }
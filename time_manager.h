@@ -6,7 +6,8 @@
 enum TimeSource {
     TSRC_NONE = 0,
     TSRC_WIFI,
-    TSRC_LTE
+    TSRC_LTE,
+    TSRC_GATEWAY      // satellite node: clock received with gateway acks
 };
 
 void   timeManager_init();
@@ -16,5 +17,9 @@ String timeManager_getDate();   // local, DD-MM-YYYY
 String timeManager_getTime();   // local, HH:MM:SS
 TimeSource timeManager_getSource();
 
+// Set the clock from a trusted peer (ESP-NOW gateway ack) and stop the
+// LTE/WiFi sync state machine.
+void   timeManager_setExternal(uint32_t epoch);
+
 #endif
 
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""Embed the pages under web/ into the firmware.
+
+Writes web_assets.h / web_assets.cpp next to the sketch: every file is
+stored gzip-compressed (level 9, no timestamp, so the output only changes
+with the content) together with a strong ETag taken from the SHA-256 of
+the uncompressed bytes. http_sendAsset() serves them with
+Content-Encoding: gzip and answers If-None-Match with 304.
+
+Files under web/assets/ get the first 8 hex digits of their hash in the
+name (app.js -> /assets/app.1a2b3c4d.js) and are marked immutable, so
+browsers cache them for a year. Pages refer to them by their plain name
+("/assets/app.js"); the reference is rewritten here, which also changes
+the page's ETag whenever an asset changes. Pages keep their path and are
+revalidated on every load.
+
+Run after editing anything in web/ and commit the generated files:
+
+    python3 tools/embed_assets.py
+
+--check regenerates in memory and fails (exit 1) if web_assets.* are out
+of date or an asset is over its gzip size budget; run it before a build.
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+WEB_DIR = os.path.join(ROOT, "web")
+OUTPUTS = ("web_assets.h", "web_assets.cpp")
+
+# Flash is shared with two OTA slots: keep the UI small
+BUDGET_ASSET = 8 * 1024          # gzipped bytes per file
+BUDGET_TOTAL = 20 * 1024         # gzipped bytes for everything
+
+TYPES = {
+    ".html": "text/html; charset=utf-8",
+    ".css": "text/css; charset=utf-8",
+    ".js": "application/javascript; charset=utf-8",
+    ".json": "application/json; charset=utf-8",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+}
+
+HEADER = "// Generated by tools/embed_assets.py from web/ - do not edit.\n"
+
+
+def symbol(rel):
+    return "WEB_" + re.sub(r"[^A-Za-z0-9]", "_", rel).upper()
+
+
+def make_asset(rel, raw, immutable):
+    digest = hashlib.sha256(raw).hexdigest()
+    path = "/" + rel
+    if immutable:
+        stem, ext = os.path.splitext(path)
+        path = "%s.%s%s" % (stem, digest[:8], ext)
+    return {
+        "rel": rel,
+        "path": path,
+        "sym": symbol(rel),
+        "type": TYPES[os.path.splitext(rel)[1].lower()],
+        "etag": '"' + digest[:16] + '"',
+        "immutable": immutable,
+        "raw": len(raw),
+        "gz": gzip.compress(raw, 9, mtime=0),
+    }
+
+
+def collect():
+    files = []
+    for dirpath, _, names in os.walk(WEB_DIR):
+        for name in sorted(names):
+            path = os.path.join(dirpath, name)
+            rel = os.path.relpath(path, WEB_DIR).replace(os.sep, "/")
+            if os.path.splitext(name)[1].lower() not in TYPES:
+                sys.exit("embed_assets: no content type for " + rel)
+            with open(path, "rb") as f:
+                files.append((rel, f.read()))
+
+    # Hashed assets first, so the pages can point at their final names
+    assets = [make_asset(rel, raw, True) for rel, raw in files if rel.startswith("assets/")]
+    for rel, raw in files:
+        if rel.startswith("assets/"):
+            continue
+        for a in assets:
+            raw = raw.replace(("/" + a["rel"]).encode(), a["path"].encode())
+        assets.append(make_asset(rel, raw, False))
+    return sorted(assets, key=lambda a: a["path"])
+
+
+def render_header(assets):
+    out = [HEADER, "//\n// path                              bytes   gzip  etag\n"]
+    for a in assets:
+        out.append("// %-32s %6d %6d  %s%s\n" % (a["path"], a["raw"], len(a["gz"]), a["etag"],
+                                                 "  immutable" if a["immutable"] else ""))
+    out.append("\n#ifndef WEB_ASSETS_H\n#define WEB_ASSETS_H\n\n#include \"http_server.h\"\n\n")
+    for a in assets:
+        out.append("extern const WebAsset %s;%s// %s\n" % (a["sym"], " " * max(1, 28 - len(a["sym"])), a["path"]))
+    out.append("\n#define WEB_ASSET_COUNT %d\n" % len(assets))
+    out.append("extern const WebAsset *const WEB_ASSETS[WEB_ASSET_COUNT];\n\n")
+    out.append("// Asset served at uri (query string ignored), nullptr if none\n")
+    out.append("const WebAsset *web_findAsset(const char *uri);\n\n#endif // WEB_ASSETS_H\n")
+    return "".join(out)
+
+
+def render_source(assets):
+    out = [HEADER, "#include \"web_assets.h\"\n"]
+    for a in assets:
+        out.append("\n// %s: %d bytes, %d gzipped\n" % (a["path"], a["raw"], len(a["gz"])))
+        out.append("static const uint8_t %s_GZ[] PROGMEM = {\n" % a["sym"])
+        data = a["gz"]
+        for i in range(0, len(data), 16):
+            out.append("  " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",\n")
+        out.append("};\n")
+        out.append("const WebAsset %s = { \"%s\", \"%s\", \"%s\", %s_GZ, sizeof(%s_GZ), %s };\n" % (
+            a["sym"], a["path"], a["type"], a["etag"].replace('"', '\\"'), a["sym"], a["sym"],
+            "true" if a["immutable"] else "false"))
+    out.append("\nconst WebAsset *const WEB_ASSETS[WEB_ASSET_COUNT] = {\n")
+    for a in assets:
+        out.append("  &%s,\n" % a["sym"])
+    out.append("};\n")
+    out.append("""
+const WebAsset *web_findAsset(const char *uri) {
+  size_t len = strcspn(uri, "?");
+  for (uint8_t i = 0; i < WEB_ASSET_COUNT; ++i) {
+    const char *path = WEB_ASSETS[i]->path;
+    if (strlen(path) == len && strncmp(path, uri, len) == 0) return WEB_ASSETS[i];
+  }
+  return nullptr;
+}
+""")
+    return "".join(out)
+
+
+def check_budget(assets):
+    errors = []
+    total = 0
+    for a in assets:
+        size = len(a["gz"])
+        total += size
+        if size > BUDGET_ASSET:
+            errors.append("%s is %d bytes gzipped, budget %d" % (a["path"], size, BUDGET_ASSET))
+    if total > BUDGET_TOTAL:
+        errors.append("web/ is %d bytes gzipped, budget %d" % (total, BUDGET_TOTAL))
+    return total, errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--check", action="store_true",
+                        help="verify the generated files and size budgets, write nothing")
+    args = parser.parse_args()
+
+    assets = collect()
+    rendered = dict(zip(OUTPUTS, (render_header(assets), render_source(assets))))
+    total, errors = check_budget(assets)
+
+    if args.check:
+        for name, text in rendered.items():
+            try:
+                with open(os.path.join(ROOT, name), newline="") as f:
+                    current = f.read()
+            except OSError:
+                current = None
+            if current != text:
+                errors.append("%s is out of date, run tools/embed_assets.py" % name)
+    else:
+        for name, text in rendered.items():
+            with open(os.path.join(ROOT, name), "w", newline="\n") as f:
+                f.write(text)
+
+    for a in assets:
+        print("%-32s %6d -> %5d bytes  %s" % (a["path"], a["raw"], len(a["gz"]), a["etag"]))
+    print("total %d of %d bytes gzipped" % (total, BUDGET_TOTAL))
+    for e in errors:
+        print("error: " + e, file=sys.stderr)
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
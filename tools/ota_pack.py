@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""Pack a firmware image for a cheaper OTA transfer.
+
+Without --base the image is zlib-compressed; with --base (the .bin the
+hives are running now) it becomes a delta that ota_payload.cpp rebuilds
+against the running slot: COPY/PATCH operations take bytes from the old
+image, ADD carries new ones, and the operation stream is deflated. Both
+are decoded on the device as they arrive, within a window of
+2^--window-bits bytes, which must not exceed OTA_INFLATE_WINDOW_BITS.
+
+    python3 tools/ota_pack.py build/fw.bin -o fw.ota
+    python3 tools/ota_pack.py build/fw.bin --base release/fw-1.4.bin -o fw-1.4-to-1.5.ota
+
+The output is decoded again here and compared with the image before it is
+written. The printed SHA-256 is the one to pass to the device (X-SHA256
+header or 'ota <url> <sha256>'). A delta only applies to a hive whose
+running image is exactly --base; the device refuses any other. --base
+must be the .bin as built (esptool appends its SHA-256 digest, which is
+what the device reports for its running slot).
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+import zlib
+
+MAGIC = b"BHD1"
+OP_END, OP_ADD, OP_COPY, OP_PATCH = range(4)
+
+BLOCK = 16          # bytes that must match exactly to start a COPY/PATCH
+STEP = 4            # index every STEP-th offset of the base
+SLACK = 32          # mismatches tolerated past the best point of a PATCH
+
+
+def varint(v):
+    out = bytearray()
+    while True:
+        b = v & 0x7F
+        v >>= 7
+        out.append(b | 0x80 if v else b)
+        if not v:
+            return bytes(out)
+
+
+def zigzag(v):
+    return v * 2 if v >= 0 else -v * 2 - 1
+
+
+def unzigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def image_digest(image):
+    """The SHA-256 esp_partition_get_sha256() reports for a running app:
+    the digest esptool appends, which covers the image without it."""
+    if len(image) < 24 + 32 or image[0] != 0xE9 or image[23] != 1:
+        raise ValueError("no appended SHA-256 digest")
+    digest = image[-32:]
+    if hashlib.sha256(image[:-32]).digest() != digest:
+        raise ValueError("appended SHA-256 digest does not match the image")
+    return digest
+
+
+def deflate(data, window_bits):
+    z = zlib.compressobj(9, zlib.DEFLATED, window_bits, 9)
+    return z.compress(data) + z.flush()
+
+
+def extend(new, base, i, j, limit, step):
+    """Length of the region from new[i]/base[j] where most bytes match.
+
+    Walks forward (step 1, up to new[limit]) or backward (step -1, down to
+    new[limit]) and keeps the end with the best matches-minus-mismatches
+    score, like bsdiff's approximate matches."""
+    score = best = length = 0
+    a, b = (i, j) if step > 0 else (i - 1, j - 1)
+    while (a < limit if step > 0 else a >= limit) and 0 <= b < len(base):
+        score += 1 if new[a] == base[b] else -1
+        a += step
+        b += step
+        if score > best:
+            best, length = score, abs(a - i) if step > 0 else i - a - 1
+        elif score < best - SLACK:
+            break
+    return length
+
+
+def make_ops(new, base):
+    index = {}
+    for j in range(len(base) - BLOCK, -1, -STEP):
+        index[base[j:j + BLOCK]] = j          # keeps the lowest offset
+    ops = bytearray()
+    base_at = 0          # where the previous COPY/PATCH ended
+    lit = 0              # start of pending ADD bytes
+    i = 0
+    while i + BLOCK <= len(new):
+        j = index.get(bytes(new[i:i + BLOCK]))
+        if j is None:
+            i += 1
+            continue
+        back = extend(new, base, i, j, lit, -1)
+        fwd = extend(new, base, i, j, len(new), 1)
+        start, src, end = i - back, j - back, i + fwd
+        if start > lit:
+            ops += bytes([OP_ADD]) + varint(start - lit) + new[lit:start]
+        diff = bytes((new[k] - base[src + k - start]) & 0xFF for k in range(start, end))
+        head = varint(zigzag(src - base_at)) + varint(end - start)
+        if any(diff):
+            ops += bytes([OP_PATCH]) + head + diff
+        else:
+            ops += bytes([OP_COPY]) + head
+        base_at = src + end - start
+        i = lit = end
+    if lit < len(new):
+        ops += bytes([OP_ADD]) + varint(len(new) - lit) + new[lit:]
+    ops.append(OP_END)
+    return bytes(ops)
+
+
+def read_varint(buf, pos):
+    v = shift = 0
+    while True:
+        b = buf[pos]
+        pos += 1
+        v |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return v, pos
+
+
+def apply_ops(ops, base):
+    """Reference decoder, mirrors otap_ops()."""
+    out = bytearray()
+    pos = base_at = 0
+    while True:
+        op = ops[pos]
+        pos += 1
+        if op == OP_END:
+            if pos != len(ops):
+                raise ValueError("data after END")
+            return bytes(out)
+        if op != OP_ADD:
+            off, pos = read_varint(ops, pos)
+            base_at += unzigzag(off)
+        n, pos = read_varint(ops, pos)
+        if op == OP_ADD:
+            out += ops[pos:pos + n]
+            pos += n
+        elif op == OP_COPY:
+            out += base[base_at:base_at + n]
+            base_at += n
+        else:
+            out += bytes((base[base_at + k] + ops[pos + k]) & 0xFF for k in range(n))
+            pos += n
+            base_at += n
+
+
+def decode(payload, base):
+    if payload[:4] == MAGIC:
+        size, base_size = struct.unpack_from("<II", payload, 4)
+        if base is None or base_size != len(base) or payload[12:44] != image_digest(base):
+            raise ValueError("delta does not match the base image")
+        image = apply_ops(zlib.decompress(payload[44:]), base)
+        if len(image) != size:
+            raise ValueError("delta size mismatch")
+        return image
+    return zlib.decompress(payload)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("image", help="new firmware .bin")
+    parser.add_argument("-o", "--output", required=True, help="payload to upload")
+    parser.add_argument("--base", help="firmware .bin the hives run now (makes a delta)")
+    parser.add_argument("--window-bits", type=int, default=15, choices=range(9, 16),
+                        help="deflate window, <= OTA_INFLATE_WINDOW_BITS on the device (default 15)")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        new = f.read()
+    if new[:1] != b"\xe9":
+        sys.exit("ota_pack: %s is not an ESP32 app image" % args.image)
+    full = deflate(new, args.window_bits)
+
+    base = None
+    if args.base:
+        with open(args.base, "rb") as f:
+            base = f.read()
+        try:
+            digest = image_digest(base)
+        except ValueError as e:
+            sys.exit("ota_pack: %s: %s" % (args.base, e))
+        ops = make_ops(new, base)
+        payload = (MAGIC + struct.pack("<II", len(new), len(base)) + digest
+                   + deflate(ops, args.window_bits))
+    else:
+        payload = full
+
+    if decode(payload, base) != new:
+        sys.exit("ota_pack: round trip failed, nothing written")
+    with open(args.output, "wb") as f:
+        f.write(payload)
+
+    print("image     %8d bytes" % len(new))
+    print("zlib      %8d bytes  %5.1f%%" % (len(full), 100.0 * len(full) / len(new)))
+    if base is not None:
+        print("delta     %8d bytes  %5.1f%%  (base %s)" % (len(payload), 100.0 * len(payload) / len(new),
+                                                       digest.hex()[:16]))
+    print("window    %8d bytes" % (1 << args.window_bits))
+    print("sha256    %s" % hashlib.sha256(payload).hexdigest())
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
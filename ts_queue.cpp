@@ -0,0 +1,454 @@
+// ts_queue.cpp - journaled upload queue on SD using sample_codec frames.
+
+#include "ts_queue.h"
+#include "sample_codec.h"
+#include "sd_storage.h"
+#include "config.h"
+#include <SD.h>
+#include <stddef.h>
+
+#define TSQ_SYNC     0xA5
+#define TSQ_REC_MAX  (2 + SAMPLE_FRAME_MAX + 2)
+
+struct TsqPos {
+  uint32_t offset;           // first record not yet delivered to this sink
+  TelemetrySample prev;      // decoder state at offset (frames are delta coded)
+  uint8_t  hasPrev;
+} __attribute__((packed));
+
+struct TsqCursor {
+  uint32_t seq;              // commit counter, the higher valid slot wins
+  uint32_t gen;              // data file generation
+  TsqPos   pos[TSQ_MAX_SINKS];
+  uint16_t crc;              // CRC-16 of all fields above
+} __attribute__((packed));
+
+static TsqCursor     s_cur;
+static uint8_t       s_curSlot = 1;        // slot holding s_cur; commits go to the other one
+static uint32_t      s_end = 0;            // end of the last whole record in the data file
+static SampleEncoder s_enc;                // continues the delta chain of the file tail
+static uint32_t      s_pending[TSQ_MAX_SINKS];
+static uint8_t       s_active = 0x01;      // sinks that hold records back
+static uint32_t      s_scannedMount = 0;   // sd_mountCount() of the last scan, 0 = never
+
+// CRC-16/CCITT-FALSE
+static uint16_t tsq_crc16(const uint8_t *p, size_t n, uint16_t crc = 0xFFFF) {
+  while (n--) {
+    crc ^= (uint16_t)(*p++) << 8;
+    for (int i = 0; i < 8; ++i) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+  }
+  return crc;
+}
+
+static void tsq_dataPath(char *out, size_t outsz, uint32_t gen) {
+  snprintf(out, outsz, TSQ_DIR "/%lu.q", (unsigned long)gen);
+}
+
+static const char *tsq_slotPath(uint8_t slot) {
+  return slot ? TSQ_DIR "/cursor.b" : TSQ_DIR "/cursor.a";
+}
+
+static SampleDecoder tsq_decoderAt(const TsqPos &p) {
+  SampleDecoder d = { p.prev, p.hasPrev != 0 };
+  return d;
+}
+
+// Lowest offset among the active sinks (s_end if none is active)
+static uint32_t tsq_minActiveOffset() {
+  uint32_t m = s_end;
+  for (uint8_t k = 0; k < TSQ_MAX_SINKS; ++k) {
+    if ((s_active & (1 << k)) && s_cur.pos[k].offset < m) m = s_cur.pos[k].offset;
+  }
+  return m;
+}
+
+// ---------------------------------------------------------
+// Records
+// ---------------------------------------------------------
+// Read one record. Returns its size, 0 at EOF or on a torn/corrupt record
+// (dec is only advanced for a good record).
+static size_t tsq_readRecord(File &f, SampleDecoder &dec, TelemetrySample &out) {
+  uint8_t buf[TSQ_REC_MAX];
+  if (f.read(buf, 2) != 2 || buf[0] != TSQ_SYNC) return 0;
+  size_t len = buf[1];
+  if (len == 0 || len > SAMPLE_FRAME_MAX) return 0;
+  if (f.read(buf + 2, len + 2) != len + 2) return 0;
+  uint16_t crc = tsq_crc16(buf + 1, len + 1);
+  if (crc != (uint16_t)(buf[2 + len] | (buf[3 + len] << 8))) return 0;
+  if (sample_decodeNext(dec, buf + 2, len, out) != len) return 0;
+  return len + 4;
+}
+
+static size_t tsq_encodeRecord(SampleEncoder &enc, const TelemetrySample &s, bool key, uint8_t *rec) {
+  size_t len = sample_encodeNext(enc, s, rec + 2, SAMPLE_FRAME_MAX, key);
+  if (!len) return 0;
+  rec[0] = TSQ_SYNC;
+  rec[1] = (uint8_t)len;
+  uint16_t crc = tsq_crc16(rec + 1, len + 1);
+  rec[2 + len] = crc & 0xFF;
+  rec[3 + len] = crc >> 8;
+  return len + 4;
+}
+
+// ---------------------------------------------------------
+// Cursor
+// ---------------------------------------------------------
+static bool tsq_readSlot(uint8_t slot, TsqCursor &c) {
+  File f = SD.open(tsq_slotPath(slot), FILE_READ);
+  if (!f) return false;
+  bool ok = f.size() == sizeof(c) && f.read((uint8_t*)&c, sizeof(c)) == sizeof(c);
+  f.close();
+  return ok && c.crc == tsq_crc16((const uint8_t*)&c, offsetof(TsqCursor, crc));
+}
+
+static void tsq_loadCursor() {
+  TsqCursor a, b;
+  bool okA = tsq_readSlot(0, a);
+  bool okB = tsq_readSlot(1, b);
+  if (okA && (!okB || a.seq > b.seq)) { s_cur = a; s_curSlot = 0; }
+  else if (okB)                       { s_cur = b; s_curSlot = 1; }
+  else {
+    memset(&s_cur, 0, sizeof(s_cur));
+    s_cur.gen = 1;
+    s_curSlot = 1;
+  }
+}
+
+// Durable once close() returns; only then does s_cur move.
+static bool tsq_commit(TsqCursor c) {
+  c.seq = s_cur.seq + 1;
+  c.crc = tsq_crc16((const uint8_t*)&c, offsetof(TsqCursor, crc));
+  uint8_t slot = s_curSlot ^ 1;
+  File f = SD.open(tsq_slotPath(slot), FILE_WRITE);
+  if (!f) {
+    sd_noteError(tsq_slotPath(slot));
+    return false;
+  }
+  bool ok = sd_write(f, (const uint8_t*)&c, sizeof(c)) == sizeof(c);
+  f.close();
+  if (!ok) return false;
+  s_cur = c;
+  s_curSlot = slot;
+  return true;
+}
+
+// Commit c (pointing into a new generation whose file already holds end
+// bytes written with enc), then drop the old data file.
+static bool tsq_switchGeneration(TsqCursor c, uint32_t end, const SampleEncoder &enc) {
+  char oldPath[24];
+  tsq_dataPath(oldPath, sizeof(oldPath), s_cur.gen);
+  if (!tsq_commit(c)) return false;
+  SD.remove(oldPath);
+  s_end = end;
+  s_enc = enc;
+  return true;
+}
+
+// Everything delivered: start an empty generation
+static bool tsq_reset() {
+  TsqCursor c;
+  memset(&c, 0, sizeof(c));
+  c.gen = s_cur.gen + 1;
+  SampleEncoder fresh;
+  sample_encoderReset(fresh);
+  if (!tsq_switchGeneration(c, 0, fresh)) return false;
+  memset(s_pending, 0, sizeof(s_pending));
+  return true;
+}
+
+// Delete data files of other generations (left by an interrupted switch)
+static void tsq_removeStale() {
+  File dir = SD.open(TSQ_DIR);
+  if (!dir) return;
+  char stale[24] = "";
+  File e = dir.openNextFile();
+  while (e) {
+    const char *name = strrchr(e.name(), '/');
+    name = name ? name + 1 : e.name();
+    char *end;
+    unsigned long gen = strtoul(name, &end, 10);
+    bool isStale = end != name && strcmp(end, ".q") == 0 && gen != s_cur.gen;
+    e.close();
+    if (isStale) {
+      tsq_dataPath(stale, sizeof(stale), gen);
+      break;
+    }
+    e = dir.openNextFile();
+  }
+  dir.close();
+  if (stale[0]) {
+    Serial.printf("[TS-QUEUE] removing stale %s\n", stale);
+    SD.remove(stale);
+    tsq_removeStale();
+  }
+}
+
+// ---------------------------------------------------------
+// Public API
+// ---------------------------------------------------------
+void tsq_init() {
+  SdLock lk;
+  sample_encoderReset(s_enc);
+  memset(s_pending, 0, sizeof(s_pending));
+  s_end = 0;
+  if (!lk) return;
+  s_scannedMount = sd_mountCount();
+  if (!SD.exists(TSQ_DIR) && !SD.mkdir(TSQ_DIR)) {
+    sd_noteError(TSQ_DIR);
+    return;
+  }
+  tsq_loadCursor();
+  tsq_removeStale();
+
+  // Scan from the lowest sink position; count what each sink still has to send
+  uint8_t first = 0;
+  uint32_t maxOff = 0;
+  for (uint8_t k = 0; k < TSQ_MAX_SINKS; ++k) {
+    if (s_cur.pos[k].offset < s_cur.pos[first].offset) first = k;
+    if (s_cur.pos[k].offset > maxOff) maxOff = s_cur.pos[k].offset;
+  }
+  char path[24];
+  tsq_dataPath(path, sizeof(path), s_cur.gen);
+  SampleDecoder dec = tsq_decoderAt(s_cur.pos[first]);
+  uint32_t size = 0;
+  s_end = s_cur.pos[first].offset;
+  File f = SD.open(path, FILE_READ);
+  if (f) {
+    size = f.size();
+    if (size >= maxOff) {
+      f.seek(s_end);
+      TelemetrySample s;
+      size_t n;
+      while ((n = tsq_readRecord(f, dec, s)) != 0) {
+        for (uint8_t k = 0; k < TSQ_MAX_SINKS; ++k) {
+          if (s_end >= s_cur.pos[k].offset) s_pending[k]++;
+        }
+        s_end += n;
+      }
+    }
+    f.close();
+  }
+
+  if (size < maxOff || s_end < maxOff) {
+    // data file lost or replaced behind our back: start a fresh generation
+    Serial.println(F("[TS-QUEUE] data file shorter than cursor, resetting queue"));
+    tsq_reset();
+    return;
+  }
+  if (size > s_end) {
+    // torn record from a power cut during tsq_push(): it was never acknowledged
+    Serial.printf("[TS-QUEUE] dropping %lu byte torn tail\n", (unsigned long)(size - s_end));
+    sd_truncate(path, s_end);
+  }
+  s_enc.prev = dec.prev;
+  s_enc.hasPrev = dec.hasPrev;
+#if ENABLE_DEBUG
+  Serial.printf("[TS-QUEUE] %lu queued samples in %s (gen %lu)\n", (unsigned long)tsq_depth(),
+                path, (unsigned long)s_cur.gen);
+#endif
+}
+
+// Rescan after the first mount or a remount (the card may have been swapped)
+static void tsq_checkMount() {
+  if (s_scannedMount != sd_mountCount()) tsq_init();
+}
+
+void tsq_setActive(uint8_t mask) {
+  s_active = mask;
+}
+
+uint32_t tsq_pending(uint8_t sink) {
+  if (sink >= TSQ_MAX_SINKS) return 0;
+  SdLock lk;
+  if (lk) tsq_checkMount();
+  return s_pending[sink];
+}
+
+uint32_t tsq_depth() {
+  SdLock lk;
+  if (lk) tsq_checkMount();
+  uint32_t d = 0;
+  for (uint8_t k = 0; k < TSQ_MAX_SINKS; ++k) {
+    if ((s_active & (1 << k)) && s_pending[k] > d) d = s_pending[k];
+  }
+  return d;
+}
+
+bool tsq_push(const TelemetrySample &s) {
+  SdLock lk;
+  if (!lk) return false;
+  tsq_checkMount();
+  char path[24];
+  tsq_dataPath(path, sizeof(path), s_cur.gen);
+  File f = SD.open(path, FILE_APPEND);
+  if (!f) {
+    Serial.printf("[TS-QUEUE] Cannot open %s for append\n", path);
+    sd_noteError(path);
+    return false;
+  }
+  uint8_t rec[TSQ_REC_MAX];
+  SampleEncoder enc = s_enc;
+  size_t n = tsq_encodeRecord(enc, s, s_end == 0, rec);   // a new file starts with a keyframe
+  bool ok = n && sd_write(f, rec, n) == n;
+  f.close();
+  if (!ok) {
+    s_scannedMount = 0;     // rescan (and cut the partial record) before the next access
+    return false;
+  }
+  s_enc = enc;
+  s_end += n;
+  for (uint8_t k = 0; k < TSQ_MAX_SINKS; ++k) s_pending[k]++;
+#if ENABLE_DEBUG
+  Serial.println(F("[TS-QUEUE] Sample enqueued to " TSQ_DIR));
+#endif
+  return true;
+}
+
+// Read up to max records from p. Returns the count; p is advanced past them.
+static uint32_t tsq_readFrom(TsqPos &p, TelemetrySample *out, uint32_t max) {
+  char path[24];
+  tsq_dataPath(path, sizeof(path), s_cur.gen);
+  File f = SD.open(path, FILE_READ);
+  if (!f) return 0;
+  f.seek(p.offset);
+  SampleDecoder dec = tsq_decoderAt(p);
+  TelemetrySample tmp;
+  uint32_t n = 0;
+  while (n < max && p.offset < s_end) {
+    TelemetrySample &s = out ? out[n] : tmp;
+    size_t len = tsq_readRecord(f, dec, s);
+    if (!len) {
+      // verified by the scan in tsq_init(), so this is a read error
+      sd_noteError(path);
+      break;
+    }
+    p.offset += len;
+    p.prev = s;
+    p.hasPrev = 1;
+    n++;
+  }
+  f.close();
+  return n;
+}
+
+uint32_t tsq_peek(uint8_t sink, TelemetrySample *out, uint32_t max) {
+  if (sink >= TSQ_MAX_SINKS) return 0;
+  SdLock lk;
+  if (!lk) return 0;
+  tsq_checkMount();
+  TsqPos p = s_cur.pos[sink];
+  return tsq_readFrom(p, out, max);
+}
+
+uint32_t tsq_forEach(TsqVisitFn visit, void *ctx, uint32_t maxItems) {
+  SdLock lk;
+  if (!lk) return 0;
+  tsq_checkMount();
+  uint32_t from = tsq_minActiveOffset();
+  TsqPos p;
+  bool found = false;
+  for (uint8_t k = 0; k < TSQ_MAX_SINKS && !found; ++k) {
+    if ((s_active & (1 << k)) && s_cur.pos[k].offset == from) { p = s_cur.pos[k]; found = true; }
+  }
+  if (!found) return 0;
+  uint32_t n = 0;
+  TelemetrySample s;
+  while (n < maxItems && tsq_readFrom(p, &s, 1) == 1) {
+    if (!visit(s, n, ctx)) break;
+    n++;
+  }
+  return n;
+}
+
+// Copy the records from the slowest active sink onwards into the next
+// generation, re-basing every sink position, and switch to it.
+static void tsq_compact(uint32_t base) {
+  char inPath[24], outPath[24];
+  tsq_dataPath(inPath, sizeof(inPath), s_cur.gen);
+  tsq_dataPath(outPath, sizeof(outPath), s_cur.gen + 1);
+  TsqCursor next;
+  memset(&next, 0, sizeof(next));
+  next.gen = s_cur.gen + 1;
+  SampleDecoder dec;
+  sample_decoderReset(dec);
+  for (uint8_t k = 0; k < TSQ_MAX_SINKS; ++k) {
+    if (s_cur.pos[k].offset == base) dec = tsq_decoderAt(s_cur.pos[k]);
+  }
+
+  File in = SD.open(inPath, FILE_READ);
+  if (!in) return;
+  File out = SD.open(outPath, FILE_WRITE);
+  if (!out) {
+    in.close();
+    sd_noteError(outPath);
+    return;
+  }
+  in.seek(base);
+  SampleEncoder enc;
+  sample_encoderReset(enc);
+  TelemetrySample s;
+  uint8_t rec[TSQ_REC_MAX];
+  uint32_t off = base, outEnd = 0, kept = 0;
+  bool ok = true;
+  while (ok && off < s_end) {
+    TelemetrySample prev = dec.prev;
+    bool hadPrev = dec.hasPrev;
+    size_t inLen = tsq_readRecord(in, dec, s);
+    if (!inLen) { ok = false; break; }
+    for (uint8_t k = 0; k < TSQ_MAX_SINKS; ++k) {
+      if (s_cur.pos[k].offset == off) {
+        next.pos[k].offset = outEnd;
+        next.pos[k].prev = prev;
+        next.pos[k].hasPrev = hadPrev;
+      }
+    }
+    size_t n = tsq_encodeRecord(enc, s, kept == 0, rec);
+    ok = n && sd_write(out, rec, n) == n;
+    off += inLen;
+    outEnd += n;
+    kept++;
+  }
+  in.close();
+  out.close();
+  // sinks that were fully caught up stay at the end; inactive sinks that
+  // lagged behind base restart at the first kept record (next.pos zeroed)
+  for (uint8_t k = 0; k < TSQ_MAX_SINKS; ++k) {
+    if (s_cur.pos[k].offset == s_end) {
+      next.pos[k].offset = outEnd;
+      next.pos[k].prev = dec.prev;
+      next.pos[k].hasPrev = dec.hasPrev;
+    }
+  }
+  if (!ok || !tsq_switchGeneration(next, outEnd, enc)) {
+    SD.remove(outPath);       // the old generation stays authoritative
+    return;
+  }
+  for (uint8_t k = 0; k < TSQ_MAX_SINKS; ++k) {
+    if (s_pending[k] > kept) s_pending[k] = kept;
+  }
+#if ENABLE_DEBUG
+  Serial.printf("[TS-QUEUE] compacted %lu samples into %s\n", (unsigned long)kept, outPath);
+#endif
+}
+
+bool tsq_ack(uint8_t sink, uint32_t n) {
+  if (sink >= TSQ_MAX_SINKS || n == 0) return false;
+  SdLock lk;
+  if (!lk) return false;
+  TsqCursor c = s_cur;
+  if (tsq_readFrom(c.pos[sink], nullptr, n) != n) return false;
+  if (!tsq_commit(c)) return false;
+  s_pending[sink] -= n;
+
+  uint32_t base = tsq_minActiveOffset();
+  if (base >= s_end) {
+    if (tsq_reset()) {
+#if ENABLE_DEBUG
+      Serial.println(F("[TS-QUEUE] queue flushed"));
+#endif
+    }
+  } else if (base >= TSQ_COMPACT_BYTES) {
+    tsq_compact(base);
+  }
+  return true;
+}
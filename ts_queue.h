@@ -0,0 +1,56 @@
+#ifndef TS_QUEUE_H
+#define TS_QUEUE_H
+
+#include <Arduino.h>
+#include "telemetry_sample.h"
+
+// SD-backed queue of samples waiting for upload, journaled so that a power
+// cut at any byte neither loses nor replays a queued sample.
+//
+// Files under TSQ_DIR:
+//   <gen>.q         append-only data file, one record per sample:
+//                   [0xA5][len][sample_codec frame][crc16 of len+frame]
+//   cursor.a/.b     two cursor slots {seq, gen, per-sink offset + decoder state, crc}
+//
+// Pushing only appends to the data file; a torn tail record fails its CRC
+// and is cut off at the next init. Upload progress is committed by writing
+// the next cursor into the slot NOT holding the current one, so an
+// interrupted commit leaves the previous cursor intact (the highest valid
+// seq wins). Once the consumed prefix is large, the remaining records are
+// copied to generation gen+1 and the cursor switches over; files of any
+// other generation are leftovers of an interrupted switch and are deleted.
+//
+// Every telemetry sink (telemetry_sink.h) has its own read position, so one
+// copy of a sample serves all of them; a record is dropped once every active
+// sink has acknowledged it.
+
+#define TSQ_DIR "/tsq"
+
+#define TSQ_MAX_SINKS 4             // read positions in the cursor (on-disk format)
+
+#ifndef TSQ_COMPACT_BYTES
+#define TSQ_COMPACT_BYTES 16384     // rewrite the data file once this much is consumed
+#endif
+
+void     tsq_init();                       // load the cursor, scan the data file, repair the tail
+bool     tsq_push(const TelemetrySample &s);
+uint32_t tsq_depth();                      // backlog of the slowest active sink
+
+// Sinks in mask hold records back; inactive sinks still get read positions
+// but never delay compaction.
+void     tsq_setActive(uint8_t mask);
+uint32_t tsq_pending(uint8_t sink);
+
+// Copy up to max samples the sink has not acknowledged yet, oldest first.
+// Nothing is consumed; the SD card is not locked once this returns.
+uint32_t tsq_peek(uint8_t sink, TelemetrySample *out, uint32_t max);
+
+// Commit the first n peeked samples as delivered for this sink
+bool     tsq_ack(uint8_t sink, uint32_t n);
+
+// Visit the samples the slowest active sink still has to send (visit
+// returns false to stop)
+typedef bool (*TsqVisitFn)(const TelemetrySample &s, uint32_t idx, void *ctx);
+uint32_t tsq_forEach(TsqVisitFn visit, void *ctx, uint32_t maxItems);
+
+#endif // TS_QUEUE_H
@@ -0,0 +1,466 @@
+// tsdb.cpp - per-day binary time-series files on SD with hourly rollups.
+
+#include "tsdb.h"
+#include "config.h"
+#include "sd_storage.h"
+#include "time_manager.h"
+#include <SD.h>
+#include <time.h>
+
+#define TSDB_MIN_VALID_TS   1600000000UL   // anything earlier means "clock not set"
+#define TSDB_NO_HOUR        0xFFFFFFFFUL
+#define TSDB_READ_CHUNK     16             // records per SD read (512 bytes)
+
+struct TsdbIndexEntry {
+  uint32_t hour_ts;
+  uint32_t rec_no;
+} __attribute__((packed));
+
+// State of the day file currently being appended to
+static uint32_t s_curDay   = 0;            // UTC day number (ts / 86400)
+static uint32_t s_curCount = 0;
+static uint32_t s_lastTs   = 0;
+static uint32_t s_lastHour = TSDB_NO_HOUR;
+static uint32_t s_dirMount = 0;            // sd_mountCount() when TSDB_DIR was checked
+
+static unsigned long s_lastSampleMs = 0;
+static unsigned long s_lastMaintainMs = 0;
+static unsigned long s_maintainGapMs = 0;    // 0 -> run on the first loop
+static bool s_sampledOnce = false;
+
+// ---------------------------------------------------------
+// Path helpers
+// ---------------------------------------------------------
+static void tsdb_path(char *out, size_t outsz, uint32_t day, const char *ext) {
+  time_t t = (time_t)day * 86400;
+  struct tm tmv;
+  gmtime_r(&t, &tmv);
+  snprintf(out, outsz, "%s/%04d%02d%02d.%s", TSDB_DIR,
+           tmv.tm_year + 1900, tmv.tm_mon + 1, tmv.tm_mday, ext);
+}
+
+// days since 1970-01-01 for a civil date (Howard Hinnant's algorithm)
+static int32_t days_from_civil(int y, unsigned m, unsigned d) {
+  y -= m <= 2;
+  const int era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = (unsigned)(y - era * 400);
+  const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int32_t)doe - 719468;
+}
+
+// Parse "YYYYMMDD.ext" (optionally with a leading path) -> day number + ext pointer
+static bool tsdb_parseName(const char *name, uint32_t &day, const char *&ext) {
+  const char *slash = strrchr(name, '/');
+  const char *p = slash ? slash + 1 : name;
+  if (strlen(p) < 12 || p[8] != '.') return false;
+  for (int i = 0; i < 8; ++i) if (p[i] < '0' || p[i] > '9') return false;
+  int y = (p[0]-'0')*1000 + (p[1]-'0')*100 + (p[2]-'0')*10 + (p[3]-'0');
+  int m = (p[4]-'0')*10 + (p[5]-'0');
+  int d = (p[6]-'0')*10 + (p[7]-'0');
+  if (m < 1 || m > 12 || d < 1 || d > 31) return false;
+  day = (uint32_t)days_from_civil(y, m, d);
+  ext = p + 9;
+  return true;
+}
+
+static bool tsdb_ensureDir() {
+  if (s_dirMount == sd_mountCount()) return true;
+  if (!SD.exists(TSDB_DIR) && !SD.mkdir(TSDB_DIR)) return false;
+  s_dirMount = sd_mountCount();
+  s_curDay = 0;                              // reload the day state from this card
+  return true;
+}
+
+// ---------------------------------------------------------
+// Append path
+// ---------------------------------------------------------
+static void tsdb_loadDayState(uint32_t day) {
+  char path[32];
+  tsdb_path(path, sizeof(path), day, "dat");
+  s_curDay = day;
+  s_curCount = 0;
+  s_lastTs = 0;
+  s_lastHour = TSDB_NO_HOUR;
+
+  File f = SD.open(path, FILE_READ);
+  if (!f) return;
+  size_t sz = f.size();
+  s_curCount = sz / sizeof(TelemetrySample);   // a torn tail record is ignored
+  if (s_curCount > 0) {
+    TelemetrySample last;
+    f.seek((s_curCount - 1) * sizeof(TelemetrySample));
+    if (f.read((uint8_t*)&last, sizeof(last)) == sizeof(last)) {
+      s_lastTs = last.ts;
+      s_lastHour = last.ts / 3600;
+    }
+  }
+  f.close();
+}
+
+bool tsdb_append(const TelemetrySample &s) {
+  if (s.ts < TSDB_MIN_VALID_TS) return false;
+  SdLock lk;
+  if (!lk || !tsdb_ensureDir()) return false;
+
+  uint32_t day = s.ts / 86400;
+  if (day != s_curDay) tsdb_loadDayState(day);
+  if (s.ts <= s_lastTs) return false;           // keep files sorted for binary search
+
+  char path[32];
+  tsdb_path(path, sizeof(path), day, "dat");
+  File f = SD.open(path, FILE_APPEND);
+  if (!f) { sd_noteError(path); return false; }
+  // A torn record from a power cut would misalign everything after it:
+  // cut the file back to the last whole record before appending.
+  size_t aligned = s_curCount * sizeof(TelemetrySample);
+  if (f.size() != aligned) {
+    f.close();
+#if ENABLE_DEBUG
+    Serial.printf("[TSDB] %s has a torn tail, truncating to %u bytes\n", path, (unsigned)aligned);
+#endif
+    if (!sd_truncate(path, aligned)) return false;
+    f = SD.open(path, FILE_APPEND);
+    if (!f) return false;
+  }
+  bool ok = sd_write(f, (const uint8_t*)&s, sizeof(s)) == sizeof(s);
+  f.close();
+  if (!ok) return false;
+
+  uint32_t hour = s.ts / 3600;
+  if (hour != s_lastHour) {
+    TsdbIndexEntry e = { hour * 3600, s_curCount };
+    tsdb_path(path, sizeof(path), day, "idx");
+    File fi = SD.open(path, FILE_APPEND);
+    if (fi) {
+      sd_write(fi, (const uint8_t*)&e, sizeof(e));
+      fi.close();
+    }
+    s_lastHour = hour;
+  }
+  s_curCount++;
+  s_lastTs = s.ts;
+  return true;
+}
+
+uint32_t tsdb_recordsToday() {
+  return s_curCount;
+}
+
+// ---------------------------------------------------------
+// Query path
+// ---------------------------------------------------------
+struct TsdbAgg {
+  uint32_t step;
+  uint32_t bucket;
+  uint32_t count;
+  int32_t  vmin[CH_COUNT];
+  int32_t  vmax[CH_COUNT];
+  int64_t  sum[CH_COUNT];
+  TsdbCallback cb;
+  void *ctx;
+  uint32_t emitted;
+  bool stop;
+};
+
+static void agg_flush(TsdbAgg &a) {
+  if (a.count == 0 || a.stop) return;
+  TsdbRollup r;
+  r.ts = a.bucket;
+  r.count = (a.count > 0xFFFF) ? 0xFFFF : (uint16_t)a.count;
+  for (int c = 0; c < CH_COUNT; ++c) {
+    r.vmin[c] = a.vmin[c];
+    r.vmax[c] = a.vmax[c];
+    r.vmean[c] = (int32_t)(a.sum[c] / (int64_t)a.count);
+  }
+  a.count = 0;
+  a.emitted++;
+  if (!a.cb(r, a.ctx)) a.stop = true;
+}
+
+// Feed one stored point (raw record: n=1, min=max=mean)
+static void agg_add(TsdbAgg &a, uint32_t ts, uint32_t n,
+                    const int32_t *vmin, const int32_t *vmax, const int32_t *vmean) {
+  uint32_t bucket = a.step ? (ts - ts % a.step) : ts;
+  if (a.count && bucket != a.bucket) agg_flush(a);
+  if (a.stop) return;
+  if (a.count == 0) {
+    a.bucket = bucket;
+    for (int c = 0; c < CH_COUNT; ++c) {
+      a.vmin[c] = vmin[c];
+      a.vmax[c] = vmax[c];
+      a.sum[c] = 0;
+    }
+  }
+  for (int c = 0; c < CH_COUNT; ++c) {
+    if (vmin[c] < a.vmin[c]) a.vmin[c] = vmin[c];
+    if (vmax[c] > a.vmax[c]) a.vmax[c] = vmax[c];
+    a.sum[c] += (int64_t)vmean[c] * n;
+  }
+  a.count += n;
+  if (a.step == 0) agg_flush(a);
+}
+
+static uint32_t read_ts_at(File &f, uint32_t rec) {
+  uint32_t ts = 0;
+  f.seek(rec * sizeof(TelemetrySample));
+  f.read((uint8_t*)&ts, sizeof(ts));
+  return ts;
+}
+
+// First record index with ts >= from (records are sorted)
+static uint32_t tsdb_lowerBound(uint32_t day, File &f, uint32_t count, uint32_t from) {
+  uint32_t lo = 0, hi = count;
+
+  // narrow with the hour index
+  char path[32];
+  tsdb_path(path, sizeof(path), day, "idx");
+  File fi = SD.open(path, FILE_READ);
+  if (fi) {
+    TsdbIndexEntry e;
+    while (fi.read((uint8_t*)&e, sizeof(e)) == sizeof(e)) {
+      if (e.rec_no > count) break;
+      if (e.hour_ts <= from) lo = e.rec_no;
+      else { hi = e.rec_no; break; }
+    }
+    fi.close();
+  }
+
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (read_ts_at(f, mid) < from) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+static void tsdb_queryRaw(uint32_t day, File &f, uint32_t from, uint32_t to, TsdbAgg &a) {
+  uint32_t count = f.size() / sizeof(TelemetrySample);
+  uint32_t i = tsdb_lowerBound(day, f, count, from);
+  f.seek(i * sizeof(TelemetrySample));
+
+  TelemetrySample buf[TSDB_READ_CHUNK];
+  while (i < count && !a.stop) {
+    uint32_t n = count - i;
+    if (n > TSDB_READ_CHUNK) n = TSDB_READ_CHUNK;
+    size_t got = f.read((uint8_t*)buf, n * sizeof(TelemetrySample)) / sizeof(TelemetrySample);
+    if (got == 0) break;
+    for (size_t k = 0; k < got; ++k) {
+      if (buf[k].ts > to) return;
+      int32_t v[CH_COUNT];
+      memcpy(v, buf[k].v, sizeof(v));
+      agg_add(a, buf[k].ts, 1, v, v, v);
+      if (a.stop) return;
+    }
+    i += got;
+  }
+}
+
+static void tsdb_queryRollup(File &f, uint32_t from, uint32_t to, TsdbAgg &a) {
+  TsdbRollup r;
+  while (!a.stop && f.read((uint8_t*)&r, sizeof(r)) == sizeof(r)) {
+    if (r.ts + 3599 < from) continue;
+    if (r.ts > to) return;
+    // the packed arrays start at odd offsets: copy before reading them as int32_t
+    int32_t vmin[CH_COUNT], vmax[CH_COUNT], vmean[CH_COUNT];
+    memcpy(vmin, r.vmin, sizeof(vmin));
+    memcpy(vmax, r.vmax, sizeof(vmax));
+    memcpy(vmean, r.vmean, sizeof(vmean));
+    agg_add(a, r.ts, r.count, vmin, vmax, vmean);
+  }
+}
+
+// Feed one day, raw file first, else its rollups
+static void tsdb_queryDay(uint32_t day, uint32_t from, uint32_t to, TsdbAgg &a) {
+  char path[32];
+  tsdb_path(path, sizeof(path), day, "dat");
+  File f = SD.open(path, FILE_READ);
+  if (f) {
+    tsdb_queryRaw(day, f, from, to, a);
+    f.close();
+    return;
+  }
+  tsdb_path(path, sizeof(path), day, "rol");
+  f = SD.open(path, FILE_READ);
+  if (f) {
+    tsdb_queryRollup(f, from, to, a);
+    f.close();
+  }
+}
+
+uint32_t tsdb_query(uint32_t from, uint32_t to, uint32_t step, TsdbCallback cb, void *ctx) {
+  if (!cb || to < from) return 0;
+  SdLock lk;
+  if (!lk) return 0;
+  TsdbAgg a;
+  memset(&a, 0, sizeof(a));
+  a.step = step;
+  a.cb = cb;
+  a.ctx = ctx;
+
+  for (uint32_t day = from / 86400; day <= to / 86400 && !a.stop; ++day) tsdb_queryDay(day, from, to, a);
+  agg_flush(a);
+  return a.emitted;
+}
+
+struct TsdbPage {
+  TsdbRollup *out;
+  uint16_t max;
+  uint16_t n;
+  uint32_t skipBelow;                   // points before the cursor went out already
+};
+
+static bool tsdb_pageAdd(const TsdbRollup &r, void *ctx) {
+  TsdbPage &pg = *(TsdbPage *)ctx;
+  if (r.ts < pg.skipBelow) return true;
+  pg.out[pg.n++] = r;
+  return pg.n < pg.max;
+}
+
+uint16_t tsdb_queryPage(uint32_t from, uint32_t to, uint32_t step, uint32_t &cursor,
+                        TsdbRollup *out, uint16_t max) {
+  if (!out || !max || to < from) {
+    cursor = 0;
+    return 0;
+  }
+  // Nothing is kept before the rollup horizon: don't walk empty days
+  if (timeManager_isTimeValid()) {
+    uint32_t today = (uint32_t)time(nullptr) / 86400;
+    uint32_t oldest = today > TSDB_ROLLUP_DAYS ? (today - TSDB_ROLLUP_DAYS) * 86400 : 0;
+    if (from < oldest) from = oldest;
+    if (to / 86400 > today) to = today * 86400 + 86399;
+    if (to < from) {
+      cursor = 0;
+      return 0;
+    }
+  }
+  TsdbPage pg = { out, max, 0, cursor };
+  TsdbAgg a;
+  memset(&a, 0, sizeof(a));
+  a.step = step;
+  a.cb = tsdb_pageAdd;
+  a.ctx = &pg;
+
+  // Restart at the last point sent: its bucket / hour rollup starts there
+  uint32_t start = cursor > from ? cursor - 1 : from;
+  for (uint32_t day = start / 86400; day <= to / 86400 && !a.stop; ++day) {
+    SdLock lk;                          // per day: other SD users get in between
+    if (!lk) break;
+    tsdb_queryDay(day, start, to, a);
+  }
+  agg_flush(a);
+  cursor = a.stop ? out[pg.n - 1].ts + 1 : 0;
+  return pg.n;
+}
+
+// ---------------------------------------------------------
+// Compaction
+// ---------------------------------------------------------
+struct RollupWriter {
+  File *out;
+  bool ok;
+};
+
+static bool rollup_emit(const TsdbRollup &r, void *ctx) {
+  RollupWriter *w = (RollupWriter*)ctx;
+  if (sd_write(*w->out, (const uint8_t*)&r, sizeof(r)) != sizeof(r)) { w->ok = false; return false; }
+  return true;
+}
+
+// Replace YYYYMMDD.dat/.idx with hourly rollups in YYYYMMDD.rol
+static bool tsdb_compactDay(uint32_t day) {
+  char dat[32], idx[32], rol[32], tmp[32];
+  tsdb_path(dat, sizeof(dat), day, "dat");
+  tsdb_path(idx, sizeof(idx), day, "idx");
+  tsdb_path(rol, sizeof(rol), day, "rol");
+  tsdb_path(tmp, sizeof(tmp), day, "tmp");
+
+  File out = SD.open(tmp, FILE_WRITE);
+  if (!out) { sd_noteError(tmp); return false; }
+  RollupWriter w = { &out, true };
+  uint32_t hours = tsdb_query(day * 86400, day * 86400 + 86399, 3600, rollup_emit, &w);
+  out.close();
+  if (!w.ok) { SD.remove(tmp); return false; }
+
+  // write-new-then-rename: a crash before the rename leaves the raw file intact
+  if (SD.exists(rol)) SD.remove(rol);
+  if (!SD.rename(tmp, rol)) return false;
+  SD.remove(dat);
+  SD.remove(idx);
+#if ENABLE_DEBUG
+  Serial.printf("[TSDB] compacted %s -> %u hourly rollups\n", dat, (unsigned)hours);
+#else
+  (void) hours;
+#endif
+  return true;
+}
+
+bool tsdb_maintain() {
+  if (!timeManager_isTimeValid()) return false;
+  uint32_t now = (uint32_t)time(nullptr);
+  if (now < TSDB_MIN_VALID_TS) return false;
+  uint32_t today = now / 86400;
+
+  SdLock lk;
+  if (!lk) return false;
+  File dir = SD.open(TSDB_DIR);
+  if (!dir) return false;
+  bool did = false;
+  File e = dir.openNextFile();
+  while (e && !did) {
+    char name[48];
+    strncpy(name, e.name(), sizeof(name) - 1);
+    name[sizeof(name) - 1] = 0;
+    e.close();
+
+    uint32_t day;
+    const char *ext;
+    if (tsdb_parseName(name, day, ext)) {
+      if (strcmp(ext, "dat") == 0 && day + TSDB_RAW_DAYS < today) {
+        did = tsdb_compactDay(day);
+      } else if (strcmp(ext, "rol") == 0 && day + TSDB_ROLLUP_DAYS < today) {
+        char path[32];
+        tsdb_path(path, sizeof(path), day, "rol");
+        did = SD.remove(path);
+      }
+    }
+    if (!did) e = dir.openNextFile();
+  }
+  dir.close();
+  return did;
+}
+
+// ---------------------------------------------------------
+// Init / loop
+// ---------------------------------------------------------
+void tsdb_init() {
+  SdLock lk;
+  if (lk && tsdb_ensureDir()) {
+#if ENABLE_DEBUG
+    Serial.println(F("[TSDB] store ready at " TSDB_DIR));
+#endif
+  }
+}
+
+void tsdb_loop() {
+  unsigned long nowMs = millis();
+  if (timeManager_isTimeValid() &&
+      (!s_sampledOnce || nowMs - s_lastSampleMs >= TSDB_SAMPLE_INTERVAL_S * 1000UL)) {
+    s_sampledOnce = true;
+    s_lastSampleMs = nowMs;
+    TelemetrySample s;
+    sample_capture(s);
+    if (!tsdb_append(s)) {
+#if ENABLE_DEBUG
+      Serial.println(F("[TSDB] append failed"));
+#endif
+    }
+  }
+
+  // One compaction step per call keeps the loop latency bounded; after a long
+  // power-off the backlog is worked off a minute apart, otherwise hourly.
+  if (nowMs - s_lastMaintainMs >= s_maintainGapMs) {
+    s_lastMaintainMs = nowMs;
+    s_maintainGapMs = tsdb_maintain() ? 60UL * 1000UL : 3600UL * 1000UL;
+  }
+}
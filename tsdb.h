@@ -0,0 +1,68 @@
+#ifndef TSDB_H
+#define TSDB_H
+
+#include <Arduino.h>
+#include "telemetry_sample.h"
+
+// Local time-series store on the SD card.
+//
+// Layout under TSDB_DIR (one set of files per UTC day):
+//   YYYYMMDD.dat  fixed-size TelemetrySample records, appended in time order
+//   YYYYMMDD.idx  hour index: {hour_start_ts, record_no} for the first record of each hour
+//   YYYYMMDD.rol  hourly rollups (min/max/mean) once the day is older than TSDB_RAW_DAYS
+//
+// Range lookups binary-search the records (narrowed by the hour index), so a
+// "last 24h" query touches only a handful of sectors.
+
+#ifndef TSDB_DIR
+#define TSDB_DIR "/tsdb"
+#endif
+
+#ifndef TSDB_SAMPLE_INTERVAL_S
+#define TSDB_SAMPLE_INTERVAL_S 300      // one record every 5 minutes
+#endif
+
+#ifndef TSDB_RAW_DAYS
+#define TSDB_RAW_DAYS 7                 // keep full resolution for a week
+#endif
+
+#ifndef TSDB_ROLLUP_DAYS
+#define TSDB_ROLLUP_DAYS 400            // keep hourly rollups for ~13 months
+#endif
+
+struct TsdbRollup {
+  uint32_t ts;                // start of the hour (UTC epoch)
+  uint16_t count;             // raw samples aggregated
+  int32_t  vmin[CH_COUNT];
+  int32_t  vmax[CH_COUNT];
+  int32_t  vmean[CH_COUNT];
+} __attribute__((packed));
+
+// Called once per output point. Return false to stop the query early.
+// For raw data min == max == mean; for rollups/downsampled points they differ.
+typedef bool (*TsdbCallback)(const TsdbRollup &point, void *ctx);
+
+void tsdb_init();
+void tsdb_loop();                                   // periodic sampling + compaction
+bool tsdb_append(const TelemetrySample &s);
+
+// Stream points in [from, to]. step == 0 returns stored resolution,
+// otherwise points are aggregated into step-second buckets.
+// Returns the number of points emitted. Memory use is constant.
+uint32_t tsdb_query(uint32_t from, uint32_t to, uint32_t step, TsdbCallback cb, void *ctx);
+
+// Same points, a page at a time, for consumers that must not run under the
+// SD lock (web clients): fills out[max] and locks the card one day file at
+// a time. Start with cursor = 0; it returns where the next page starts, 0
+// once [from, to] is done. With the clock set, from is clamped to the
+// oldest day still kept (TSDB_ROLLUP_DAYS) and to to today.
+uint16_t tsdb_queryPage(uint32_t from, uint32_t to, uint32_t step, uint32_t &cursor,
+                        TsdbRollup *out, uint16_t max);
+
+// Compact at most one old day into rollups / drop expired rollups.
+// Returns true if something was done.
+bool tsdb_maintain();
+
+uint32_t tsdb_recordsToday();
+
+#endif // TSDB_H
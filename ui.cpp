@@ -3,7 +3,6 @@
 #include <Arduino.h>
 #include <LiquidCrystal_I2C.h>
 #include "lcd_endpoint.h"      // update web mirror when UI prints
-#include "lcd_server_simple.h" // update standalone lcd server on :8080 as well
 #include "greek_utils.h"
 
 extern LiquidCrystal_I2C lcd;
@@ -102,7 +101,7 @@ static void getExistingLineCells(uint8_t row, VisualCells &cells) {
 }
 
 // Insert text (UTF-8) at given visual column (col), row, replacing existing cells as needed.
-// This writes the resulting 20-column string to BOTH lcd_endpoint and lcd_server_simple buffers.
+// This writes the resulting 20-column string to the lcd_endpoint buffer.
 static void setWebTextAt(uint8_t col, uint8_t row, const String &text) {
     if (row >= 4) return;
     if (col >= 20) return;
@@ -119,9 +118,7 @@ static void setWebTextAt(uint8_t col, uint8_t row, const String &text) {
 
     String result = joinVisualPad(existing, 20);
 
-    // write to both web buffers so :80 and :8080 reflect same content
     lcd_set_line(row, result);
-    lcd_set_line_simple(row, result);
 }
 
 // --------------------------------------------------
@@ -178,7 +175,6 @@ void uiInit() {
         String empty20;
         for (int k = 0; k < 20; ++k) empty20 += ' ';
         lcd_set_line(i, empty20);
-        lcd_set_line_simple(i, empty20);
     }
 }
 
@@ -189,7 +185,6 @@ void uiClear() {
         String empty20;
         for (int k = 0; k < 20; ++k) empty20 += ' ';
         lcd_set_line(i, empty20);
-        lcd_set_line_simple(i, empty20);
     }
 }
 
@@ -0,0 +1,123 @@
+// upload_scheduler.cpp - link/battery aware gate for the telemetry sinks.
+
+#include "upload_scheduler.h"
+#include "ts_queue.h"
+#include "modem_manager.h"
+#include "config.h"
+#include <WiFi.h>
+
+#define SCHED_BURST_MAX_MS (15UL * 60UL * 1000UL)   // a burst that cannot empty the queue gives up
+
+static SchedMode     s_mode = SCHED_NORMAL;
+static int16_t       s_csq = 99;                // 0..31, 99 = unknown
+static unsigned long s_csqAtMs = 0;
+static bool          s_csqRead = false;
+static bool          s_burst = false;           // released backlog is being sent
+static unsigned long s_burstStartMs = 0;
+static unsigned long s_heldSinceMs = 0;         // queue last empty (age of the oldest held sample)
+
+static uint32_t s_sends[2];                     // [0] WiFi, [1] LTE
+static uint32_t s_radioMs[2];
+static uint32_t s_delivered[2];
+
+void sched_loop() {
+  unsigned long now = millis();
+  bool wifi = WiFi.status() == WL_CONNECTED;
+
+  // CSQ costs an AT round trip: sample it once a minute, and only when LTE matters
+  if (!wifi && modem_isReady() && (!s_csqRead || now - s_csqAtMs >= SCHED_CSQ_INTERVAL_MS)) {
+    s_csq = modem_getRSSI();
+    s_csqAtMs = now;
+    s_csqRead = true;
+  }
+
+  int batt = test_batt_percent;
+  bool csqKnown = s_csq != 99;
+  SchedMode m;
+  if (wifi)                                                   m = SCHED_FLUSH;
+  else if (batt < SCHED_BATT_CRITICAL)                        m = SCHED_SAVE;
+  else if (csqKnown && s_csq >= SCHED_CSQ_GOOD)               m = SCHED_FLUSH;
+  else if (!csqKnown || s_csq < SCHED_CSQ_POOR || batt < SCHED_BATT_LOW) m = SCHED_DEFER;
+  else                                                        m = SCHED_NORMAL;
+
+  if (m != s_mode) {
+    Serial.printf("[SCHED] %s -> %s (csq %d, batt %d%%)\n", sched_modeName(s_mode), sched_modeName(m), s_csq, batt);
+    s_mode = m;
+  }
+
+  uint32_t depth = tsq_depth();
+  if (depth == 0) {
+    if (s_burst) Serial.println(F("[SCHED] backlog sent"));
+    s_burst = false;
+    s_heldSinceMs = now;
+    return;
+  }
+  if (s_burst) {
+    if (now - s_burstStartMs >= SCHED_BURST_MAX_MS) {
+      Serial.printf("[SCHED] burst ended with %lu samples left\n", (unsigned long)depth);
+      s_burst = false;
+      s_heldSinceMs = now;
+    }
+    return;
+  }
+  if (m < SCHED_DEFER) return;
+
+  unsigned long maxAgeMs = (unsigned long)SCHED_MAX_DEFER_MIN * 60000UL * (m == SCHED_SAVE ? 4 : 1);
+  bool full = m == SCHED_DEFER && depth >= SCHED_DEFER_BATCH;
+  if (full || now - s_heldSinceMs >= maxAgeMs) {
+    Serial.printf("[SCHED] releasing %lu deferred samples (%s)\n", (unsigned long)depth, full ? "batch" : "age");
+    s_burst = true;
+    s_burstStartMs = now;
+  }
+}
+
+bool sched_uploadAllowed() {
+  return s_mode <= SCHED_NORMAL || s_burst;
+}
+
+SchedMode sched_mode() {
+  return s_mode;
+}
+
+int16_t sched_csq() {
+  return s_csq;
+}
+
+void sched_noteSend(uint32_t durationMs, uint8_t delivered) {
+  // sinks use WiFi whenever it is associated
+  int link = WiFi.status() == WL_CONNECTED ? 0 : 1;
+  s_sends[link]++;
+  s_radioMs[link] += durationMs;
+  s_delivered[link] += delivered;
+}
+
+const char *sched_modeName(SchedMode m) {
+  switch (m) {
+    case SCHED_FLUSH:  return "FLUSH";
+    case SCHED_NORMAL: return "NORMAL";
+    case SCHED_DEFER:  return "DEFER";
+    case SCHED_SAVE:   return "SAVE";
+    default:           return "?";
+  }
+}
+
+void sched_print(Print &out) {
+  unsigned long now = millis();
+  out.printf("[SCHED] mode %s%s, csq %d (%d dBm), batt %d%%\n", sched_modeName(s_mode),
+             s_burst ? " (burst)" : "", s_csq, s_csq == 99 ? 0 : -113 + 2 * s_csq, test_batt_percent);
+  out.printf("[SCHED] %lu queued, held for %lu min\n", (unsigned long)tsq_depth(),
+             (unsigned long)((now - s_heldSinceMs) / 60000UL));
+  static const char *const names[2] = { "WiFi", "LTE" };
+  static const uint16_t currentMa[2] = { SCHED_WIFI_TX_MA, SCHED_LTE_TX_MA };
+  for (int i = 0; i < 2; ++i) {
+    uint32_t n = s_delivered[i];
+    out.printf("[SCHED] %-4s sends %lu, radio %lu s, delivered %lu", names[i], (unsigned long)s_sends[i],
+               (unsigned long)(s_radioMs[i] / 1000UL), (unsigned long)n);
+    if (n) {
+      // mA*s per sample = ms * mA / 1000
+      out.printf(", %lu ms/sample, ~%.1f mAs/sample", (unsigned long)(s_radioMs[i] / n),
+                 (float)s_radioMs[i] * currentMa[i] / 1000.0f / n);
+    }
+    out.println();
+  }
+}
@@ -0,0 +1,77 @@
+#ifndef UPLOAD_SCHEDULER_H
+#define UPLOAD_SCHEDULER_H
+
+#include <Arduino.h>
+
+// Decides when the telemetry sinks may use the radio. Samples are still
+// captured and queued every ts_interval_min; only their transmission moves.
+//
+//   FLUSH   WiFi associated, or LTE signal at least SCHED_CSQ_GOOD:
+//           send everything now, the link is cheap
+//   NORMAL  medium LTE signal and battery above SCHED_BATT_LOW: send as queued
+//   DEFER   weak signal (below SCHED_CSQ_POOR) or low battery: hold samples
+//           and send them in one burst once SCHED_DEFER_BATCH are queued or
+//           the oldest has waited SCHED_MAX_DEFER_MIN
+//   SAVE    battery below SCHED_BATT_CRITICAL without WiFi (even at a good
+//           signal): as DEFER but only the age limit (x4) releases a burst
+//
+// A released burst runs until the queue is empty, so one radio session
+// carries the whole backlog. Radio time spent per delivered sample is
+// accounted per link for the serial 'sched' report.
+
+#ifndef SCHED_CSQ_GOOD
+#define SCHED_CSQ_GOOD 16            // CSQ 16 = -81 dBm
+#endif
+
+#ifndef SCHED_CSQ_POOR
+#define SCHED_CSQ_POOR 8             // CSQ 8 = -97 dBm
+#endif
+
+#ifndef SCHED_BATT_LOW
+#define SCHED_BATT_LOW 30            // %
+#endif
+
+#ifndef SCHED_BATT_CRITICAL
+#define SCHED_BATT_CRITICAL 15       // %
+#endif
+
+#ifndef SCHED_DEFER_BATCH
+#define SCHED_DEFER_BATCH 12
+#endif
+
+#ifndef SCHED_MAX_DEFER_MIN
+#define SCHED_MAX_DEFER_MIN 360
+#endif
+
+#ifndef SCHED_CSQ_INTERVAL_MS
+#define SCHED_CSQ_INTERVAL_MS 60000UL
+#endif
+
+// Average supply current while a send is in progress, for the energy estimate
+#ifndef SCHED_WIFI_TX_MA
+#define SCHED_WIFI_TX_MA 130
+#endif
+
+#ifndef SCHED_LTE_TX_MA
+#define SCHED_LTE_TX_MA 450
+#endif
+
+enum SchedMode {
+  SCHED_FLUSH = 0,
+  SCHED_NORMAL,
+  SCHED_DEFER,
+  SCHED_SAVE
+};
+
+void      sched_loop();              // re-evaluate the mode (cheap, call every loop)
+bool      sched_uploadAllowed();     // checked by sinks_loop()
+SchedMode sched_mode();
+int16_t   sched_csq();               // last sampled CSQ (99 = unknown), no AT traffic
+
+// Account one send attempt (called by the sink runner)
+void      sched_noteSend(uint32_t durationMs, uint8_t delivered);
+
+const char *sched_modeName(SchedMode m);
+void      sched_print(Print &out);   // serial 'sched'
+
+#endif // UPLOAD_SCHEDULER_H
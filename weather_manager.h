@@ -25,7 +25,7 @@ int  weather_daysCount();               // number of samples currently cached (e
 void weather_getDay(int idx, WeatherDay &out); // idx: 0..weather_daysCount()-1
 
 // Runtime helpers (no API key functions anymore)
-void weather_setCoords(double lat, double lon);          // store coordinates in Preferences
+void weather_setCoords(double lat, double lon);          // store coordinates (settings_setCoords)
 bool weather_geocodeLocation(const char* city, const char* countryCode); // fetch lat/lon by name and store
 
 String weather_getLastError();           // last error string
@@ -0,0 +1,116 @@
+'use strict';
+// Beehive dashboard: readings from /api/v1/current, charts from
+// /api/v1/history, the LCD mirror from the /lcd/stream event feed.
+const $ = id => document.getElementById(id);
+
+// [field, label, unit, decimals]
+const CARDS = [
+  ['weight', 'Weight', 'kg', 2],
+  ['temp_int', 'Inside', '°C', 1],
+  ['hum_int', 'Inside RH', '%', 0],
+  ['temp_ext', 'Outside', '°C', 1],
+  ['hum_ext', 'Outside RH', '%', 0],
+  ['pressure', 'Pressure', 'hPa', 0],
+  ['batt', 'Battery', 'V', 2],
+];
+let hours = 24;
+
+const fmt = (v, d) => (v == null || isNaN(v) ? '-' : Number(v).toFixed(d));
+
+async function loadCurrent() {
+  try {
+    const c = await (await fetch('/api/v1/current')).json();
+    $('cards').innerHTML = CARDS.map(([k, label, unit, d]) =>
+      `<div class="card"><span>${label}</span><b>${fmt(c[k], d)}</b> ${unit}</div>`).join('') +
+      `<div class="card"><span>Link</span><b>${c.link}</b> ${c.rssi_dbm == null ? '' : c.rssi_dbm + ' dBm'}</div>`;
+    $('status').textContent = c.ts ? new Date(c.ts * 1000).toLocaleString() : 'clock not set';
+  } catch (e) {
+    $('status').textContent = 'offline';
+  }
+}
+
+// Follows the "next" cursor until the whole range is loaded
+async function loadHistory() {
+  const to = Math.floor(Date.now() / 1000);
+  const step = hours <= 24 ? 600 : hours <= 168 ? 3600 : 14400;
+  let next = to - hours * 3600, names = [], points = [];
+  try {
+    while (next != null) {
+      const h = await (await fetch(`/api/v1/history?from=${next}&to=${to}&step=${step}`)).json();
+      names = h.channels;
+      points = points.concat(h.points);
+      next = h.next;
+    }
+  } catch (e) {
+    return;
+  }
+  const col = n => names.indexOf(n);
+  draw($('c-weight'), points, [[col('weight'), '#c80']]);
+  draw($('c-temp'), points, [[col('temp_int'), '#d33'], [col('temp_ext'), '#36c']]);
+}
+
+// points: [ts, n, [mean...], [min...], [max...]]; a band for min..max, a line for the mean
+function draw(cv, points, series) {
+  const dpr = window.devicePixelRatio || 1, w = cv.clientWidth, h = cv.clientHeight;
+  cv.width = w * dpr;
+  cv.height = h * dpr;
+  const g = cv.getContext('2d');
+  g.scale(dpr, dpr);
+  g.font = '11px sans-serif';
+  g.fillStyle = '#888';
+  if (!points.length) {
+    g.fillText('no data', 8, 16);
+    return;
+  }
+  let lo = Infinity, hi = -Infinity;
+  for (const p of points) {
+    for (const [i] of series) {
+      lo = Math.min(lo, p[3][i]);
+      hi = Math.max(hi, p[4][i]);
+    }
+  }
+  if (hi - lo < 0.1) { hi += 0.5; lo -= 0.5; }
+  const t0 = points[0][0], t1 = points[points.length - 1][0], left = 42, bottom = 16;
+  const x = t => left + (w - left - 4) * (t - t0) / Math.max(1, t1 - t0);
+  const y = v => 4 + (h - bottom - 8) * (hi - v) / (hi - lo);
+  g.fillText(hi.toFixed(1), 2, 12);
+  g.fillText(lo.toFixed(1), 2, h - bottom);
+  g.fillText(new Date(t0 * 1000).toLocaleString(), left, h - 2);
+  const end = new Date(t1 * 1000).toLocaleString();
+  g.fillText(end, w - g.measureText(end).width - 2, h - 2);
+  for (const [i, color] of series) {
+    g.fillStyle = color;
+    g.strokeStyle = color;
+    g.globalAlpha = 0.2;
+    g.beginPath();
+    points.forEach((p, k) => (k ? g.lineTo : g.moveTo).call(g, x(p[0]), y(p[4][i])));
+    for (let k = points.length - 1; k >= 0; --k) g.lineTo(x(points[k][0]), y(points[k][3][i]));
+    g.fill();
+    g.globalAlpha = 1;
+    g.beginPath();
+    points.forEach((p, k) => (k ? g.lineTo : g.moveTo).call(g, x(p[0]), y(p[2][i])));
+    g.stroke();
+  }
+}
+
+function watchLcd() {
+  const rows = ['', '', '', ''];
+  const es = new EventSource('/lcd/stream');
+  es.onmessage = e => {
+    const d = JSON.parse(e.data);
+    for (const k in d.rows) rows[k] = d.rows[k];
+    $('lcd').textContent = rows.join('\n');
+  };
+}
+
+document.querySelectorAll('.range button').forEach(b => b.onclick = () => {
+  document.querySelectorAll('.range button').forEach(o => o.classList.toggle('on', o === b));
+  hours = +b.dataset.h;
+  loadHistory();
+});
+
+loadCurrent();
+loadHistory();
+watchLcd();
+setInterval(loadCurrent, 15000);
+setInterval(loadHistory, 600000);
@@ -0,0 +1,291 @@
+// Generated by tools/embed_assets.py from web/ - do not edit.
+#include "web_assets.h"
+
+// /assets/app.f2f49b68.css: 1155 bytes, 546 gzipped
+static const uint8_t WEB_ASSETS_APP_CSS_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xad, 0x93, 0xdb, 0xae, 0xa3, 0x20,
+  0x14, 0x86, 0xef, 0x7d, 0x0a, 0x93, 0x66, 0x92, 0xbd, 0x93, 0x62, 0x44, 0x7b, 0x84, 0xab, 0x79,
+  0x14, 0x14, 0xb0, 0x4c, 0x11, 0x0c, 0xe0, 0x6c, 0x3b, 0xc6, 0x77, 0x9f, 0x45, 0x4f, 0xd6, 0xee,
+  0xb9, 0x9c, 0x34, 0x31, 0x29, 0xe0, 0xef, 0xb7, 0x3e, 0xd6, 0xaa, 0x2c, 0xbf, 0x8c, 0xd2, 0x9a,
+  0x80, 0x24, 0x6b, 0x95, 0xbe, 0x10, 0x7f, 0xf1, 0x41, 0xb4, 0xa8, 0x57, 0xeb, 0x9f, 0x4e, 0x31,
+  0xbd, 0xf6, 0xcc, 0x78, 0xe4, 0x85, 0x53, 0x92, 0xb6, 0xcc, 0x35, 0xca, 0x90, 0x3c, 0x65, 0x7d,
+  0xb0, 0xb4, 0x63, 0x9c, 0x2b, 0xd3, 0x10, 0x5c, 0x74, 0x03, 0x6c, 0x0d, 0xe8, 0x4b, 0xf1, 0x70,
+  0x22, 0xc7, 0x5d, 0x0e, 0xff, 0x6b, 0xab, 0xad, 0x23, 0xab, 0xa2, 0x28, 0x68, 0xc5, 0xea, 0x73,
+  0xe3, 0x6c, 0x6f, 0x38, 0x59, 0x49, 0x06, 0xbf, 0xfd, 0x94, 0x9c, 0x04, 0xe3, 0xc2, 0x8d, 0x5c,
+  0xf9, 0x4e, 0xb3, 0x0b, 0x91, 0x5a, 0x0c, 0xf4, 0x57, 0xef, 0x83, 0x92, 0x17, 0x54, 0x03, 0x8c,
+  0x30, 0x81, 0xf8, 0x8e, 0xd5, 0x02, 0x55, 0x22, 0x7c, 0x09, 0x61, 0x28, 0xd3, 0xaa, 0x31, 0x48,
+  0x01, 0x9a, 0x27, 0x15, 0xf3, 0x42, 0x2b, 0x23, 0x20, 0x07, 0xdf, 0xd8, 0xbd, 0xfa, 0x23, 0x08,
+  0xce, 0x36, 0xa2, 0x9d, 0x21, 0xf3, 0xf4, 0xd0, 0x0d, 0xd3, 0xa9, 0x58, 0x9c, 0xc0, 0xa2, 0x9d,
+  0x92, 0x95, 0x0f, 0x2c, 0xf4, 0x7e, 0xbc, 0x43, 0xee, 0xf7, 0x7b, 0x3a, 0x9f, 0xc9, 0x8e, 0xd7,
+  0x23, 0x35, 0x73, 0xdc, 0x3f, 0x01, 0x1b, 0xa7, 0x38, 0x8d, 0x0f, 0x04, 0x00, 0xb0, 0x12, 0x04,
+  0x60, 0xea, 0xbe, 0x35, 0x9e, 0x38, 0xd1, 0x09, 0x16, 0x3e, 0xa2, 0x12, 0x24, 0x95, 0xd6, 0xeb,
+  0x56, 0x19, 0xb0, 0xf1, 0x81, 0x4b, 0xf0, 0xb0, 0xc6, 0xd2, 0x7d, 0x7e, 0xd2, 0x86, 0x75, 0x24,
+  0xc2, 0x24, 0x59, 0x8c, 0x1d, 0x17, 0x46, 0xa4, 0xa4, 0x95, 0x75, 0x60, 0x83, 0xe0, 0x6e, 0x48,
+  0xbd, 0xd5, 0x8a, 0xa7, 0x2b, 0xb1, 0x11, 0x98, 0xef, 0xee, 0x1b, 0xc8, 0x31, 0xae, 0x7a, 0x4f,
+  0x76, 0xe0, 0xf5, 0x21, 0x7d, 0x4e, 0x4b, 0xc1, 0x93, 0x79, 0x82, 0x56, 0xda, 0xd6, 0x67, 0xfa,
+  0xef, 0xc2, 0x0e, 0x50, 0xd8, 0xed, 0x95, 0xea, 0xdd, 0x1a, 0x64, 0x39, 0x66, 0x1a, 0x31, 0xde,
+  0xed, 0x61, 0xf8, 0x16, 0x08, 0xdc, 0xc0, 0x57, 0x6e, 0x1b, 0x69, 0xd5, 0x87, 0x60, 0xcd, 0xf8,
+  0x1d, 0xb5, 0x3e, 0xe4, 0xf4, 0xbd, 0xa0, 0x07, 0x25, 0xbc, 0x9f, 0xe2, 0xd8, 0x0e, 0xcb, 0x42,
+  0x36, 0x57, 0xf8, 0xd7, 0xdc, 0x2c, 0x46, 0xbf, 0x84, 0xc4, 0xd0, 0x7b, 0x11, 0x90, 0x37, 0x25,
+  0x52, 0x35, 0xbd, 0x7b, 0xd2, 0x1d, 0x22, 0x1c, 0xfd, 0x5f, 0x16, 0x21, 0xbb, 0x66, 0x5d, 0x50,
+  0x80, 0xb0, 0xec, 0x82, 0x07, 0xc1, 0x76, 0xbb, 0x9d, 0x92, 0x9a, 0x99, 0xdf, 0xcc, 0x8f, 0xb7,
+  0x1e, 0xc7, 0x79, 0xfe, 0x83, 0x9e, 0x84, 0x6a, 0x4e, 0x81, 0x14, 0x79, 0x2c, 0x70, 0xe1, 0x1f,
+  0x8a, 0x3b, 0xdf, 0xb3, 0xc2, 0x45, 0x0b, 0x62, 0xac, 0x6b, 0x99, 0x5e, 0x5c, 0xc5, 0x16, 0xe2,
+  0x1f, 0x14, 0x57, 0xcf, 0x6f, 0x94, 0xe5, 0x3c, 0x43, 0x51, 0x40, 0x76, 0xce, 0x94, 0x09, 0x0b,
+  0x45, 0xbc, 0x2c, 0xe3, 0xb2, 0x18, 0x96, 0xcb, 0xe5, 0xae, 0x9e, 0x92, 0x0e, 0x5c, 0xbd, 0x2e,
+  0xe2, 0xa2, 0x7c, 0xa4, 0x1d, 0xe5, 0x71, 0x9e, 0xdc, 0xef, 0x57, 0x13, 0xed, 0xbc, 0xcd, 0x0b,
+  0x8d, 0xa3, 0x86, 0xee, 0xd5, 0xe2, 0xac, 0xa4, 0x37, 0x07, 0x05, 0xae, 0x4f, 0x14, 0x7a, 0xfd,
+  0xb1, 0xb3, 0xcd, 0x8a, 0xd8, 0x47, 0xd2, 0xda, 0x00, 0x93, 0x7d, 0xbb, 0x29, 0x14, 0x6c, 0x77,
+  0xed, 0xa5, 0x6f, 0xb5, 0xcf, 0x1d, 0x3a, 0x25, 0x7f, 0x01, 0x06, 0x88, 0xf7, 0x14, 0x83, 0x04,
+  0x00, 0x00,
+};
+const WebAsset WEB_ASSETS_APP_CSS = { "/assets/app.f2f49b68.css", "text/css; charset=utf-8", "\"f2f49b68fc2d6c13\"", WEB_ASSETS_APP_CSS_GZ, sizeof(WEB_ASSETS_APP_CSS_GZ), true };
+
+// /assets/app.fc62d09b.js: 4024 bytes, 1811 gzipped
+static const uint8_t WEB_ASSETS_APP_JS_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xb5, 0x57, 0x6d, 0x6f, 0xdb, 0x46,
+  0x12, 0xfe, 0xee, 0x5f, 0x31, 0x4d, 0x7d, 0xe5, 0xb2, 0x96, 0x68, 0xc9, 0x76, 0x03, 0x23, 0xb2,
+  0x1d, 0x24, 0x4e, 0x0a, 0xe7, 0xe0, 0x26, 0x41, 0x1c, 0x5c, 0x3f, 0xe8, 0x84, 0x66, 0x45, 0xae,
+  0xc4, 0xad, 0xa8, 0x5d, 0x1d, 0xb9, 0x92, 0x6c, 0xa4, 0xfe, 0x4f, 0xfd, 0x0d, 0xfd, 0x65, 0xf7,
+  0xcc, 0x2e, 0x49, 0xbd, 0x9c, 0x83, 0x03, 0x0e, 0x38, 0xc3, 0x36, 0x97, 0xb3, 0x33, 0xcf, 0xec,
+  0xbc, 0xee, 0x30, 0x5a, 0x56, 0x8a, 0x2a, 0x57, 0xea, 0xd4, 0x45, 0x83, 0x83, 0xe3, 0x63, 0x7a,
+  0xad, 0x54, 0xae, 0x57, 0x8a, 0x32, 0x59, 0xe5, 0x63, 0x2b, 0xcb, 0xec, 0x05, 0x95, 0x4a, 0x66,
+  0xda, 0x4c, 0x2b, 0x9a, 0x94, 0x76, 0x4e, 0xc7, 0x72, 0xa1, 0x8f, 0x57, 0xfd, 0xe3, 0x74, 0x59,
+  0x96, 0xca, 0xb8, 0x0e, 0xa5, 0xb9, 0x2c, 0x5d, 0xd8, 0x64, 0x80, 0x66, 0x3f, 0xd7, 0x95, 0xb3,
+  0xe5, 0x43, 0x87, 0x5c, 0xae, 0xe8, 0xf6, 0xfa, 0x0d, 0xcd, 0x75, 0x59, 0xda, 0x32, 0x80, 0x30,
+  0xed, 0xb8, 0x48, 0xb3, 0x63, 0xa8, 0x56, 0x72, 0x4e, 0x6a, 0x05, 0x28, 0x9a, 0x28, 0x95, 0x25,
+  0x07, 0xa9, 0x35, 0x95, 0xa3, 0x43, 0xba, 0x24, 0x9d, 0xd1, 0xe5, 0x15, 0x65, 0x36, 0x5d, 0xce,
+  0xb1, 0x9d, 0x4c, 0x95, 0x7b, 0x5b, 0x28, 0x5e, 0xbe, 0x7e, 0x78, 0x97, 0x09, 0x9d, 0xc5, 0x83,
+  0x03, 0xd6, 0x38, 0x9c, 0x68, 0x55, 0x64, 0x1d, 0x2a, 0xe4, 0x58, 0x15, 0x1d, 0x5a, 0x1a, 0x8d,
+  0x53, 0x65, 0x2a, 0xd5, 0x73, 0x59, 0x54, 0xa3, 0x1a, 0xef, 0xfa, 0xd5, 0xa7, 0x37, 0x77, 0xc0,
+  0x1c, 0x1e, 0x10, 0x0d, 0xa3, 0xb5, 0xd2, 0xd3, 0xdc, 0x45, 0x1d, 0x8a, 0x7e, 0x6d, 0x57, 0xb3,
+  0x29, 0xfe, 0x9f, 0x8c, 0x3a, 0x9e, 0xc1, 0xa9, 0xf9, 0xe2, 0x37, 0x6d, 0xfc, 0xc6, 0x3b, 0x53,
+  0xe9, 0x4c, 0xf1, 0xea, 0xaf, 0x3f, 0xaf, 0xf1, 0xe8, 0xd7, 0x3c, 0xf9, 0x72, 0xbe, 0xcb, 0x42,
+  0x9f, 0x6e, 0xf8, 0xe5, 0x6f, 0xf8, 0xd7, 0xdb, 0xc6, 0x51, 0xf7, 0x9e, 0xe9, 0xc3, 0xd2, 0x7d,
+  0x1b, 0x68, 0x97, 0xe7, 0x09, 0xa4, 0x45, 0xa9, 0xaa, 0x6a, 0x59, 0x7a, 0xf1, 0x8f, 0x5b, 0xeb,
+  0xfc, 0xa3, 0xdc, 0xe2, 0x1a, 0x4b, 0xe7, 0x71, 0x5e, 0xe3, 0xa9, 0xca, 0x07, 0x5e, 0xfe, 0xa3,
+  0x36, 0x6b, 0x34, 0x38, 0x28, 0x94, 0xa3, 0xdc, 0x2e, 0xcb, 0x0a, 0x8e, 0x38, 0x39, 0x83, 0xf7,
+  0x82, 0x6f, 0x26, 0x73, 0x07, 0x82, 0x58, 0xc1, 0x6b, 0x31, 0x7b, 0x5c, 0xac, 0xe8, 0xf2, 0x92,
+  0xcc, 0xb2, 0x28, 0xe8, 0x8f, 0x3f, 0x48, 0x57, 0xef, 0xe5, 0x7b, 0xb1, 0x8a, 0xe9, 0x25, 0x45,
+  0xdd, 0x88, 0x5e, 0xd0, 0xfb, 0xe5, 0x7c, 0xac, 0x4a, 0x50, 0x12, 0x67, 0x7f, 0xd6, 0xf7, 0x2a,
+  0x13, 0x59, 0xcc, 0xa1, 0x90, 0xd5, 0x83, 0x49, 0x69, 0xb2, 0x34, 0xa9, 0xd3, 0xd6, 0x50, 0x61,
+  0x65, 0x76, 0x1d, 0x92, 0x44, 0xc4, 0xf4, 0x15, 0xc7, 0x73, 0xe5, 0x83, 0x7f, 0x12, 0x05, 0xbd,
+  0x29, 0xb4, 0xca, 0xb5, 0xd4, 0x8e, 0x44, 0x78, 0x4c, 0x94, 0x4b, 0x73, 0x11, 0xed, 0xa5, 0x58,
+  0x14, 0xc7, 0xc9, 0xef, 0x95, 0x35, 0x02, 0x4a, 0x58, 0xf8, 0x50, 0x44, 0x29, 0x12, 0xb3, 0x8a,
+  0xe2, 0x44, 0x1b, 0xa3, 0xca, 0x9b, 0xcf, 0xbf, 0xdc, 0x02, 0xc9, 0x47, 0x38, 0x99, 0xcb, 0x85,
+  0x10, 0xc3, 0xd9, 0x7e, 0x36, 0x8c, 0xd8, 0x30, 0x2f, 0x4d, 0xf4, 0xe5, 0x22, 0xd3, 0x2b, 0x4a,
+  0x0b, 0x59, 0x55, 0x97, 0xcf, 0x18, 0xe9, 0xd9, 0xd5, 0x45, 0xb5, 0x90, 0xe6, 0xea, 0xf0, 0xab,
+  0x17, 0x7a, 0xbc, 0x38, 0xf6, 0xaf, 0x17, 0x63, 0x50, 0xe0, 0x1b, 0x91, 0x0e, 0x67, 0x23, 0xf6,
+  0x0d, 0x36, 0xc6, 0x57, 0x74, 0xf8, 0x95, 0x31, 0xb1, 0x06, 0xca, 0xd5, 0x17, 0x1c, 0xcd, 0x6a,
+  0x23, 0xa2, 0x28, 0xa6, 0xa3, 0xff, 0x86, 0x7f, 0xab, 0xcd, 0x6c, 0x1b, 0x3b, 0x4d, 0x0a, 0x50,
+  0x1a, 0xd4, 0x34, 0x29, 0xab, 0x4a, 0xff, 0x96, 0x8d, 0xe7, 0xad, 0xf7, 0xe1, 0x71, 0x76, 0xf8,
+  0xd6, 0xce, 0x11, 0x45, 0x94, 0xbd, 0x9e, 0x47, 0x8d, 0xfa, 0xd6, 0x23, 0x95, 0x93, 0x6e, 0xc9,
+  0x2e, 0x71, 0xc8, 0xa4, 0x6b, 0x6b, 0x1c, 0x17, 0xd4, 0x25, 0x44, 0x51, 0x9a, 0x2f, 0xc9, 0xa8,
+  0x35, 0xbd, 0x91, 0x4e, 0x09, 0xff, 0xfe, 0x23, 0xf5, 0x7b, 0xbd, 0x1e, 0x87, 0xef, 0xd6, 0xa6,
+  0xb2, 0x50, 0x77, 0xa8, 0x7f, 0x33, 0x45, 0x90, 0x5e, 0x50, 0x94, 0x16, 0x36, 0x9d, 0x91, 0xb1,
+  0x8e, 0x2a, 0xc5, 0x2d, 0x81, 0xe8, 0x91, 0x52, 0x89, 0xb0, 0x90, 0x50, 0x71, 0x1d, 0xbd, 0x6f,
+  0xab, 0x8b, 0xec, 0x64, 0x02, 0x9b, 0x54, 0x10, 0x3c, 0x78, 0xf4, 0xf5, 0xf9, 0xb3, 0x2d, 0x0a,
+  0xbb, 0xae, 0x7c, 0xd1, 0x3f, 0x33, 0xe0, 0x7f, 0x46, 0x88, 0x6c, 0x85, 0x5e, 0xb0, 0x34, 0x4e,
+  0x17, 0x9e, 0xbe, 0xce, 0x6d, 0xa1, 0xa8, 0x94, 0x66, 0xaa, 0x90, 0x70, 0x3e, 0x77, 0x54, 0xf6,
+  0x54, 0x46, 0xdd, 0x84, 0xb6, 0x52, 0x67, 0x54, 0xc8, 0x23, 0x67, 0xa1, 0xfa, 0x17, 0xe9, 0xf2,
+  0x64, 0x52, 0x58, 0x5b, 0x0a, 0xb6, 0x34, 0x31, 0x76, 0x0d, 0xa6, 0xe3, 0x60, 0xea, 0xa0, 0xe5,
+  0xad, 0x9c, 0x5a, 0x80, 0x3b, 0x54, 0xc1, 0x05, 0x97, 0x01, 0xdc, 0xf3, 0xbc, 0xd7, 0x83, 0xed,
+  0x2d, 0xad, 0xff, 0xfc, 0x1c, 0xc4, 0xd3, 0x40, 0xed, 0x9f, 0x9d, 0xf5, 0x7a, 0x2c, 0xcf, 0xc5,
+  0xc3, 0xa7, 0x87, 0x34, 0x14, 0x76, 0x6b, 0xf6, 0x1f, 0x3d, 0x5f, 0x87, 0x8c, 0x9c, 0x2b, 0x2e,
+  0xab, 0x21, 0x32, 0x65, 0x81, 0x8c, 0x70, 0xe1, 0x65, 0xb0, 0x93, 0xf6, 0xeb, 0x5c, 0xc3, 0x4a,
+  0xe1, 0x51, 0xbe, 0x0b, 0x31, 0x6e, 0x7c, 0xda, 0x9c, 0x2f, 0x7f, 0xba, 0x26, 0xbe, 0xec, 0xb5,
+  0xd5, 0x97, 0xdc, 0x46, 0x2f, 0x0f, 0xbf, 0x32, 0xd4, 0xe3, 0x0f, 0xce, 0x62, 0xe9, 0xec, 0xe3,
+  0x0f, 0x6c, 0x1d, 0x96, 0xfc, 0x78, 0xfc, 0xb2, 0x57, 0x36, 0xd4, 0x9e, 0x31, 0x4f, 0xd0, 0xb3,
+  0x51, 0x39, 0x45, 0xd5, 0xec, 0xb4, 0x27, 0x0e, 0x8b, 0x04, 0x67, 0x41, 0xd0, 0x45, 0x9e, 0x84,
+  0xf7, 0x0d, 0x42, 0xb0, 0x3f, 0x4f, 0x78, 0x11, 0x88, 0x8f, 0x4f, 0xa6, 0x48, 0xa9, 0xdc, 0xb2,
+  0x34, 0x21, 0x0b, 0xda, 0x72, 0xb7, 0x05, 0x64, 0x0d, 0x77, 0x18, 0x7f, 0x12, 0x54, 0x6f, 0xa6,
+  0xee, 0x3f, 0x4c, 0x84, 0xf1, 0xf8, 0x59, 0x29, 0xd7, 0x82, 0x6b, 0xbb, 0x5b, 0x77, 0xe7, 0xb8,
+  0xf1, 0x64, 0x87, 0x86, 0x43, 0x08, 0x8b, 0x68, 0xb3, 0x11, 0x7d, 0x9f, 0x9e, 0xf7, 0xa2, 0xd1,
+  0x68, 0x4f, 0x92, 0xdb, 0xed, 0x13, 0x72, 0x6d, 0x37, 0xf7, 0x92, 0xd9, 0xe9, 0x69, 0x84, 0x28,
+  0x6d, 0x6d, 0x71, 0xf3, 0xf5, 0x5b, 0xa7, 0xcf, 0xd3, 0x00, 0x1a, 0x32, 0x37, 0xc0, 0xbc, 0xa0,
+  0x21, 0x63, 0x19, 0x88, 0xcc, 0x95, 0x34, 0x49, 0x92, 0xb0, 0xf4, 0x5c, 0xb7, 0x2b, 0x79, 0xcf,
+  0xab, 0xd1, 0x80, 0x24, 0x8d, 0xa5, 0xc9, 0x68, 0x82, 0xd4, 0xf6, 0xdb, 0xd8, 0xe9, 0x80, 0xc8,
+  0x15, 0xe1, 0x89, 0x9c, 0xe9, 0x0c, 0x71, 0xd0, 0xa6, 0xb4, 0x3f, 0x7a, 0xba, 0xda, 0x9c, 0xb8,
+  0x52, 0xa5, 0x56, 0xd5, 0x76, 0x76, 0x67, 0x8b, 0x12, 0x6e, 0x5b, 0xc3, 0x59, 0x76, 0x9d, 0x64,
+  0x6a, 0xa5, 0x53, 0xf5, 0x11, 0x5d, 0xb7, 0xf8, 0x24, 0x81, 0xc0, 0x0d, 0xba, 0xdf, 0xa1, 0x35,
+  0x97, 0xfa, 0x2a, 0x49, 0x0b, 0x8d, 0x3a, 0xfc, 0x55, 0x67, 0x2e, 0xef, 0xf8, 0x4c, 0x6a, 0x69,
+  0x37, 0xde, 0x73, 0xbe, 0x0c, 0x56, 0xc9, 0x9a, 0x19, 0x18, 0x13, 0xd9, 0x0b, 0xf4, 0x9a, 0x9a,
+  0x7b, 0x16, 0x8e, 0xee, 0x16, 0xd9, 0x9f, 0x60, 0x1a, 0x90, 0x70, 0xff, 0xfa, 0x4a, 0xbf, 0x77,
+  0x22, 0x3a, 0xc9, 0x22, 0xef, 0xfa, 0x69, 0x52, 0x71, 0x07, 0x11, 0xe0, 0xef, 0xb0, 0x50, 0x4d,
+  0x9c, 0xd8, 0xd0, 0x0e, 0xfa, 0xfd, 0xc5, 0x3d, 0x55, 0xd2, 0x54, 0x5d, 0xb6, 0x6b, 0x12, 0xd5,
+  0xbb, 0xba, 0x28, 0xee, 0xdc, 0x03, 0x4a, 0x01, 0x2c, 0xdf, 0x9f, 0x9f, 0x9f, 0x7b, 0xba, 0x9e,
+  0x90, 0xf8, 0xae, 0xce, 0xbf, 0x42, 0x99, 0xa9, 0xcb, 0x9b, 0x64, 0x0a, 0x12, 0x9f, 0xbd, 0x62,
+  0x63, 0x31, 0x9a, 0x38, 0xbe, 0xf2, 0xce, 0x71, 0x81, 0x3e, 0xaf, 0x33, 0x73, 0x37, 0xdd, 0xb8,
+  0x52, 0x0b, 0xee, 0x09, 0xef, 0xcc, 0x44, 0xa3, 0x57, 0x63, 0x08, 0xc9, 0x35, 0x5e, 0xbb, 0xcd,
+  0x3b, 0x33, 0x72, 0x3c, 0x44, 0xb0, 0x6f, 0x41, 0x76, 0x52, 0x07, 0xa0, 0x51, 0xb9, 0xb5, 0x3b,
+  0xd4, 0x23, 0xde, 0xdf, 0x0e, 0x0c, 0xff, 0x14, 0x6d, 0xd3, 0x41, 0xa8, 0x45, 0x61, 0x11, 0xc2,
+  0xe1, 0xe9, 0x08, 0xcc, 0x6d, 0xb1, 0x78, 0x9d, 0x81, 0x43, 0xde, 0x8b, 0x5c, 0x33, 0xc7, 0xd9,
+  0x16, 0xc7, 0x63, 0x7d, 0x5c, 0x36, 0x1c, 0xbc, 0x5d, 0x86, 0xbc, 0xa0, 0x5e, 0xd2, 0x87, 0x12,
+  0x16, 0x3e, 0xba, 0xc4, 0xcb, 0x4f, 0x03, 0x26, 0x77, 0xeb, 0xe5, 0xa6, 0x98, 0x5c, 0xaf, 0xad,
+  0xd6, 0x61, 0x6f, 0x84, 0x5f, 0x0c, 0x5a, 0xfd, 0x0d, 0x69, 0xc7, 0x8f, 0x80, 0xee, 0x07, 0x96,
+  0x42, 0x4d, 0x38, 0x2e, 0x67, 0x27, 0x1d, 0x1a, 0x5b, 0xe7, 0x30, 0x89, 0x71, 0xb7, 0xdb, 0x44,
+  0xfa, 0x9e, 0x9b, 0x1b, 0x17, 0xa8, 0x67, 0x3c, 0x22, 0xb1, 0xe6, 0x63, 0xf1, 0xba, 0x4b, 0x67,
+  0x31, 0xf2, 0x42, 0xf0, 0xca, 0xf5, 0xb8, 0xb1, 0xb6, 0x96, 0xf5, 0xbd, 0x6a, 0x4f, 0xde, 0x20,
+  0x3d, 0x00, 0x69, 0xc5, 0x48, 0x67, 0x0c, 0xc3, 0x47, 0xa8, 0x15, 0x76, 0xe9, 0xdc, 0x03, 0x79,
+  0x8b, 0x57, 0x0c, 0xd4, 0x18, 0x1f, 0x6f, 0xb2, 0xc3, 0xc7, 0x3a, 0xd7, 0xed, 0x80, 0xd1, 0x47,
+  0x75, 0xe2, 0xcc, 0xfd, 0x93, 0x7d, 0x9e, 0xc2, 0xee, 0xf3, 0x6c, 0x54, 0xed, 0xf3, 0xb6, 0x97,
+  0x20, 0x7c, 0xf7, 0xad, 0x2b, 0x30, 0xb8, 0x28, 0xa0, 0x9c, 0x6c, 0x99, 0xa3, 0x50, 0xd6, 0x97,
+  0x9b, 0x6b, 0x14, 0xf6, 0x7e, 0x0b, 0x61, 0x4f, 0x29, 0x04, 0xb9, 0x3c, 0xbb, 0xa0, 0xa1, 0xf2,
+  0x79, 0x68, 0x6b, 0xc8, 0x71, 0x5d, 0x87, 0xdd, 0xe6, 0xd4, 0x41, 0xdf, 0x4e, 0xe6, 0x75, 0xb8,
+  0x69, 0xda, 0xf2, 0x89, 0x04, 0xdc, 0xad, 0x22, 0xcf, 0x35, 0xa8, 0x37, 0x30, 0x53, 0xdb, 0x99,
+  0x7a, 0x72, 0x6b, 0x5a, 0xd8, 0xb1, 0x2c, 0x5e, 0x15, 0x8b, 0x5c, 0x12, 0xa7, 0xd4, 0x49, 0xb3,
+  0x31, 0x56, 0x53, 0x6d, 0x3e, 0x22, 0xa2, 0xcd, 0x6d, 0x51, 0x27, 0x10, 0x4e, 0xf3, 0x56, 0xe2,
+  0xfe, 0x11, 0x8b, 0x0e, 0xcd, 0xc2, 0x70, 0x38, 0xc3, 0xdd, 0x38, 0xe5, 0xc9, 0x45, 0x7d, 0xb6,
+  0xb8, 0x1f, 0x61, 0x97, 0x5d, 0x61, 0x19, 0x27, 0xf0, 0x42, 0x21, 0xa6, 0x1d, 0xba, 0x17, 0x0b,
+  0x24, 0x1b, 0x5c, 0xf9, 0x20, 0x9a, 0x84, 0x8f, 0x6b, 0x54, 0x6f, 0x1c, 0x97, 0xe7, 0x6c, 0x73,
+  0xd7, 0x6c, 0x72, 0x74, 0x00, 0xf2, 0x15, 0x8e, 0x35, 0xa0, 0x6e, 0x17, 0xca, 0x1a, 0x25, 0x02,
+  0x80, 0x21, 0xab, 0x67, 0xa3, 0x16, 0xb8, 0x25, 0x84, 0x9a, 0x8b, 0x07, 0x5b, 0x5e, 0x11, 0xf1,
+  0xd3, 0xf6, 0xf6, 0xff, 0xef, 0xd6, 0x9e, 0xec, 0x58, 0xdb, 0x84, 0x22, 0x68, 0xf1, 0xe3, 0x50,
+  0xdb, 0xf8, 0xd7, 0x7c, 0x61, 0xde, 0xa6, 0xd9, 0xce, 0x20, 0x53, 0xf2, 0x98, 0x84, 0xb1, 0x21,
+  0xe2, 0xb9, 0xbd, 0xfd, 0x1b, 0x6d, 0xa5, 0x61, 0x55, 0x67, 0xe1, 0x5b, 0xfe, 0x60, 0xba, 0xc3,
+  0x04, 0x92, 0x2a, 0xcc, 0xcb, 0x9b, 0x2f, 0xa9, 0xd0, 0x95, 0x71, 0xb7, 0x5a, 0x83, 0x1b, 0xb6,
+  0x92, 0x53, 0x4e, 0x01, 0xc5, 0x96, 0x6c, 0x0f, 0xde, 0x9c, 0xcb, 0x7f, 0xbf, 0xfb, 0xf0, 0x3e,
+  0x59, 0xc8, 0xb2, 0x52, 0x42, 0x25, 0xdc, 0x52, 0xb7, 0x43, 0x14, 0xd8, 0x66, 0xa4, 0x71, 0x43,
+  0x25, 0x7c, 0xaa, 0xd8, 0x9f, 0x0d, 0xfe, 0x86, 0x64, 0xa0, 0x60, 0xdd, 0x0e, 0x9f, 0xd0, 0xff,
+  0x1f, 0xa3, 0x20, 0xf3, 0xd4, 0xb3, 0xf1, 0x3f, 0x4d, 0x38, 0xd6, 0xa3, 0xbf, 0x57, 0xdb, 0xef,
+  0xb9, 0x7f, 0x2d, 0xf1, 0x85, 0x72, 0xa7, 0x0a, 0x95, 0x62, 0xa2, 0x79, 0x05, 0x6f, 0x46, 0x49,
+  0x18, 0x00, 0xc7, 0x4b, 0x94, 0x2f, 0x64, 0xda, 0x78, 0x8c, 0xd9, 0x80, 0x31, 0x6c, 0xc2, 0x65,
+  0x96, 0x72, 0xea, 0x88, 0xb8, 0x31, 0xe9, 0x7f, 0x40, 0xb3, 0x2c, 0x6b, 0x13, 0x3f, 0xa0, 0xdf,
+  0x62, 0x9c, 0x42, 0x09, 0x4f, 0xa7, 0xb8, 0xc3, 0x22, 0x70, 0x75, 0x08, 0xbb, 0x18, 0xbf, 0xc7,
+  0x21, 0x86, 0xcd, 0xc7, 0xd2, 0xd1, 0xd8, 0xbb, 0x08, 0x23, 0x71, 0x92, 0xfb, 0x59, 0x70, 0x7b,
+  0x12, 0x85, 0x55, 0xfc, 0xf9, 0xb3, 0xf3, 0xbd, 0x33, 0x38, 0xd8, 0x63, 0xd9, 0xc4, 0x7b, 0x70,
+  0x00, 0x98, 0x77, 0x70, 0x53, 0xb9, 0x92, 0x85, 0xd8, 0x92, 0x42, 0x7f, 0xfb, 0x29, 0x0c, 0xab,
+  0xfb, 0x0c, 0x37, 0xcd, 0xb7, 0x34, 0x46, 0xcd, 0xc0, 0xf1, 0x6f, 0x6a, 0x1b, 0x02, 0x2b, 0xb8,
+  0x0f, 0x00, 0x00,
+};
+const WebAsset WEB_ASSETS_APP_JS = { "/assets/app.fc62d09b.js", "application/javascript; charset=utf-8", "\"fc62d09b5b5042f3\"", WEB_ASSETS_APP_JS_GZ, sizeof(WEB_ASSETS_APP_JS_GZ), true };
+
+// /dashboard.html: 935 bytes, 498 gzipped
+static const uint8_t WEB_DASHBOARD_HTML_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x7d, 0x53, 0xc1, 0x6e, 0xdb, 0x30,
+  0x0c, 0xbd, 0xe7, 0x2b, 0x34, 0x1d, 0x8a, 0x16, 0x58, 0xec, 0xc4, 0x0b, 0xd2, 0x16, 0x95, 0x75,
+  0xd8, 0x76, 0xed, 0x69, 0x03, 0x76, 0x56, 0x24, 0xda, 0xd6, 0xa2, 0x48, 0x82, 0x44, 0x27, 0xcb,
+  0xdf, 0x8f, 0xb2, 0x17, 0xb4, 0x6b, 0xb3, 0x5d, 0x6c, 0x91, 0x7c, 0x7c, 0x7c, 0xa4, 0x28, 0xf1,
+  0xc1, 0x04, 0x8d, 0xe7, 0x08, 0x6c, 0xc0, 0x83, 0x93, 0xa2, 0x7c, 0x99, 0x53, 0xbe, 0x6f, 0x39,
+  0x78, 0x4e, 0x36, 0x28, 0x23, 0xc5, 0x01, 0x50, 0x31, 0x3d, 0xa8, 0x94, 0x01, 0x5b, 0x3e, 0x62,
+  0xb7, 0x7c, 0xe0, 0x7f, 0xbc, 0x5e, 0x1d, 0xa0, 0xe5, 0x47, 0x0b, 0xa7, 0x18, 0x12, 0x72, 0xa6,
+  0x83, 0x47, 0xf0, 0x84, 0x3a, 0x59, 0x83, 0x43, 0x6b, 0xe0, 0x68, 0x35, 0x2c, 0x27, 0xe3, 0xa3,
+  0xf5, 0x16, 0xad, 0x72, 0xcb, 0xac, 0x95, 0x83, 0x76, 0xcd, 0xe5, 0x42, 0xa0, 0x45, 0x07, 0xf2,
+  0x33, 0xc0, 0x60, 0x8f, 0xc0, 0x9e, 0x03, 0x21, 0x42, 0x12, 0xf5, 0xec, 0x5e, 0x08, 0x67, 0xfd,
+  0x9e, 0x25, 0x70, 0x2d, 0xcf, 0x78, 0x76, 0x90, 0x07, 0x00, 0xaa, 0x31, 0x24, 0xe8, 0x5a, 0x5e,
+  0xab, 0x4c, 0x72, 0x72, 0xad, 0x62, 0xac, 0xba, 0xa6, 0xdb, 0x3c, 0xee, 0xb6, 0x0f, 0x95, 0xce,
+  0xb9, 0xd0, 0xd6, 0xb3, 0xee, 0x5d, 0x30, 0x67, 0xb2, 0x8a, 0x01, 0x89, 0x9a, 0x59, 0xbf, 0xaf,
+  0x44, 0x3e, 0x91, 0xa3, 0xf2, 0xcc, 0x9a, 0x52, 0x44, 0xe1, 0x48, 0x04, 0xd4, 0x84, 0x07, 0x8d,
+  0xd6, 0xf7, 0x55, 0x55, 0x89, 0xba, 0xc4, 0xe5, 0xcc, 0x49, 0x34, 0x0b, 0x91, 0x4b, 0x2c, 0xcc,
+  0x29, 0x5a, 0x25, 0x43, 0x19, 0x04, 0x9a, 0x9d, 0x2f, 0x61, 0x3a, 0x19, 0x7b, 0x64, 0xda, 0x91,
+  0xce, 0x96, 0x27, 0x9a, 0x29, 0x10, 0x6e, 0x37, 0x22, 0x52, 0xaa, 0x51, 0xa8, 0x96, 0x43, 0xcb,
+  0x9b, 0x0d, 0xbf, 0x20, 0x02, 0xcd, 0xbb, 0xd9, 0xb0, 0x41, 0xd4, 0x33, 0xe6, 0x1d, 0x76, 0xbd,
+  0xa5, 0xa9, 0xdf, 0x93, 0x79, 0xce, 0xff, 0xc4, 0xdc, 0x37, 0x2b, 0x2e, 0x3f, 0xad, 0xde, 0x80,
+  0x6a, 0x12, 0x42, 0x72, 0x3a, 0xdb, 0x8f, 0x09, 0x64, 0xf9, 0x6b, 0x15, 0x27, 0x8d, 0x3f, 0xc0,
+  0xf6, 0x03, 0xb2, 0xdb, 0x7d, 0x7f, 0x27, 0xea, 0x57, 0x7e, 0xa1, 0x95, 0x3f, 0xaa, 0x3c, 0xb7,
+  0xb8, 0x3c, 0x4d, 0xa8, 0xd2, 0xe5, 0xec, 0x96, 0x13, 0xb6, 0x70, 0x5d, 0x25, 0xfd, 0x0e, 0x87,
+  0x08, 0x89, 0x46, 0x99, 0x80, 0xdd, 0xde, 0x18, 0xe8, 0x9f, 0xbe, 0xdc, 0x31, 0x61, 0x2f, 0x8d,
+  0xee, 0x99, 0xf5, 0x44, 0x66, 0x7d, 0xb6, 0x06, 0x44, 0x6d, 0xe5, 0x5f, 0x31, 0xf8, 0x45, 0xb1,
+  0x30, 0xe2, 0x25, 0xf8, 0x1f, 0x59, 0x48, 0x75, 0xae, 0x8b, 0xba, 0x72, 0x1b, 0x62, 0x68, 0xe4,
+  0x57, 0x9b, 0xa3, 0x53, 0x67, 0xba, 0xca, 0x46, 0x8a, 0x48, 0xea, 0x0a, 0x8f, 0xd3, 0xa6, 0x90,
+  0xc4, 0xd2, 0xc4, 0xab, 0xbc, 0x2e, 0x04, 0x2c, 0x4b, 0xa3, 0x2e, 0xeb, 0xc6, 0xe5, 0x37, 0xc0,
+  0x31, 0x8a, 0x5a, 0x49, 0x76, 0x73, 0xb0, 0xc6, 0x04, 0x7c, 0x62, 0x2f, 0x61, 0x7a, 0x0d, 0xc9,
+  0x6a, 0x5a, 0x85, 0xe7, 0xf9, 0x50, 0x70, 0xa4, 0x68, 0x66, 0x21, 0x19, 0x3a, 0xd9, 0x88, 0x2c,
+  0x27, 0xfd, 0x66, 0x73, 0xf5, 0xb6, 0x31, 0xab, 0xc7, 0x5d, 0xf5, 0x73, 0xde, 0xa2, 0x09, 0x56,
+  0x3a, 0x98, 0x76, 0x97, 0x94, 0x96, 0x67, 0xb9, 0xf8, 0x0d, 0xa1, 0xa5, 0x5a, 0x10, 0xa7, 0x03,
+  0x00, 0x00,
+};
+const WebAsset WEB_DASHBOARD_HTML = { "/dashboard.html", "text/html; charset=utf-8", "\"ebb292120a5f2b27\"", WEB_DASHBOARD_HTML_GZ, sizeof(WEB_DASHBOARD_HTML_GZ), false };
+
+// /index.html: 469 bytes, 273 gzipped
+static const uint8_t WEB_INDEX_HTML_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x75, 0x51, 0x3d, 0x4f, 0xc5, 0x30,
+  0x0c, 0xdc, 0xfb, 0x2b, 0xc2, 0x14, 0x90, 0x80, 0x08, 0xb1, 0x30, 0xe4, 0x79, 0xe0, 0x3d, 0x31,
+  0xf0, 0x2d, 0x75, 0x60, 0x4e, 0x13, 0x97, 0x1a, 0xd2, 0xa6, 0x72, 0xd2, 0xa2, 0xfe, 0x7b, 0xd2,
+  0xf6, 0x21, 0x01, 0x52, 0x17, 0xeb, 0x6c, 0xdd, 0x5d, 0xe2, 0xb3, 0x3e, 0x71, 0xc1, 0xa6, 0xa9,
+  0x47, 0xd1, 0xa4, 0xd6, 0x83, 0x3e, 0x56, 0x34, 0x0e, 0x74, 0x8b, 0xc9, 0x08, 0xdb, 0x18, 0x8e,
+  0x98, 0x76, 0x72, 0x48, 0xf5, 0xc5, 0x8d, 0x04, 0x9d, 0x28, 0x79, 0x84, 0x07, 0x9c, 0x44, 0x89,
+  0x3c, 0x22, 0x6b, 0xb5, 0x4e, 0xb4, 0x5a, 0x55, 0x55, 0x70, 0x13, 0x14, 0xba, 0xb9, 0x86, 0x5b,
+  0xc4, 0x86, 0x46, 0x14, 0x4f, 0xa1, 0xa3, 0x14, 0x32, 0x31, 0xcf, 0x0a, 0x3d, 0xf8, 0x5c, 0x3c,
+  0x81, 0x36, 0xa2, 0x61, 0xac, 0x77, 0x52, 0x39, 0x13, 0x9b, 0x2a, 0x18, 0x76, 0x12, 0x0e, 0x3f,
+  0x50, 0x2b, 0x93, 0x1d, 0x33, 0xed, 0x1f, 0xf7, 0x8b, 0x6a, 0x92, 0x50, 0x66, 0x3b, 0x14, 0x6f,
+  0x74, 0x47, 0xc2, 0x32, 0x3a, 0xec, 0x12, 0x19, 0x1f, 0xb7, 0x34, 0x3d, 0x87, 0x91, 0x22, 0x85,
+  0x4e, 0xc2, 0x2b, 0x53, 0x6b, 0x78, 0x12, 0x4a, 0x54, 0xc6, 0x7e, 0x0e, 0xfd, 0xe2, 0xb1, 0xa5,
+  0xf3, 0xd6, 0x5d, 0x7e, 0xc4, 0x59, 0xf6, 0xb8, 0x3f, 0x88, 0xd3, 0xfb, 0xf2, 0xe5, 0xf9, 0x6c,
+  0xe6, 0x9e, 0x8b, 0x3f, 0x1c, 0x15, 0x13, 0xa3, 0x69, 0x25, 0xf8, 0x79, 0xd9, 0xb5, 0xd9, 0xb2,
+  0x34, 0x3d, 0xa9, 0xf1, 0x4a, 0xd9, 0x81, 0x39, 0x7f, 0x5a, 0xc2, 0x7e, 0x05, 0x22, 0x6b, 0x1c,
+  0x75, 0xef, 0x71, 0xe3, 0x95, 0x7c, 0x09, 0x26, 0x1b, 0x25, 0x1c, 0xc1, 0x2f, 0x7b, 0xb5, 0xe4,
+  0xa9, 0x96, 0xd4, 0x73, 0xc2, 0xf3, 0xf9, 0x8a, 0x6f, 0x31, 0xed, 0x2b, 0x79, 0xd5, 0x01, 0x00,
+  0x00,
+};
+const WebAsset WEB_INDEX_HTML = { "/index.html", "text/html; charset=utf-8", "\"1ce4cb8cd5cc175d\"", WEB_INDEX_HTML_GZ, sizeof(WEB_INDEX_HTML_GZ), false };
+
+// /provision.html: 841 bytes, 417 gzipped
+static const uint8_t WEB_PROVISION_HTML_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x9d, 0x93, 0x41, 0x6b, 0xdc, 0x30,
+  0x10, 0x85, 0xef, 0xfe, 0x15, 0xaa, 0x0e, 0xa5, 0x85, 0x1a, 0x77, 0x9d, 0x12, 0xc2, 0x56, 0x36,
+  0x34, 0x84, 0x42, 0x4f, 0x5d, 0xba, 0x85, 0x9c, 0x65, 0x6b, 0x1c, 0x0f, 0x2b, 0x4b, 0xc2, 0x1a,
+  0x7b, 0xd7, 0x84, 0xfe, 0xf7, 0x4a, 0xb6, 0xbb, 0x24, 0x9b, 0xe6, 0xd0, 0x5e, 0x2c, 0xa4, 0x91,
+  0xbf, 0x79, 0x7a, 0x4f, 0x12, 0x6f, 0x94, 0xad, 0x69, 0x72, 0xc0, 0x5a, 0xea, 0x74, 0x29, 0xd6,
+  0x2f, 0x48, 0x55, 0x8a, 0x0e, 0x48, 0xb2, 0xba, 0x95, 0xbd, 0x07, 0x2a, 0xf8, 0x40, 0x4d, 0x7a,
+  0xc3, 0xd7, 0x55, 0x23, 0x3b, 0x28, 0xf8, 0x88, 0x70, 0x74, 0xb6, 0x27, 0xce, 0x6a, 0x6b, 0x08,
+  0x4c, 0xd8, 0x75, 0x44, 0x45, 0x6d, 0xa1, 0x60, 0xc4, 0x1a, 0xd2, 0x79, 0xf2, 0x01, 0x0d, 0x12,
+  0x4a, 0x9d, 0xfa, 0x5a, 0x6a, 0x28, 0x36, 0xbc, 0x4c, 0x04, 0x21, 0x69, 0x28, 0x6f, 0x01, 0x5a,
+  0x1c, 0x81, 0xdd, 0xe3, 0x57, 0x64, 0xbb, 0xde, 0x8e, 0xe8, 0xd1, 0x1a, 0x91, 0x2d, 0xd5, 0x44,
+  0x78, 0x9a, 0xc2, 0x58, 0x59, 0x35, 0x3d, 0x36, 0x81, 0x9f, 0x36, 0xb2, 0x43, 0x3d, 0x6d, 0xbf,
+  0xf4, 0x81, 0xf6, 0xb9, 0x93, 0xfd, 0x03, 0x9a, 0xed, 0x26, 0x77, 0xa7, 0x5f, 0x5a, 0x56, 0xa0,
+  0x1f, 0x15, 0x7a, 0xa7, 0xe5, 0xb4, 0xad, 0xb4, 0xad, 0x0f, 0x6b, 0x3d, 0x25, 0xeb, 0xb6, 0x37,
+  0x61, 0x8b, 0xc8, 0x16, 0x5a, 0x22, 0xb2, 0xe5, 0x70, 0x11, 0x1b, 0x66, 0xed, 0xd5, 0xab, 0x32,
+  0x42, 0x29, 0x11, 0x8d, 0xed, 0x3b, 0x26, 0x6b, 0x0a, 0x2b, 0x05, 0xcf, 0xbc, 0x1c, 0xe3, 0xa9,
+  0x1a, 0xe4, 0x2c, 0xd8, 0xd0, 0x5a, 0x55, 0xf0, 0xdd, 0xf7, 0xfd, 0xcf, 0x78, 0xa4, 0x59, 0x43,
+  0xb9, 0xdf, 0x7f, 0xbb, 0x63, 0x1b, 0x81, 0xc6, 0x0d, 0xb4, 0x9a, 0xe4, 0x3d, 0xaa, 0x0d, 0x67,
+  0xd1, 0xe3, 0x82, 0x13, 0x9c, 0x82, 0x5b, 0x9d, 0x3c, 0x69, 0x30, 0x0f, 0xc1, 0x28, 0x7e, 0x95,
+  0x07, 0x4b, 0xb3, 0xe5, 0xe7, 0x3f, 0x90, 0x9d, 0xf4, 0xfe, 0x68, 0x7b, 0x75, 0x01, 0x72, 0xfe,
+  0x70, 0xe6, 0xb8, 0x75, 0xcb, 0x33, 0xd6, 0xf5, 0xa7, 0xa7, 0xac, 0xb6, 0x7f, 0xae, 0x2a, 0x67,
+  0xef, 0x2a, 0x59, 0x1f, 0x06, 0xf7, 0xfe, 0x85, 0xbc, 0xfc, 0xff, 0xe4, 0xe5, 0x97, 0xf2, 0xf2,
+  0x7f, 0x90, 0xa7, 0x70, 0x64, 0x73, 0x24, 0x05, 0x7f, 0x12, 0x55, 0x8c, 0x33, 0xba, 0x59, 0x0d,
+  0x44, 0xd6, 0xac, 0x34, 0x3f, 0x54, 0x1d, 0x12, 0x2f, 0xf7, 0xc1, 0x7d, 0x91, 0x2d, 0xa5, 0x18,
+  0x64, 0x40, 0xc4, 0x21, 0x46, 0xf4, 0x22, 0xa9, 0x1e, 0x2a, 0x6b, 0xe9, 0x22, 0xa6, 0xbf, 0x35,
+  0xfc, 0x18, 0x1b, 0xbe, 0xde, 0x8f, 0xbd, 0x65, 0x3f, 0x66, 0xd4, 0xb9, 0xf1, 0xb9, 0x61, 0x36,
+  0x5f, 0xa1, 0x70, 0x4f, 0xe2, 0x93, 0x49, 0x7e, 0x03, 0x76, 0xb3, 0x79, 0x97, 0x49, 0x03, 0x00,
+  0x00,
+};
+const WebAsset WEB_PROVISION_HTML = { "/provision.html", "text/html; charset=utf-8", "\"2665b8a64686ec08\"", WEB_PROVISION_HTML_GZ, sizeof(WEB_PROVISION_HTML_GZ), false };
+
+// /wifi.html: 320 bytes, 232 gzipped
+static const uint8_t WEB_WIFI_HTML_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x65, 0x90, 0x3b, 0x6b, 0xc5, 0x30,
+  0x0c, 0x85, 0xf7, 0xfc, 0x0a, 0x77, 0xd2, 0x54, 0x32, 0xdc, 0xa5, 0x5c, 0x64, 0x4f, 0xa5, 0xd0,
+  0xe9, 0x5e, 0x70, 0xa1, 0x63, 0x71, 0x62, 0x85, 0x08, 0x92, 0xd8, 0xd8, 0xf2, 0x7d, 0xfc, 0xfb,
+  0x3a, 0x8f, 0x4e, 0x5d, 0x64, 0xa4, 0xf3, 0x1d, 0x74, 0x64, 0x7c, 0xf1, 0xa1, 0x97, 0x67, 0x24,
+  0x35, 0xca, 0x3c, 0x19, 0x3c, 0x2a, 0x39, 0x6f, 0x70, 0x26, 0x71, 0xaa, 0x1f, 0x5d, 0xca, 0x24,
+  0x1a, 0x8a, 0x0c, 0xaf, 0x6f, 0x60, 0x50, 0x58, 0x26, 0x32, 0xdf, 0xfc, 0xc1, 0xca, 0x92, 0x94,
+  0x88, 0xed, 0x3e, 0xc1, 0x76, 0x77, 0x75, 0xc1, 0x3f, 0x4d, 0x83, 0xe3, 0xc9, 0x58, 0x09, 0x89,
+  0xd4, 0x46, 0xf6, 0x89, 0x3c, 0x2d, 0xc2, 0x6e, 0xca, 0x95, 0x3b, 0x55, 0x7d, 0x08, 0x69, 0x56,
+  0x75, 0xc3, 0x18, 0xbc, 0x86, 0xeb, 0xc5, 0x7e, 0x81, 0x72, 0xbd, 0x70, 0x58, 0x34, 0xb4, 0x75,
+  0xdf, 0xcf, 0x9d, 0x07, 0x06, 0xd3, 0x58, 0xfb, 0xf9, 0x7e, 0xc6, 0x2e, 0x19, 0xe4, 0x25, 0x16,
+  0x51, 0x8b, 0x9b, 0x49, 0x43, 0xce, 0xec, 0x41, 0xad, 0xb1, 0x35, 0x08, 0x3d, 0xa4, 0xc6, 0xaa,
+  0x48, 0x73, 0x75, 0x39, 0xdf, 0x43, 0xf2, 0xff, 0x0d, 0xb1, 0x2a, 0x7f, 0x86, 0x78, 0x50, 0xbb,
+  0x69, 0x33, 0x1e, 0xec, 0xae, 0xe7, 0xd2, 0xcd, 0x2c, 0xa0, 0x6e, 0x6e, 0x2a, 0xb5, 0xb5, 0xee,
+  0x46, 0x35, 0x08, 0xb6, 0x6b, 0xe2, 0xf5, 0xdd, 0x0e, 0xac, 0x57, 0xac, 0x3f, 0xd5, 0xfc, 0x02,
+  0xbb, 0x24, 0x3c, 0x58, 0x40, 0x01, 0x00, 0x00,
+};
+const WebAsset WEB_WIFI_HTML = { "/wifi.html", "text/html; charset=utf-8", "\"751129776c7b99f1\"", WEB_WIFI_HTML_GZ, sizeof(WEB_WIFI_HTML_GZ), false };
+
+const WebAsset *const WEB_ASSETS[WEB_ASSET_COUNT] = {
+  &WEB_ASSETS_APP_CSS,
+  &WEB_ASSETS_APP_JS,
+  &WEB_DASHBOARD_HTML,
+  &WEB_INDEX_HTML,
+  &WEB_PROVISION_HTML,
+  &WEB_WIFI_HTML,
+};
+
+const WebAsset *web_findAsset(const char *uri) {
+  size_t len = strcspn(uri, "?");
+  for (uint8_t i = 0; i < WEB_ASSET_COUNT; ++i) {
+    const char *path = WEB_ASSETS[i]->path;
+    if (strlen(path) == len && strncmp(path, uri, len) == 0) return WEB_ASSETS[i];
+  }
+  return nullptr;
+}
@@ -0,0 +1,29 @@
+// Generated by tools/embed_assets.py from web/ - do not edit.
+//
+// path                              bytes   gzip  etag
+// /assets/app.f2f49b68.css           1155    546  "f2f49b68fc2d6c13"  immutable
+// /assets/app.fc62d09b.js            4024   1811  "fc62d09b5b5042f3"  immutable
+// /dashboard.html                     935    498  "ebb292120a5f2b27"
+// /index.html                         469    273  "1ce4cb8cd5cc175d"
+// /provision.html                     841    417  "2665b8a64686ec08"
+// /wifi.html                          320    232  "751129776c7b99f1"
+
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include "http_server.h"
+
+extern const WebAsset WEB_ASSETS_APP_CSS;          // /assets/app.f2f49b68.css
+extern const WebAsset WEB_ASSETS_APP_JS;           // /assets/app.fc62d09b.js
+extern const WebAsset WEB_DASHBOARD_HTML;          // /dashboard.html
+extern const WebAsset WEB_INDEX_HTML;              // /index.html
+extern const WebAsset WEB_PROVISION_HTML;          // /provision.html
+extern const WebAsset WEB_WIFI_HTML;               // /wifi.html
+
+#define WEB_ASSET_COUNT 6
+extern const WebAsset *const WEB_ASSETS[WEB_ASSET_COUNT];
+
+// Asset served at uri (query string ignored), nullptr if none
+const WebAsset *web_findAsset(const char *uri);
+
+#endif // WEB_ASSETS_H
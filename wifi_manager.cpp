@@ -0,0 +1,362 @@
+// wifi_manager.cpp - event-driven WiFi station with scan cache and BSSID memory.
+
+#include "wifi_manager.h"
+#include "config.h"
+#include "gateway.h"
+#include "settings.h"
+#include <WiFi.h>
+
+#define WIFI_MAX_CREDS   6
+#define WIFI_EVENT_GUARD_MS 300       // disconnect events this soon after begin() belong to the previous link
+
+struct WifiCred {
+  String ssid;
+  String pass;
+};
+
+// Compiled-in fallback hotspots (config.h)
+static const char *const kHotspots[][2] = {
+  { WIFI_SSID1, WIFI_PASS1 },
+  { WIFI_SSID2, WIFI_PASS2 },
+};
+
+enum WifiState { WS_OFF, WS_IDLE, WS_SCANNING, WS_CONNECTING, WS_CONNECTED };
+
+static WifiState     s_state = WS_OFF;
+static WifiState     s_scanReturn = WS_IDLE;     // state after a scan-only request
+static bool          s_scanOnly = false;
+static unsigned long s_stateMs = 0;
+static unsigned long s_retryAtMs = 0;
+static unsigned long s_backoffMs = WIFI_RETRY_MIN_MS;
+static bool          s_fastTried = false;
+static bool          s_attemptFast = false;
+static uint8_t       s_planIdx = 0;              // next credential to look up in the scan
+static String        s_attemptSsid;
+
+static WifiCred s_creds[WIFI_MAX_CREDS];
+static uint8_t  s_credCount = 0;
+
+static volatile bool s_credsChanged = false;     // set by the settings listener
+
+static WifiScanEntry s_scan[WIFI_SCAN_MAX];
+static uint8_t       s_scanCount = 0;
+static unsigned long s_scanAtMs = 0;
+static bool          s_scanValid = false;
+
+// set from the WiFi event task, consumed by wifi_loop()
+static volatile bool          s_evGotIp = false;
+static volatile bool          s_evDisconnected = false;
+static volatile uint8_t       s_evReason = 0;
+static volatile unsigned long s_evAtMs = 0;
+
+static uint32_t      s_joins = 0;
+static uint32_t      s_fastJoins = 0;
+static uint32_t      s_failures = 0;
+static unsigned long s_lastJoinMs = 0;           // begin() to IP of the last association
+
+static void wifi_onEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+    s_evGotIp = true;
+  } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+    s_evReason = info.wifi_sta_disconnected.reason;
+    s_evAtMs = millis();
+    s_evDisconnected = true;
+  }
+}
+
+static void wifi_setState(WifiState st) {
+  s_state = st;
+  s_stateMs = millis();
+}
+
+static const WifiCred *wifi_credFor(const String &ssid) {
+  for (uint8_t i = 0; i < s_credCount; ++i) {
+    if (s_creds[i].ssid == ssid) return &s_creds[i];
+  }
+  return nullptr;
+}
+
+static void wifi_addCred(const String &ssid, const String &pass) {
+  if (!ssid.length() || s_credCount >= WIFI_MAX_CREDS || wifi_credFor(ssid)) return;
+  s_creds[s_credCount].ssid = ssid;
+  s_creds[s_credCount].pass = pass;
+  s_credCount++;
+}
+
+static void wifi_loadCredentials() {
+  const Settings &cfg = settings();
+  s_credCount = 0;
+  for (uint8_t i = 0; i < SETTINGS_WIFI_SLOTS; ++i) wifi_addCred(cfg.wifi[i].ssid, cfg.wifi[i].pass);
+  for (size_t i = 0; i < sizeof(kHotspots) / sizeof(kHotspots[0]); ++i) wifi_addCred(kHotspots[i][0], kHotspots[i][1]);
+  s_fastTried = false;
+}
+
+static void wifi_onSettings(uint16_t changed) {
+  if (changed & SET_WIFI) s_credsChanged = true;   // may run on a web server task
+}
+
+static void wifi_rememberLink() {
+  uint8_t *bssid = WiFi.BSSID();
+  uint8_t ch = (uint8_t)WiFi.channel();
+  if (!bssid || !ch) return;
+  // settings only writes NVS when the AP changed, not on every reconnect
+  settings_setWifiLast(s_attemptSsid.c_str(), bssid, ch);
+}
+
+// Leave the station idle; ESP-NOW roles keep STA mode on the ESP-NOW channel
+static void wifi_radioDown() {
+#if NODE_ROLE == NODE_ROLE_STANDALONE
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+#else
+  WiFi.disconnect(false);
+  gateway_restoreChannel();
+#endif
+}
+
+static void wifi_begin(const WifiCred &c, const uint8_t *bssid, uint8_t channel, bool fast) {
+  Serial.printf("[WiFi] Joining %s (ch %u%s)\n", c.ssid.c_str(), channel, fast ? ", stored BSSID" : "");
+  s_attemptSsid = c.ssid;
+  s_attemptFast = fast;
+  s_evGotIp = false;
+  s_evDisconnected = false;
+  WiFi.begin(c.ssid.c_str(), c.pass.c_str(), channel, bssid, true);
+  wifi_setState(WS_CONNECTING);
+}
+
+// Round over: nothing left to try until the backoff expires
+static void wifi_roundFailed() {
+  s_failures++;
+  s_fastTried = false;
+  s_scanValid = false;          // the next round looks again
+  s_retryAtMs = millis() + s_backoffMs;
+  Serial.printf("[WiFi] No network joined, retry in %lu s\n", s_backoffMs / 1000UL);
+  s_backoffMs = min(s_backoffMs * 2, WIFI_RETRY_MAX_MS);
+#if NODE_ROLE != NODE_ROLE_STANDALONE
+  gateway_restoreChannel();
+#endif
+  wifi_setState(WS_IDLE);
+}
+
+// Join the strongest scanned AP of the next credential that is in range
+static void wifi_tryNextScanned() {
+  for (; s_planIdx < s_credCount; ++s_planIdx) {
+    const WifiCred &c = s_creds[s_planIdx];
+    for (uint8_t j = 0; j < s_scanCount; ++j) {          // s_scan is sorted by RSSI
+      if (c.ssid != s_scan[j].ssid) continue;
+      s_planIdx++;
+      wifi_begin(c, s_scan[j].bssid, s_scan[j].channel, false);
+      return;
+    }
+  }
+  wifi_roundFailed();
+}
+
+static void wifi_startScan(bool scanOnly) {
+  s_scanOnly = scanOnly;
+  s_scanReturn = s_state;
+  if (WiFi.getMode() == WIFI_OFF) WiFi.mode(WIFI_STA);
+  if (WiFi.scanNetworks(true) == WIFI_SCAN_FAILED) {
+    Serial.println(F("[WiFi] scan failed to start"));
+    if (scanOnly) return;
+    wifi_roundFailed();
+    return;
+  }
+  wifi_setState(WS_SCANNING);
+}
+
+static void wifi_startAttempt() {
+  if (s_credCount == 0) {
+    s_retryAtMs = millis() + WIFI_RETRY_MAX_MS;
+    return;
+  }
+  if (WiFi.getMode() == WIFI_OFF) WiFi.mode(WIFI_STA);
+
+  const Settings &cfg = settings();
+  const WifiCred *last = cfg.wifiLastChannel ? wifi_credFor(cfg.wifiLastSsid) : nullptr;
+  if (!s_fastTried && last) {
+    s_fastTried = true;
+    wifi_begin(*last, cfg.wifiLastBssid, cfg.wifiLastChannel, true);
+    return;
+  }
+  s_planIdx = 0;
+  if (s_scanValid && millis() - s_scanAtMs < WIFI_SCAN_TTL_MS) wifi_tryNextScanned();
+  else wifi_startScan(false);
+}
+
+static void wifi_storeScan(int16_t n) {
+  s_scanCount = 0;
+  for (int16_t i = 0; i < n && s_scanCount < WIFI_SCAN_MAX; ++i) {
+    WifiScanEntry &e = s_scan[s_scanCount];
+    strlcpy(e.ssid, WiFi.SSID(i).c_str(), sizeof(e.ssid));
+    if (!e.ssid[0]) continue;                            // hidden network
+    uint8_t *b = WiFi.BSSID(i);
+    if (b) memcpy(e.bssid, b, 6);
+    else memset(e.bssid, 0, 6);
+    e.channel = (uint8_t)WiFi.channel(i);
+    e.rssi = (int8_t)WiFi.RSSI(i);
+    // insertion sort, strongest first
+    for (uint8_t k = s_scanCount; k > 0 && s_scan[k].rssi > s_scan[k - 1].rssi; --k) {
+      WifiScanEntry t = s_scan[k];
+      s_scan[k] = s_scan[k - 1];
+      s_scan[k - 1] = t;
+    }
+    s_scanCount++;
+  }
+  WiFi.scanDelete();
+  s_scanAtMs = millis();
+  s_scanValid = true;
+}
+
+void wifi_init() {
+  WiFi.persistent(false);         // credentials live in our own NVS keys
+  WiFi.setAutoReconnect(false);   // reconnects are ours, with backoff and the fast path
+  WiFi.onEvent(wifi_onEvent);
+  settings_onChange(wifi_onSettings);
+  wifi_loadCredentials();
+}
+
+void wifi_loop() {
+  unsigned long now = millis();
+
+  if (s_credsChanged) {
+    s_credsChanged = false;
+    wifi_loadCredentials();
+    if (s_state == WS_IDLE) s_retryAtMs = now;     // new network: try it now
+  }
+
+  if (s_evDisconnected) {
+    s_evDisconnected = false;
+    bool stale = (long)(s_evAtMs - s_stateMs) < (long)WIFI_EVENT_GUARD_MS;
+    if (s_state == WS_CONNECTED) {
+      Serial.printf("[WiFi] Connection lost (reason %u)\n", s_evReason);
+      s_fastTried = false;                           // same AP first
+      s_retryAtMs = now;
+      wifi_setState(WS_IDLE);
+    } else if (s_state == WS_SCANNING && s_scanReturn == WS_CONNECTED) {
+      Serial.printf("[WiFi] Connection lost during scan (reason %u)\n", s_evReason);
+      s_fastTried = false;
+      s_retryAtMs = now;
+      s_scanReturn = WS_IDLE;
+    } else if (s_state == WS_CONNECTING && !stale) {
+      Serial.printf("[WiFi] Join %s failed (reason %u)\n", s_attemptSsid.c_str(), s_evReason);
+      if (s_attemptFast) wifi_startAttempt();        // fall back to the scan
+      else wifi_tryNextScanned();
+    }
+  }
+
+  if (s_evGotIp) {
+    s_evGotIp = false;
+    if (s_state == WS_CONNECTING) {
+      s_lastJoinMs = now - s_stateMs;
+      s_joins++;
+      if (s_attemptFast) s_fastJoins++;
+      s_backoffMs = WIFI_RETRY_MIN_MS;
+      wifi_setState(WS_CONNECTED);
+      wifi_rememberLink();
+      Serial.printf("[WiFi] Connected to %s, IP %s, %lu ms\n", s_attemptSsid.c_str(),
+                    WiFi.localIP().toString().c_str(), s_lastJoinMs);
+    }
+  }
+
+  switch (s_state) {
+    case WS_OFF:
+    case WS_CONNECTED:
+      break;
+
+    case WS_IDLE:
+      if ((long)(now - s_retryAtMs) >= 0) wifi_startAttempt();
+      break;
+
+    case WS_SCANNING: {
+      int16_t n = WiFi.scanComplete();
+      if (n == WIFI_SCAN_RUNNING && now - s_stateMs < 15000UL) break;
+      wifi_storeScan(n > 0 ? n : 0);
+      if (s_scanOnly) {
+        wifi_setState(s_scanReturn);
+        break;
+      }
+      s_planIdx = 0;
+      wifi_tryNextScanned();
+      break;
+    }
+
+    case WS_CONNECTING:
+      if (now - s_stateMs >= WIFI_CONNECT_TIMEOUT_MS) {
+        Serial.printf("[WiFi] Join %s timed out\n", s_attemptSsid.c_str());
+        WiFi.disconnect(false);
+        if (s_attemptFast) wifi_startAttempt();
+        else wifi_tryNextScanned();
+      }
+      break;
+  }
+}
+
+void wifi_setEnabled(bool on) {
+  if (on) {
+    if (s_state != WS_OFF) return;
+    s_fastTried = false;
+    s_retryAtMs = millis();
+    wifi_setState(WS_IDLE);
+    return;
+  }
+  if (s_state == WS_OFF) return;
+  if (s_state == WS_SCANNING) WiFi.scanDelete();
+  wifi_radioDown();
+  wifi_setState(WS_OFF);
+}
+
+bool wifi_isEnabled() {
+  return s_state != WS_OFF;
+}
+
+void wifi_connectNow() {
+  wifi_setEnabled(true);
+  if (s_state == WS_IDLE) {
+    s_backoffMs = WIFI_RETRY_MIN_MS;
+    s_retryAtMs = millis();
+  }
+}
+
+bool wifi_isConnected() {
+  // a scan requested while associated keeps the link up
+  bool up = s_state == WS_CONNECTED || (s_state == WS_SCANNING && s_scanOnly && s_scanReturn == WS_CONNECTED);
+  return up && WiFi.status() == WL_CONNECTED;
+}
+
+void wifi_requestScan() {
+  if (s_state == WS_CONNECTED || s_state == WS_IDLE) wifi_startScan(true);
+}
+
+uint8_t wifi_scanResults(const WifiScanEntry **out, unsigned long *ageMs) {
+  if (out) *out = s_scan;
+  if (ageMs) *ageMs = s_scanValid ? millis() - s_scanAtMs : 0;
+  return s_scanValid ? s_scanCount : 0;
+}
+
+void wifi_print(Print &out) {
+  static const char *const names[] = { "off", "idle", "scanning", "connecting", "connected" };
+  out.printf("[WiFi] %s", names[s_state]);
+  if (s_state == WS_CONNECTED) {
+    out.printf(" to %s, IP %s, RSSI %d dBm", s_attemptSsid.c_str(), WiFi.localIP().toString().c_str(), (int)WiFi.RSSI());
+  } else if (s_state == WS_IDLE) {
+    long wait = (long)(s_retryAtMs - millis());
+    out.printf(", next try in %ld s", wait > 0 ? wait / 1000L : 0L);
+  }
+  out.printf("\n[WiFi] %u known networks, joins %lu (%lu via stored BSSID), failed rounds %lu, last join %lu ms\n",
+             s_credCount, (unsigned long)s_joins, (unsigned long)s_fastJoins, (unsigned long)s_failures, s_lastJoinMs);
+  const Settings &cfg = settings();
+  if (cfg.wifiLastChannel) {
+    const uint8_t *b = cfg.wifiLastBssid;
+    out.printf("[WiFi] stored: %s %02x:%02x:%02x:%02x:%02x:%02x ch %u\n", cfg.wifiLastSsid, b[0], b[1], b[2], b[3],
+               b[4], b[5], cfg.wifiLastChannel);
+  }
+  unsigned long age;
+  const WifiScanEntry *e;
+  uint8_t n = wifi_scanResults(&e, &age);
+  if (!n) return;
+  out.printf("[WiFi] scan cache (%lu s old):\n", age / 1000UL);
+  for (uint8_t i = 0; i < n; ++i) {
+    out.printf("  %-32s ch %2u %4d dBm%s\n", e[i].ssid, e[i].channel, e[i].rssi, wifi_credFor(e[i].ssid) ? "  known" : "");
+  }
+}
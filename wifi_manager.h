@@ -0,0 +1,62 @@
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <Arduino.h>
+
+// The only owner of the WiFi station. Everything else asks for WiFi with
+// wifi_setEnabled()/wifi_connectNow() and checks wifi_isConnected();
+// nothing outside this module calls WiFi.begin()/disconnect()/scanNetworks().
+//
+// Non-blocking: WiFi events only set flags, wifi_loop() runs the state machine.
+//   1. fast path: the last good network is joined directly with its stored
+//      BSSID and channel, skipping the scan (~2 s less per association)
+//   2. otherwise an async scan (cached for WIFI_SCAN_TTL_MS) picks the
+//      strongest AP of each known SSID, in credential order
+//   3. when every candidate failed, retry with exponential backoff
+//
+// Credentials: the settings.h WiFi slots (provisioning form, key server),
+// then WIFI_SSID1/WIFI_SSID2 from config.h. Changes are picked up through a
+// settings listener; the last AP is stored with settings_setWifiLast().
+// ESP-NOW roles (gateway.h) keep the radio in STA mode while WiFi is off.
+
+#ifndef WIFI_CONNECT_TIMEOUT_MS
+#define WIFI_CONNECT_TIMEOUT_MS 10000UL
+#endif
+
+#ifndef WIFI_SCAN_TTL_MS
+#define WIFI_SCAN_TTL_MS 300000UL
+#endif
+
+#ifndef WIFI_RETRY_MIN_MS
+#define WIFI_RETRY_MIN_MS 10000UL
+#endif
+
+#ifndef WIFI_RETRY_MAX_MS
+#define WIFI_RETRY_MAX_MS 300000UL
+#endif
+
+#define WIFI_SCAN_MAX 16
+
+struct WifiScanEntry {
+  char    ssid[33];
+  uint8_t bssid[6];
+  uint8_t channel;
+  int8_t  rssi;
+};
+
+void wifi_init();                 // after settings_init(): load credentials, hook events
+void wifi_loop();
+
+void wifi_setEnabled(bool on);    // off: drop the association (LTE takeover)
+bool wifi_isEnabled();
+void wifi_connectNow();           // enable and start an attempt without waiting for the backoff
+bool wifi_isConnected();
+
+// Start an async scan that refreshes the cache (ignored while connecting)
+void wifi_requestScan();
+// Cached results, strongest first; ageMs tells how old they are
+uint8_t wifi_scanResults(const WifiScanEntry **out, unsigned long *ageMs);
+
+void wifi_print(Print &out);      // serial 'wifi'
+
+#endif // WIFI_MANAGER_H